@@ -3,8 +3,79 @@
  * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
  *
  **/
+#define _GNU_SOURCE /* mremap */
 #include "array.h"
 
+#include <stddef.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <strings.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define IS_MAPPED(array)                                                       \
+  ((array)->mode != ARRAY_MAP_NONE)
+
+#define IS_READ_ONLY(array)                                                    \
+  ((array)->mode == ARRAY_MAP_RDONLY)
+
+/* Eytzinger arrays are frozen, only array_sort undoes the layout */
+#define IS_FROZEN(array)                                                       \
+  ((array)->layout == ARRAY_LAYOUT_EYTZINGER)
+
+#define IS_SEGMENTED(array)                                                    \
+  ((array)->segments != NULL)
+
+#define IS_SPARSE(array)                                                       \
+  ((array)->sparse)
+
+/* page holding a block of slots (sparse arrays only) */
+#define PAGE_OF(ptr)                                                           \
+  ((array_page_ptr)((char *)(ptr) - offsetof(array_page_t, slots)))
+
+#define IS_FLAT_HEAP(array)                                                    \
+  (! IS_SEGMENTED(array) && ! IS_MAPPED(array))
+
+/* number of elements that fit without resizing */
+#define CAPACITY(array)                                                        \
+  ((array)->n_size - (array)->gap_len)
+
+#define MAPPED_LENGTH(n_size)                                                  \
+  (ARRAY_HEADER_SIZE + (size_t)(n_size) * sizeof(generic_ptr))
+
+/* shared by all untouched blocks of sparse arrays, never written */
+static const array_page_t array_zero_page;
+
+/* -- internal functions ---------------------------------------------------- */
+static array_ptr array_new_segmented(cmp_func_ptr cmp, free_func_ptr free,
+                                     int sparse);
+static inline int array_sparse_set(array_ptr array, unsigned index,
+                                   generic_ptr item);
+static inline generic_dptr array_slot(array_ptr array, unsigned index);
+static inline generic_dptr array_run(array_ptr array, unsigned index,
+                                     unsigned* len);
+static inline generic_dptr array_run_back(array_ptr array, unsigned index,
+                                          unsigned* len);
+static inline int array_copy_in(array_ptr array, unsigned index,
+                                generic_dptr items, unsigned n);
+static inline int array_iter_refill(array_iterator_ptr iter);
+static inline array_ptr array_new_like(array_ptr array, unsigned size);
+static inline int array_realloc(array_ptr array, unsigned new_size);
+static inline void array_gap_move(array_ptr array, unsigned pos);
+static inline void array_gap_close(array_ptr array);
+static inline int array_set(array_ptr array, unsigned index,
+                            generic_ptr item);
+static inline int array_remap(array_ptr array, unsigned new_size);
+static inline int array_resegment(array_ptr array, unsigned new_size);
+static inline unsigned array_bound(array_ptr array, generic_ptr key,
+                                   int bias);
+static inline unsigned array_eytzinger_bound(array_ptr array,
+                                             generic_ptr key, int bias);
+static unsigned array_eytzinger_fill(generic_dptr in, generic_dptr out,
+                                     unsigned i, unsigned k, unsigned n);
+static int array_word_cmp(const generic_ptr a, generic_ptr b);
+
 /* Allocate an array of 'number' elements,each of which require 'size' bytes */
 array_ptr array_init(unsigned size, cmp_func_ptr cmp, free_func_ptr free)
 {
@@ -19,6 +90,18 @@ array_ptr array_init(unsigned size, cmp_func_ptr cmp, free_func_ptr free)
 
   array->num = 0;
   array->n_size = MAX(ARRAY_INIT_SIZE, size);
+  array->layout = ARRAY_LAYOUT_LINEAR;
+  array->stamp = 0;
+  array->gap_start = array->gap_len = 0;
+
+  array->mode = ARRAY_MAP_NONE;
+  array->fd = -1;
+  array->header = NULL;
+
+  array->segments = NULL;
+  array->n_segments = 0;
+  array->dir_size = 0;
+  array->sparse = 0;
 
   fullsize = array->n_size * sizeof(generic_ptr);
   if (! (array->space = (generic_dptr) malloc(fullsize))) {
@@ -31,27 +114,232 @@ array_ptr array_init(unsigned size, cmp_func_ptr cmp, free_func_ptr free)
 }
 
 
+/* Allocate an empty segmented array. Storage grows one block of
+   ARRAY_SEGMENT_SIZE elements at a time, existing blocks are never
+   moved, so element addresses survive growth. */
+array_ptr array_init_segmented(cmp_func_ptr cmp, free_func_ptr free)
+{
+  return array_new_segmented(cmp, free, 0);
+}
+
+
+/* Allocate an empty sparse array. This is a segmented array whose
+   blocks all share a single read-only page of NULLs until they are
+   first written to. Each page keeps an occupancy bitmap, so scans
+   skip empty pages and NULL holes altogether. */
+array_ptr array_init_sparse(cmp_func_ptr cmp, free_func_ptr free)
+{
+  return array_new_segmented(cmp, free, 1);
+}
+
+
+/* Open (or create, in ARRAY_MAP_RDWR mode) an array backed by the
+   file at 'path'. Slots hold raw pointer-sized words (ids, offsets,
+   ...) and are paged in on demand. Several processes can share the
+   same file in ARRAY_MAP_RDONLY mode. Returns NULL on failure. */
+array_ptr array_open_mapped(const char* path, int mode)
+{
+  array_ptr array;
+  struct stat st;
+  size_t length;
+  int flags, prot;
+
+  assert(mode == ARRAY_MAP_RDONLY || mode == ARRAY_MAP_RDWR);
+
+  if (! (array = (array_ptr)(malloc(sizeof(array_t)))))
+    return NULL;
+
+  array->cmp = array_word_cmp;
+  array->free = NULL;
+  array->mode = mode;
+  array->layout = ARRAY_LAYOUT_LINEAR;
+  array->stamp = 0;
+  array->gap_start = array->gap_len = 0;
+
+  array->segments = NULL;
+  array->n_segments = 0;
+  array->dir_size = 0;
+  array->sparse = 0;
+
+  flags = (mode == ARRAY_MAP_RDONLY) ? O_RDONLY : (O_RDWR | O_CREAT);
+  prot = (mode == ARRAY_MAP_RDONLY) ? PROT_READ : (PROT_READ | PROT_WRITE);
+
+  if ((array->fd = open(path, flags, 0644)) < 0) {
+    free(array);
+    return NULL;
+  }
+
+  if (fstat(array->fd, &st) < 0) goto fail;
+  length = st.st_size;
+
+  /* brand new file, make room for the header and the first slots */
+  if (0 == length) {
+    if (mode == ARRAY_MAP_RDONLY) goto fail;
+
+    length = MAPPED_LENGTH(ARRAY_INIT_SIZE);
+    if (ftruncate(array->fd, length) < 0) goto fail;
+  }
+
+  if (length < ARRAY_HEADER_SIZE) goto fail;
+
+  array->header = (array_header_ptr) \
+    mmap(NULL, length, prot, MAP_SHARED, array->fd, 0);
+
+  if (MAP_FAILED == (generic_ptr) array->header) goto fail;
+
+  if (0 == array->header->magic && mode == ARRAY_MAP_RDWR) {
+    array->header->magic = ARRAY_MAGIC;
+    array->header->word_size = sizeof(generic_ptr);
+    array->header->num = 0;
+  }
+
+  array->n_size = (length - ARRAY_HEADER_SIZE) / sizeof(generic_ptr);
+
+  /* foreign or damaged files, e.g. truncated under their count */
+  if ((ARRAY_MAGIC != array->header->magic) ||
+      (sizeof(generic_ptr) != array->header->word_size) ||
+      (array->header->num > array->n_size) ||
+      (array->header->num > UINT_MAX)) {
+    munmap(array->header, length);
+    goto fail;
+  }
+
+  array->space = (generic_dptr)((char *) array->header + ARRAY_HEADER_SIZE);
+  array->num = (unsigned) array->header->num;
+
+  return array;
+
+ fail:
+  close(array->fd);
+  free(array);
+  return NULL;
+}
+
+
+/* Flush the element count and dirty pages of a mapped array back to
+   the file. If 'async' is non-zero, the write is only scheduled. */
+int array_sync(array_ptr array, int async)
+{
+  assert(array);
+
+  if (! IS_MAPPED(array)) return ARRAY_OK;
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+
+  array->header->num = array->num;
+  if (msync(array->header, MAPPED_LENGTH(array->n_size),
+            async ? MS_ASYNC : MS_SYNC) < 0)
+    return ARRAY_OUT_OF_MEM;
+
+  return ARRAY_OK;
+}
+
+
+/* Tell the kernel how a mapped array is going to be accessed */
+int array_advise(array_ptr array, int advice)
+{
+  int native;
+  assert(array);
+
+  if (! IS_MAPPED(array)) return ARRAY_OK;
+
+  switch (advice) {
+  case ARRAY_ADVICE_NORMAL: native = MADV_NORMAL; break;
+  case ARRAY_ADVICE_RANDOM: native = MADV_RANDOM; break;
+  case ARRAY_ADVICE_SEQUENTIAL: native = MADV_SEQUENTIAL; break;
+  case ARRAY_ADVICE_WILLNEED: native = MADV_WILLNEED; break;
+  case ARRAY_ADVICE_DONTNEED: native = MADV_DONTNEED; break;
+  default: assert(0); return ARRAY_OK;
+  }
+
+  (void) madvise(array->header, MAPPED_LENGTH(array->n_size), native);
+  return ARRAY_OK;
+}
+
+
 int array_find(array_ptr array, generic_ptr key)
 {
-  unsigned i;
+  unsigned i, len;
   generic_dptr elem;
 
-  /* Scans for key */
-  for (i=0, elem = array->space;
-       i < array->n_size; i ++, elem ++) {
+  /* Sparse: visit occupied slots only */
+  if (IS_SPARSE(array)) {
+    for (i=0; array_next_occupied(array, &i); i ++) {
+      if (! array->cmp(*array_slot(array, i), key))
+        return i;
+    }
 
-    if ((*elem) && (! array->cmp(*elem, key)))
-      return i;
+    return -1;
+  }
+
+  /* Scans for key, one contiguous run at a time */
+  for (i=0; i < array->num; ) {
+    elem = array_run(array, i, &len);
+    len = MIN(len, array->num - i);
+
+    for (; len --; i ++, elem ++) {
+      if ((*elem) && (! array->cmp(*elem, key)))
+        return i;
+    }
   }
 
   return -1;
 }
 
+
+int array_next_occupied(array_ptr array, unsigned* index)
+{
+  unsigned i = (*index), seg, word;
+  unsigned long long bits;
+  array_page_ptr page;
+
+  if (! IS_SPARSE(array)) {
+    for (; i < array->num; i ++) {
+      if (*array_slot(array, i)) {
+        (*index) = i;
+        return 1;
+      }
+    }
+
+    return 0;
+  }
+
+  while (i < array->num) {
+    seg = i >> ARRAY_SEGMENT_SHIFT;
+    page = PAGE_OF(array->segments[seg]);
+
+    /* skip empty pages altogether */
+    if (! page->used) {
+      i = (seg + 1) << ARRAY_SEGMENT_SHIFT;
+      continue;
+    }
+
+    /* first set bit at or after i within this page */
+    word = (i & ARRAY_SEGMENT_MASK) >> 6;
+    bits = page->bits[word] & (~0ULL << (i & 63));
+
+    while (! bits && ++ word < ARRAY_PAGE_WORDS)
+      bits = page->bits[word];
+
+    if (! bits) {
+      i = (seg + 1) << ARRAY_SEGMENT_SHIFT;
+      continue;
+    }
+
+    i = (seg << ARRAY_SEGMENT_SHIFT) + (word << 6) + CTZ64(bits);
+    if (i >= array->num) break;
+
+    (*index) = i;
+    return 1;
+  }
+
+  return 0;
+}
+
 int array_fetch(array_ptr array, unsigned index, generic_dptr out)
 {
   if (index >= array->num) return ARRAY_OUT_OF_BOUNDS;
 
-  (*out) = *(array->space + index );
+  (*out) = *array_slot(array, index);
   return ARRAY_OK;
 }
 
@@ -61,16 +349,138 @@ int array_insert(array_ptr array, unsigned index, generic_ptr buf)
   int res = ARRAY_OK;
   assert(array);
 
-  if ((index >= array->n_size) &&
-      ((res = array_resize(array, 1 + index)) != ARRAY_OK))
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+  if (IS_FROZEN(array)) return ARRAY_BAD_LAYOUT;
+
+  /* writing past the end needs the room held by the gap, if any */
+  if (index >= CAPACITY(array)) {
+    array_gap_close(array);
+
+    if ((index >= array->n_size) &&
+        ((res = array_resize(array, 1 + index)) != ARRAY_OK))
+      return res;
+  }
+
+  if ((res = array_set(array, index, buf)) != ARRAY_OK)
     return res;
 
-  *(array->space + index) = buf;
-  if (index >= array->num) array->num = index + 1;
+  if (index >= array->num)
+    array->num = index + 1;
 
   return ARRAY_OK;
 }
 
+
+/* Insert 'obj' before position 'index' (index == array_n() appends),
+   shifting the following elements up by one. Large flat arrays keep
+   a gap at the last edit point, so edits clustered around a cursor
+   move only the elements between consecutive edit points. */
+int array_insert_before(array_ptr array, unsigned index, generic_ptr obj)
+{
+  int res;
+  unsigned i;
+  generic_ptr tmp;
+  assert(array);
+
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+  if (IS_FROZEN(array)) return ARRAY_BAD_LAYOUT;
+  if (index > array->num) return ARRAY_OUT_OF_BOUNDS;
+  ++ array->stamp;
+
+  /* no spare slot left, neither in the gap nor at the end */
+  if ((array->n_size <= array->num) &&
+      ((res = array_resize(array, 1 + array->num)) != ARRAY_OK))
+    return res;
+
+  if (IS_FLAT_HEAP(array)) {
+    if (! array->gap_len) {
+
+      /* small arrays: plain shifting */
+      if (array->num < ARRAY_GAP_THRESHOLD) {
+        memmove(array->space + index + 1, array->space + index,
+                (array->num - index) * sizeof(generic_ptr));
+
+        array->space[index] = obj;
+        ++ array->num;
+        return ARRAY_OK;
+      }
+
+      /* open a gap on the spare room at the end */
+      array->gap_start = array->num;
+      array->gap_len = array->n_size - array->num;
+    }
+
+    array_gap_move(array, index);
+    array->space[array->gap_start ++] = obj;
+    -- array->gap_len;
+    ++ array->num;
+
+    return ARRAY_OK;
+  }
+
+  /* segmented and mapped arrays shift element by element */
+  for (i = array->num; i > index; -- i) {
+    tmp = *array_slot(array, i - 1);
+    if ((res = array_set(array, i, tmp)) != ARRAY_OK)
+      return res;
+  }
+
+  ++ array->num;
+  return array_set(array, index, obj);
+}
+
+
+/* Remove the element at 'index', shifting the following elements
+   down by one. If 'obj' is non-NULL, the removed element is stored
+   in (*obj). The element is not freed. */
+int array_delete(array_ptr array, unsigned index, generic_dptr obj)
+{
+  int res;
+  unsigned i;
+  assert(array);
+
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+  if (IS_FROZEN(array)) return ARRAY_BAD_LAYOUT;
+  if (index >= array->num) return ARRAY_OUT_OF_BOUNDS;
+  ++ array->stamp;
+
+  if (obj) (*obj) = *array_slot(array, index);
+
+  if (IS_FLAT_HEAP(array)) {
+    if (! array->gap_len) {
+
+      /* small arrays: plain shifting */
+      if (array->num < ARRAY_GAP_THRESHOLD) {
+        memmove(array->space + index, array->space + index + 1,
+                (array->num - index - 1) * sizeof(generic_ptr));
+
+        array->space[-- array->num] = NULL;
+        return ARRAY_OK;
+      }
+
+      /* open a (possibly empty) gap on the spare room at the end */
+      array->gap_start = array->num;
+      array->gap_len = array->n_size - array->num;
+    }
+
+    /* swallow the element into the gap */
+    array_gap_move(array, index + 1);
+    -- array->gap_start;
+    ++ array->gap_len;
+    -- array->num;
+
+    return ARRAY_OK;
+  }
+
+  /* segmented and mapped arrays shift element by element */
+  for (i = index + 1; i < array->num; ++ i) {
+    if ((res = array_set(array, i - 1, *array_slot(array, i))) != ARRAY_OK)
+      return res;
+  }
+
+  return array_set(array, -- array->num, NULL);
+}
+
 unsigned array_n(const array_ptr array)
 {
   return array->num;
@@ -78,15 +488,28 @@ unsigned array_n(const array_ptr array)
 
 unsigned array_count(const array_ptr array, generic_ptr key)
 {
-  unsigned res = 0, i;
+  unsigned res = 0, i, len;
   generic_dptr elem;
 
-  /* Scans for key */
-  for (i=0, elem = array->space;
-       i < array->n_size; i ++, elem ++) {
+  /* Sparse: visit occupied slots only */
+  if (IS_SPARSE(array)) {
+    for (i=0; array_next_occupied(array, &i); i ++) {
+      if (! array->cmp(*array_slot(array, i), key))
+        res ++ ;
+    }
+
+    return res;
+  }
+
+  /* Scans for key, one contiguous run at a time */
+  for (i=0; i < array->num; ) {
+    elem = array_run(array, i, &len);
+    len = MIN(len, array->num - i);
 
-    if ((*elem) && (! array->cmp(*elem, key)))
-      res ++ ;
+    for (i += len; len --; elem ++) {
+      if ((*elem) && (! array->cmp(*elem, key)))
+        res ++ ;
+    }
   }
 
   return res;
@@ -96,34 +519,80 @@ array_iterator_ptr array_iter(array_ptr array, int dir)
 {
   array_iterator_ptr res;
 
-  if (! (res = (array_iterator_ptr)(malloc(sizeof(array_iterator_ptr)))))
+  if (! (res = (array_iterator_ptr)(malloc(sizeof(array_iterator_t)))))
     return NULL;
 
-  if (ARRAY_ITER_FORWARD == dir) {
-    res->next = array->space;
-    res->last = array->space + array->n_size -1;
-  }
-
-  else if (ARRAY_ITER_BACKWARD == dir) {
-    res->last = array->space;
-    res->next = array->space + array->n_size -1;
-  }
+  array_iter_init(res, array, dir);
+  return res;
+}
 
-  else assert(0);
+/* Set up a caller-provided (e.g. stack allocated) iterator. There is
+   nothing to release afterwards. */
+void array_iter_init(array_iterator_ptr iter, array_ptr array, int dir)
+{
+  assert(ARRAY_ITER_FORWARD == dir || ARRAY_ITER_BACKWARD == dir);
+
+  iter->array = array;
+  iter->next = NULL;
+  iter->run = 0;
+  iter->left = iter->total = array->num;
+  iter->stamp = array->stamp;
+  iter->dir = dir;
+}
 
-  return res;
+/* non-zero if elements moved or went away since 'iter' was set up.
+   Growth that leaves them in place (into spare room, or a block at a
+   time on segmented arrays) does not count. Iterators then stop, the
+   elements they point to may be gone. */
+int array_iter_changed(array_iterator_ptr iter)
+{
+  return iter->stamp != iter->array->stamp;
 }
 
 int array_iter_next(array_iterator_ptr iter, generic_dptr next)
 {
-  if (iter->next == iter->last) return 0;
+  if (! iter->left || array_iter_changed(iter)) return 0;
+  if (! iter->run && ! array_iter_refill(iter)) return 0;
 
   (*next) = (*iter->next);
   iter->next += iter->dir;
+  -- iter->run;
+  -- iter->left;
 
   return 1;
 }
 
+/* Fetch up to 'max' items into 'out', returns the number of items
+   fetched (0 when done). Forward iteration copies whole runs at a
+   time. */
+unsigned array_iter_next_batch(array_iterator_ptr iter, generic_dptr out,
+                               unsigned max)
+{
+  unsigned res = 0, len, i;
+
+  if (array_iter_changed(iter)) return 0;
+
+  while ((res < max) && iter->left) {
+    if (! iter->run && ! array_iter_refill(iter)) break;
+    len = MIN(iter->run, max - res);
+
+    if (ARRAY_ITER_FORWARD == iter->dir) {
+      memcpy(out + res, iter->next, len * sizeof(generic_ptr));
+      iter->next += len;
+    }
+    else {
+      for (i = 0; i < len; i ++)
+        out[res + i] = *(iter->next --);
+    }
+
+    iter->run -= len;
+    iter->left -= len;
+    res += len;
+  }
+
+  return res;
+}
+
 
 void array_iter_deinit(array_iterator_ptr iter)
 {
@@ -134,151 +603,772 @@ void array_iter_deinit(array_iterator_ptr iter)
 void array_deinit(array_ptr array)
 {
   assert(array);
-  unsigned i;
+  unsigned i, len;
   generic_dptr elem;
 
+  if (IS_MAPPED(array)) {
+    /* words are not owned, just persist the element count */
+    if (! IS_READ_ONLY(array)) array->header->num = array->num;
+
+    munmap(array->header, MAPPED_LENGTH(array->n_size));
+    close(array->fd);
+    free(array);
+    return;
+  }
 
   /* Free all non-null objects */
-  for (i=0, elem = array->space;
-       i < array->n_size; i ++, elem ++) {
-    if (*elem) array->free(*elem);
+  if (array->free && IS_SPARSE(array)) {
+    for (i=0; array_next_occupied(array, &i); i ++)
+      array->free(*array_slot(array, i));
+  }
+  else if (array->free) {
+    for (i=0; i < array->num; ) {
+      elem = array_run(array, i, &len);
+      len = MIN(len, array->num - i);
+
+      for (i += len; len --; elem ++) {
+        if (*elem) array->free(*elem);
+      }
+    }
+  }
+
+  if (IS_SPARSE(array)) {
+    for (i=0; i < array->n_segments; i ++) {
+      if (PAGE_OF(array->segments[i]) != &array_zero_page)
+        free(PAGE_OF(array->segments[i]));
+    }
+
+    free(array->segments);
   }
+  else if (IS_SEGMENTED(array)) {
+    for (i=0; i < array->n_segments; i ++)
+      free(array->segments[i]);
+
+    free(array->segments);
+  }
+  else free(array->space);
 
-  free(array->space);
   free(array);
 }
 
 
-/* array_ptr array_dup(array_ptr old) */
-/* { */
-/*   array_pyt new; */
-/*   size_t fullsize; */
+/* Returns a shallow copy of 'old'. Element ownership is *not*
+   transferred, clients are responsible for taking additional
+   references where needed. */
+array_ptr array_dup(array_ptr old)
+{
+  array_ptr new;
+
+  if (! (new = array_new_like(old, old->num)))
+    return NULL;
+
+  if (ARRAY_OK != array_append(new, old)) {
+    new->num = 0;
+    array_deinit(new);
+    return NULL;
+  }
+
+  new->layout = old->layout;
+  return new;
+}
+
+
+/* append the elements of array2 to the end of array1 (array1 and
+   array2 may be the same array) */
+int array_append(array_ptr array1, array_ptr array2)
+{
+  int res;
+  unsigned i, len, n = array2->num;
+  generic_dptr run;
+
+  if (IS_READ_ONLY(array1)) return ARRAY_READ_ONLY;
+  if (IS_FROZEN(array1)) return ARRAY_BAD_LAYOUT;
+
+  /* make sure array1 has enough room */
+  array_gap_close(array1);
+  if ((array1->n_size < array1->num + n) &&
+      ((res = array_resize(array1, array1->num + n)) != ARRAY_OK))
+    return res;
+
+  for (i=0; i < n; i += len) {
+    run = array_run(array2, i, &len);
+    len = MIN(len, n - i);
+
+    if ((res = array_copy_in(array1, array1->num + i, run, len)) != ARRAY_OK)
+      return res;
+  }
+  array1->num += n;
+
+  return ARRAY_OK;
+}
+
+
+/* append 'n' elements from 'items' to the end of 'array'. Room is
+   made once for the final length, growth is amortized. 'items' must
+   not point into the array's own storage. */
+int array_extend(array_ptr array, generic_dptr items, unsigned n)
+{
+  int res;
+  assert(array);
+
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+  if (IS_FROZEN(array)) return ARRAY_BAD_LAYOUT;
+
+  array_gap_close(array);
+  if ((array->n_size < array->num + n) &&
+      ((res = array_resize(array, array->num + n)) != ARRAY_OK))
+    return res;
+
+  if ((res = array_copy_in(array, array->num, items, n)) != ARRAY_OK)
+    return res;
+
+  array->num += n;
+
+  return ARRAY_OK;
+}
+
+
+/* join array1 and array2, returning a new array */
+array_ptr array_join(array_ptr array1, array_ptr array2)
+{
+  array_ptr array;
+
+  if (! (array = array_new_like(array1, array1->num + array2->num)))
+    return NULL;
+
+  if ((ARRAY_OK != array_append(array, array1)) ||
+      (ARRAY_OK != array_append(array, array2))) {
+    array->num = 0;
+    array_deinit(array);
+    return NULL;
+  }
+
+  return array;
+}
+
+
+/* copy elements in [start, stop) into 'out', which must have room
+   for (stop - start) elements. */
+int array_slice(array_ptr array, unsigned start, unsigned stop,
+                generic_dptr out)
+{
+  unsigned len;
+  generic_dptr run;
+  assert(array);
+
+  if ((start > stop) || (stop > array->num))
+    return ARRAY_OUT_OF_BOUNDS;
+
+  for (; start < stop; start += len, out += len) {
+    run = array_run(array, start, &len);
+    len = MIN(len, stop - start);
+
+    memcpy(out, run, len * sizeof(generic_ptr));
+  }
+
+  return ARRAY_OK;
+}
+
+
+int array_sort(array_ptr array, cmp_func_ptr compare)
+{
+  int res;
+  generic_dptr tmp;
+
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+
+  array->layout = ARRAY_LAYOUT_LINEAR;
+  ++ array->stamp;
+
+  if (! IS_SEGMENTED(array)) {
+    array_gap_close(array);
+    qsort((generic_dptr)array->space, array->num, sizeof(generic_ptr),
+          (int (*)(const void *, const void *)) compare);
+    return ARRAY_OK;
+  }
+
+  /* segmented: sort a contiguous copy, then scatter it back */
+  if (! (tmp = (generic_dptr) malloc(MAX(array->num, 1) *
+                                     sizeof(generic_ptr))))
+    return ARRAY_OUT_OF_MEM;
+
+  array_slice(array, 0, array->num, tmp);
+  qsort(tmp, array->num, sizeof(generic_ptr),
+        (int (*)(const void *, const void *)) compare);
+  res = array_copy_in(array, 0, tmp, array->num);
+
+  free(tmp);
+  return res;
+}
+
+
+/* position of the first element not less than 'key' */
+unsigned array_lower_bound(array_ptr array, generic_ptr key)
+{
+  assert(array);
+
+  if (ARRAY_LAYOUT_EYTZINGER == array->layout)
+    return array_eytzinger_bound(array, key, 0);
+
+  return array_bound(array, key, 0);
+}
+
 
-/*   if (! (new = (array_ptr)(malloc(sizeof(array_t))))) */
-/*     return NULL; */
+/* position of the first element greater than 'key' */
+unsigned array_upper_bound(array_ptr array, generic_ptr key)
+{
+  assert(array);
+
+  if (ARRAY_LAYOUT_EYTZINGER == array->layout)
+    return array_eytzinger_bound(array, key, 1);
+
+  return array_bound(array, key, 1);
+}
 
-/*   new->num = old->num; */
-/*   new->n_size = old->num; */
-/*   new->obj_size = old->obj_size; */
-/*   new->index = -new->obj_size; */
 
-/*   fullsize = old->n_size * old->obj_size; */
-/*   if (! (new->space = malloc(fullsize))) */
-/*     return NULL; */
+/* position of an element equal to 'key', -1 if there is none */
+int array_bsearch(array_ptr array, generic_ptr key)
+{
+  unsigned index = array_lower_bound(array, key);
 
-/*   memcpy(new->space, old->space, fullsize); */
-/*   return new; */
-/* } */
+  if ((index < array->num) &&
+      (! array->cmp(*array_slot(array, index), key)))
+    return index;
 
+  return -1;
+}
 
-/* /\* append the elements of array2 to the end of array1 *\/ */
-/* int array_append(array_ptr array1, array_ptr array2) */
-/* { */
-/*   char *pos; */
 
-/*   if (array1->index >= 0) return ARRAY_NESTED_OPERATION; */
-/*   if (array1->obj_size != array2->obj_size) return -2; */
+/* Rearrange a sorted, contiguous array in Eytzinger (BFS) order: the
+   root at 0, children of k at 2k+1 and 2k+2. Searches then touch a
+   predictable, prefetchable path. The array is frozen from now on:
+   mutators fail with ARRAY_BAD_LAYOUT until array_sort. */
+int array_eytzinger(array_ptr array)
+{
+  generic_dptr tmp;
+  assert(array);
 
-/*   /\* make sure array1 has enough room *\/ */
-/*   if (array1->n_size < array1->num + array2->num) { */
-/*     if (array_resize(array1, array1->num + array2->num) == ARRAY_OUT_OF_MEM) { */
-/*       return ARRAY_OUT_OF_MEM; */
-/*     } */
-/*   } */
+  if (IS_SEGMENTED(array)) return ARRAY_BAD_LAYOUT;
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+  if (IS_FROZEN(array)) return ARRAY_OK;
 
-/*   pos = array1->space + array1->num * array1->obj_size; */
-/*   memcpy(pos, array2->space, array2->num * array2->obj_size); */
-/*   array1->num += array2->num; */
+  if (! (tmp = (generic_dptr) malloc(MAX(array->num, 1) *
+                                     sizeof(generic_ptr))))
+    return ARRAY_OUT_OF_MEM;
 
-/*   return 1; */
-/* } */
+  array_gap_close(array);
+  memcpy(tmp, array->space, array->num * sizeof(generic_ptr));
+  array_eytzinger_fill(tmp, array->space, 0, 1, array->num);
+  array->layout = ARRAY_LAYOUT_EYTZINGER;
+  ++ array->stamp;
 
+  free(tmp);
+  return ARRAY_OK;
+}
 
-/* /\* join array1 and array2, returning a new array *\/ */
-/* array_ptr array_join(array_ptr array1, array_ptr array2) */
-/* { */
-/*   array_ptr array; */
-/*   char *pos; */
 
-/*   if (array1->obj_size != array2->obj_size) */
-/*     return ARRAY_NESTED_OPERATION; */
+/* make sure there is room for at least 'size' elements */
+int array_reserve(array_ptr array, unsigned size)
+{
+  assert(array);
 
-/*   if (! array = (array_ptr)(malloc(sizeof(array_t)))) */
-/*     return NULL; */
+  array_gap_close(array);
+  if (size <= array->n_size) return ARRAY_OK;
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
 
-/*   array->num = array1->num + array2->num; */
-/*   array->n_size = array->num; */
-/*   sizeof(generic_ptr) = array1->obj_size; */
-/*   array->index = -sizeof(generic_ptr); */
+  return array_realloc(array, size);
+}
 
-/*   if (! (array->space = malloc(array->n_size * sizeof(generic_ptr)))) { */
-/*     free(array); */
-/*     return NULL; */
-/*   } */
 
-/*   memcpy(array->space, array1->space, array1->num * array1->obj_size); */
-/*   pos = array->space + array1->num * array1->obj_size; */
+/* release unused room at the end of the array */
+int array_shrink_to_fit(array_ptr array)
+{
+  assert(array);
 
-/*   memcpy(pos, array2->space, array2->num * array2->obj_size); */
-/*   return array; */
-/* } */
+  array_gap_close(array);
+  if (array->num == array->n_size) return ARRAY_OK;
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
 
+  return array_realloc(array, MAX(array->num, 1));
+}
 
 
 int array_resize(array_ptr array, unsigned new_size)
 {
-  unsigned old_size;
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+
+  /* segmented arrays grow a block at a time, no need to double */
+  if (IS_SEGMENTED(array)) return array_realloc(array, new_size);
+
+  return array_realloc(array, MAX(array->n_size * 2, new_size));
+}
+
+
+/* drop all but the last of each run of equal elements, which are
+   freed with 'free_func' (if not NULL). 'compare' gets pointers to
+   slots, as in array_sort. */
+int array_uniq(array_ptr array, cmp_func_ptr compare, free_func_ptr free_func)
+{
+  int res = ARRAY_OK;
+  unsigned i, k, n = array->num;
+  generic_dptr items;
+
+  if (IS_READ_ONLY(array)) return ARRAY_READ_ONLY;
+  if (IS_FROZEN(array)) return ARRAY_BAD_LAYOUT;
+  if (n < 2) return ARRAY_OK;
+  ++ array->stamp;
+
+  /* segmented: work on a contiguous copy, then scatter it back */
+  if (IS_SEGMENTED(array)) {
+    if (! (items = (generic_dptr) malloc(n * sizeof(generic_ptr))))
+      return ARRAY_OUT_OF_MEM;
+
+    array_slice(array, 0, n, items);
+  }
+  else {
+    array_gap_close(array);
+    items = array->space;
+  }
+
+  for (i = k = 0; i < n; i ++) {
+    if ((i + 1 < n) && ! (*compare)(items + i, items + i + 1)) {
+      if (free_func != NULL) (*free_func)(items[i]);
+    }
+    else items[k ++] = items[i];
+  }
+
+  if (IS_SEGMENTED(array)) {
+    res = array_copy_in(array, 0, items, k);
+    for (i = k; (ARRAY_OK == res) && (i < n); i ++)
+      res = array_set(array, i, NULL);
+
+    free(items);
+  }
+  else memset(items + k, 0, (n - k) * sizeof(generic_ptr));
+
+  array->num = k;
+  return res;
+}
+
+
+/* -- internal functions ---------------------------------------------------- */
+
+/* common ctor for segmented and sparse arrays */
+static array_ptr array_new_segmented(cmp_func_ptr cmp, free_func_ptr free,
+                                     int sparse)
+{
+  array_ptr array;
+
+  if (! (array = (array_ptr)(malloc(sizeof(array_t)))))
+    return NULL;
+
+  array->cmp = cmp;
+  array->free = free;
+
+  array->num = 0;
+  array->n_size = 0;
+  array->space = NULL;
+  array->layout = ARRAY_LAYOUT_LINEAR;
+  array->stamp = 0;
+  array->gap_start = array->gap_len = 0;
+
+  array->mode = ARRAY_MAP_NONE;
+  array->fd = -1;
+  array->header = NULL;
+
+  array->sparse = sparse;
+  array->n_segments = 0;
+  array->dir_size = ARRAY_INIT_SIZE / sizeof(generic_ptr);
+  if (! (array->segments = (generic_tptr) \
+         calloc(array->dir_size, sizeof(generic_dptr)))) {
+    free(array);
+    return NULL;
+  }
+
+  /* first block */
+  if (ARRAY_OK != array_resegment(array, ARRAY_SEGMENT_SIZE)) {
+    free(array->segments);
+    free(array);
+    return NULL;
+  }
+
+  return array;
+}
+
+/* store 'item' at 'index' of a sparse array, materializing its page
+   on first write and keeping the occupancy bitmap current */
+static inline int array_sparse_set(array_ptr array, unsigned index,
+                                   generic_ptr item)
+{
+  unsigned seg = index >> ARRAY_SEGMENT_SHIFT;
+  unsigned ofs = index & ARRAY_SEGMENT_MASK;
+  unsigned long long mask = 1ULL << (ofs & 63);
+  array_page_ptr page = PAGE_OF(array->segments[seg]);
+
+  if (page == &array_zero_page) {
+    if (! item) return ARRAY_OK;
+    if (! (page = (array_page_ptr) calloc(1, sizeof(array_page_t))))
+      return ARRAY_OUT_OF_MEM;
+
+    array->segments[seg] = page->slots;
+  }
+
+  if (item && ! (page->bits[ofs >> 6] & mask)) {
+    page->bits[ofs >> 6] |= mask;
+    ++ page->used;
+  }
+  else if (! item && (page->bits[ofs >> 6] & mask)) {
+    page->bits[ofs >> 6] &= ~mask;
+    -- page->used;
+  }
+
+  page->slots[ofs] = item;
+  return ARRAY_OK;
+}
+
+/* address of the slot at 'index' */
+static inline generic_dptr array_slot(array_ptr array, unsigned index)
+{
+  if (IS_SEGMENTED(array))
+    return array->segments[index >> ARRAY_SEGMENT_SHIFT] +
+      (index & ARRAY_SEGMENT_MASK);
+
+  if (index >= array->gap_start)
+    return array->space + index + array->gap_len;
+
+  return array->space + index;
+}
+
+/* address of the slot at 'index', (*len) is set to the number of
+   contiguous slots from there to the end of its block */
+static inline generic_dptr array_run(array_ptr array, unsigned index,
+                                     unsigned* len)
+{
+  if (IS_SEGMENTED(array)) {
+    (*len) = ARRAY_SEGMENT_SIZE - (index & ARRAY_SEGMENT_MASK);
+    return array->segments[index >> ARRAY_SEGMENT_SHIFT] +
+      (index & ARRAY_SEGMENT_MASK);
+  }
+
+  if (array->gap_len) {
+    if (index < array->gap_start) {
+      (*len) = array->gap_start - index;
+      return array->space + index;
+    }
+
+    (*len) = array->n_size - array->gap_len - index;
+    return array->space + index + array->gap_len;
+  }
+
+  (*len) = array->n_size - index;
+  return array->space + index;
+}
+
+/* same as array_run, walking backwards to the start of the block */
+static inline generic_dptr array_run_back(array_ptr array, unsigned index,
+                                          unsigned* len)
+{
+  if (IS_SEGMENTED(array)) {
+    (*len) = 1 + (index & ARRAY_SEGMENT_MASK);
+    return array->segments[index >> ARRAY_SEGMENT_SHIFT] +
+      (index & ARRAY_SEGMENT_MASK);
+  }
+
+  if (array->gap_len && index >= array->gap_start) {
+    (*len) = 1 + index - array->gap_start;
+    return array->space + index + array->gap_len;
+  }
+
+  (*len) = 1 + index;
+  return array->space + index;
+}
+
+/* copy 'n' items into the slots starting at 'index', room must have
+   already been made */
+static inline int array_copy_in(array_ptr array, unsigned index,
+                                generic_dptr items, unsigned n)
+{
+  int res;
+  unsigned len;
+  generic_dptr run;
+
+  if (IS_SPARSE(array)) {
+    for (; n; index ++, items ++, n --) {
+      if ((res = array_sparse_set(array, index, *items)) != ARRAY_OK)
+        return res;
+    }
+
+    return ARRAY_OK;
+  }
+
+  for (; n; index += len, items += len, n -= len) {
+    run = array_run(array, index, &len);
+    len = MIN(len, n);
+
+    memcpy(run, items, len * sizeof(generic_ptr));
+  }
+
+  return ARRAY_OK;
+}
+
+/* branchless binary search over a linear sorted array. bias 0
+   yields the lower bound, bias 1 the upper bound. */
+static inline unsigned array_bound(array_ptr array, generic_ptr key,
+                                   int bias)
+{
+  unsigned base = 0, half, n = array->num;
+
+  if (! n) return 0;
+
+  while (n > 1) {
+    half = n >> 1;
+    base = (array->cmp(*array_slot(array, base + half), key) < bias)
+      ? base + half : base;
+    n -= half;
+  }
+
+  return base + (array->cmp(*array_slot(array, base), key) < bias);
+}
+
+/* search over an Eytzinger array, k is 1-based. Going right on every
+   'less' leaves the answer encoded in the trailing ones of k. */
+static inline unsigned array_eytzinger_bound(array_ptr array,
+                                             generic_ptr key, int bias)
+{
+  unsigned k = 1, n = array->num;
+  generic_dptr space = array->space;
+
+  while (k <= n) {
+    PREFETCH(space + k * ARRAY_EYTZINGER_AHEAD);
+    k = 2 * k + (array->cmp(space[k - 1], key) < bias);
+  }
+
+  k >>= ffs(~k);
+  return k ? k - 1 : n;
+}
+
+/* in-order walk of the implicit tree rooted at k (1-based), filling
+   it from the sorted 'in' */
+static unsigned array_eytzinger_fill(generic_dptr in, generic_dptr out,
+                                     unsigned i, unsigned k, unsigned n)
+{
+  if (k <= n) {
+    i = array_eytzinger_fill(in, out, i, 2 * k, n);
+    out[k - 1] = in[i ++];
+    i = array_eytzinger_fill(in, out, i, 2 * k + 1, n);
+  }
+
+  return i;
+}
+
+/* point the iterator at the block holding its next element. Ends
+   the iteration (returns 0) if the array shrank below it. */
+static inline int array_iter_refill(array_iterator_ptr iter)
+{
+  unsigned index = (ARRAY_ITER_FORWARD == iter->dir)
+    ? iter->total - iter->left : iter->left - 1;
+
+  if (index >= iter->array->num) {
+    iter->left = 0;
+    return 0;
+  }
+
+  if (ARRAY_ITER_FORWARD == iter->dir) {
+    iter->next = array_run(iter->array, index, &iter->run);
+    iter->run = MIN(iter->run, iter->array->num - index);
+  }
+  else
+    iter->next = array_run_back(iter->array, index, &iter->run);
+
+  iter->run = MIN(iter->run, iter->left);
+  return 1;
+}
+
+/* an empty heap array with the same storage kind as 'array' */
+static inline array_ptr array_new_like(array_ptr array, unsigned size)
+{
+  array_ptr res;
+
+  if (! IS_SEGMENTED(array))
+    return array_init(size, array->cmp, array->free);
+
+  if ((res = array_new_segmented(array->cmp, array->free, array->sparse)) &&
+      (ARRAY_OK != array_reserve(res, size))) {
+    array_deinit(res);
+    return NULL;
+  }
+
+  return res;
+}
+
+/* store 'item' at 'index', room must have already been made */
+static inline int array_set(array_ptr array, unsigned index,
+                            generic_ptr item)
+{
+  if (IS_SPARSE(array)) return array_sparse_set(array, index, item);
+
+  *array_slot(array, index) = item;
+  return ARRAY_OK;
+}
+
+/* move the gap so that it starts at 'pos' */
+static inline void array_gap_move(array_ptr array, unsigned pos)
+{
+  generic_dptr space = array->space;
+  unsigned gap_len = array->gap_len;
+
+  if (pos < array->gap_start)
+    memmove(space + pos + gap_len, space + pos,
+            (array->gap_start - pos) * sizeof(generic_ptr));
+
+  else if (pos > array->gap_start)
+    memmove(space + array->gap_start, space + array->gap_start + gap_len,
+            (pos - array->gap_start) * sizeof(generic_ptr));
+
+  array->gap_start = pos;
+}
+
+/* move the gap to the end, where it becomes plain spare room again */
+static inline void array_gap_close(array_ptr array)
+{
+  if (! array->gap_len) return;
+  ++ array->stamp;
+
+  array_gap_move(array, array->num);
+  memset(array->space + array->num, 0,
+         array->gap_len * sizeof(generic_ptr));
+
+  array->gap_start = array->gap_len = 0;
+}
+
+/* set storage size to exactly 'new_size' elements, zeroing the tail
+   if the array grew */
+static inline int array_realloc(array_ptr array, unsigned new_size)
+{
+  size_t old_size;
   generic_dptr newspace;
 
+  /* blocks stay where they are, unless released */
+  if (IS_SEGMENTED(array)) {
+    if (new_size < array->n_size) ++ array->stamp;
+    return array_resegment(array, new_size);
+  }
+
+  ++ array->stamp;
+  if (IS_MAPPED(array)) return array_remap(array, new_size);
+
+  array_gap_close(array);
   old_size = array->n_size;
-  array->n_size = MAX(array->n_size * 2, new_size);
 
   if (! (newspace = \
 	 (generic_dptr) realloc(array->space,
-				array->n_size * sizeof(generic_ptr)))) {
-    array->n_size = old_size;
+				new_size * sizeof(generic_ptr))))
     return ARRAY_OUT_OF_MEM;
-  }
 
   array->space = newspace;
-  memset(array->space + old_size * sizeof(generic_ptr), 0,
-	 (array->n_size - old_size) * sizeof(generic_ptr));
+  array->n_size = new_size;
+
+  if (old_size < new_size)
+    memset(array->space + old_size, 0,
+           (new_size - old_size) * sizeof(generic_ptr));
 
   return ARRAY_OK;
 }
 
-void array_sort(array_ptr array, cmp_func_ptr compare)
+/* allocate (or release) blocks so that exactly enough of them are
+   around to hold 'new_size' elements. Only the directory is ever
+   reallocated, blocks stay where they are. */
+static inline int array_resegment(array_ptr array, unsigned new_size)
 {
-  qsort((generic_dptr)array->space, array->num, sizeof(generic_ptr), compare);
-}
+  unsigned needed, dir_size;
+  generic_tptr directory;
+  generic_dptr block;
 
+  needed = (new_size + ARRAY_SEGMENT_MASK) >> ARRAY_SEGMENT_SHIFT;
+  needed = MAX(needed, 1);
 
-void array_uniq(array_ptr array, cmp_func_ptr compare, free_func_ptr free_func)
-{
-  int i, last;
-  generic_ptr dest, obj1, obj2;
+  if (needed > array->dir_size) {
+    dir_size = MAX(array->dir_size * 2, needed);
+    if (! (directory = (generic_tptr) \
+           realloc(array->segments, dir_size * sizeof(generic_dptr))))
+      return ARRAY_OUT_OF_MEM;
 
-  dest = array->space;
-  obj1 = array->space;
-  obj2 = array->space + 1;
-  last = array->num;
+    array->segments = directory;
+    array->dir_size = dir_size;
+  }
 
-  for(i = 1; i < last; i++) {
-    if ((*compare)((char **) obj1, (char **) obj2) != 0) {
-      if (dest != obj1) {
-	memcpy(dest, obj1, sizeof(generic_ptr));
-      }
-      dest ++ ;
-    }
-    else {
-      if (free_func != NULL) (*free_func)(obj1);
-      array->num--;
-    }
-    obj1 ++ ;
-    obj2 ++ ;
+  while (array->n_segments < needed) {
+    /* sparse blocks are materialized on first write */
+    if (IS_SPARSE(array))
+      block = (generic_dptr) array_zero_page.slots;
+
+    else if (! (block = (generic_dptr) \
+                calloc(ARRAY_SEGMENT_SIZE, sizeof(generic_ptr))))
+      return ARRAY_OUT_OF_MEM;
+
+    array->segments[array->n_segments ++] = block;
+    array->n_size = array->n_segments << ARRAY_SEGMENT_SHIFT;
   }
 
-  if (dest != obj1) {
-    memcpy(dest, obj1, sizeof(generic_ptr));
+  while (array->n_segments > needed) {
+    block = array->segments[-- array->n_segments];
+
+    if (! IS_SPARSE(array)) free(block);
+    else if (PAGE_OF(block) != &array_zero_page) free(PAGE_OF(block));
+
+    array->n_size = array->n_segments << ARRAY_SEGMENT_SHIFT;
+  }
+
+  return ARRAY_OK;
+}
+
+/* resize the backing file and the mapping to exactly 'new_size'
+   slots. The file grows zero-filled, so no explicit memset. */
+static inline int array_remap(array_ptr array, unsigned new_size)
+{
+  size_t old_length = MAPPED_LENGTH(array->n_size);
+  size_t new_length = MAPPED_LENGTH(new_size);
+  generic_ptr base;
+
+  /* keep the on-disk count current, the mapping may move */
+  array->header->num = array->num;
+
+  if ((new_length > old_length) &&
+      (ftruncate(array->fd, new_length) < 0))
+    return ARRAY_OUT_OF_MEM;
+
+#ifdef MREMAP_MAYMOVE
+  base = mremap(array->header, old_length, new_length, MREMAP_MAYMOVE);
+#else
+  munmap(array->header, old_length);
+  base = mmap(NULL, new_length, PROT_READ | PROT_WRITE,
+              MAP_SHARED, array->fd, 0);
+#endif
+
+  if (MAP_FAILED == base) {
+#ifndef MREMAP_MAYMOVE
+    /* old mapping is gone, try to restore it */
+    base = mmap(NULL, old_length, PROT_READ | PROT_WRITE,
+                MAP_SHARED, array->fd, 0);
+    assert(MAP_FAILED != base);
+    array->header = (array_header_ptr) base;
+    array->space = (generic_dptr)((char *) base + ARRAY_HEADER_SIZE);
+#endif
+    return ARRAY_OUT_OF_MEM;
   }
+
+  if (new_length < old_length)
+    (void) ftruncate(array->fd, new_length);
+
+  array->header = (array_header_ptr) base;
+  array->space = (generic_dptr)((char *) base + ARRAY_HEADER_SIZE);
+  array->n_size = new_size;
+
+  return ARRAY_OK;
+}
+
+/* default comparison for mapped arrays: raw words */
+static int array_word_cmp(const generic_ptr a, generic_ptr b)
+{
+  return (a < b) ? -1 : (a > b);
 }
@@ -8,33 +8,132 @@
 
 #define ARRAY_INIT_SIZE 1024
 
+/* Segmented arrays: storage is a directory of fixed-size blocks */
+#define ARRAY_SEGMENT_SHIFT 12
+#define ARRAY_SEGMENT_SIZE  (1 << ARRAY_SEGMENT_SHIFT)
+#define ARRAY_SEGMENT_MASK  (ARRAY_SEGMENT_SIZE - 1)
+
+/* Flat arrays larger than this switch to a gap buffer for middle
+   insertions and deletions, smaller ones just memmove */
+#define ARRAY_GAP_THRESHOLD 4096
+
+/* Sparse arrays: pages of ARRAY_SEGMENT_SIZE slots with an occupancy
+   bitmap, allocated on first write */
+#define ARRAY_PAGE_WORDS    (ARRAY_SEGMENT_SIZE / 64)
+
+typedef struct array_page_t {
+  unsigned used;                               /* non-NULL slots */
+  unsigned long long bits[ARRAY_PAGE_WORDS];   /* occupancy      */
+  generic_ptr slots[ARRAY_SEGMENT_SIZE];
+} array_page_t;
+typedef array_page_t* array_page_ptr;
+
 /* Error constants */
 #define ARRAY_OK             0
 #define ARRAY_OUT_OF_BOUNDS -1
 #define ARRAY_OUT_OF_MEM    -2
+#define ARRAY_READ_ONLY     -3
+#define ARRAY_BAD_LAYOUT    -4
+
+/* Element layouts */
+#define ARRAY_LAYOUT_LINEAR     0  /* index order (sorted, if sorted)  */
+#define ARRAY_LAYOUT_EYTZINGER  1  /* sorted, in BFS order of a tree   */
+
+/* Eytzinger search prefetches this many slots ahead of the current
+   node, i.e. a full cache line of descendants a few levels down */
+#define ARRAY_EYTZINGER_AHEAD  (64 / sizeof(generic_ptr))
+
+/* Mapping modes */
+#define ARRAY_MAP_NONE       0  /* plain heap array */
+#define ARRAY_MAP_RDONLY     1  /* shared read-only file mapping */
+#define ARRAY_MAP_RDWR       2  /* shared read-write file mapping */
+
+/* Access pattern hints for mapped arrays */
+#define ARRAY_ADVICE_NORMAL      0
+#define ARRAY_ADVICE_RANDOM      1
+#define ARRAY_ADVICE_SEQUENTIAL  2
+#define ARRAY_ADVICE_WILLNEED    3
+#define ARRAY_ADVICE_DONTNEED    4
+
+/* On-disk header of mapped arrays. Element slots follow the header,
+   which is padded to keep them aligned. */
+#define ARRAY_MAGIC       0x48415252 /* "HARR" */
+#define ARRAY_HEADER_SIZE 64
+
+typedef struct array_header_t {
+  unsigned magic;
+  unsigned word_size;  /* sizeof(generic_ptr) of the writer */
+  unsigned long long num;
+} array_header_t;
+typedef array_header_t* array_header_ptr;
 
 typedef struct array_t {
-  generic_dptr space;
+  generic_dptr space;     /* NULL for segmented arrays */
   cmp_func_ptr cmp;
   free_func_ptr free;
 
   unsigned num;     /* number of array elements.            */
   size_t n_size;    /* size of 'data' array (in objects)    */
+  int layout;       /* one of ARRAY_LAYOUT_xxx              */
+  unsigned stamp;   /* bumped when elements move or go away */
+
+  /* gap buffer, flat heap arrays only. When gap_len > 0, elements
+     from gap_start on are stored gap_len slots further, and the gap
+     spans the whole spare room (n_size == num + gap_len). */
+  unsigned gap_start;
+  unsigned gap_len;
+
+  /* file backing, mapped arrays only */
+  int mode;         /* one of ARRAY_MAP_xxx                 */
+  int fd;           /* -1 for heap arrays                   */
+  array_header_ptr header;
+
+  /* block directory, segmented arrays only */
+  generic_tptr segments;
+  unsigned n_segments;    /* blocks allocated                 */
+  unsigned dir_size;      /* size of 'segments' (in blocks)   */
+  int sparse;             /* blocks are slots of array_page_t */
 } array_t;
 typedef array_t* array_ptr;
 
 typedef struct array_iterator_t {
+  array_ptr array;
 
-  generic_dptr next;
-  generic_dptr last;
+  generic_dptr next;  /* next element to be produced             */
+  unsigned run;       /* elements left in the current block      */
+  unsigned left;      /* elements left overall                   */
+  unsigned total;     /* elements in the array at creation time  */
+  unsigned stamp;     /* array stamp at creation time            */
 
   int dir;
 } array_iterator_t;
 typedef array_iterator_t* array_iterator_ptr;
 
+/* -- Macros ---------------------------------------------------------------- */
+
+/**
+   Generate over all items in an array, using a stack allocated
+   iterator (no malloc/free). 'iter' must be an array_iterator_t.
+*/
+#define array_foreach_item(array, iter, dir, item_p)                          \
+  for(array_iter_init(&(iter), array, dir);                                   \
+      array_iter_next(&(iter), item_p);)
+
+/* -- Interface ------------------------------------------------------------- */
+
 /* ctor */
 array_ptr array_init(unsigned size, cmp_func_ptr cmp, free_func_ptr free);
 
+/* segmented ctor: growth never moves existing elements */
+array_ptr array_init_segmented(cmp_func_ptr cmp, free_func_ptr free);
+
+/* sparse ctor: untouched blocks take no memory, NULL holes are
+   skipped through occupancy bitmaps */
+array_ptr array_init_sparse(cmp_func_ptr cmp, free_func_ptr free);
+
+/* file-backed ctor: slots hold raw pointer-sized words */
+array_ptr array_open_mapped(const char* path, int mode);
+
 /* dctor */
 void array_deinit (array_ptr array);
 
@@ -43,13 +142,23 @@ int array_fetch(array_ptr array, unsigned index, generic_dptr out);
 
 /* setter */
 int array_insert(array_ptr array, unsigned index, generic_ptr obj);
+
+/* middle insertion/deletion, elements are shifted */
+int array_insert_before(array_ptr array, unsigned index, generic_ptr obj);
 int array_delete(array_ptr array, unsigned index, generic_dptr obj);
 
 int array_find(array_ptr array, generic_ptr buf);
 
+/* first non-NULL slot at or after (*index), 0 if there is none */
+int array_next_occupied(array_ptr array, unsigned* index);
+
 /* iterators */
 array_iterator_ptr array_iter(array_ptr array, int dir);
+void array_iter_init(array_iterator_ptr iter, array_ptr array, int dir);
 int array_iter_next(array_iterator_ptr iter, generic_dptr next);
+int array_iter_changed(array_iterator_ptr iter);
+unsigned array_iter_next_batch(array_iterator_ptr iter, generic_dptr out,
+                               unsigned max);
 
 unsigned array_n(const array_ptr array);
 
@@ -62,8 +171,29 @@ void array_iter_deinit(array_iterator_ptr iter);
 array_ptr array_dup(array_ptr old);
 array_ptr array_join (array_ptr array1, array_ptr array2);
 int array_append(array_ptr array1, array_ptr array2);
-void array_sort (array_ptr array, cmp_func_ptr compare);
-void array_uniq (array_ptr array, cmp_func_ptr compare, free_func_ptr free);
+int array_extend(array_ptr array, generic_dptr items, unsigned n);
+int array_slice(array_ptr array, unsigned start, unsigned stop,
+                generic_dptr out);
+int array_sort (array_ptr array, cmp_func_ptr compare);
+int array_uniq (array_ptr array, cmp_func_ptr compare, free_func_ptr free);
+
+/* -- sorted arrays --------------------------------------------------------- */
+/* Elements must be sorted w.r.t. the array's cmp and must not be
+   NULL. Bounds are positions in storage, array_n() if none. Once
+   in Eytzinger layout, mutators fail with ARRAY_BAD_LAYOUT until the
+   array is sorted again. */
+unsigned array_lower_bound(array_ptr array, generic_ptr key);
+unsigned array_upper_bound(array_ptr array, generic_ptr key);
+int array_bsearch(array_ptr array, generic_ptr key);
+int array_eytzinger(array_ptr array);
+
+/* -- capacity management --------------------------------------------------- */
+int array_reserve(array_ptr array, unsigned size);
+int array_shrink_to_fit(array_ptr array);
+
+/* -- mapped arrays --------------------------------------------------------- */
+int array_sync(array_ptr array, int async);
+int array_advise(array_ptr array, int advice);
 
 /* -- internal functions ---------------------------------------------------- */
 int array_resize(array_ptr array, unsigned new_size);
@@ -0,0 +1,1164 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include <stdint.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "art.h"
+
+/* leaves are tagged with the low bit among the children */
+#define IS_LEAF(x)                                                             \
+  (((uintptr_t) (x)) & 1)
+
+#define LEAF_RAW(x)                                                            \
+  ((art_leaf_ptr) (((uintptr_t) (x)) & ~ (uintptr_t) 1))
+
+#define LEAF_TAG(l)                                                            \
+  ((art_node_ptr) (((uintptr_t) (l)) | 1))
+
+#define INITIAL_STACK 16
+
+/* sizes below which nodes shrink, short of the growth points to avoid
+   flapping between sizes */
+#define SHRINK_16   3
+#define SHRINK_48  12
+#define SHRINK_256 37
+
+/* -- internal functions ---------------------------------------------------- */
+static art_leaf_ptr art_leaf_new(const unsigned char* key, size_t len,
+                                 generic_ptr value);
+static inline int art_leaf_matches(const art_leaf_ptr l,
+                                   const unsigned char* key, size_t len);
+static art_node_ptr art_node_new(unsigned char type);
+static void art_node_free(art_node_ptr n, free_func_ptr free_value);
+static inline void art_copy_header(art_node_ptr dst, const art_node_ptr src);
+
+static inline art_node_ptr* art_find_child(art_node_ptr n, unsigned char c);
+static inline unsigned art_node16_lower_bound(const art_node16_ptr p,
+                                              unsigned char c);
+static int art_add_child(art_node_ptr* ref, art_node_ptr n, unsigned char c,
+                         art_node_ptr child);
+static void art_remove_child(art_node_ptr* ref, art_node_ptr n,
+                             unsigned char c, art_node_ptr* child_ref);
+static void art_collapse(art_node_ptr* ref);
+static art_node_ptr art_next_child(const art_node_ptr n, int* pos, int dir);
+
+static inline unsigned art_check_prefix(const art_node_ptr n,
+                                        const unsigned char* key, size_t len,
+                                        size_t depth);
+static unsigned art_prefix_mismatch(const art_node_ptr n,
+                                    const unsigned char* key, size_t len,
+                                    size_t depth);
+static art_leaf_ptr art_minimum(art_node_ptr n);
+static art_leaf_ptr art_maximum(art_node_ptr n);
+
+static int art_insert_rec(art_tree_ptr tree, art_node_ptr* ref,
+                          const unsigned char* key, size_t len, size_t depth,
+                          generic_ptr value, generic_dptr old_p);
+static art_leaf_ptr art_delete_rec(art_node_ptr* ref,
+                                   const unsigned char* key, size_t len,
+                                   size_t depth);
+static int art_iter_push(art_iterator_ptr iter, art_node_ptr n);
+
+art_tree_ptr art_init(void)
+{
+  art_tree_ptr tree;
+
+  if (! (tree = (art_tree_ptr) malloc(sizeof(art_tree_t))))
+    return NULL;
+
+  tree->root = NULL;
+  tree->num = 0;
+
+  return tree;
+}
+
+
+void art_deinit(art_tree_ptr tree, free_func_ptr free_value)
+{
+  CHECK_INSTANCE(tree);
+
+  art_clear(tree, free_value);
+  free(tree);
+}
+
+
+void art_clear(art_tree_ptr tree, free_func_ptr free_value)
+{
+  CHECK_INSTANCE(tree);
+
+  if (tree->root)
+    art_node_free(tree->root, free_value);
+
+  tree->root = NULL;
+  tree->num = 0;
+}
+
+
+int art_insert(art_tree_ptr tree, const unsigned char* key, size_t len,
+               generic_ptr value, generic_dptr old_p)
+{
+  CHECK_INSTANCE(tree);
+
+  return art_insert_rec(tree, &tree->root, key, len, 0, value, old_p);
+}
+
+
+int art_find(art_tree_ptr tree, const unsigned char* key, size_t len,
+             generic_dptr value_p)
+{
+  art_node_ptr n;
+  art_node_ptr* child;
+  art_leaf_ptr l = NULL;
+  size_t depth = 0;
+
+  CHECK_INSTANCE(tree);
+
+  n = tree->root;
+  while (n) {
+    if (IS_LEAF(n)) {
+      l = LEAF_RAW(n);
+      break;
+    }
+
+    /* bytes past the stored prefix are checked at the leaf */
+    if (n->prefix_len) {
+      if (art_check_prefix(n, key, len, depth) !=
+          MIN(n->prefix_len, ART_MAX_PREFIX))
+        return 0;
+
+      depth += n->prefix_len;
+      if (depth > len)
+        return 0;
+    }
+
+    if (depth == len) {
+      l = n->leaf;
+      break;
+    }
+
+    if (! (child = art_find_child(n, key[depth])))
+      return 0;
+
+    n = *child;
+    ++ depth;
+  }
+
+  if (! l || ! art_leaf_matches(l, key, len))
+    return 0;
+
+  if (value_p)
+    *value_p = l->value;
+
+  return 1;
+}
+
+
+int art_delete(art_tree_ptr tree, const unsigned char* key, size_t len,
+               generic_dptr value_p)
+{
+  art_leaf_ptr l;
+
+  CHECK_INSTANCE(tree);
+
+  if (! (l = art_delete_rec(&tree->root, key, len, 0)))
+    return 0;
+
+  if (value_p)
+    *value_p = l->value;
+
+  free(l);
+  -- tree->num;
+  return 1;
+}
+
+
+int art_longest_prefix(art_tree_ptr tree,
+                       const unsigned char* key, size_t len,
+                       size_t* match_len, generic_dptr value_p)
+{
+  art_node_ptr n;
+  art_node_ptr* child;
+  art_leaf_ptr l, best = NULL;
+  size_t depth = 0;
+
+  CHECK_INSTANCE(tree);
+
+  /* candidates are verified in full, so that an optimistic skip over a
+     long prefix can not produce a wrong match */
+  n = tree->root;
+  while (n) {
+    if (IS_LEAF(n)) {
+      l = LEAF_RAW(n);
+      if (l->len <= len && ! memcmp(l->key, key, l->len))
+        best = l;
+      break;
+    }
+
+    if (n->prefix_len) {
+      if (art_check_prefix(n, key, len, depth) !=
+          MIN(n->prefix_len, ART_MAX_PREFIX))
+        break;
+
+      depth += n->prefix_len;
+      if (depth > len)
+        break;
+    }
+
+    l = n->leaf;
+    if (l && l->len <= len && ! memcmp(l->key, key, l->len))
+      best = l;
+
+    if (depth == len || ! (child = art_find_child(n, key[depth])))
+      break;
+
+    n = *child;
+    ++ depth;
+  }
+
+  if (! best)
+    return 0;
+
+  if (match_len)
+    *match_len = best->len;
+
+  if (value_p)
+    *value_p = best->value;
+
+  return 1;
+}
+
+
+int art_first(art_tree_ptr tree, const unsigned char** key_p,
+              size_t* len_p, generic_dptr value_p)
+{
+  art_leaf_ptr l;
+
+  CHECK_INSTANCE(tree);
+
+  if (! tree->root)
+    return 0;
+
+  l = art_minimum(tree->root);
+
+  if (key_p)
+    *key_p = l->key;
+  if (len_p)
+    *len_p = l->len;
+  if (value_p)
+    *value_p = l->value;
+
+  return 1;
+}
+
+
+int art_last(art_tree_ptr tree, const unsigned char** key_p,
+             size_t* len_p, generic_dptr value_p)
+{
+  art_leaf_ptr l;
+
+  CHECK_INSTANCE(tree);
+
+  if (! tree->root)
+    return 0;
+
+  l = art_maximum(tree->root);
+
+  if (key_p)
+    *key_p = l->key;
+  if (len_p)
+    *len_p = l->len;
+  if (value_p)
+    *value_p = l->value;
+
+  return 1;
+}
+
+
+size_t art_count(art_tree_ptr tree)
+{
+  CHECK_INSTANCE(tree);
+
+  return tree->num;
+}
+
+
+art_iterator_ptr art_iter(art_tree_ptr tree,
+                          const unsigned char* prefix, size_t len,
+                          int dir)
+{
+  art_iterator_ptr iter;
+  art_node_ptr n;
+  art_node_ptr* child;
+  art_leaf_ptr l;
+  const unsigned char* p;
+  size_t depth = 0, k;
+
+  CHECK_INSTANCE(tree);
+
+  if (! (iter = (art_iterator_ptr) malloc(sizeof(art_iterator_t))))
+    return NULL;
+
+  if (! (iter->stack = (art_frame_t*)
+         malloc(INITIAL_STACK * sizeof(art_frame_t)))) {
+    free(iter);
+    return NULL;
+  }
+
+  iter->size = INITIAL_STACK;
+  iter->depth = 0;
+  iter->dir = dir;
+
+  /* find the subtree of the keys starting with prefix */
+  n = tree->root;
+  while (n) {
+    if (IS_LEAF(n)) {
+      l = LEAF_RAW(n);
+      if (l->len < len || (len && memcmp(l->key, prefix, len)))
+        n = NULL;
+      break;
+    }
+
+    if (depth == len)
+      break;
+
+    if (n->prefix_len) {
+      k = MIN(n->prefix_len, len - depth);
+      p = n->prefix_len > ART_MAX_PREFIX
+        ? art_minimum(n)->key + depth : n->prefix;
+
+      if (memcmp(p, prefix + depth, k)) {
+        n = NULL;
+        break;
+      }
+
+      depth += n->prefix_len;
+      if (depth >= len)
+        break;
+    }
+
+    if (! (child = art_find_child(n, prefix[depth]))) {
+      n = NULL;
+      break;
+    }
+
+    n = *child;
+    ++ depth;
+  }
+
+  if (n)
+    art_iter_push(iter, n);
+
+  return iter;
+}
+
+
+void art_iter_free(art_iterator_ptr iter)
+{
+  CHECK_INSTANCE(iter);
+
+  free(iter->stack);
+  free(iter);
+}
+
+
+int art_iter_next(art_iterator_ptr iter, const unsigned char** key_p,
+                  size_t* len_p, generic_dptr value_p)
+{
+  art_frame_t* f;
+  art_node_ptr n, child;
+  art_leaf_ptr l = NULL;
+
+  CHECK_INSTANCE(iter);
+
+  /* frames start at pos -2; forward, the leaf slot comes first (pos
+     -1), then the children; backward, the children come first, from
+     the top, then the leaf slot */
+  while (! l && iter->depth) {
+    f = &iter->stack[iter->depth - 1];
+    n = f->node;
+
+    if (IS_LEAF(n)) {
+      -- iter->depth;
+      l = LEAF_RAW(n);
+      break;
+    }
+
+    if (iter->dir == ART_ITER_FORWARD) {
+      if (f->pos == -2) {
+        f->pos = -1;
+        if (n->leaf) {
+          l = n->leaf;
+          break;
+        }
+      }
+
+      if ((child = art_next_child(n, &f->pos, iter->dir))) {
+        if (art_iter_push(iter, child) != ART_OK)
+          return ART_OUT_OF_MEM;
+      }
+      else
+        -- iter->depth;
+    }
+    else {
+      if (f->pos == -2)
+        f->pos = 256;
+
+      if ((child = art_next_child(n, &f->pos, iter->dir))) {
+        if (art_iter_push(iter, child) != ART_OK)
+          return ART_OUT_OF_MEM;
+      }
+      else {
+        -- iter->depth;
+        l = n->leaf;
+      }
+    }
+  }
+
+  if (! l)
+    return 0;
+
+  if (key_p)
+    *key_p = l->key;
+  if (len_p)
+    *len_p = l->len;
+  if (value_p)
+    *value_p = l->value;
+
+  return 1;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static art_leaf_ptr art_leaf_new(const unsigned char* key, size_t len,
+                                 generic_ptr value)
+{
+  art_leaf_ptr l;
+
+  if (! (l = (art_leaf_ptr) malloc(sizeof(art_leaf_t) + len)))
+    return NULL;
+
+  /* leaves are tagged in their low bit */
+  assert(! IS_LEAF(l));
+
+  l->value = value;
+  l->len = len;
+  memcpy(l->key, key, len);
+
+  return l;
+}
+
+
+static inline int art_leaf_matches(const art_leaf_ptr l,
+                                   const unsigned char* key, size_t len)
+{
+  return l->len == len && ! memcmp(l->key, key, len);
+}
+
+
+static art_node_ptr art_node_new(unsigned char type)
+{
+  art_node_ptr n;
+  size_t size;
+
+  switch (type) {
+  case ART_NODE4:   size = sizeof(art_node4_t);   break;
+  case ART_NODE16:  size = sizeof(art_node16_t);  break;
+  case ART_NODE48:  size = sizeof(art_node48_t);  break;
+  default:          size = sizeof(art_node256_t); break;
+  }
+
+  if (! (n = (art_node_ptr) calloc(1, size)))
+    return NULL;
+
+  n->type = type;
+  return n;
+}
+
+
+static void art_node_free(art_node_ptr n, free_func_ptr free_value)
+{
+  art_node_ptr child;
+  int pos = -1;
+
+  if (IS_LEAF(n)) {
+    if (free_value)
+      free_value(LEAF_RAW(n)->value);
+    free(LEAF_RAW(n));
+    return;
+  }
+
+  while ((child = art_next_child(n, &pos, ART_ITER_FORWARD)))
+    art_node_free(child, free_value);
+
+  if (n->leaf)
+    art_node_free(LEAF_TAG(n->leaf), free_value);
+
+  free(n);
+}
+
+
+static inline void art_copy_header(art_node_ptr dst, const art_node_ptr src)
+{
+  dst->num = src->num;
+  dst->prefix_len = src->prefix_len;
+  memcpy(dst->prefix, src->prefix, MIN(src->prefix_len, ART_MAX_PREFIX));
+  dst->leaf = src->leaf;
+}
+
+
+static inline art_node_ptr* art_find_child(art_node_ptr n, unsigned char c)
+{
+  unsigned i;
+
+  switch (n->type) {
+  case ART_NODE4: {
+    art_node4_ptr p = (art_node4_ptr) n;
+    for (i = 0; i < n->num; ++ i)
+      if (p->keys[i] == c)
+        return &p->children[i];
+    return NULL;
+  }
+
+  case ART_NODE16: {
+    art_node16_ptr p = (art_node16_ptr) n;
+#ifdef __SSE2__
+    /* compare all 16 key bytes at once */
+    unsigned bits = _mm_movemask_epi8(
+      _mm_cmpeq_epi8(_mm_set1_epi8((char) c),
+                     _mm_loadu_si128((const __m128i*) p->keys)))
+      & ((1U << n->num) - 1);
+
+    return bits ? &p->children[CTZ64(bits)] : NULL;
+#else
+    for (i = 0; i < n->num; ++ i)
+      if (p->keys[i] == c)
+        return &p->children[i];
+    return NULL;
+#endif
+  }
+
+  case ART_NODE48: {
+    art_node48_ptr p = (art_node48_ptr) n;
+    return p->index[c] ? &p->children[p->index[c] - 1] : NULL;
+  }
+
+  default: {
+    art_node256_ptr p = (art_node256_ptr) n;
+    return p->children[c] ? &p->children[c] : NULL;
+  }
+  }
+}
+
+
+/* the position of the first key byte greater than c */
+static inline unsigned art_node16_lower_bound(const art_node16_ptr p,
+                                              unsigned char c)
+{
+#ifdef __SSE2__
+  /* SSE2 compares signed bytes: flip the sign bits to compare unsigned */
+  const __m128i bias = _mm_set1_epi8((char) 0x80);
+  unsigned bits = _mm_movemask_epi8(
+    _mm_cmpgt_epi8(
+      _mm_xor_si128(_mm_loadu_si128((const __m128i*) p->keys), bias),
+      _mm_xor_si128(_mm_set1_epi8((char) c), bias)))
+    & ((1U << p->n.num) - 1);
+
+  return bits ? (unsigned) CTZ64(bits) : p->n.num;
+#else
+  unsigned i;
+
+  for (i = 0; i < p->n.num && p->keys[i] < c; ++ i)
+    ;
+  return i;
+#endif
+}
+
+
+static int art_add_child(art_node_ptr* ref, art_node_ptr n, unsigned char c,
+                         art_node_ptr child)
+{
+  art_node_ptr grown;
+  unsigned i;
+
+  switch (n->type) {
+  case ART_NODE4: {
+    art_node4_ptr p = (art_node4_ptr) n;
+
+    if (n->num < 4) {
+      for (i = 0; i < n->num && p->keys[i] < c; ++ i)
+        ;
+      memmove(p->keys + i + 1, p->keys + i, n->num - i);
+      memmove(p->children + i + 1, p->children + i,
+              (n->num - i) * sizeof(art_node_ptr));
+      p->keys[i] = c;
+      p->children[i] = child;
+      ++ n->num;
+      return ART_OK;
+    }
+
+    if (! (grown = art_node_new(ART_NODE16)))
+      return ART_OUT_OF_MEM;
+
+    art_copy_header(grown, n);
+    memcpy(((art_node16_ptr) grown)->keys, p->keys, 4);
+    memcpy(((art_node16_ptr) grown)->children, p->children,
+           4 * sizeof(art_node_ptr));
+    break;
+  }
+
+  case ART_NODE16: {
+    art_node16_ptr p = (art_node16_ptr) n;
+
+    if (n->num < 16) {
+      i = art_node16_lower_bound(p, c);
+      memmove(p->keys + i + 1, p->keys + i, n->num - i);
+      memmove(p->children + i + 1, p->children + i,
+              (n->num - i) * sizeof(art_node_ptr));
+      p->keys[i] = c;
+      p->children[i] = child;
+      ++ n->num;
+      return ART_OK;
+    }
+
+    if (! (grown = art_node_new(ART_NODE48)))
+      return ART_OUT_OF_MEM;
+
+    art_copy_header(grown, n);
+    for (i = 0; i < 16; ++ i) {
+      ((art_node48_ptr) grown)->index[p->keys[i]] = i + 1;
+      ((art_node48_ptr) grown)->children[i] = p->children[i];
+    }
+    break;
+  }
+
+  case ART_NODE48: {
+    art_node48_ptr p = (art_node48_ptr) n;
+
+    if (n->num < 48) {
+      /* removals leave holes */
+      for (i = 0; p->children[i]; ++ i)
+        ;
+      p->children[i] = child;
+      p->index[c] = i + 1;
+      ++ n->num;
+      return ART_OK;
+    }
+
+    if (! (grown = art_node_new(ART_NODE256)))
+      return ART_OUT_OF_MEM;
+
+    art_copy_header(grown, n);
+    for (i = 0; i < 256; ++ i)
+      if (p->index[i])
+        ((art_node256_ptr) grown)->children[i] = p->children[p->index[i] - 1];
+    break;
+  }
+
+  default:
+    ((art_node256_ptr) n)->children[c] = child;
+    ++ n->num;
+    return ART_OK;
+  }
+
+  free(n);
+  *ref = grown;
+  return art_add_child(ref, grown, c, child);
+}
+
+
+static void art_remove_child(art_node_ptr* ref, art_node_ptr n,
+                             unsigned char c, art_node_ptr* child_ref)
+{
+  art_node_ptr shrunk = NULL;
+  unsigned i, j;
+
+  switch (n->type) {
+  case ART_NODE4:
+  case ART_NODE16: {
+    unsigned char* keys = n->type == ART_NODE4
+      ? ((art_node4_ptr) n)->keys : ((art_node16_ptr) n)->keys;
+    art_node_ptr* children = n->type == ART_NODE4
+      ? ((art_node4_ptr) n)->children : ((art_node16_ptr) n)->children;
+
+    i = child_ref - children;
+    memmove(keys + i, keys + i + 1, n->num - i - 1);
+    memmove(children + i, children + i + 1,
+            (n->num - i - 1) * sizeof(art_node_ptr));
+    -- n->num;
+
+    if (n->type == ART_NODE4) {
+      art_collapse(ref);
+      return;
+    }
+
+    if (n->num > SHRINK_16 || ! (shrunk = art_node_new(ART_NODE4)))
+      return;
+
+    art_copy_header(shrunk, n);
+    memcpy(((art_node4_ptr) shrunk)->keys, keys, n->num);
+    memcpy(((art_node4_ptr) shrunk)->children, children,
+           n->num * sizeof(art_node_ptr));
+    break;
+  }
+
+  case ART_NODE48: {
+    art_node48_ptr p = (art_node48_ptr) n;
+
+    p->children[p->index[c] - 1] = NULL;
+    p->index[c] = 0;
+    -- n->num;
+
+    if (n->num > SHRINK_48 || ! (shrunk = art_node_new(ART_NODE16)))
+      return;
+
+    art_copy_header(shrunk, n);
+    for (i = j = 0; i < 256; ++ i)
+      if (p->index[i]) {
+        ((art_node16_ptr) shrunk)->keys[j] = i;
+        ((art_node16_ptr) shrunk)->children[j ++] =
+          p->children[p->index[i] - 1];
+      }
+    break;
+  }
+
+  default: {
+    art_node256_ptr p = (art_node256_ptr) n;
+
+    p->children[c] = NULL;
+    -- n->num;
+
+    if (n->num > SHRINK_256 || ! (shrunk = art_node_new(ART_NODE48)))
+      return;
+
+    art_copy_header(shrunk, n);
+    for (i = j = 0; i < 256; ++ i)
+      if (p->children[i]) {
+        ((art_node48_ptr) shrunk)->children[j] = p->children[i];
+        ((art_node48_ptr) shrunk)->index[i] = ++ j;
+      }
+    break;
+  }
+  }
+
+  /* when out of memory, the node just stays bigger */
+  free(n);
+  *ref = shrunk;
+}
+
+
+/* replace a Node4 left with a single child or leaf by it, merging the
+   prefixes */
+static void art_collapse(art_node_ptr* ref)
+{
+  art_node4_ptr p = (art_node4_ptr) *ref;
+  art_node_ptr child;
+  unsigned char buf[ART_MAX_PREFIX];
+  unsigned k;
+
+  assert(p->n.type == ART_NODE4);
+  if (p->n.num + (p->n.leaf != NULL) != 1)
+    return;
+
+  if (! p->n.num)
+    child = LEAF_TAG(p->n.leaf);
+
+  else {
+    child = p->children[0];
+
+    /* leaves have the whole key, inner nodes get this prefix, the
+       branch byte and their own prefix */
+    if (! IS_LEAF(child)) {
+      k = MIN(p->n.prefix_len, ART_MAX_PREFIX);
+      memcpy(buf, p->n.prefix, k);
+      if (k < ART_MAX_PREFIX)
+        buf[k ++] = p->keys[0];
+      if (k < ART_MAX_PREFIX) {
+        memcpy(buf + k, child->prefix,
+               MIN(child->prefix_len, ART_MAX_PREFIX - k));
+        k += MIN(child->prefix_len, ART_MAX_PREFIX - k);
+      }
+
+      memcpy(child->prefix, buf, k);
+      child->prefix_len += p->n.prefix_len + 1;
+    }
+  }
+
+  free(p);
+  *ref = child;
+}
+
+
+/* the child after (or before, backward) position pos, updated; NULL
+   when there are no more. Positions are indexes for Node4 and Node16,
+   key bytes for Node48 and Node256 */
+static art_node_ptr art_next_child(const art_node_ptr n, int* pos, int dir)
+{
+  int i;
+
+  if (dir == ART_ITER_FORWARD) {
+    i = *pos + 1;
+
+    switch (n->type) {
+    case ART_NODE4:
+      if (i < n->num)
+        return ((art_node4_ptr) n)->children[*pos = i];
+      break;
+
+    case ART_NODE16:
+      if (i < n->num)
+        return ((art_node16_ptr) n)->children[*pos = i];
+      break;
+
+    case ART_NODE48: {
+      art_node48_ptr p = (art_node48_ptr) n;
+      for (; i < 256; ++ i)
+        if (p->index[i]) {
+          *pos = i;
+          return p->children[p->index[i] - 1];
+        }
+      break;
+    }
+
+    default: {
+      art_node256_ptr p = (art_node256_ptr) n;
+      for (; i < 256; ++ i)
+        if (p->children[i]) {
+          *pos = i;
+          return p->children[i];
+        }
+      break;
+    }
+    }
+
+    *pos = 256;
+    return NULL;
+  }
+
+  i = *pos - 1;
+
+  switch (n->type) {
+  case ART_NODE4:
+    i = MIN(i, n->num - 1);
+    if (i >= 0)
+      return ((art_node4_ptr) n)->children[*pos = i];
+    break;
+
+  case ART_NODE16:
+    i = MIN(i, n->num - 1);
+    if (i >= 0)
+      return ((art_node16_ptr) n)->children[*pos = i];
+    break;
+
+  case ART_NODE48: {
+    art_node48_ptr p = (art_node48_ptr) n;
+    for (; i >= 0; -- i)
+      if (p->index[i]) {
+        *pos = i;
+        return p->children[p->index[i] - 1];
+      }
+    break;
+  }
+
+  default: {
+    art_node256_ptr p = (art_node256_ptr) n;
+    for (; i >= 0; -- i)
+      if (p->children[i]) {
+        *pos = i;
+        return p->children[i];
+      }
+    break;
+  }
+  }
+
+  *pos = -1;
+  return NULL;
+}
+
+
+/* the number of stored prefix bytes matching the key at depth */
+static inline unsigned art_check_prefix(const art_node_ptr n,
+                                        const unsigned char* key, size_t len,
+                                        size_t depth)
+{
+  unsigned i, max = MIN(MIN(n->prefix_len, ART_MAX_PREFIX), len - depth);
+
+  for (i = 0; i < max; ++ i)
+    if (n->prefix[i] != key[depth + i])
+      return i;
+
+  return max;
+}
+
+
+/* the number of prefix bytes matching the key at depth; bytes past the
+   stored ones come from any leaf below, all of them share the prefix */
+static unsigned art_prefix_mismatch(const art_node_ptr n,
+                                    const unsigned char* key, size_t len,
+                                    size_t depth)
+{
+  art_leaf_ptr l;
+  unsigned i = art_check_prefix(n, key, len, depth);
+  size_t max;
+
+  if (i < ART_MAX_PREFIX || n->prefix_len <= ART_MAX_PREFIX)
+    return i;
+
+  l = art_minimum(n);
+  max = MIN(MIN(l->len, len) - depth, n->prefix_len);
+  for (; i < max; ++ i)
+    if (l->key[depth + i] != key[depth + i])
+      return i;
+
+  return i;
+}
+
+
+static art_leaf_ptr art_minimum(art_node_ptr n)
+{
+  int pos;
+
+  /* a key ending at a node is smaller than any below it */
+  while (! IS_LEAF(n)) {
+    if (n->leaf)
+      return n->leaf;
+
+    pos = -1;
+    n = art_next_child(n, &pos, ART_ITER_FORWARD);
+  }
+
+  return LEAF_RAW(n);
+}
+
+
+static art_leaf_ptr art_maximum(art_node_ptr n)
+{
+  art_node_ptr child;
+  int pos;
+
+  while (! IS_LEAF(n)) {
+    pos = 256;
+    if (! (child = art_next_child(n, &pos, ART_ITER_BACKWARD)))
+      return n->leaf;
+
+    n = child;
+  }
+
+  return LEAF_RAW(n);
+}
+
+
+static int art_insert_rec(art_tree_ptr tree, art_node_ptr* ref,
+                          const unsigned char* key, size_t len, size_t depth,
+                          generic_ptr value, generic_dptr old_p)
+{
+  art_node_ptr n = *ref, nn;
+  art_node_ptr* child;
+  art_leaf_ptr l, nl;
+  unsigned p;
+  unsigned char c;
+
+  if (! n) {
+    if (! (nl = art_leaf_new(key, len, value)))
+      return ART_OUT_OF_MEM;
+
+    *ref = LEAF_TAG(nl);
+    ++ tree->num;
+    return ART_OK;
+  }
+
+  if (IS_LEAF(n)) {
+    l = LEAF_RAW(n);
+
+    if (art_leaf_matches(l, key, len)) {
+      if (old_p)
+        *old_p = l->value;
+      l->value = value;
+      return ART_REPLACED;
+    }
+
+    /* split the leaf, on a node holding the common part of the keys */
+    if (! (nl = art_leaf_new(key, len, value)))
+      return ART_OUT_OF_MEM;
+
+    if (! (nn = art_node_new(ART_NODE4))) {
+      free(nl);
+      return ART_OUT_OF_MEM;
+    }
+
+    for (p = 0; depth + p < MIN(l->len, len) &&
+           l->key[depth + p] == key[depth + p]; ++ p)
+      ;
+
+    nn->prefix_len = p;
+    memcpy(nn->prefix, key + depth, MIN(p, ART_MAX_PREFIX));
+    depth += p;
+
+    if (l->len == depth)
+      nn->leaf = l;
+    else
+      art_add_child(&nn, nn, l->key[depth], n);
+
+    if (len == depth)
+      nn->leaf = nl;
+    else
+      art_add_child(&nn, nn, key[depth], LEAF_TAG(nl));
+
+    *ref = nn;
+    ++ tree->num;
+    return ART_OK;
+  }
+
+  if (n->prefix_len) {
+    p = art_prefix_mismatch(n, key, len, depth);
+
+    if (p < n->prefix_len) {
+      /* split the prefix, on a node holding its matching part */
+      if (! (nl = art_leaf_new(key, len, value)))
+        return ART_OUT_OF_MEM;
+
+      if (! (nn = art_node_new(ART_NODE4))) {
+        free(nl);
+        return ART_OUT_OF_MEM;
+      }
+
+      nn->prefix_len = p;
+      memcpy(nn->prefix, n->prefix, MIN(p, ART_MAX_PREFIX));
+
+      if (n->prefix_len <= ART_MAX_PREFIX) {
+        c = n->prefix[p];
+        n->prefix_len -= p + 1;
+        memmove(n->prefix, n->prefix + p + 1, n->prefix_len);
+      }
+      else {
+        l = art_minimum(n);
+        c = l->key[depth + p];
+        n->prefix_len -= p + 1;
+        memcpy(n->prefix, l->key + depth + p + 1,
+               MIN(n->prefix_len, ART_MAX_PREFIX));
+      }
+
+      art_add_child(&nn, nn, c, n);
+
+      if (len == depth + p)
+        nn->leaf = nl;
+      else
+        art_add_child(&nn, nn, key[depth + p], LEAF_TAG(nl));
+
+      *ref = nn;
+      ++ tree->num;
+      return ART_OK;
+    }
+
+    depth += n->prefix_len;
+  }
+
+  if (depth == len) {
+    if (n->leaf) {
+      if (old_p)
+        *old_p = n->leaf->value;
+      n->leaf->value = value;
+      return ART_REPLACED;
+    }
+
+    if (! (n->leaf = art_leaf_new(key, len, value)))
+      return ART_OUT_OF_MEM;
+
+    ++ tree->num;
+    return ART_OK;
+  }
+
+  if ((child = art_find_child(n, key[depth])))
+    return art_insert_rec(tree, child, key, len, depth + 1, value, old_p);
+
+  if (! (nl = art_leaf_new(key, len, value)))
+    return ART_OUT_OF_MEM;
+
+  if (art_add_child(ref, n, key[depth], LEAF_TAG(nl)) != ART_OK) {
+    free(nl);
+    return ART_OUT_OF_MEM;
+  }
+
+  ++ tree->num;
+  return ART_OK;
+}
+
+
+/* the leaf of key, unlinked, NULL if not found */
+static art_leaf_ptr art_delete_rec(art_node_ptr* ref,
+                                   const unsigned char* key, size_t len,
+                                   size_t depth)
+{
+  art_node_ptr n = *ref;
+  art_node_ptr* child;
+  art_leaf_ptr l;
+
+  if (! n)
+    return NULL;
+
+  if (IS_LEAF(n)) {
+    l = LEAF_RAW(n);
+    if (! art_leaf_matches(l, key, len))
+      return NULL;
+
+    *ref = NULL;
+    return l;
+  }
+
+  if (n->prefix_len) {
+    if (art_check_prefix(n, key, len, depth) !=
+        MIN(n->prefix_len, ART_MAX_PREFIX))
+      return NULL;
+
+    depth += n->prefix_len;
+    if (depth > len)
+      return NULL;
+  }
+
+  if (depth == len) {
+    l = n->leaf;
+    if (! l || ! art_leaf_matches(l, key, len))
+      return NULL;
+
+    n->leaf = NULL;
+    if (n->type == ART_NODE4)
+      art_collapse(ref);
+
+    return l;
+  }
+
+  if (! (child = art_find_child(n, key[depth])))
+    return NULL;
+
+  if (! IS_LEAF(*child))
+    return art_delete_rec(child, key, len, depth + 1);
+
+  l = LEAF_RAW(*child);
+  if (! art_leaf_matches(l, key, len))
+    return NULL;
+
+  art_remove_child(ref, n, key[depth], child);
+  return l;
+}
+
+
+static int art_iter_push(art_iterator_ptr iter, art_node_ptr n)
+{
+  art_frame_t* stack;
+
+  if (iter->depth == iter->size) {
+    if (! (stack = (art_frame_t*)
+           realloc(iter->stack, 2 * iter->size * sizeof(art_frame_t))))
+      return ART_OUT_OF_MEM;
+
+    iter->stack = stack;
+    iter->size *= 2;
+  }
+
+  iter->stack[iter->depth].node = n;
+  iter->stack[iter->depth ++].pos = -2;
+  return ART_OK;
+}
@@ -0,0 +1,151 @@
+#ifndef ART_H
+#define ART_H
+
+#include "common.h"
+
+/* Adaptive radix tree (Leis et al.) over byte-string keys.
+
+   Inner nodes branch on one key byte and come in four sizes: Node4
+   and Node16 keep sorted key bytes next to their children, Node48 maps
+   bytes to 48 child slots, Node256 is a plain array. Nodes grow and
+   shrink between sizes as children come and go. Single-child paths
+   are compressed into a per-node prefix, of which only the first
+   ART_MAX_PREFIX bytes are stored: lookups skip the rest and check
+   the whole key at the leaf.
+
+   Leaves hold a copy of the key and are tagged pointers (low bit set)
+   among the children. A key which is a proper prefix of other keys is
+   kept in the leaf slot of the node where it ends, so keys may contain
+   any byte, 0 included. Iteration is in lexicographic byte order,
+   shorter keys first. */
+
+#define ART_ITER_FORWARD   0
+#define ART_ITER_BACKWARD  1
+
+#define ART_MAX_PREFIX     10
+
+#define ART_NODE4          0
+#define ART_NODE16         1
+#define ART_NODE48         2
+#define ART_NODE256        3
+
+/* Error constants */
+#define ART_OK             0
+#define ART_REPLACED       1
+#define ART_OUT_OF_MEM    -2
+
+typedef struct art_leaf_t {
+  generic_ptr value;
+  size_t len;
+  unsigned char key[];
+} art_leaf_t;
+typedef art_leaf_t* art_leaf_ptr;
+
+/* common header of inner nodes */
+typedef struct art_node_t {
+  unsigned char type;
+  unsigned short num;          /* children                             */
+  unsigned prefix_len;         /* may exceed ART_MAX_PREFIX            */
+  unsigned char prefix[ART_MAX_PREFIX];
+  art_leaf_ptr leaf;           /* key ending at this node, if any      */
+} art_node_t;
+typedef art_node_t* art_node_ptr;
+
+typedef struct art_node4_t {
+  art_node_t n;
+  unsigned char keys[4];
+  art_node_ptr children[4];
+} art_node4_t;
+typedef art_node4_t* art_node4_ptr;
+
+typedef struct art_node16_t {
+  art_node_t n;
+  unsigned char keys[16];
+  art_node_ptr children[16];
+} art_node16_t;
+typedef art_node16_t* art_node16_ptr;
+
+typedef struct art_node48_t {
+  art_node_t n;
+  unsigned char index[256];    /* 0 for no child, else slot + 1        */
+  art_node_ptr children[48];
+} art_node48_t;
+typedef art_node48_t* art_node48_ptr;
+
+typedef struct art_node256_t {
+  art_node_t n;
+  art_node_ptr children[256];
+} art_node256_t;
+typedef art_node256_t* art_node256_ptr;
+
+typedef struct art_tree_t {
+  art_node_ptr root;
+  size_t num;
+} art_tree_t;
+typedef art_tree_t* art_tree_ptr;
+
+typedef struct art_frame_t {
+  art_node_ptr node;
+  int pos;
+} art_frame_t;
+
+typedef struct art_iterator_t {
+  art_frame_t* stack;
+  size_t depth;
+  size_t size;
+  int dir;
+} art_iterator_t;
+typedef art_iterator_t* art_iterator_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* constructor */
+art_tree_ptr art_init(void);
+
+/* destructor, free_value may be NULL */
+void art_deinit(art_tree_ptr tree, free_func_ptr free_value);
+
+/* remove all entries */
+void art_clear(art_tree_ptr tree, free_func_ptr free_value);
+
+/* ART_OK if the key is new, ART_REPLACED if its old value went to
+   *old_p (when not NULL), ART_OUT_OF_MEM */
+int art_insert(art_tree_ptr tree, const unsigned char* key, size_t len,
+               generic_ptr value, generic_dptr old_p);
+
+/* 1 if found, 0 otherwise */
+int art_find(art_tree_ptr tree, const unsigned char* key, size_t len,
+             generic_dptr value_p);
+
+int art_delete(art_tree_ptr tree, const unsigned char* key, size_t len,
+               generic_dptr value_p);
+
+/* the longest key which is a prefix of key, 1 if any */
+int art_longest_prefix(art_tree_ptr tree,
+                       const unsigned char* key, size_t len,
+                       size_t* match_len, generic_dptr value_p);
+
+/* smallest and biggest keys, 1 if the tree is not empty. Keys belong
+   to the tree */
+int art_first(art_tree_ptr tree, const unsigned char** key_p,
+              size_t* len_p, generic_dptr value_p);
+int art_last(art_tree_ptr tree, const unsigned char** key_p,
+             size_t* len_p, generic_dptr value_p);
+
+/* number of entries */
+size_t art_count(art_tree_ptr tree);
+
+/* iterator over the keys starting with prefix (all keys for len 0),
+   in dir order. The tree must not change while iterating */
+art_iterator_ptr art_iter(art_tree_ptr tree,
+                          const unsigned char* prefix, size_t len,
+                          int dir);
+
+/* iterator destructor */
+void art_iter_free(art_iterator_ptr iter);
+
+/* next entry, 0 at the end */
+int art_iter_next(art_iterator_ptr iter, const unsigned char** key_p,
+                  size_t* len_p, generic_dptr value_p);
+
+#endif
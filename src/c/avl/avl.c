@@ -18,19 +18,19 @@ static inline avl_node_ptr
 new_node(generic_ptr key, generic_ptr value);
 
 static inline avl_node_ptr
-find_rightmost(avl_node_dptr node_p);
+find_rightmost(avl_tree_ptr tree, avl_node_dptr node_p);
 
 static inline void
-do_rebalance(avl_node_tptr stack_nodep, int stack_n);
+do_rebalance(avl_tree_ptr tree, avl_node_tptr stack_nodep, int stack_n);
 
 static inline void
-compute_height(avl_node_ptr node);
+compute_height(avl_tree_ptr tree, avl_node_ptr node);
 
 static inline void
-rotate_left(avl_node_dptr node_p);
+rotate_left(avl_tree_ptr tree, avl_node_dptr node_p);
 
 static inline void
-rotate_right(avl_node_dptr node_p);
+rotate_right(avl_tree_ptr tree, avl_node_dptr node_p);
 
 static inline void
 avl_record_iter_forward(avl_node_ptr node, avl_iterator_ptr iter);
@@ -38,6 +38,10 @@ avl_record_iter_forward(avl_node_ptr node, avl_iterator_ptr iter);
 static inline void
 avl_record_iter_backward(avl_node_ptr node, avl_iterator_ptr iter);
 
+static void
+avl_record_iter_key(avl_node_ptr node, generic_ptr key, cmp_func_ptr cmp,
+                    avl_iterator_ptr iter);
+
 static inline void
 avl_walk_forward(avl_node_ptr node, iter_func_ptr func);
 
@@ -52,6 +56,10 @@ do_check_tree(avl_node_ptr node, cmp_func_ptr compare, int* error);
 static inline void
 free_entry(avl_node_ptr node, free_func_ptr key_free, free_func_ptr value_free);
 
+static avl_node_ptr
+build_sorted(avl_tree_ptr tree, generic_dptr keys, generic_dptr values,
+             int n, int* error);
+
 /* -- public functions ------------------------------------------------------ */
 
 /**
@@ -70,11 +78,27 @@ avl_tree_ptr avl_init(cmp_func_ptr cmp)
     this->root = NULL;
     this->cmp = cmp;
     this->num_entries = 0;
+    this->modified = 0;
+    this->update = NULL;
   }
 
   return this;
 }
 
+/**
+   Keep data of its own (the keys' or the values') in every node of
+   the empty tree, such as subtree aggregates: update is called on a
+   node whenever its subtrees change, children before their parents,
+   and returns whether the node's data changed.
+*/
+void avl_set_update(avl_tree_ptr this, avl_update_func_ptr update)
+{
+  CHECK_INSTANCE(this);
+  assert(! this->root);
+
+  this->update = update;
+}
+
 /**
    Delete all storage associated with `tree'.  The functions
    key_delete_func and value_delete_func, if non-null, are called to
@@ -116,6 +140,7 @@ void avl_clear(avl_tree_ptr this,
   free_entry(this->root, key_free, value_free);
   this->root = NULL;
   this->num_entries = 0;
+  ++ this->modified;
 }
 
 /**
@@ -213,7 +238,8 @@ int avl_last(avl_tree_ptr this, generic_dptr key_p, generic_dptr value_p)
 
 /**
    Insert the value `value' under the key `key'.  Multiple items are
-   allowed with the same value; all are inserted.
+   allowed with the same value; all are inserted. Returns 1 if the key
+   was already there, 0 if not, or AVL_OUT_OF_MEM.
  */
 int avl_insert(avl_tree_ptr this, generic_ptr key, generic_ptr value)
 {
@@ -239,15 +265,43 @@ int avl_insert(avl_tree_ptr this, generic_ptr key, generic_ptr value)
   }
 
   /* insert the item and re-balance the tree */
-  (*node_p) = new_node(key, value);
-  do_rebalance(stack_nodep, stack_n);
+  if (! ((*node_p) = new_node(key, value))) return AVL_OUT_OF_MEM;
+  if (this->update) this->update(*node_p);
+  do_rebalance(this, stack_nodep, stack_n);
 
   this->num_entries++;
-  this->modified = 1;
+  ++ this->modified;
 
   return status;
 }
 
+/**
+   Fill the empty tree with the `n' items of `keys' and `values' (NULL
+   for all-NULL values), which must be sorted by key. The tree is
+   built balanced in O(n), without comparing keys or rotating. Returns
+   1 on success, 0 if the tree is not empty or out of memory, in which
+   case the tree is left empty.
+*/
+int avl_build_sorted(avl_tree_ptr this,
+                     generic_dptr keys,
+                     generic_dptr values,
+                     int n)
+{
+  CHECK_INSTANCE(this);
+
+  int error = 0;
+
+  if (this->root || n < 0) return 0;
+
+  this->root = build_sorted(this, keys, values, n, &error);
+  if (error) return 0;
+
+  this->num_entries = n;
+  ++ this->modified;
+
+  return 1;
+}
+
 /**
    Search for an entry matching key; if not found, insert key and
    return the address of the value slot for this entry.  If found,
@@ -282,12 +336,13 @@ int avl_find_or_insert(avl_tree_ptr this, generic_ptr key, generic_tptr slot_p)
   }
 
   /* insert the item and re-balance the tree */
-  (*node_p) = new_node(key, NULL);
+  if (! ((*node_p) = new_node(key, NULL))) return AVL_OUT_OF_MEM;
+  if (this->update) this->update(*node_p);
 
-  do_rebalance(stack_nodep, stack_n);
+  do_rebalance(this, stack_nodep, stack_n);
 
   this->num_entries++;
-  this->modified = 1;
+  ++ this->modified;
 
   if (slot_p != 0) (*slot_p) = &node->value;
 
@@ -331,7 +386,7 @@ int avl_delete(avl_tree_ptr this, generic_ptr key, generic_dptr value_p)
 
   if (!node->left) (*node_p) = node->right;
   else {
-    rightmost = find_rightmost(&node->left);
+    rightmost = find_rightmost(this, &node->left);
     rightmost->left = node->left;
     rightmost->right = node->right;
     rightmost->height = -2;     /* mark bogus height for do_rebal */
@@ -343,9 +398,9 @@ int avl_delete(avl_tree_ptr this, generic_ptr key, generic_dptr value_p)
   free(node);
 
   /* work our way back up, re-balancing the tree */
-  do_rebalance(stack_nodep, stack_n);
+  do_rebalance(this, stack_nodep, stack_n);
   this->num_entries--;
-  this->modified = 1;
+  ++ this->modified;
 
   return 1;
 }
@@ -384,7 +439,7 @@ int avl_delete_pair(avl_tree_ptr this, generic_ptr key, generic_ptr value_p)
  delete_item:
   if (!node->left) (*node_p) = node->right;
   else {
-    rightmost = find_rightmost(&node->left);
+    rightmost = find_rightmost(this, &node->left);
     rightmost->left = node->left;
     rightmost->right = node->right;
     rightmost->height = -2;     /* mark bogus height for do_rebal */
@@ -396,9 +451,9 @@ int avl_delete_pair(avl_tree_ptr this, generic_ptr key, generic_ptr value_p)
   free(node);
 
   /* work our way back up, re-balancing the tree */
-  do_rebalance(stack_nodep, stack_n);
+  do_rebalance(this, stack_nodep, stack_n);
   this->num_entries--;
-  this->modified = 1;
+  ++ this->modified;
 
   return 1;
 }
@@ -407,10 +462,8 @@ int avl_delete_pair(avl_tree_ptr this, generic_ptr key, generic_ptr value_p)
 /**
    Generate the next item from the avl-tree.
 
-   Returns 0 if there are no more items in the tree.  Deletion of last
-   generated item (via avl_delete) is supported.  Insertion of items
-   during generation will result in these items never being generated
-   (until the next avl_init_gen()).
+   Returns 0 if there are no more items in the tree.  Any insertion or
+   deletion ends the generation, see avl_iter_changed().
 */
 avl_iterator_ptr avl_iter(avl_tree_ptr tree, int dir)
 {
@@ -420,7 +473,7 @@ avl_iterator_ptr avl_iter(avl_tree_ptr tree, int dir)
   /* what a hack */
   this = (avl_iterator_ptr)(malloc(sizeof(avl_iterator)));
   this->tree = tree;
-  this->nodelist = (avl_node_dptr)(malloc(sizeof(avl_node) * tree->num_entries));
+  this->nodelist = (avl_node_dptr)(malloc(sizeof(avl_node_ptr) * tree->num_entries));
   this->count = 0;
 
   if (dir == AVL_ITER_FORWARD) {
@@ -431,10 +484,11 @@ avl_iterator_ptr avl_iter(avl_tree_ptr tree, int dir)
   }
   else assert(0);
 
-  this->count = 0; /* FIXME: twice? */
+  this->n = this->count;
+  this->count = 0;
 
   /* catch any attempt to modify the tree while we generate */
-  tree->modified = 0;
+  this->stamp = tree->modified;
 
   return this;
 }
@@ -445,7 +499,8 @@ int avl_iter_next(avl_iterator_ptr this, generic_dptr key_p, generic_dptr value_
   CHECK_INSTANCE(this);
   avl_node_ptr node;
 
-  if (this->count == this->tree->num_entries) return 0;
+  if (this->count == this->n || avl_iter_changed(this))
+    return 0;
 
   else {
     node = this->nodelist[this->count++];
@@ -457,6 +512,55 @@ int avl_iter_next(avl_iterator_ptr this, generic_dptr key_p, generic_dptr value_
 }
 
 
+/**
+   Generate, in order, the items whose keys equal key. Equal keys are
+   adjacent in order, so only the subtrees that may hold them are
+   visited: O(log(n) + k) for k items.
+*/
+avl_iterator_ptr avl_iter_key(avl_tree_ptr tree, generic_ptr key)
+{
+  CHECK_INSTANCE(tree);
+  avl_iterator_ptr this;
+
+  if (! (this = (avl_iterator_ptr) malloc(sizeof(avl_iterator))))
+    return NULL;
+
+  this->tree = tree;
+
+  /* count them, then record them */
+  this->nodelist = NULL;
+  this->count = 0;
+  avl_record_iter_key(tree->root, key, tree->cmp, this);
+
+  if (! (this->nodelist = (avl_node_dptr)
+         malloc(sizeof(avl_node_ptr) * (this->count + 1)))) {
+    free(this);
+    return NULL;
+  }
+
+  this->count = 0;
+  avl_record_iter_key(tree->root, key, tree->cmp, this);
+
+  this->n = this->count;
+  this->count = 0;
+  this->stamp = tree->modified;
+
+  return this;
+}
+
+
+/**
+   Has the tree been modified since the iterator was created? Its node
+   list may then hold freed nodes.
+*/
+int avl_iter_changed(avl_iterator_ptr this)
+{
+  CHECK_INSTANCE(this);
+
+  return this->stamp != this->tree->modified;
+}
+
+
 /**
    Free an iterator.
 */
@@ -499,7 +603,7 @@ void avl_foreach(avl_tree_ptr this, iter_func_ptr func, int direction)
 
 /* -------------------------- internal functions -------------------------- */
 static inline avl_node_ptr
-find_rightmost(avl_node_dptr node_p)
+find_rightmost(avl_tree_ptr tree, avl_node_dptr node_p)
 {
   avl_node_ptr node;
   int stack_n = 0;
@@ -513,21 +617,22 @@ find_rightmost(avl_node_dptr node_p)
   }
   (*node_p) = node->left;
 
-  do_rebalance(stack_nodep, stack_n);
+  do_rebalance(tree, stack_nodep, stack_n);
   return node;
 }
 
 
 static inline void
-do_rebalance(avl_node_tptr stack_nodep, int stack_n)
+do_rebalance(avl_tree_ptr tree, avl_node_tptr stack_nodep, int stack_n)
 {
   avl_node_dptr node_p;
   avl_node_ptr node;
 
   int hl, hr;
-  int height;
+  int height, updated;
 
-  /* work our way back up, re-balancing the tree */
+  /* work our way back up, re-balancing the tree; stop where neither
+     the height nor the node's data change any more */
   while (--stack_n >= 0) {
     node_p = stack_nodep[stack_n];
     node = (*node_p);
@@ -535,16 +640,18 @@ do_rebalance(avl_node_tptr stack_nodep, int stack_n)
     hl = HEIGHT(node->left);            /* watch for NIL */
     hr = HEIGHT(node->right);           /* watch for NIL */
     if ((hr - hl) < -1) {
-      rotate_right(node_p);
+      rotate_right(tree, node_p);
     }
 
     else if ((hr - hl) > 1) {
-      rotate_left(node_p);
+      rotate_left(tree, node_p);
     }
 
     else {
       height = MAX(hl, hr) + 1;
-      if (height == node->height) break;
+      updated = tree->update && tree->update(node);
+
+      if (height == node->height && !updated) break;
       node->height = height;
     }
   }
@@ -552,7 +659,7 @@ do_rebalance(avl_node_tptr stack_nodep, int stack_n)
 
 
 static inline void
-rotate_left(avl_node_dptr node_p)
+rotate_left(avl_tree_ptr tree, avl_node_dptr node_p)
 {
   avl_node_ptr old_root = (*node_p);
   avl_node_ptr new_root;
@@ -571,16 +678,16 @@ rotate_left(avl_node_dptr node_p)
     new_right->left = new_root->right;
     new_root->right = new_right;
     new_root->left = old_root;
-    compute_height(new_right);
+    compute_height(tree, new_right);
   }
 
-  compute_height(old_root);
-  compute_height(new_root);
+  compute_height(tree, old_root);
+  compute_height(tree, new_root);
 }
 
 
 static inline void
-rotate_right( avl_node_dptr node_p)
+rotate_right(avl_tree_ptr tree, avl_node_dptr node_p)
 {
   avl_node_ptr old_root = (*node_p);
   avl_node_ptr new_root;
@@ -599,11 +706,11 @@ rotate_right( avl_node_dptr node_p)
     new_left->right = new_root->left;
     new_root->left = new_left;
     new_root->right = old_root;
-    compute_height(new_left);
+    compute_height(tree, new_left);
   }
 
-  compute_height(old_root);
-  compute_height(new_root);
+  compute_height(tree, old_root);
+  compute_height(tree, new_root);
 }
 
 
@@ -649,10 +756,35 @@ avl_record_iter_backward(avl_node_ptr node, avl_iterator_ptr iter)
   }
 }
 
+static void
+avl_record_iter_key(avl_node_ptr node, generic_ptr key, cmp_func_ptr cmp,
+                    avl_iterator_ptr iter)
+{
+  int diff;
+
+  if (node) {
+    diff = cmp(key, node->key);
+
+    if (diff <= 0)
+      avl_record_iter_key(node->left, key, cmp, iter);
+
+    if (! diff) {
+      if (iter->nodelist) iter->nodelist[iter->count] = node;
+      iter->count ++;
+    }
+
+    if (diff >= 0)
+      avl_record_iter_key(node->right, key, cmp, iter);
+  }
+}
+
+/* height and the node's data, from the children */
 static inline void
-compute_height(avl_node_ptr node) {
+compute_height(avl_tree_ptr tree, avl_node_ptr node) {
   node->height = 1 + MAX(HEIGHT(node->left),
 			 HEIGHT(node->right));
+
+  if (tree->update) tree->update(node);
 }
 
 static inline void
@@ -669,17 +801,55 @@ free_entry(avl_node_ptr node,
   }
 }
 
+/* Internal service of avl_build_sorted: the middle item is the root
+   of a subtree whose halves differ in size by at most one. On error
+   the nodes built so far are freed, items are left to the caller. */
+static avl_node_ptr
+build_sorted(avl_tree_ptr tree, generic_dptr keys, generic_dptr values,
+             int n, int* error)
+{
+  avl_node_ptr left, node;
+  int mid = n / 2;
+
+  if (n <= 0) return NULL;
+
+  left = build_sorted(tree, keys, values, mid, error);
+  if (*error) return NULL;
+
+  if (!(node = (avl_node_ptr)(malloc(sizeof(avl_node))))) {
+    free_entry(left, NULL, NULL);
+    ++(*error);
+    return NULL;
+  }
+
+  node->key = keys[mid];
+  node->value = values ? values[mid] : NULL;
+  node->left = left;
+  node->right = build_sorted(tree, keys + mid + 1,
+                             values ? values + mid + 1 : NULL,
+                             n - mid - 1, error);
+  if (*error) {
+    free_entry(node, NULL, NULL);
+    return NULL;
+  }
+
+  compute_height(tree, node);
+  return node;
+}
+
 /* Allocate a new AVL node */
 static inline avl_node_ptr
 new_node(generic_ptr key, generic_ptr value)
 {
   avl_node_ptr new = (avl_node_ptr)(malloc(sizeof(avl_node)));
 
-  new->key = key;
-  new->value = value;
-  new->height = 0;
-  new->left = NULL;
-  new->right = NULL;
+  if (new) {
+    new->key = key;
+    new->value = value;
+    new->height = 0;
+    new->left = NULL;
+    new->right = NULL;
+  }
 
   return new;
 }
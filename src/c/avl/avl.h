@@ -4,6 +4,9 @@
 #define AVL_ITER_FORWARD 	0
 #define AVL_ITER_BACKWARD 	1
 
+/* Error constants */
+#define AVL_OUT_OF_MEM    -2
+
 #include "common.h"
 
 typedef struct avl_node_struct avl_node;
@@ -21,6 +24,9 @@ struct avl_node_struct {
   int height;
 };
 
+/* recomputes a node's own data from its children, see avl_set_update */
+typedef int (*avl_update_func_ptr)(avl_node_ptr node);
+
 typedef struct avl_tree_struct avl_tree;
 typedef avl_tree* avl_tree_ptr;
 
@@ -33,7 +39,10 @@ struct avl_tree_struct {
   cmp_func_ptr cmp;
 
   int num_entries;
-  int modified;
+  unsigned modified;  /* bumped by every insertion and deletion */
+
+  /* node hook, for augmented trees */
+  avl_update_func_ptr update;
 };
 
 typedef struct avl_iterator_struct avl_iterator;
@@ -42,7 +51,9 @@ typedef avl_iterator* avl_iterator_ptr;
 struct avl_iterator_struct {
     avl_tree_ptr tree;
     avl_node_dptr nodelist;
+    int n;
     int count;
+    unsigned stamp;
 };
 
 /* -- Macros ---------------------------------------------------------------- */
@@ -67,6 +78,10 @@ struct avl_iterator_struct {
 /* constructor */
 avl_tree_ptr avl_init(cmp_func_ptr cmp);
 
+/* node hook of an augmented tree, set while empty */
+void avl_set_update(avl_tree_ptr tree,
+		    avl_update_func_ptr update);
+
 /* destructor */
 void avl_deinit(avl_tree_ptr tree,
 		free_func_ptr free_key,
@@ -92,6 +107,12 @@ int avl_insert (avl_tree_ptr tree,
 		generic_ptr key,
 		generic_ptr value);
 
+/* bulk insertion of sorted items into an empty tree */
+int avl_build_sorted (avl_tree_ptr tree,
+		      generic_dptr keys,
+		      generic_dptr values,
+		      int n);
+
 /* find element */
 int avl_find (avl_tree_ptr tree,
 	      generic_ptr key,
@@ -121,6 +142,10 @@ void avl_foreach (avl_tree_ptr tree,
 avl_iterator_ptr avl_iter (avl_tree_ptr tree,
 			   int dir);
 
+/* iterator over the items with keys equal to key */
+avl_iterator_ptr avl_iter_key (avl_tree_ptr tree,
+			       generic_ptr key);
+
 /* iterator destructor */
 void avl_iter_free (avl_iterator_ptr);
 
@@ -129,6 +154,9 @@ int avl_iter_next (avl_iterator_ptr ,
 		   generic_dptr,
 		   generic_dptr);
 
+/* was the tree modified since the iterator was created? */
+int avl_iter_changed (avl_iterator_ptr);
+
 /* number of entries */
 int avl_count(avl_tree_ptr tree);
 
@@ -0,0 +1,309 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include <stdint.h>
+
+#include "interval.h"
+
+#define INTERVAL(node)                                  \
+  ((interval_key_ptr) (node)->key)
+
+/* -- static function prototypes -------------------------------------------- */
+static inline int
+compare(double lo, double hi, generic_ptr value,
+        interval_key_ptr other, int with_value);
+
+static int
+compare_keys(generic_ptr a, generic_ptr b);
+
+static int
+update_max(avl_node_ptr node);
+
+static inline int
+delete_interval(interval_tree_ptr this, double lo, double hi,
+                generic_ptr value, int with_value, generic_dptr value_p);
+
+static inline void
+descend(interval_iterator_ptr iter, avl_node_ptr node);
+
+#ifndef NDEBUG
+static inline double
+do_check_max(avl_node_ptr node, int* error);
+#endif
+
+/* -- public functions ------------------------------------------------------ */
+
+interval_tree_ptr interval_init(void)
+{
+  interval_tree_ptr this = avl_init(compare_keys);
+  if (this)
+    avl_set_update(this, update_max);
+
+  return this;
+}
+
+
+void interval_deinit(interval_tree_ptr this,
+                     free_func_ptr value_free)
+{
+  avl_deinit(this, free, value_free);
+}
+
+
+void interval_clear(interval_tree_ptr this,
+                    free_func_ptr value_free)
+{
+  avl_clear(this, free, value_free);
+}
+
+
+int interval_count(interval_tree_ptr this)
+{
+  return avl_count(this);
+}
+
+
+/**
+   Insert the interval [lo, hi] with `value'. Equal intervals are all
+   inserted. Fails with INTERVAL_BAD_BOUNDS if lo > hi (or either is a
+   NaN).
+ */
+int interval_insert(interval_tree_ptr this,
+                    double lo, double hi,
+                    generic_ptr value)
+{
+  CHECK_INSTANCE(this);
+
+  interval_key_ptr key;
+
+  if (! (lo <= hi)) return INTERVAL_BAD_BOUNDS;
+
+  if (! (key = (interval_key_ptr) malloc(sizeof(interval_key))))
+    return INTERVAL_OUT_OF_MEM;
+
+  key->lo = lo;
+  key->hi = hi;
+  key->max = hi;
+  key->value = value;
+
+  if (avl_insert(this, key, value) == AVL_OUT_OF_MEM) {
+    free(key);
+    return INTERVAL_OUT_OF_MEM;
+  }
+
+  return INTERVAL_OK;
+}
+
+
+int interval_delete(interval_tree_ptr this,
+                    double lo, double hi,
+                    generic_dptr value_p)
+{
+  CHECK_INSTANCE(this);
+
+  return delete_interval(this, lo, hi, NULL, 0, value_p);
+}
+
+
+int interval_delete_pair(interval_tree_ptr this,
+                         double lo, double hi,
+                         generic_ptr value)
+{
+  CHECK_INSTANCE(this);
+
+  return delete_interval(this, lo, hi, value, 1, NULL);
+}
+
+
+/**
+   Iterate over the intervals overlapping [lo, hi], in order. The
+   nodes on the stack have their left subtree done; subtrees whose
+   biggest hi comes before lo are never entered, and the walk ends at
+   the first node starting after hi. Every subtree entered holds a
+   match or that last node, so k matches take O(log(n) + k) steps
+   once the stack is primed.
+*/
+interval_iterator_ptr interval_iter(interval_tree_ptr tree,
+                                    double lo, double hi)
+{
+  CHECK_INSTANCE(tree);
+  interval_iterator_ptr this;
+
+  if (! (this = (interval_iterator_ptr)(malloc(sizeof(interval_iterator)))))
+    return NULL;
+
+  this->lo = lo;
+  this->hi = hi;
+  this->stack_n = 0;
+
+  descend(this, tree->root);
+
+  return this;
+}
+
+
+int interval_iter_next(interval_iterator_ptr this,
+                       double* lo_p, double* hi_p,
+                       generic_dptr value_p)
+{
+  CHECK_INSTANCE(this);
+  avl_node_ptr node;
+  interval_key_ptr key;
+
+  while (this->stack_n) {
+    node = this->stack[-- this->stack_n];
+    key = INTERVAL(node);
+
+    /* this one and all those after it start past the range */
+    if (key->lo > this->hi) {
+      this->stack_n = 0;
+      return 0;
+    }
+
+    descend(this, node->right);
+
+    if (key->hi >= this->lo) {
+      if (lo_p) (*lo_p) = key->lo;
+      if (hi_p) (*hi_p) = key->hi;
+      if (value_p) (*value_p) = key->value;
+
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+void interval_iter_free(interval_iterator_ptr this)
+{
+  CHECK_INSTANCE(this);
+
+  free(this);
+}
+
+
+/* -------------------------- internal functions -------------------------- */
+static inline int
+compare(double lo, double hi, generic_ptr value,
+        interval_key_ptr other, int with_value)
+{
+  if (lo != other->lo) return (lo < other->lo) ? -1 : 1;
+  if (hi != other->hi) return (hi < other->hi) ? -1 : 1;
+
+  /* equal intervals are told apart by their values' addresses */
+  if (! with_value || value == other->value) return 0;
+  return ((uintptr_t) value < (uintptr_t) other->value) ? -1 : 1;
+}
+
+
+/* the order of the avl tree; even equal intervals of the same value
+   have keys of their own, so every key is found again exactly */
+static int
+compare_keys(generic_ptr a, generic_ptr b)
+{
+  interval_key_ptr x = (interval_key_ptr) a;
+  int diff;
+
+  if ((diff = compare(x->lo, x->hi, x->value, (interval_key_ptr) b, 1)))
+    return diff;
+
+  if (a == b) return 0;
+  return ((uintptr_t) a < (uintptr_t) b) ? -1 : 1;
+}
+
+
+/* the avl node hook: the biggest hi, from the children */
+static int
+update_max(avl_node_ptr node)
+{
+  interval_key_ptr key = INTERVAL(node);
+  double max = key->hi;
+
+  if (node->left) max = MAX(max, INTERVAL(node->left)->max);
+  if (node->right) max = MAX(max, INTERVAL(node->right)->max);
+
+  if (max == key->max) return 0;
+
+  key->max = max;
+  return 1;
+}
+
+
+/* find a matching interval, then delete its node by its own key */
+static inline int
+delete_interval(interval_tree_ptr this, double lo, double hi,
+                generic_ptr value, int with_value, generic_dptr value_p)
+{
+  avl_node_ptr node = this->root;
+  interval_key_ptr key;
+  int diff;
+
+  while (node) {
+    if (! (diff = compare(lo, hi, value, INTERVAL(node), with_value)))
+      break;
+
+    node = (diff < 0) ? node->left : node->right;
+  }
+
+  if (! node) return 0;         /* not found */
+
+  key = INTERVAL(node);
+  if (value_p != 0) (*value_p) = key->value;
+
+  avl_delete(this, key, NULL);
+  free(key);
+
+  return 1;
+}
+
+
+/* push node and its left spine, as long as they reach the range */
+static inline void
+descend(interval_iterator_ptr iter, avl_node_ptr node)
+{
+  while (node && INTERVAL(node)->max >= iter->lo) {
+    iter->stack[iter->stack_n++] = node;
+    node = node->left;
+  }
+}
+
+#ifndef NDEBUG
+/* Check if the tree is well-formed, and the maxes right (this is for
+   debugging purposes only) */
+int
+interval_check_tree(interval_tree_ptr this)
+{
+  int error = avl_check_tree(this);
+  if (this->root) (void) do_check_max(this->root, &error);
+
+  return error;
+}
+
+/* Internal service of interval_check_tree */
+static inline double
+do_check_max(avl_node_ptr node, int* error)
+{
+  double max, sub;
+
+  max = INTERVAL(node)->hi;
+  if (node->left) {
+    sub = do_check_max(node->left, error);
+    max = MAX(max, sub);
+  }
+  if (node->right) {
+    sub = do_check_max(node->right, error);
+    max = MAX(max, sub);
+  }
+
+  if (max != INTERVAL(node)->max) {
+    (void) printf("Bad max for 0x%p: computed=%g stored=%g\n",
+                  (void*) node, max, INTERVAL(node)->max);
+    ++(*error);
+  }
+
+  return max;
+}
+#endif
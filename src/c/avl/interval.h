@@ -0,0 +1,97 @@
+#ifndef INTERVAL_INCLUDED
+#define INTERVAL_INCLUDED
+
+#include "avl.h"
+
+/* Interval trees: AVL trees (avl.c) of closed intervals [lo, hi] with
+   double endpoints, ordered by lo (then hi). Every node also keeps the
+   biggest hi of its subtree, kept up to date by the avl node hook, so
+   that queries skip the subtrees ending before the query range and
+   stop at the first interval starting after it. Intervals come out of
+   queries in order of lo. */
+
+#define INTERVAL_OK          0
+#define INTERVAL_OUT_OF_MEM -2
+#define INTERVAL_BAD_BOUNDS -3
+
+#define INTERVAL_MAX_HEIGHT 96
+
+/* the key of each avl node; the node's value is the interval's */
+typedef struct interval_key_struct interval_key;
+typedef interval_key* interval_key_ptr;
+
+struct interval_key_struct {
+  double lo;
+  double hi;
+
+  /* the biggest hi in the subtree */
+  double max;
+
+  generic_ptr value;
+};
+
+typedef avl_tree interval_tree;
+typedef interval_tree* interval_tree_ptr;
+
+typedef struct interval_iterator_struct interval_iterator;
+typedef interval_iterator* interval_iterator_ptr;
+
+struct interval_iterator_struct {
+  double lo;
+  double hi;
+
+  /* nodes whose right subtree is still to be visited */
+  avl_node_ptr stack[INTERVAL_MAX_HEIGHT];
+  int stack_n;
+};
+
+/* -- Interface ------------------------------------------------------------- */
+
+/* constructor */
+interval_tree_ptr interval_init(void);
+
+/* destructor */
+void interval_deinit(interval_tree_ptr tree,
+                     free_func_ptr free_value);
+
+/* remove all entries */
+void interval_clear(interval_tree_ptr tree,
+                    free_func_ptr free_value);
+
+/* insertion, the same interval may be inserted many times */
+int interval_insert(interval_tree_ptr tree,
+                    double lo, double hi,
+                    generic_ptr value);
+
+/* delete an interval [lo, hi], 1 if found */
+int interval_delete(interval_tree_ptr tree,
+                    double lo, double hi,
+                    generic_dptr value_p);
+
+/* delete the interval [lo, hi] of value, 1 if found */
+int interval_delete_pair(interval_tree_ptr tree,
+                         double lo, double hi,
+                         generic_ptr value);
+
+/* number of entries */
+int interval_count(interval_tree_ptr tree);
+
+/* iterator over the intervals overlapping [lo, hi]; stabbing queries
+   have lo == hi. The tree must not change while iterating */
+interval_iterator_ptr interval_iter(interval_tree_ptr tree,
+                                    double lo, double hi);
+
+/* iterator destructor */
+void interval_iter_free(interval_iterator_ptr iter);
+
+/* next interval, 0 at the end */
+int interval_iter_next(interval_iterator_ptr iter,
+                       double* lo_p, double* hi_p,
+                       generic_dptr value_p);
+
+#ifndef NDEBUG
+/* tree check (debugging) */
+int interval_check_tree(interval_tree_ptr tree);
+#endif
+
+#endif
@@ -0,0 +1,941 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "bdd.h"
+
+#include <math.h>
+
+#define BDD_TERMINAL_VAR ((unsigned) -1)
+#define BDD_FREE_VAR     ((unsigned) -2)
+
+#define IS_CONST(f)                                                            \
+  ((f) <= BDD_TRUE)
+
+/* constants sit below all variables */
+#define LEVEL(mgr, f)                                                          \
+  (IS_CONST(f) ? (unsigned) -1 : (mgr)->level[(mgr)->nodes[f].var])
+
+/* computed cache operations */
+#define BDD_OP_ITE      1
+#define BDD_OP_RESTRICT 2
+#define BDD_OP_EXISTS   3
+
+typedef struct bdd_sift_order_t {
+  unsigned num;
+  unsigned var;
+} bdd_sift_order_t;
+
+/* -- internal functions ---------------------------------------------------- */
+static inline unsigned bdd_hash(unsigned a, unsigned b, unsigned c);
+static inline bdd_t bdd_subtable_find(bdd_mgr_ptr mgr, bdd_subtable_ptr st,
+                                      bdd_t low, bdd_t high);
+static inline void bdd_subtable_insert(bdd_mgr_ptr mgr, bdd_subtable_ptr st,
+                                       bdd_t f);
+static void bdd_subtable_remove(bdd_mgr_ptr mgr, bdd_subtable_ptr st,
+                                bdd_t f);
+static int bdd_subtable_reserve(bdd_mgr_ptr mgr, bdd_subtable_ptr st,
+                                unsigned n);
+static inline int bdd_nodes_reserve(bdd_mgr_ptr mgr, unsigned n);
+static inline void bdd_node_release(bdd_mgr_ptr mgr, bdd_t f);
+static bdd_t bdd_mk(bdd_mgr_ptr mgr, unsigned var, bdd_t low, bdd_t high);
+static int bdd_add_vars(bdd_mgr_ptr mgr, unsigned nvars);
+static void bdd_checkpoint(bdd_mgr_ptr mgr, bdd_t f, bdd_t g, bdd_t h);
+static inline bdd_cache_entry_ptr bdd_cache_slot(bdd_mgr_ptr mgr,
+                                                 unsigned op, bdd_t f,
+                                                 bdd_t g, bdd_t h);
+static inline void bdd_cache_clear(bdd_mgr_ptr mgr);
+static bdd_t bdd_ite_rec(bdd_mgr_ptr mgr, bdd_t f, bdd_t g, bdd_t h);
+static bdd_t bdd_restrict_rec(bdd_mgr_ptr mgr, bdd_t f, unsigned v,
+                              int value);
+static bdd_t bdd_exists_rec(bdd_mgr_ptr mgr, bdd_t f, unsigned v);
+static double bdd_sat_rec(bdd_mgr_ptr mgr, bdd_t f, double* density);
+static long bdd_size_rec(bdd_mgr_ptr mgr, bdd_t f, unsigned char* marks);
+static void bdd_mark(bdd_mgr_ptr mgr, bdd_t f, unsigned char* marks);
+static void bdd_deref_rec(bdd_mgr_ptr mgr, bdd_t f);
+static int bdd_swap(bdd_mgr_ptr mgr, unsigned i);
+static int bdd_sift(bdd_mgr_ptr mgr, unsigned v);
+static int bdd_sift_order_cmp(const void* a, const void* b);
+
+bdd_mgr_ptr bdd_init(unsigned nvars, unsigned cache_size)
+{
+  bdd_mgr_ptr mgr;
+  unsigned size;
+
+  if (! (mgr = (bdd_mgr_ptr) calloc(1, sizeof(bdd_mgr_t))))
+    return NULL;
+
+  if (! cache_size) cache_size = BDD_CACHE_SIZE;
+  for (size = 1; size < cache_size; size <<= 1)
+    ;
+
+  mgr->n_size = BDD_INIT_NODES;
+  mgr->nodes = (bdd_node_ptr) malloc(mgr->n_size * sizeof(bdd_node_t));
+  mgr->cache = (bdd_cache_entry_ptr)
+    calloc(size, sizeof(bdd_cache_entry_t));
+  mgr->cache_mask = size - 1;
+
+  if (! mgr->nodes || ! mgr->cache) {
+    bdd_deinit(mgr);
+    return NULL;
+  }
+
+  /* the constants */
+  mgr->nodes[BDD_FALSE].var = mgr->nodes[BDD_TRUE].var = BDD_TERMINAL_VAR;
+  mgr->nodes[BDD_FALSE].low = mgr->nodes[BDD_FALSE].high = BDD_FALSE;
+  mgr->nodes[BDD_TRUE].low = mgr->nodes[BDD_TRUE].high = BDD_TRUE;
+  mgr->nodes[BDD_FALSE].ref = mgr->nodes[BDD_TRUE].ref = 0;
+  mgr->used = 2;
+  mgr->free_nodes = BDD_FALSE;
+
+  mgr->next_gc = mgr->next_reorder = BDD_INIT_GC;
+
+  if (bdd_add_vars(mgr, nvars) != BDD_OK) {
+    bdd_deinit(mgr);
+    return NULL;
+  }
+
+  return mgr;
+}
+
+
+void bdd_deinit(bdd_mgr_ptr mgr)
+{
+  unsigned v;
+  CHECK_INSTANCE(mgr);
+
+  for (v = 0; v < mgr->nvars; v ++)
+    free(mgr->subtables[v].slots);
+
+  free(mgr->subtables);
+  free(mgr->level);
+  free(mgr->var_at);
+  free(mgr->nodes);
+  free(mgr->cache);
+  free(mgr);
+}
+
+
+bdd_t bdd_ref(bdd_mgr_ptr mgr, bdd_t f)
+{
+  CHECK_INSTANCE(mgr);
+  assert(f < mgr->used);
+
+  mgr->nodes[f].ref ++;
+  return f;
+}
+
+
+void bdd_deref(bdd_mgr_ptr mgr, bdd_t f)
+{
+  CHECK_INSTANCE(mgr);
+  assert(f < mgr->used && mgr->nodes[f].ref);
+
+  mgr->nodes[f].ref --;
+}
+
+
+bdd_t bdd_var(bdd_mgr_ptr mgr, unsigned v)
+{
+  CHECK_INSTANCE(mgr);
+
+  if (v >= mgr->nvars && bdd_add_vars(mgr, v + 1 - mgr->nvars) != BDD_OK)
+    return BDD_NONE;
+
+  return bdd_mk(mgr, v, BDD_FALSE, BDD_TRUE);
+}
+
+
+unsigned bdd_top_var(bdd_mgr_ptr mgr, bdd_t f)
+{
+  CHECK_INSTANCE(mgr);
+  assert(! IS_CONST(f));
+  return mgr->nodes[f].var;
+}
+
+
+bdd_t bdd_low(bdd_mgr_ptr mgr, bdd_t f)
+{
+  CHECK_INSTANCE(mgr);
+  assert(! IS_CONST(f));
+  return mgr->nodes[f].low;
+}
+
+
+bdd_t bdd_high(bdd_mgr_ptr mgr, bdd_t f)
+{
+  CHECK_INSTANCE(mgr);
+  assert(! IS_CONST(f));
+  return mgr->nodes[f].high;
+}
+
+
+/* if f then g else h, the one operation all others are built on */
+bdd_t bdd_ite(bdd_mgr_ptr mgr, bdd_t f, bdd_t g, bdd_t h)
+{
+  CHECK_INSTANCE(mgr);
+
+  bdd_checkpoint(mgr, f, g, h);
+  return bdd_ite_rec(mgr, f, g, h);
+}
+
+
+bdd_t bdd_not(bdd_mgr_ptr mgr, bdd_t f)
+{
+  return bdd_ite(mgr, f, BDD_FALSE, BDD_TRUE);
+}
+
+
+bdd_t bdd_and(bdd_mgr_ptr mgr, bdd_t f, bdd_t g)
+{
+  return bdd_ite(mgr, f, g, BDD_FALSE);
+}
+
+
+bdd_t bdd_or(bdd_mgr_ptr mgr, bdd_t f, bdd_t g)
+{
+  return bdd_ite(mgr, f, BDD_TRUE, g);
+}
+
+
+bdd_t bdd_xor(bdd_mgr_ptr mgr, bdd_t f, bdd_t g)
+{
+  bdd_t ng = bdd_not(mgr, g);
+
+  if (ng == BDD_NONE) return BDD_NONE;
+  return bdd_ite(mgr, f, ng, g);
+}
+
+
+bdd_t bdd_implies(bdd_mgr_ptr mgr, bdd_t f, bdd_t g)
+{
+  return bdd_ite(mgr, f, g, BDD_TRUE);
+}
+
+
+bdd_t bdd_restrict(bdd_mgr_ptr mgr, bdd_t f, unsigned v, int value)
+{
+  CHECK_INSTANCE(mgr);
+
+  if (v >= mgr->nvars) return f;
+
+  bdd_checkpoint(mgr, f, f, f);
+  return bdd_restrict_rec(mgr, f, v, value ? 1 : 0);
+}
+
+
+bdd_t bdd_exists(bdd_mgr_ptr mgr, bdd_t f, unsigned v)
+{
+  CHECK_INSTANCE(mgr);
+
+  if (v >= mgr->nvars) return f;
+
+  bdd_checkpoint(mgr, f, f, f);
+  return bdd_exists_rec(mgr, f, v);
+}
+
+
+/* The density of f (the fraction of satisfying assignments) does not
+   depend on skipped levels, hence on the variable order */
+double bdd_sat_count(bdd_mgr_ptr mgr, bdd_t f)
+{
+  double *density, res;
+  unsigned i;
+  CHECK_INSTANCE(mgr);
+
+  if (! (density = (double *) malloc(mgr->used * sizeof(double))))
+    return -1;
+
+  for (i = 0; i < mgr->used; i ++)
+    density[i] = -1;
+
+  res = ldexp(bdd_sat_rec(mgr, f, density), mgr->nvars);
+
+  free(density);
+  return res;
+}
+
+
+long bdd_size(bdd_mgr_ptr mgr, bdd_t f)
+{
+  unsigned char* marks;
+  long res;
+  CHECK_INSTANCE(mgr);
+
+  if (! (marks = (unsigned char *) calloc(mgr->used, 1)))
+    return -1;
+
+  res = bdd_size_rec(mgr, f, marks);
+
+  free(marks);
+  return res;
+}
+
+
+unsigned bdd_live(bdd_mgr_ptr mgr)
+{
+  CHECK_INSTANCE(mgr);
+  return mgr->live;
+}
+
+
+/* Mark from the referenced nodes, then rebuild the subtables with the
+   marked ones and release the others. */
+void bdd_gc(bdd_mgr_ptr mgr)
+{
+  unsigned char* marks;
+  bdd_t f;
+  unsigned v;
+  CHECK_INSTANCE(mgr);
+
+  /* nothing can be done without the marks, nodes are just kept */
+  if (! (marks = (unsigned char *) calloc(mgr->used, 1)))
+    return;
+
+  for (f = BDD_TRUE + 1; f < mgr->used; f ++) {
+    if (mgr->nodes[f].var != BDD_FREE_VAR && mgr->nodes[f].ref)
+      bdd_mark(mgr, f, marks);
+  }
+
+  for (v = 0; v < mgr->nvars; v ++) {
+    memset(mgr->subtables[v].slots, 0,
+           mgr->subtables[v].size * sizeof(bdd_t));
+    mgr->subtables[v].num = 0;
+  }
+
+  for (f = BDD_TRUE + 1; f < mgr->used; f ++) {
+    if (mgr->nodes[f].var == BDD_FREE_VAR) continue;
+
+    if (marks[f])
+      bdd_subtable_insert(mgr, &mgr->subtables[mgr->nodes[f].var], f);
+    else
+      bdd_node_release(mgr, f);
+  }
+
+  free(marks);
+  bdd_cache_clear(mgr);
+  mgr->gcs ++;
+}
+
+
+/* Sift every variable, largest levels first. While reordering, node
+   ref counts include parent nodes, so that swaps can free the nodes
+   they make dead straight away and the size is always exact. */
+int bdd_reorder(bdd_mgr_ptr mgr)
+{
+  bdd_sift_order_t* order;
+  bdd_t f;
+  unsigned v;
+  int res = BDD_OK;
+  CHECK_INSTANCE(mgr);
+
+  if (mgr->nvars < 2) return BDD_OK;
+
+  if (! (order = (bdd_sift_order_t *)
+         malloc(mgr->nvars * sizeof(bdd_sift_order_t))))
+    return BDD_OUT_OF_MEM;
+
+  bdd_gc(mgr);
+
+  for (f = BDD_TRUE + 1; f < mgr->used; f ++) {
+    if (mgr->nodes[f].var == BDD_FREE_VAR) continue;
+    mgr->nodes[mgr->nodes[f].low].ref ++;
+    mgr->nodes[mgr->nodes[f].high].ref ++;
+  }
+  mgr->reordering = 1;
+
+  for (v = 0; v < mgr->nvars; v ++) {
+    order[v].num = mgr->subtables[v].num;
+    order[v].var = v;
+  }
+  qsort(order, mgr->nvars, sizeof(bdd_sift_order_t), bdd_sift_order_cmp);
+
+  for (v = 0; v < mgr->nvars && res == BDD_OK; v ++)
+    res = bdd_sift(mgr, order[v].var);
+
+  mgr->reordering = 0;
+  for (f = BDD_TRUE + 1; f < mgr->used; f ++) {
+    if (mgr->nodes[f].var == BDD_FREE_VAR) continue;
+    mgr->nodes[mgr->nodes[f].low].ref --;
+    mgr->nodes[mgr->nodes[f].high].ref --;
+  }
+
+  free(order);
+  bdd_cache_clear(mgr);
+  mgr->reorders ++;
+
+  return res;
+}
+
+
+void bdd_auto_reorder(bdd_mgr_ptr mgr, int enable)
+{
+  CHECK_INSTANCE(mgr);
+
+  mgr->auto_reorder = enable;
+  mgr->next_reorder = MAX(2 * mgr->live, BDD_INIT_GC);
+}
+
+
+unsigned bdd_nvars(bdd_mgr_ptr mgr)
+{
+  CHECK_INSTANCE(mgr);
+  return mgr->nvars;
+}
+
+
+unsigned bdd_var_level(bdd_mgr_ptr mgr, unsigned v)
+{
+  CHECK_INSTANCE(mgr);
+  assert(v < mgr->nvars);
+  return mgr->level[v];
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static inline unsigned bdd_hash(unsigned a, unsigned b, unsigned c)
+{
+  unsigned long long h = (((unsigned long long) a << 32) | b)
+    * 0x9E3779B97F4A7C15ULL;
+
+  h ^= c * 0xC2B2AE3D27D4EB4FULL;
+  return (unsigned)(h ^ (h >> 32));
+}
+
+
+/* Linear probing, keys are the (low, high) pair of the nodes */
+static inline bdd_t bdd_subtable_find(bdd_mgr_ptr mgr, bdd_subtable_ptr st,
+                                      bdd_t low, bdd_t high)
+{
+  unsigned mask = st->size - 1, i = bdd_hash(low, high, 0) & mask;
+  bdd_t f;
+
+  while ((f = st->slots[i])) {
+    if (mgr->nodes[f].low == low && mgr->nodes[f].high == high)
+      return f;
+
+    i = (i + 1) & mask;
+  }
+
+  return BDD_FALSE;
+}
+
+
+/* f must not be in st, which must have room for it */
+static inline void bdd_subtable_insert(bdd_mgr_ptr mgr, bdd_subtable_ptr st,
+                                       bdd_t f)
+{
+  unsigned mask = st->size - 1;
+  unsigned i = bdd_hash(mgr->nodes[f].low, mgr->nodes[f].high, 0) & mask;
+
+  while (st->slots[i])
+    i = (i + 1) & mask;
+
+  st->slots[i] = f;
+  st->num ++;
+}
+
+
+/* Backward shift deletion: the entries after the hole move back into
+   it unless their home slot lies (cyclically) in between */
+static void bdd_subtable_remove(bdd_mgr_ptr mgr, bdd_subtable_ptr st,
+                                bdd_t f)
+{
+  unsigned mask = st->size - 1, i, j, k;
+  bdd_t g;
+
+  i = bdd_hash(mgr->nodes[f].low, mgr->nodes[f].high, 0) & mask;
+  while (st->slots[i] != f)
+    i = (i + 1) & mask;
+
+  st->slots[i] = BDD_FALSE;
+  st->num --;
+
+  for (j = (i + 1) & mask; (g = st->slots[j]); j = (j + 1) & mask) {
+    k = bdd_hash(mgr->nodes[g].low, mgr->nodes[g].high, 0) & mask;
+
+    if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+      continue;
+
+    st->slots[i] = g;
+    st->slots[j] = BDD_FALSE;
+    i = j;
+  }
+}
+
+
+/* room for n more nodes, keeping the load factor within 1/2 */
+static int bdd_subtable_reserve(bdd_mgr_ptr mgr, bdd_subtable_ptr st,
+                                unsigned n)
+{
+  bdd_t *slots = st->slots;
+  unsigned i, old_size = st->size, size = st->size;
+
+  if (2 * (st->num + n) <= st->size) return BDD_OK;
+
+  while (2 * (st->num + n) > size)
+    size <<= 1;
+
+  if (! (st->slots = (bdd_t *) calloc(size, sizeof(bdd_t)))) {
+    st->slots = slots;
+    return BDD_OUT_OF_MEM;
+  }
+
+  st->size = size;
+  st->num = 0;
+
+  for (i = 0; i < old_size; i ++) {
+    if (slots[i]) bdd_subtable_insert(mgr, st, slots[i]);
+  }
+
+  free(slots);
+  return BDD_OK;
+}
+
+
+/* room for n more nodes in the arena, free ones aside */
+static inline int bdd_nodes_reserve(bdd_mgr_ptr mgr, unsigned n)
+{
+  bdd_node_ptr nodes;
+  unsigned size = mgr->n_size;
+
+  if (mgr->used + n <= mgr->n_size) return BDD_OK;
+
+  while (mgr->used + n > size)
+    size <<= 1;
+
+  if (! (nodes = (bdd_node_ptr) realloc(mgr->nodes,
+                                        size * sizeof(bdd_node_t))))
+    return BDD_OUT_OF_MEM;
+
+  mgr->nodes = nodes;
+  mgr->n_size = size;
+
+  return BDD_OK;
+}
+
+
+static inline void bdd_node_release(bdd_mgr_ptr mgr, bdd_t f)
+{
+  mgr->nodes[f].var = BDD_FREE_VAR;
+  mgr->nodes[f].low = mgr->free_nodes;
+  mgr->free_nodes = f;
+  mgr->live --;
+}
+
+
+/* The unique node (var, low, high) */
+static bdd_t bdd_mk(bdd_mgr_ptr mgr, unsigned var, bdd_t low, bdd_t high)
+{
+  bdd_subtable_ptr st = &mgr->subtables[var];
+  bdd_node_ptr node;
+  bdd_t f;
+
+  if (low == high) return low;
+
+  if ((f = bdd_subtable_find(mgr, st, low, high)))
+    return f;
+
+  if (bdd_nodes_reserve(mgr, 1) != BDD_OK ||
+      bdd_subtable_reserve(mgr, st, 1) != BDD_OK)
+    return BDD_NONE;
+
+  if ((f = mgr->free_nodes))
+    mgr->free_nodes = mgr->nodes[f].low;
+  else
+    f = mgr->used ++;
+
+  node = &mgr->nodes[f];
+  node->var = var;
+  node->low = low;
+  node->high = high;
+  node->ref = 0;
+
+  if (mgr->reordering) {
+    mgr->nodes[low].ref ++;
+    mgr->nodes[high].ref ++;
+  }
+
+  bdd_subtable_insert(mgr, st, f);
+  mgr->live ++;
+
+  return f;
+}
+
+
+/* new variables go at the bottom levels */
+static int bdd_add_vars(bdd_mgr_ptr mgr, unsigned nvars)
+{
+  unsigned v, size = MAX(mgr->vars_size, 16);
+  void *level, *var_at, *subtables;
+
+  while (mgr->nvars + nvars > size)
+    size <<= 1;
+
+  if (size > mgr->vars_size) {
+    if (! (level = realloc(mgr->level, size * sizeof(unsigned))))
+      return BDD_OUT_OF_MEM;
+    mgr->level = (unsigned *) level;
+
+    if (! (var_at = realloc(mgr->var_at, size * sizeof(unsigned))))
+      return BDD_OUT_OF_MEM;
+    mgr->var_at = (unsigned *) var_at;
+
+    if (! (subtables = realloc(mgr->subtables,
+                               size * sizeof(bdd_subtable_t))))
+      return BDD_OUT_OF_MEM;
+    mgr->subtables = (bdd_subtable_ptr) subtables;
+
+    mgr->vars_size = size;
+  }
+
+  for (v = 0; v < nvars; v ++, mgr->nvars ++) {
+    bdd_subtable_ptr st = &mgr->subtables[mgr->nvars];
+
+    if (! (st->slots = (bdd_t *) calloc(BDD_INIT_SUBTABLE, sizeof(bdd_t))))
+      return BDD_OUT_OF_MEM;
+
+    st->size = BDD_INIT_SUBTABLE;
+    st->num = 0;
+    mgr->level[mgr->nvars] = mgr->var_at[mgr->nvars] = mgr->nvars;
+  }
+
+  return BDD_OK;
+}
+
+
+/* Collect, and reorder if enabled, before an operation on f, g, h */
+static void bdd_checkpoint(bdd_mgr_ptr mgr, bdd_t f, bdd_t g, bdd_t h)
+{
+  int gc = mgr->live >= mgr->next_gc;
+  int reorder = mgr->auto_reorder && mgr->live >= mgr->next_reorder;
+
+  if (! gc && ! reorder) return;
+
+  mgr->nodes[f].ref ++;
+  mgr->nodes[g].ref ++;
+  mgr->nodes[h].ref ++;
+
+  if (gc) {
+    bdd_gc(mgr);
+    if (mgr->live > mgr->next_gc / 2) mgr->next_gc *= 2;
+  }
+
+  if (reorder) {
+    bdd_reorder(mgr);
+    mgr->next_reorder = MAX(2 * mgr->live, BDD_INIT_GC);
+  }
+
+  mgr->nodes[f].ref --;
+  mgr->nodes[g].ref --;
+  mgr->nodes[h].ref --;
+}
+
+
+static inline bdd_cache_entry_ptr bdd_cache_slot(bdd_mgr_ptr mgr,
+                                                 unsigned op, bdd_t f,
+                                                 bdd_t g, bdd_t h)
+{
+  return &mgr->cache[bdd_hash(f, g, h ^ (op << 28)) & mgr->cache_mask];
+}
+
+
+static inline void bdd_cache_clear(bdd_mgr_ptr mgr)
+{
+  memset(mgr->cache, 0, (mgr->cache_mask + 1) * sizeof(bdd_cache_entry_t));
+}
+
+
+static bdd_t bdd_ite_rec(bdd_mgr_ptr mgr, bdd_t f, bdd_t g, bdd_t h)
+{
+  bdd_cache_entry_ptr entry;
+  bdd_node_ptr node;
+  bdd_t f0, f1, g0, g1, h0, h1, t, e, res;
+  unsigned top, var;
+
+  /* terminal cases */
+  if (f == BDD_TRUE) return g;
+  if (f == BDD_FALSE) return h;
+  if (g == h) return g;
+  if (g == BDD_TRUE && h == BDD_FALSE) return f;
+
+  /* ite(f, f, h) = ite(f, 1, h) and ite(f, g, f) = ite(f, g, 0) */
+  if (g == f) g = BDD_TRUE;
+  if (h == f) h = BDD_FALSE;
+
+  entry = bdd_cache_slot(mgr, BDD_OP_ITE, f, g, h);
+  if (entry->op == BDD_OP_ITE &&
+      entry->f == f && entry->g == g && entry->h == h)
+    return entry->res;
+
+  top = MIN(LEVEL(mgr, f), MIN(LEVEL(mgr, g), LEVEL(mgr, h)));
+  var = mgr->var_at[top];
+
+  node = &mgr->nodes[f];
+  if (LEVEL(mgr, f) == top) { f0 = node->low; f1 = node->high; }
+  else f0 = f1 = f;
+
+  node = &mgr->nodes[g];
+  if (LEVEL(mgr, g) == top) { g0 = node->low; g1 = node->high; }
+  else g0 = g1 = g;
+
+  node = &mgr->nodes[h];
+  if (LEVEL(mgr, h) == top) { h0 = node->low; h1 = node->high; }
+  else h0 = h1 = h;
+
+  if ((t = bdd_ite_rec(mgr, f1, g1, h1)) == BDD_NONE ||
+      (e = bdd_ite_rec(mgr, f0, g0, h0)) == BDD_NONE ||
+      (res = bdd_mk(mgr, var, e, t)) == BDD_NONE)
+    return BDD_NONE;
+
+  /* the recursion may have reused the slot */
+  entry = bdd_cache_slot(mgr, BDD_OP_ITE, f, g, h);
+  entry->op = BDD_OP_ITE;
+  entry->f = f;
+  entry->g = g;
+  entry->h = h;
+  entry->res = res;
+
+  return res;
+}
+
+
+static bdd_t bdd_restrict_rec(bdd_mgr_ptr mgr, bdd_t f, unsigned v,
+                              int value)
+{
+  bdd_cache_entry_ptr entry;
+  bdd_t low, high, res;
+  unsigned var;
+
+  if (LEVEL(mgr, f) > mgr->level[v]) return f;
+
+  low = mgr->nodes[f].low;
+  high = mgr->nodes[f].high;
+  var = mgr->nodes[f].var;
+
+  if (var == v) return value ? high : low;
+
+  entry = bdd_cache_slot(mgr, BDD_OP_RESTRICT, f, v, value);
+  if (entry->op == BDD_OP_RESTRICT &&
+      entry->f == f && entry->g == v && entry->h == (bdd_t) value)
+    return entry->res;
+
+  if ((low = bdd_restrict_rec(mgr, low, v, value)) == BDD_NONE ||
+      (high = bdd_restrict_rec(mgr, high, v, value)) == BDD_NONE ||
+      (res = bdd_mk(mgr, var, low, high)) == BDD_NONE)
+    return BDD_NONE;
+
+  entry = bdd_cache_slot(mgr, BDD_OP_RESTRICT, f, v, value);
+  entry->op = BDD_OP_RESTRICT;
+  entry->f = f;
+  entry->g = v;
+  entry->h = value;
+  entry->res = res;
+
+  return res;
+}
+
+
+static bdd_t bdd_exists_rec(bdd_mgr_ptr mgr, bdd_t f, unsigned v)
+{
+  bdd_cache_entry_ptr entry;
+  bdd_t low, high, res;
+  unsigned var;
+
+  if (LEVEL(mgr, f) > mgr->level[v]) return f;
+
+  low = mgr->nodes[f].low;
+  high = mgr->nodes[f].high;
+  var = mgr->nodes[f].var;
+
+  if (var == v) return bdd_ite_rec(mgr, low, BDD_TRUE, high);
+
+  entry = bdd_cache_slot(mgr, BDD_OP_EXISTS, f, v, 0);
+  if (entry->op == BDD_OP_EXISTS && entry->f == f && entry->g == v)
+    return entry->res;
+
+  if ((low = bdd_exists_rec(mgr, low, v)) == BDD_NONE ||
+      (high = bdd_exists_rec(mgr, high, v)) == BDD_NONE ||
+      (res = bdd_mk(mgr, var, low, high)) == BDD_NONE)
+    return BDD_NONE;
+
+  entry = bdd_cache_slot(mgr, BDD_OP_EXISTS, f, v, 0);
+  entry->op = BDD_OP_EXISTS;
+  entry->f = f;
+  entry->g = v;
+  entry->h = 0;
+  entry->res = res;
+
+  return res;
+}
+
+
+static double bdd_sat_rec(bdd_mgr_ptr mgr, bdd_t f, double* density)
+{
+  if (IS_CONST(f)) return f == BDD_TRUE ? 1.0 : 0.0;
+
+  if (density[f] < 0)
+    density[f] = (bdd_sat_rec(mgr, mgr->nodes[f].low, density) +
+                  bdd_sat_rec(mgr, mgr->nodes[f].high, density)) / 2;
+
+  return density[f];
+}
+
+
+static long bdd_size_rec(bdd_mgr_ptr mgr, bdd_t f, unsigned char* marks)
+{
+  if (marks[f]) return 0;
+  marks[f] = 1;
+
+  if (IS_CONST(f)) return 1;
+
+  return 1 + bdd_size_rec(mgr, mgr->nodes[f].low, marks)
+    + bdd_size_rec(mgr, mgr->nodes[f].high, marks);
+}
+
+
+static void bdd_mark(bdd_mgr_ptr mgr, bdd_t f, unsigned char* marks)
+{
+  if (IS_CONST(f) || marks[f]) return;
+  marks[f] = 1;
+
+  bdd_mark(mgr, mgr->nodes[f].low, marks);
+  bdd_mark(mgr, mgr->nodes[f].high, marks);
+}
+
+
+/* while reordering only, release f and its descendants as they die */
+static void bdd_deref_rec(bdd_mgr_ptr mgr, bdd_t f)
+{
+  bdd_t low, high;
+
+  if (-- mgr->nodes[f].ref || IS_CONST(f)) return;
+
+  low = mgr->nodes[f].low;
+  high = mgr->nodes[f].high;
+
+  bdd_subtable_remove(mgr, &mgr->subtables[mgr->nodes[f].var], f);
+  bdd_node_release(mgr, f);
+
+  bdd_deref_rec(mgr, low);
+  bdd_deref_rec(mgr, high);
+}
+
+
+/* Swap levels i and i + 1, with variables x and y. Nodes of x which do
+   not depend on y just move down; the others become y nodes in place,
+   with x nodes of the cofactors as children:
+
+     f = x ? (y ? f11 : f10) : (y ? f01 : f00)
+       = y ? (x ? f11 : f01) : (x ? f10 : f00)
+
+   All the memory needed is reserved up front, so that a swap is never
+   left half way. */
+static int bdd_swap(bdd_mgr_ptr mgr, unsigned i)
+{
+  unsigned x = mgr->var_at[i], y = mgr->var_at[i + 1], j, k, n;
+  bdd_subtable_ptr stx = &mgr->subtables[x], sty = &mgr->subtables[y];
+  bdd_t *xs, f, f0, f1, f00, f01, f10, f11, low, high;
+
+  n = stx->num;
+
+  if (bdd_nodes_reserve(mgr, 2 * n) != BDD_OK ||
+      bdd_subtable_reserve(mgr, stx, 2 * n) != BDD_OK ||
+      bdd_subtable_reserve(mgr, sty, n) != BDD_OK ||
+      ! (xs = (bdd_t *) malloc(MAX(n, 1) * sizeof(bdd_t))))
+    return BDD_OUT_OF_MEM;
+
+  for (j = k = 0; j < stx->size; j ++) {
+    if (stx->slots[j]) xs[k ++] = stx->slots[j];
+  }
+
+  for (j = 0; j < n; j ++) {
+    f = xs[j];
+    f0 = mgr->nodes[f].low;
+    f1 = mgr->nodes[f].high;
+
+    if (mgr->nodes[f0].var != y && mgr->nodes[f1].var != y) continue;
+
+    if (mgr->nodes[f0].var == y) {
+      f00 = mgr->nodes[f0].low; f01 = mgr->nodes[f0].high;
+    }
+    else f00 = f01 = f0;
+
+    if (mgr->nodes[f1].var == y) {
+      f10 = mgr->nodes[f1].low; f11 = mgr->nodes[f1].high;
+    }
+    else f10 = f11 = f1;
+
+    bdd_subtable_remove(mgr, stx, f);
+
+    low = bdd_mk(mgr, x, f00, f10);
+    high = bdd_mk(mgr, x, f01, f11);
+    mgr->nodes[low].ref ++;
+    mgr->nodes[high].ref ++;
+
+    bdd_deref_rec(mgr, f0);
+    bdd_deref_rec(mgr, f1);
+
+    mgr->nodes[f].var = y;
+    mgr->nodes[f].low = low;
+    mgr->nodes[f].high = high;
+    bdd_subtable_insert(mgr, sty, f);
+  }
+
+  mgr->var_at[i] = y;
+  mgr->var_at[i + 1] = x;
+  mgr->level[x] = i + 1;
+  mgr->level[y] = i;
+
+  free(xs);
+  return BDD_OK;
+}
+
+
+/* Move v all the way down, then all the way up, and back to the level
+   where the BDDs were smallest. */
+static int bdd_sift(bdd_mgr_ptr mgr, unsigned v)
+{
+  unsigned best = mgr->live, best_level = mgr->level[v];
+  int res;
+
+  while (mgr->level[v] + 1 < mgr->nvars) {
+    if ((res = bdd_swap(mgr, mgr->level[v])) != BDD_OK) return res;
+
+    if (mgr->live < best) {
+      best = mgr->live;
+      best_level = mgr->level[v];
+    }
+    else if (mgr->live > best * BDD_MAX_GROWTH) break;
+  }
+
+  while (mgr->level[v] > 0) {
+    if ((res = bdd_swap(mgr, mgr->level[v] - 1)) != BDD_OK) return res;
+
+    if (mgr->live < best) {
+      best = mgr->live;
+      best_level = mgr->level[v];
+    }
+    else if (mgr->live > best * BDD_MAX_GROWTH) break;
+  }
+
+  while (mgr->level[v] < best_level) {
+    if ((res = bdd_swap(mgr, mgr->level[v])) != BDD_OK) return res;
+  }
+
+  while (mgr->level[v] > best_level) {
+    if ((res = bdd_swap(mgr, mgr->level[v] - 1)) != BDD_OK) return res;
+  }
+
+  return BDD_OK;
+}
+
+
+/* larger levels first */
+static int bdd_sift_order_cmp(const void* a, const void* b)
+{
+  unsigned na = ((const bdd_sift_order_t *) a)->num;
+  unsigned nb = ((const bdd_sift_order_t *) b)->num;
+
+  return na < nb ? 1 : na > nb ? -1 : 0;
+}
@@ -0,0 +1,148 @@
+#ifndef BDD_H
+#define BDD_H
+
+#include "common.h"
+
+/* Reduced ordered binary decision diagrams.
+
+   All BDDs of a manager share one node arena and are hash-consed, so
+   that equal functions are the same node: nodes are 32-bit ids into
+   the arena, 0 and 1 being the constants. Each variable has its own
+   open-addressing unique subtable, keyed by (low, high). Results of
+   ITE and friends go through a direct-mapped, lossy computed cache.
+
+   Dead nodes are reclaimed by mark-and-sweep from the externally
+   referenced ones (bdd_ref/bdd_deref). Collection (and dynamic
+   reordering, if enabled) only happens when an operation starts, with
+   its operands protected, so a result stays valid until the next
+   operation: reference it to keep it longer.
+
+   Reordering is by sifting (Rudell). Adjacent levels are swapped in
+   place, so node ids, and therefore every BDD held by the user, keep
+   denoting the same functions. */
+
+typedef unsigned bdd_t;
+
+#define BDD_FALSE 0
+#define BDD_TRUE  1
+
+/* invalid BDD, returned when out of memory */
+#define BDD_NONE ((bdd_t) -1)
+
+#define BDD_INIT_NODES    1024
+#define BDD_INIT_SUBTABLE 16
+#define BDD_INIT_GC       (1 << 16)
+#define BDD_CACHE_SIZE    (1 << 16)
+
+/* sifting stops moving a variable in one direction once the BDD grows
+   past this factor of the best size found */
+#define BDD_MAX_GROWTH 1.2
+
+/* Error constants */
+#define BDD_OK           0
+#define BDD_OUT_OF_MEM  -2
+
+typedef struct bdd_node_t {
+  unsigned var;
+  bdd_t low;
+  bdd_t high;
+
+  /* external references. While reordering, parent nodes count too */
+  unsigned ref;
+} bdd_node_t;
+typedef bdd_node_t* bdd_node_ptr;
+
+typedef struct bdd_subtable_t {
+  bdd_t* slots;        /* node ids, 0 (BDD_FALSE) marks free slots  */
+  unsigned size;       /* a power of 2                              */
+  unsigned num;
+} bdd_subtable_t;
+typedef bdd_subtable_t* bdd_subtable_ptr;
+
+typedef struct bdd_cache_entry_t {
+  unsigned op;         /* 0 for empty entries                       */
+  bdd_t f, g, h;
+  bdd_t res;
+} bdd_cache_entry_t;
+typedef bdd_cache_entry_t* bdd_cache_entry_ptr;
+
+typedef struct bdd_mgr_t {
+  /* node arena, released nodes are chained through low */
+  bdd_node_ptr nodes;
+  unsigned n_size;
+  unsigned used;
+  bdd_t free_nodes;
+  unsigned live;       /* nodes in use, constants excluded          */
+
+  /* variables, their levels and subtables */
+  unsigned nvars;
+  unsigned vars_size;
+  unsigned* level;     /* variable -> level                         */
+  unsigned* var_at;    /* level -> variable                         */
+  bdd_subtable_ptr subtables;
+
+  bdd_cache_entry_ptr cache;
+  unsigned cache_mask;
+
+  unsigned next_gc;
+  int auto_reorder;
+  unsigned next_reorder;
+  int reordering;
+
+  /* statistics */
+  unsigned gcs;
+  unsigned reorders;
+} bdd_mgr_t;
+typedef bdd_mgr_t* bdd_mgr_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* cache_size is rounded up to a power of 2, 0 for BDD_CACHE_SIZE */
+bdd_mgr_ptr bdd_init(unsigned nvars, unsigned cache_size);
+void bdd_deinit(bdd_mgr_ptr mgr);
+
+/* external references */
+bdd_t bdd_ref(bdd_mgr_ptr mgr, bdd_t f);
+void bdd_deref(bdd_mgr_ptr mgr, bdd_t f);
+
+/* the function of variable v, added (at the bottom level) if new */
+bdd_t bdd_var(bdd_mgr_ptr mgr, unsigned v);
+
+/* node contents, for non-constant f */
+unsigned bdd_top_var(bdd_mgr_ptr mgr, bdd_t f);
+bdd_t bdd_low(bdd_mgr_ptr mgr, bdd_t f);
+bdd_t bdd_high(bdd_mgr_ptr mgr, bdd_t f);
+
+/* operations return BDD_NONE when out of memory */
+bdd_t bdd_ite(bdd_mgr_ptr mgr, bdd_t f, bdd_t g, bdd_t h);
+bdd_t bdd_not(bdd_mgr_ptr mgr, bdd_t f);
+bdd_t bdd_and(bdd_mgr_ptr mgr, bdd_t f, bdd_t g);
+bdd_t bdd_or(bdd_mgr_ptr mgr, bdd_t f, bdd_t g);
+bdd_t bdd_xor(bdd_mgr_ptr mgr, bdd_t f, bdd_t g);
+bdd_t bdd_implies(bdd_mgr_ptr mgr, bdd_t f, bdd_t g);
+
+/* f with variable v set to value, and existentially quantified */
+bdd_t bdd_restrict(bdd_mgr_ptr mgr, bdd_t f, unsigned v, int value);
+bdd_t bdd_exists(bdd_mgr_ptr mgr, bdd_t f, unsigned v);
+
+/* satisfying assignments over all the manager variables */
+double bdd_sat_count(bdd_mgr_ptr mgr, bdd_t f);
+
+/* number of nodes of f, constants included; -1 if out of memory */
+long bdd_size(bdd_mgr_ptr mgr, bdd_t f);
+
+/* nodes in use, constants excluded */
+unsigned bdd_live(bdd_mgr_ptr mgr);
+
+/* mark-and-sweep collection, also clears the computed cache */
+void bdd_gc(bdd_mgr_ptr mgr);
+
+/* sift all variables once, and enable/disable sifting whenever the
+   number of nodes doubles */
+int bdd_reorder(bdd_mgr_ptr mgr);
+void bdd_auto_reorder(bdd_mgr_ptr mgr, int enable);
+
+unsigned bdd_nvars(bdd_mgr_ptr mgr);
+unsigned bdd_var_level(bdd_mgr_ptr mgr, unsigned v);
+
+#endif
@@ -0,0 +1,424 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "cache.h"
+
+/* tables are presized for max_entries, up to this many buckets */
+#define MAX_INIT_BUCKETS (1 << 20)
+
+#define BUCKET(cache, hash)                                                    \
+  (MIX64(hash) & (cache)->mask)
+
+#define ENTRY(l)                                                               \
+  DLIST_ENTRY(l, cache_entry_t, link)
+
+#define OVER_BUDGET(cache)                                                     \
+  (((cache)->max_entries && (cache)->num > (cache)->max_entries) ||            \
+   ((cache)->max_bytes && (cache)->bytes > (cache)->max_bytes))
+
+/* -- internal functions ---------------------------------------------------- */
+static inline cache_entry_ptr cache_lookup(cache_ptr cache, generic_ptr key,
+                                           unsigned hash);
+static inline void cache_touch(cache_ptr cache, cache_entry_ptr e);
+static cache_entry_ptr cache_entry_new(cache_ptr cache);
+static void cache_remove(cache_ptr cache, cache_entry_ptr e);
+static cache_entry_ptr cache_victim(cache_ptr cache);
+static void cache_evict(cache_ptr cache, cache_entry_ptr keep);
+static void cache_grow(cache_ptr cache);
+
+cache_ptr cache_init(hash_func_ptr hash_func,
+                     cmp_func_ptr cmp_func,
+                     free_func_ptr key_free_func,
+                     free_func_ptr value_free_func,
+                     int policy,
+                     size_t max_entries,
+                     size_t max_bytes,
+                     cache_size_func_ptr size_func)
+{
+  cache_ptr cache;
+  size_t n = CACHE_INIT_BUCKETS;
+
+  if (! (cache = (cache_ptr) malloc(sizeof(cache_t))))
+    return NULL;
+
+  while (n < max_entries && n < MAX_INIT_BUCKETS)
+    n <<= 1;
+
+  if (! (cache->buckets = (cache_entry_ptr*)
+         calloc(n, sizeof(cache_entry_ptr)))) {
+    free(cache);
+    return NULL;
+  }
+
+  cache->mask = n - 1;
+
+  cache->hash_func = hash_func;
+  cache->cmp_func = cmp_func;
+  cache->key_free_func = key_free_func;
+  cache->value_free_func = value_free_func;
+  cache->size_func = size_func;
+
+  cache->policy = policy;
+  cache->max_entries = max_entries;
+  cache->max_bytes = max_bytes;
+
+  cache->num = 0;
+  cache->bytes = 0;
+
+  dlist_init(&cache->order);
+  cache->hand = dlist_end(&cache->order);
+
+  cache->chunks = NULL;
+  cache->chunk_used = CACHE_CHUNK_SIZE;
+  cache->free_entries = NULL;
+
+  memset(&cache->stats, 0, sizeof(cache_stats_t));
+
+  return cache;
+}
+
+
+void cache_deinit(cache_ptr cache)
+{
+  CHECK_INSTANCE(cache);
+
+  cache_clear(cache);
+
+  free(cache->buckets);
+  free(cache);
+}
+
+
+void cache_clear(cache_ptr cache)
+{
+  dlist_link_ptr l;
+  cache_entry_ptr e;
+  cache_chunk_ptr chunk;
+
+  CHECK_INSTANCE(cache);
+
+  dlist_foreach(&cache->order, l) {
+    e = ENTRY(l);
+    if (cache->key_free_func)
+      cache->key_free_func(e->key);
+    if (cache->value_free_func)
+      cache->value_free_func(e->value);
+  }
+
+  while ((chunk = cache->chunks)) {
+    cache->chunks = chunk->next;
+    free(chunk);
+  }
+
+  memset(cache->buckets, 0, (cache->mask + 1) * sizeof(cache_entry_ptr));
+
+  cache->num = 0;
+  cache->bytes = 0;
+
+  dlist_init(&cache->order);
+  cache->hand = dlist_end(&cache->order);
+
+  cache->chunk_used = CACHE_CHUNK_SIZE;
+  cache->free_entries = NULL;
+}
+
+
+int cache_put(cache_ptr cache, generic_ptr key, generic_ptr value)
+{
+  CHECK_INSTANCE(cache);
+
+  return cache_put_sized(cache, key, value,
+                         cache->size_func ? cache->size_func(key, value) : 0);
+}
+
+
+int cache_put_sized(cache_ptr cache, generic_ptr key, generic_ptr value,
+                    size_t size)
+{
+  cache_entry_ptr e;
+  unsigned hash;
+  size_t i;
+
+  CHECK_INSTANCE(cache);
+
+  if (cache->max_bytes && size > cache->max_bytes)
+    return CACHE_TOO_BIG;
+
+  hash = cache->hash_func(key);
+
+  if ((e = cache_lookup(cache, key, hash))) {
+    if (cache->key_free_func)
+      cache->key_free_func(e->key);
+    if (cache->value_free_func)
+      cache->value_free_func(e->value);
+
+    cache->bytes += size - e->size;
+    e->key = key;
+    e->value = value;
+    e->size = size;
+
+    cache_touch(cache, e);
+  }
+
+  else {
+    /* keep chains short; when out of memory they just get longer */
+    if (cache->num > cache->mask)
+      cache_grow(cache);
+
+    if (! (e = cache_entry_new(cache)))
+      return CACHE_OUT_OF_MEM;
+
+    e->key = key;
+    e->value = value;
+    e->hash = hash;
+    e->referenced = 0;
+    e->size = size;
+
+    i = BUCKET(cache, hash);
+    e->next = cache->buckets[i];
+    cache->buckets[i] = e;
+
+    /* CLOCK: just behind the hand, the last to be examined */
+    if (cache->policy == CACHE_LRU)
+      dlist_push_front(&cache->order, &e->link);
+    else
+      dlist_insert_before(&cache->order, cache->hand, &e->link);
+
+    ++ cache->num;
+    cache->bytes += size;
+  }
+
+  cache_evict(cache, e);
+  return CACHE_OK;
+}
+
+
+generic_ptr cache_get(cache_ptr cache, generic_ptr key)
+{
+  cache_entry_ptr e;
+
+  CHECK_INSTANCE(cache);
+
+  if (! (e = cache_lookup(cache, key, cache->hash_func(key)))) {
+    ++ cache->stats.misses;
+    return NULL;
+  }
+
+  ++ cache->stats.hits;
+  cache_touch(cache, e);
+
+  return e->value;
+}
+
+
+generic_ptr cache_peek(cache_ptr cache, generic_ptr key)
+{
+  cache_entry_ptr e;
+
+  CHECK_INSTANCE(cache);
+
+  e = cache_lookup(cache, key, cache->hash_func(key));
+  return e ? e->value : NULL;
+}
+
+
+int cache_delete(cache_ptr cache, generic_ptr key)
+{
+  cache_entry_ptr e;
+
+  CHECK_INSTANCE(cache);
+
+  if (! (e = cache_lookup(cache, key, cache->hash_func(key))))
+    return CACHE_NOT_FOUND;
+
+  cache_remove(cache, e);
+  return CACHE_OK;
+}
+
+
+void cache_resize(cache_ptr cache, size_t max_entries, size_t max_bytes)
+{
+  CHECK_INSTANCE(cache);
+
+  cache->max_entries = max_entries;
+  cache->max_bytes = max_bytes;
+
+  cache_evict(cache, NULL);
+}
+
+
+size_t cache_count(cache_ptr cache)
+{
+  CHECK_INSTANCE(cache);
+
+  return cache->num;
+}
+
+
+size_t cache_bytes(cache_ptr cache)
+{
+  CHECK_INSTANCE(cache);
+
+  return cache->bytes;
+}
+
+
+size_t cache_max_bytes(cache_ptr cache)
+{
+  CHECK_INSTANCE(cache);
+
+  return cache->max_bytes;
+}
+
+
+void cache_get_stats(cache_ptr cache, cache_stats_ptr stats)
+{
+  CHECK_INSTANCE(cache);
+
+  *stats = cache->stats;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static inline cache_entry_ptr cache_lookup(cache_ptr cache, generic_ptr key,
+                                           unsigned hash)
+{
+  cache_entry_ptr e;
+
+  /* keys with different hashes can not be equal */
+  for (e = cache->buckets[BUCKET(cache, hash)]; e; e = e->next)
+    if (e->hash == hash && ! cache->cmp_func(key, e->key))
+      return e;
+
+  return NULL;
+}
+
+
+static inline void cache_touch(cache_ptr cache, cache_entry_ptr e)
+{
+  if (cache->policy == CACHE_CLOCK)
+    e->referenced = 1;
+
+  else if (e->link.prev != dlist_end(&cache->order)) {
+    dlist_unlink(&cache->order, &e->link);
+    dlist_push_front(&cache->order, &e->link);
+  }
+}
+
+
+static cache_entry_ptr cache_entry_new(cache_ptr cache)
+{
+  cache_entry_ptr e;
+  cache_chunk_ptr chunk;
+
+  if ((e = cache->free_entries)) {
+    cache->free_entries = e->next;
+    return e;
+  }
+
+  if (cache->chunk_used == CACHE_CHUNK_SIZE) {
+    if (! (chunk = (cache_chunk_ptr) malloc(sizeof(cache_chunk_t))))
+      return NULL;
+
+    chunk->next = cache->chunks;
+    cache->chunks = chunk;
+    cache->chunk_used = 0;
+  }
+
+  return &cache->chunks->entries[cache->chunk_used ++];
+}
+
+
+static void cache_remove(cache_ptr cache, cache_entry_ptr e)
+{
+  cache_entry_ptr* p;
+
+  for (p = &cache->buckets[BUCKET(cache, e->hash)]; *p != e; p = &(*p)->next)
+    ;
+  *p = e->next;
+
+  if (cache->hand == &e->link)
+    cache->hand = e->link.next;
+  dlist_unlink(&cache->order, &e->link);
+
+  -- cache->num;
+  cache->bytes -= e->size;
+
+  if (cache->key_free_func)
+    cache->key_free_func(e->key);
+  if (cache->value_free_func)
+    cache->value_free_func(e->value);
+
+  e->next = cache->free_entries;
+  cache->free_entries = e;
+}
+
+
+static cache_entry_ptr cache_victim(cache_ptr cache)
+{
+  dlist_link_ptr end = dlist_end(&cache->order);
+  cache_entry_ptr e;
+
+  if (cache->policy == CACHE_LRU)
+    return ENTRY(dlist_last(&cache->order));
+
+  /* one sweep clears every bit, so this ends within two */
+  for (;;) {
+    if (cache->hand == end)
+      cache->hand = end->next;
+
+    e = ENTRY(cache->hand);
+    if (! e->referenced)
+      return e;
+
+    e->referenced = 0;
+    cache->hand = cache->hand->next;
+  }
+}
+
+
+/* evict until within bounds, sparing keep */
+static void cache_evict(cache_ptr cache, cache_entry_ptr keep)
+{
+  cache_entry_ptr e;
+
+  while (cache->num && OVER_BUDGET(cache)) {
+    if ((e = cache_victim(cache)) == keep) {
+      if (cache->num == 1)
+        break;
+
+      /* CLOCK only, keep goes round once more */
+      keep->referenced = 1;
+      continue;
+    }
+
+    ++ cache->stats.evictions;
+    cache_remove(cache, e);
+  }
+}
+
+
+static void cache_grow(cache_ptr cache)
+{
+  cache_entry_ptr* buckets;
+  cache_entry_ptr e, next;
+  size_t i, old_size = cache->mask + 1;
+
+  if (! (buckets = (cache_entry_ptr*)
+         calloc(2 * old_size, sizeof(cache_entry_ptr))))
+    return;
+
+  cache->mask = 2 * old_size - 1;
+
+  /* stored hashes, no calls to hash_func */
+  for (i = 0; i < old_size; ++ i)
+    for (e = cache->buckets[i]; e; e = next) {
+      next = e->next;
+      e->next = buckets[BUCKET(cache, e->hash)];
+      buckets[BUCKET(cache, e->hash)] = e;
+    }
+
+  free(cache->buckets);
+  cache->buckets = buckets;
+}
@@ -0,0 +1,134 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "common.h"
+#include "list/list.h"
+
+/* Bounded key-value caches.
+
+   Entries live in a chained hash table, as in ht (chunked entries,
+   stored hashes so that cmp_func only runs on likely matches), and
+   are also linked on an intrusive list giving the eviction order:
+
+   - CACHE_LRU keeps the list in recency order, every hit moves the
+     entry to the front and eviction takes the back.
+
+   - CACHE_CLOCK keeps the list in insertion order and a referenced
+     bit per entry. Hits only set the bit; eviction sweeps a hand over
+     the list, clearing bits, and takes the first entry without one.
+     Hits write nothing but a bit, at the price of a coarser order.
+
+   The cache is bounded by a number of entries, a number of bytes (the
+   size of each entry comes from size_func, or is given explicitly), or
+   both; 0 means unbounded. Evicted entries go to the key and value
+   free functions. */
+
+#define CACHE_LRU          0
+#define CACHE_CLOCK        1
+
+#define CACHE_CHUNK_SIZE   1024
+#define CACHE_INIT_BUCKETS 64
+
+/* Error constants */
+#define CACHE_OK           0
+#define CACHE_NOT_FOUND   -1
+#define CACHE_OUT_OF_MEM  -2
+#define CACHE_TOO_BIG     -3
+
+/* the size of an entry, counted against max_bytes */
+typedef size_t (*cache_size_func_ptr)(generic_ptr key, generic_ptr value);
+
+typedef struct cache_entry_t {
+  generic_ptr key;
+  generic_ptr value;
+  unsigned hash;
+  unsigned referenced;               /* CLOCK only                   */
+  size_t size;
+  struct cache_entry_t* next;        /* chain, or free list          */
+  dlist_link_t link;                 /* eviction order               */
+} cache_entry_t;
+typedef cache_entry_t* cache_entry_ptr;
+
+typedef struct cache_chunk_t {
+  struct cache_chunk_t* next;
+  cache_entry_t entries[CACHE_CHUNK_SIZE];
+} cache_chunk_t;
+typedef cache_chunk_t* cache_chunk_ptr;
+
+typedef struct cache_stats_t {
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long evictions;
+} cache_stats_t;
+typedef cache_stats_t* cache_stats_ptr;
+
+typedef struct cache_t {
+  cache_entry_ptr* buckets;
+  size_t mask;                       /* buckets - 1, a power of 2    */
+
+  hash_func_ptr hash_func;
+  cmp_func_ptr cmp_func;
+  free_func_ptr key_free_func;
+  free_func_ptr value_free_func;
+  cache_size_func_ptr size_func;
+
+  int policy;
+  size_t max_entries;
+  size_t max_bytes;
+
+  size_t num;
+  size_t bytes;
+
+  dlist_t order;                     /* LRU: most recent first       */
+  dlist_link_ptr hand;               /* CLOCK: next entry to examine */
+
+  cache_chunk_ptr chunks;
+  size_t chunk_used;
+  cache_entry_ptr free_entries;
+
+  cache_stats_t stats;
+} cache_t;
+typedef cache_t* cache_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* constructor, size_func may be NULL (entries of size 0 unless put
+   with cache_put_sized) */
+cache_ptr cache_init(hash_func_ptr hash_func,
+                     cmp_func_ptr cmp_func,
+                     free_func_ptr key_free_func,
+                     free_func_ptr value_free_func,
+                     int policy,
+                     size_t max_entries,
+                     size_t max_bytes,
+                     cache_size_func_ptr size_func);
+
+/* destructor */
+void cache_deinit(cache_ptr cache);
+
+/* remove all entries, statistics are kept */
+void cache_clear(cache_ptr cache);
+
+/* insert or replace, evicting as needed. CACHE_TOO_BIG if the entry
+   alone exceeds max_bytes (the cache is left as it was) */
+int cache_put(cache_ptr cache, generic_ptr key, generic_ptr value);
+int cache_put_sized(cache_ptr cache, generic_ptr key, generic_ptr value,
+                    size_t size);
+
+/* the value of key, NULL on a miss. Counts as a use of the entry */
+generic_ptr cache_get(cache_ptr cache, generic_ptr key);
+
+/* as cache_get, without touching the eviction order or statistics */
+generic_ptr cache_peek(cache_ptr cache, generic_ptr key);
+
+int cache_delete(cache_ptr cache, generic_ptr key);
+
+/* new bounds, evicting as needed */
+void cache_resize(cache_ptr cache, size_t max_entries, size_t max_bytes);
+
+size_t cache_count(cache_ptr cache);
+size_t cache_bytes(cache_ptr cache);
+size_t cache_max_bytes(cache_ptr cache);
+void cache_get_stats(cache_ptr cache, cache_stats_ptr stats);
+
+#endif
@@ -24,6 +24,92 @@ typedef int (*cmp_func_ptr)(const generic_ptr a, generic_ptr b); /* 0 -> equal *
 #define MAX(a,b)				                               \
   ((a) > (b) ? (a) : (b))
 
+#define MIN(a,b)				                               \
+  ((a) < (b) ? (a) : (b))
+
+/* hint the cache about an upcoming read; no-op where unsupported */
+#ifdef __GNUC__
+#define PREFETCH(addr)                                                         \
+  __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr)
+#endif
+
+/* index of the lowest set bit of a non-zero 64-bit word */
+#ifdef __GNUC__
+#define CTZ64(x)                                                               \
+  __builtin_ctzll(x)
+#else
+static inline int CTZ64(unsigned long long x)
+{
+  int res = 0;
+  while (! (x & 1)) { x >>= 1; ++ res; }
+  return res;
+}
+#endif
+
+/* number of leading zero bits of a non-zero 64-bit word */
+#ifdef __GNUC__
+#define CLZ64(x)                                                               \
+  __builtin_clzll(x)
+#else
+static inline int CLZ64(unsigned long long x)
+{
+  int res = 0;
+  while (! (x & (1ULL << 63))) { x <<= 1; ++ res; }
+  return res;
+}
+#endif
+
+/* spread the bits of a 64-bit hash over the whole word (the
+   splitmix64 finalizer), for hashes that are not well mixed */
+static inline unsigned long long MIX64(unsigned long long x)
+{
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+  return x ^ (x >> 31);
+}
+
+/* -- Concurrency ----------------------------------------------------------- */
+#define CACHE_LINE_SIZE 64
+
+/* atomics on word-sized integers and pointers, ordering is explicit */
+#ifdef __GNUC__
+#define CACHE_ALIGNED                                                          \
+  __attribute__((aligned(CACHE_LINE_SIZE)))
+
+#define ATOMIC_LOAD(ptr, order)                                                \
+  __atomic_load_n(ptr, __ATOMIC_##order)
+
+#define ATOMIC_STORE(ptr, value, order)                                        \
+  __atomic_store_n(ptr, value, __ATOMIC_##order)
+
+#define ATOMIC_FETCH_ADD(ptr, value, order)                                    \
+  __atomic_fetch_add(ptr, value, __ATOMIC_##order)
+
+/* weak compare-and-swap; on failure *expected gets the current value */
+#define ATOMIC_CAS(ptr, expected, desired, order)                              \
+  __atomic_compare_exchange_n(ptr, expected, desired, 1,                       \
+                              __ATOMIC_##order, __ATOMIC_RELAXED)
+
+#if defined(__i386__) || defined(__x86_64__)
+#define CPU_RELAX()                                                            \
+  __builtin_ia32_pause()
+#else
+#define CPU_RELAX()                                                            \
+  __asm__ __volatile__("" ::: "memory")
+#endif
+
+#else
+/* C11 atomics only apply to _Atomic objects, not to the plain words
+   above, so there is no portable fallback: modules that need atomics
+   check ATOMICS_UNSUPPORTED and fail to build with a clear message */
+#define ATOMICS_UNSUPPORTED
+
+#define CACHE_ALIGNED
+#define CPU_RELAX()
+#endif
+
 #define CHECK_INSTANCE(ptr)                                                    \
   assert(ptr)
 
@@ -0,0 +1,384 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "deque.h"
+
+/* total number of slots in the ring */
+#define SLOTS(deque)                                                           \
+  ((size_t)(deque)->n_blocks << DEQUE_BLOCK_SHIFT)
+
+#define WRAP(deque, slot)                                                      \
+  ((slot) & (SLOTS(deque) - 1))
+
+#define BLOCK_OF(deque, slot)                                                  \
+  ((deque)->map + ((slot) >> DEQUE_BLOCK_SHIFT))
+
+/* slot of the index-th item, the block must be there */
+#define ITEM(deque, index)                                                     \
+  (*BLOCK_OF(deque, WRAP(deque, (deque)->start + (index))))                    \
+  [((deque)->start + (index)) & DEQUE_BLOCK_MASK]
+
+/* -- internal functions ---------------------------------------------------- */
+static inline int deque_reserve(deque_ptr deque, unsigned n);
+static inline generic_dptr deque_block(deque_ptr deque, size_t slot);
+static inline void deque_release(deque_ptr deque, size_t slot);
+
+deque_ptr deque_init(free_func_ptr free_func)
+{
+  deque_ptr deque;
+
+  if (! (deque = (deque_ptr) malloc(sizeof(deque_t))))
+    return NULL;
+
+  if (! (deque->map = (generic_dptr *) calloc(DEQUE_INIT_BLOCKS,
+                                              sizeof(generic_dptr)))) {
+    free(deque);
+    return NULL;
+  }
+
+  deque->n_blocks = DEQUE_INIT_BLOCKS;
+  deque->start = 0;
+  deque->num = 0;
+  deque->free = free_func;
+
+  deque->spare = NULL;
+  deque->n_spare = 0;
+
+  return deque;
+}
+
+
+void deque_deinit(deque_ptr deque)
+{
+  generic_dptr block;
+  CHECK_INSTANCE(deque);
+
+  deque_clear(deque);
+
+  while ((block = deque->spare)) {
+    deque->spare = (generic_dptr)(*block);
+    free(block);
+  }
+
+  free(deque->map);
+  free(deque);
+}
+
+
+/* Release all items (with 'free', if any) and the blocks holding them */
+void deque_clear(deque_ptr deque)
+{
+  unsigned i;
+  CHECK_INSTANCE(deque);
+
+  if (deque->free) {
+    for (i = 0; i < deque->num; i ++)
+      deque->free(ITEM(deque, i));
+  }
+
+  /* blocks reserved by a failed extend may lie beyond the last item */
+  for (i = 0; i < deque->n_blocks; i ++) {
+    if (deque->map[i]) deque_release(deque, (size_t) i << DEQUE_BLOCK_SHIFT);
+  }
+
+  deque->start = 0;
+  deque->num = 0;
+}
+
+
+int deque_push_back(deque_ptr deque, generic_ptr item)
+{
+  size_t slot;
+  generic_dptr block;
+  CHECK_INSTANCE(deque);
+
+  if (deque_reserve(deque, 1) != DEQUE_OK) return DEQUE_OUT_OF_MEM;
+
+  slot = WRAP(deque, deque->start + deque->num);
+  if (! (block = deque_block(deque, slot))) return DEQUE_OUT_OF_MEM;
+
+  block[slot & DEQUE_BLOCK_MASK] = item;
+  deque->num ++;
+
+  return DEQUE_OK;
+}
+
+
+int deque_push_front(deque_ptr deque, generic_ptr item)
+{
+  size_t slot;
+  generic_dptr block;
+  CHECK_INSTANCE(deque);
+
+  if (deque_reserve(deque, 1) != DEQUE_OK) return DEQUE_OUT_OF_MEM;
+
+  slot = WRAP(deque, deque->start - 1);
+  if (! (block = deque_block(deque, slot))) return DEQUE_OUT_OF_MEM;
+
+  block[slot & DEQUE_BLOCK_MASK] = item;
+  deque->start = slot;
+  deque->num ++;
+
+  return DEQUE_OK;
+}
+
+
+int deque_pop_back(deque_ptr deque, generic_dptr item)
+{
+  size_t slot;
+  CHECK_INSTANCE(deque);
+
+  if (! deque->num) return DEQUE_EMPTY;
+
+  slot = WRAP(deque, deque->start + deque->num - 1);
+  (*item) = (*BLOCK_OF(deque, slot))[slot & DEQUE_BLOCK_MASK];
+  deque->num --;
+
+  /* that was the first slot of its block */
+  if (! (slot & DEQUE_BLOCK_MASK)) deque_release(deque, slot);
+
+  return DEQUE_OK;
+}
+
+
+int deque_pop_front(deque_ptr deque, generic_dptr item)
+{
+  size_t slot;
+  CHECK_INSTANCE(deque);
+
+  if (! deque->num) return DEQUE_EMPTY;
+
+  slot = deque->start;
+  (*item) = (*BLOCK_OF(deque, slot))[slot & DEQUE_BLOCK_MASK];
+  deque->start = WRAP(deque, slot + 1);
+  deque->num --;
+
+  /* that was the last slot of its block */
+  if ((slot & DEQUE_BLOCK_MASK) == DEQUE_BLOCK_MASK)
+    deque_release(deque, slot);
+
+  return DEQUE_OK;
+}
+
+
+int deque_peek_back(deque_ptr deque, generic_dptr item)
+{
+  CHECK_INSTANCE(deque);
+
+  if (! deque->num) return DEQUE_EMPTY;
+
+  (*item) = ITEM(deque, deque->num - 1);
+  return DEQUE_OK;
+}
+
+
+int deque_peek_front(deque_ptr deque, generic_dptr item)
+{
+  CHECK_INSTANCE(deque);
+
+  if (! deque->num) return DEQUE_EMPTY;
+
+  (*item) = ITEM(deque, 0);
+  return DEQUE_OK;
+}
+
+
+int deque_fetch(deque_ptr deque, unsigned index, generic_dptr item)
+{
+  CHECK_INSTANCE(deque);
+
+  if (index >= deque->num) return DEQUE_OUT_OF_BOUNDS;
+
+  (*item) = ITEM(deque, index);
+  return DEQUE_OK;
+}
+
+
+/* Overwrite the index-th item. The old one is *not* released. */
+int deque_set(deque_ptr deque, unsigned index, generic_ptr item)
+{
+  CHECK_INSTANCE(deque);
+
+  if (index >= deque->num) return DEQUE_OUT_OF_BOUNDS;
+
+  ITEM(deque, index) = item;
+  return DEQUE_OK;
+}
+
+
+/* Append n items. All the blocks needed are set up before any item
+   is copied, so on failure the deque is left unchanged. */
+int deque_extend_back(deque_ptr deque, generic_dptr items, unsigned n)
+{
+  size_t slot;
+  unsigned i, len;
+  generic_dptr block;
+  CHECK_INSTANCE(deque);
+
+  if (deque_reserve(deque, n) != DEQUE_OK) return DEQUE_OUT_OF_MEM;
+
+  for (i = 0; i < n; i += DEQUE_BLOCK_SIZE - (slot & DEQUE_BLOCK_MASK)) {
+    slot = WRAP(deque, deque->start + deque->num + i);
+    if (! deque_block(deque, slot)) return DEQUE_OUT_OF_MEM;
+  }
+
+  for (i = 0; i < n; i += len) {
+    slot = WRAP(deque, deque->start + deque->num);
+    block = *BLOCK_OF(deque, slot);
+    len = MIN(n - i, DEQUE_BLOCK_SIZE - (slot & DEQUE_BLOCK_MASK));
+
+    memcpy(block + (slot & DEQUE_BLOCK_MASK), items + i,
+           len * sizeof(generic_ptr));
+    deque->num += len;
+  }
+
+  return DEQUE_OK;
+}
+
+
+/* Prepend n items, last one first. See deque_extend_back. */
+int deque_extend_front(deque_ptr deque, generic_dptr items, unsigned n)
+{
+  size_t slot;
+  unsigned i;
+  CHECK_INSTANCE(deque);
+
+  if (deque_reserve(deque, n) != DEQUE_OK) return DEQUE_OUT_OF_MEM;
+
+  for (i = 0; i < n; i += 1 + (slot & DEQUE_BLOCK_MASK)) {
+    slot = WRAP(deque, deque->start - 1 - i);
+    if (! deque_block(deque, slot)) return DEQUE_OUT_OF_MEM;
+  }
+
+  for (i = 0; i < n; i ++) {
+    deque->start = WRAP(deque, deque->start - 1);
+    ITEM(deque, 0) = items[i];
+  }
+
+  deque->num += n;
+  return DEQUE_OK;
+}
+
+
+/* Remove up to n items from the front into 'items', in order. Returns
+   the number of items removed. */
+unsigned deque_pop_many_front(deque_ptr deque, generic_dptr items,
+                              unsigned n)
+{
+  size_t slot;
+  unsigned i, len, offset;
+  CHECK_INSTANCE(deque);
+
+  n = MIN(n, deque->num);
+  for (i = 0; i < n; i += len) {
+    slot = deque->start;
+    offset = slot & DEQUE_BLOCK_MASK;
+    len = MIN(n - i, DEQUE_BLOCK_SIZE - offset);
+
+    memcpy(items + i, *BLOCK_OF(deque, slot) + offset,
+           len * sizeof(generic_ptr));
+
+    deque->start = WRAP(deque, slot + len);
+    deque->num -= len;
+
+    if (offset + len == DEQUE_BLOCK_SIZE) deque_release(deque, slot);
+  }
+
+  return n;
+}
+
+
+/* Remove up to n items from the back into 'items', last one first.
+   Returns the number of items removed. */
+unsigned deque_pop_many_back(deque_ptr deque, generic_dptr items,
+                             unsigned n)
+{
+  unsigned i;
+  CHECK_INSTANCE(deque);
+
+  n = MIN(n, deque->num);
+  for (i = 0; i < n; i ++)
+    deque_pop_back(deque, items + i);
+
+  return n;
+}
+
+
+unsigned deque_n(const deque_ptr deque)
+{
+  CHECK_INSTANCE(deque);
+  return deque->num;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+
+/* Make room for n more items. At least a block worth of slots is
+   always kept free, so the first and the last item never share a
+   block from opposite ends of the ring, and a block emptied at either
+   end really is empty. The map doubles as needed, blocks are moved in
+   order so that the first item ends up in the first block. */
+static inline int deque_reserve(deque_ptr deque, unsigned n)
+{
+  unsigned i, n_blocks, first;
+  generic_dptr* map;
+
+  if ((size_t) deque->num + n + DEQUE_BLOCK_SIZE <= SLOTS(deque))
+    return DEQUE_OK;
+
+  n_blocks = deque->n_blocks;
+  while (((size_t) n_blocks << DEQUE_BLOCK_SHIFT) <
+         (size_t) deque->num + n + DEQUE_BLOCK_SIZE)
+    n_blocks <<= 1;
+
+  if (! (map = (generic_dptr *) calloc(n_blocks, sizeof(generic_dptr))))
+    return DEQUE_OUT_OF_MEM;
+
+  first = deque->start >> DEQUE_BLOCK_SHIFT;
+  for (i = 0; i < deque->n_blocks; i ++)
+    map[i] = deque->map[(first + i) & (deque->n_blocks - 1)];
+
+  free(deque->map);
+  deque->map = map;
+  deque->n_blocks = n_blocks;
+  deque->start &= DEQUE_BLOCK_MASK;
+
+  return DEQUE_OK;
+}
+
+
+/* The block holding 'slot', set up from the pool (or the heap) if
+   needed. NULL if out of memory. */
+static inline generic_dptr deque_block(deque_ptr deque, size_t slot)
+{
+  generic_dptr* entry = BLOCK_OF(deque, slot);
+
+  if (*entry) return *entry;
+
+  if (deque->spare) {
+    (*entry) = deque->spare;
+    deque->spare = (generic_dptr)(*deque->spare);
+    deque->n_spare --;
+  }
+  else (*entry) = (generic_dptr) malloc(DEQUE_BLOCK_SIZE * sizeof(generic_ptr));
+
+  return *entry;
+}
+
+
+/* Give back the block holding 'slot' to the pool (or the heap) */
+static inline void deque_release(deque_ptr deque, size_t slot)
+{
+  generic_dptr* entry = BLOCK_OF(deque, slot);
+  generic_dptr block = *entry;
+
+  (*entry) = NULL;
+
+  if (deque->n_spare < DEQUE_SPARE_BLOCKS) {
+    (*block) = (generic_ptr) deque->spare;
+    deque->spare = block;
+    deque->n_spare ++;
+  }
+  else free(block);
+}
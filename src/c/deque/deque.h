@@ -0,0 +1,69 @@
+#ifndef DEQUE_H
+#define DEQUE_H
+
+#include "common.h"
+
+/* Double ended queue of generic_ptr items, stored in fixed-size blocks
+   (no per-item allocation) reached through a circular map of block
+   pointers. Both ends grow and shrink in O(1), item i is found in O(1)
+   with a shift and a mask. Blocks emptied at either end are kept in a
+   small pool for reuse. Stacks and queues are deques used at one end
+   or both. */
+
+#define DEQUE_BLOCK_SHIFT  7
+#define DEQUE_BLOCK_SIZE   (1 << DEQUE_BLOCK_SHIFT)
+#define DEQUE_BLOCK_MASK   (DEQUE_BLOCK_SIZE - 1)
+
+#define DEQUE_INIT_BLOCKS  4  /* initial map size, a power of 2 */
+#define DEQUE_SPARE_BLOCKS 8  /* max number of pooled blocks    */
+
+/* Error constants */
+#define DEQUE_OK             0
+#define DEQUE_OUT_OF_BOUNDS -1
+#define DEQUE_OUT_OF_MEM    -2
+#define DEQUE_EMPTY         -3
+
+typedef struct deque_t {
+  generic_dptr* map;   /* circular, NULL for unused blocks      */
+  unsigned n_blocks;   /* size of 'map', a power of 2           */
+  size_t start;        /* slot of the first item, in the ring of
+                          n_blocks * DEQUE_BLOCK_SIZE slots      */
+  unsigned num;
+
+  free_func_ptr free;
+
+  /* pooled blocks, chained through their first slot */
+  generic_dptr spare;
+  unsigned n_spare;
+} deque_t;
+typedef deque_t* deque_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+deque_ptr deque_init(free_func_ptr free);
+void deque_deinit(deque_ptr deque);
+void deque_clear(deque_ptr deque);
+
+/* both ends, O(1) */
+int deque_push_back(deque_ptr deque, generic_ptr item);
+int deque_push_front(deque_ptr deque, generic_ptr item);
+int deque_pop_back(deque_ptr deque, generic_dptr item);
+int deque_pop_front(deque_ptr deque, generic_dptr item);
+int deque_peek_back(deque_ptr deque, generic_dptr item);
+int deque_peek_front(deque_ptr deque, generic_dptr item);
+
+/* random access, O(1) */
+int deque_fetch(deque_ptr deque, unsigned index, generic_dptr item);
+int deque_set(deque_ptr deque, unsigned index, generic_ptr item);
+
+/* batches, copied a block at a time. extend_front pushes items one
+   after the other, so they end up in reverse order at the front */
+int deque_extend_back(deque_ptr deque, generic_dptr items, unsigned n);
+int deque_extend_front(deque_ptr deque, generic_dptr items, unsigned n);
+unsigned deque_pop_many_front(deque_ptr deque, generic_dptr items,
+                              unsigned n);
+unsigned deque_pop_many_back(deque_ptr deque, generic_dptr items,
+                             unsigned n);
+
+unsigned deque_n(const deque_ptr deque);
+
+#endif
@@ -0,0 +1,118 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "bloom.h"
+
+#include <math.h>
+
+/* odd constants picking one bit per word (as in Parquet's filters) */
+static const unsigned bloom_salt[BLOOM_BLOCK_WORDS] = {
+  0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+  0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U,
+};
+
+/* the high half of the hash picks the block (without a division) */
+#define BLOCK_OF(bloom, h)                                                     \
+  (&(bloom)->blocks[(size_t)((((h) >> 32) * (bloom)->n_blocks) >> 32)])
+
+/* -- internal functions ---------------------------------------------------- */
+static inline void bloom_mask(unsigned key, unsigned* mask);
+
+bloom_ptr bloom_init(size_t capacity, double fpp)
+{
+  bloom_ptr bloom;
+  double bits;
+  void* blocks;
+
+  if (! (bloom = (bloom_ptr) malloc(sizeof(bloom_t))))
+    return NULL;
+
+  if (fpp <= 0 || fpp >= 1) fpp = 0.01;
+
+  /* bits needed by split block filters, from the Parquet spec */
+  bits = -8.0 * MAX(capacity, 1) / log(1 - pow(fpp, 1.0 / 8));
+  bloom->n_blocks = MAX((size_t) ceil(bits / 256), 1);
+  bloom->num = 0;
+
+  if (posix_memalign(&blocks, CACHE_LINE_SIZE,
+                     bloom->n_blocks * sizeof(bloom_block_t))) {
+    free(bloom);
+    return NULL;
+  }
+
+  bloom->blocks = (bloom_block_ptr) blocks;
+  bloom_clear(bloom);
+
+  return bloom;
+}
+
+
+void bloom_deinit(bloom_ptr bloom)
+{
+  CHECK_INSTANCE(bloom);
+
+  free(bloom->blocks);
+  free(bloom);
+}
+
+
+void bloom_clear(bloom_ptr bloom)
+{
+  CHECK_INSTANCE(bloom);
+
+  memset(bloom->blocks, 0, bloom->n_blocks * sizeof(bloom_block_t));
+  bloom->num = 0;
+}
+
+
+void bloom_add(bloom_ptr bloom, unsigned long long hash)
+{
+  unsigned mask[BLOOM_BLOCK_WORDS], i;
+  bloom_block_ptr block;
+  CHECK_INSTANCE(bloom);
+
+  hash = MIX64(hash);
+  block = BLOCK_OF(bloom, hash);
+  bloom_mask((unsigned) hash, mask);
+
+  for (i = 0; i < BLOOM_BLOCK_WORDS; i ++)
+    block->words[i] |= mask[i];
+
+  bloom->num ++;
+}
+
+
+int bloom_contains(const bloom_ptr bloom, unsigned long long hash)
+{
+  unsigned mask[BLOOM_BLOCK_WORDS], miss = 0, i;
+  bloom_block_ptr block;
+  CHECK_INSTANCE(bloom);
+
+  hash = MIX64(hash);
+  block = BLOCK_OF(bloom, hash);
+  bloom_mask((unsigned) hash, mask);
+
+  /* no early exit, so that the loop vectorizes */
+  for (i = 0; i < BLOOM_BLOCK_WORDS; i ++)
+    miss |= mask[i] & ~ block->words[i];
+
+  return ! miss;
+}
+
+
+size_t bloom_n(const bloom_ptr bloom)
+{
+  CHECK_INSTANCE(bloom);
+  return bloom->num;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static inline void bloom_mask(unsigned key, unsigned* mask)
+{
+  unsigned i;
+
+  for (i = 0; i < BLOOM_BLOCK_WORDS; i ++)
+    mask[i] = 1U << ((key * bloom_salt[i]) >> 27);
+}
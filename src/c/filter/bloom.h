@@ -0,0 +1,43 @@
+#ifndef BLOOM_H
+#define BLOOM_H
+
+#include "common.h"
+
+/* Split block Bloom filters. Each key sets (and tests) 8 bits in a
+   single 256-bit block, one per 32-bit word, so that a lookup touches
+   one cache line and its 8 word operations vectorize (a single AVX2
+   instruction each with -O2 -mavx2).
+
+   Keys are 64-bit hashes, which are mixed again here so they need not
+   be well distributed. Bloom filters can not forget a key: rebuild
+   them when too many keys are gone. */
+
+#define BLOOM_BLOCK_WORDS 8
+
+typedef struct bloom_block_t {
+  unsigned words[BLOOM_BLOCK_WORDS];
+} bloom_block_t;
+typedef bloom_block_t* bloom_block_ptr;
+
+typedef struct bloom_t {
+  bloom_block_ptr blocks;
+  size_t n_blocks;
+  size_t num;          /* keys added */
+} bloom_t;
+typedef bloom_t* bloom_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* room for 'capacity' keys with a false positive rate of about fpp */
+bloom_ptr bloom_init(size_t capacity, double fpp);
+void bloom_deinit(bloom_ptr bloom);
+void bloom_clear(bloom_ptr bloom);
+
+void bloom_add(bloom_ptr bloom, unsigned long long hash);
+
+/* 0 if hash was never added, 1 if it probably was */
+int bloom_contains(const bloom_ptr bloom, unsigned long long hash);
+
+size_t bloom_n(const bloom_ptr bloom);
+
+#endif
@@ -0,0 +1,276 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "cms.h"
+
+/* the counter of row i, and its sign in Count sketches */
+#define SLOT(cms, h, i)                                                        \
+  ((i) * (cms)->width +                                                        \
+   (((unsigned) (h) + (i) * ((unsigned) ((h) >> 32) | 1)) & ((cms)->width - 1)))
+
+#define SIGN(signs, i)                                                         \
+  (((signs) >> (i)) & 1 ? -1 : 1)
+
+/* -- internal functions ---------------------------------------------------- */
+static int cms_cmp_count(const void* a, const void* b);
+static inline void cms_put(unsigned char* buf, unsigned long long x,
+                           unsigned n);
+static inline unsigned long long cms_get(const unsigned char* buf,
+                                         unsigned n);
+
+cms_ptr cms_init(size_t width, unsigned depth, int kind)
+{
+  cms_ptr cms;
+  size_t size = 1;
+
+  if (! depth || depth > CMS_MAX_DEPTH ||
+      (kind != CMS_COUNT_MIN && kind != CMS_COUNT_SKETCH))
+    return NULL;
+
+  while (size < width && size < CMS_MAX_WIDTH)
+    size *= 2;
+
+  if (! (cms = (cms_ptr) malloc(sizeof(cms_t))))
+    return NULL;
+
+  if (! (cms->counters = (long long *)
+         calloc(size * depth, sizeof(long long)))) {
+    free(cms);
+    return NULL;
+  }
+
+  cms->width = size;
+  cms->depth = depth;
+  cms->kind = kind;
+  cms->total = 0;
+
+  return cms;
+}
+
+
+void cms_deinit(cms_ptr cms)
+{
+  CHECK_INSTANCE(cms);
+
+  free(cms->counters);
+  free(cms);
+}
+
+
+void cms_clear(cms_ptr cms)
+{
+  CHECK_INSTANCE(cms);
+
+  memset(cms->counters, 0, cms->width * cms->depth * sizeof(long long));
+  cms->total = 0;
+}
+
+
+void cms_add(cms_ptr cms, unsigned long long hash, long long count)
+{
+  unsigned long long signs;
+  unsigned i;
+  CHECK_INSTANCE(cms);
+
+  hash = MIX64(hash);
+  cms->total += count;
+
+  if (cms->kind == CMS_COUNT_MIN) {
+    for (i = 0; i < cms->depth; i ++)
+      cms->counters[SLOT(cms, hash, i)] += count;
+  }
+  else {
+    signs = MIX64(hash);
+    for (i = 0; i < cms->depth; i ++)
+      cms->counters[SLOT(cms, hash, i)] += SIGN(signs, i) * count;
+  }
+}
+
+
+void cms_add_batch(cms_ptr cms, const unsigned long long* hashes,
+                   const long long* counts, size_t n)
+{
+  size_t i;
+  CHECK_INSTANCE(cms);
+
+  for (i = 0; i < n; i ++)
+    cms_add(cms, hashes[i], counts ? counts[i] : 1);
+}
+
+
+long long cms_estimate(const cms_ptr cms, unsigned long long hash)
+{
+  long long est[CMS_MAX_DEPTH], res;
+  unsigned long long signs;
+  unsigned i;
+  CHECK_INSTANCE(cms);
+
+  hash = MIX64(hash);
+
+  if (cms->kind == CMS_COUNT_MIN) {
+    res = cms->counters[SLOT(cms, hash, 0)];
+    for (i = 1; i < cms->depth; i ++)
+      res = MIN(res, cms->counters[SLOT(cms, hash, i)]);
+
+    return res;
+  }
+
+  signs = MIX64(hash);
+  for (i = 0; i < cms->depth; i ++)
+    est[i] = SIGN(signs, i) * cms->counters[SLOT(cms, hash, i)];
+
+  /* the median, of the two middle ones for even depths */
+  qsort(est, cms->depth, sizeof(long long), cms_cmp_count);
+  return (cms->depth & 1)
+    ? est[cms->depth / 2]
+    : (est[cms->depth / 2 - 1] + est[cms->depth / 2]) / 2;
+}
+
+
+void cms_estimate_batch(const cms_ptr cms, const unsigned long long* hashes,
+                        long long* estimates, size_t n)
+{
+  size_t i;
+  CHECK_INSTANCE(cms);
+
+  for (i = 0; i < n; i ++)
+    estimates[i] = cms_estimate(cms, hashes[i]);
+}
+
+
+int cms_merge(cms_ptr cms, const cms_ptr other)
+{
+  size_t i, n;
+  CHECK_INSTANCE(cms);
+  CHECK_INSTANCE(other);
+
+  if (cms->width != other->width || cms->depth != other->depth ||
+      cms->kind != other->kind)
+    return CMS_MISMATCH;
+
+  /* a plain loop, which vectorizes */
+  n = cms->width * cms->depth;
+  for (i = 0; i < n; i ++)
+    cms->counters[i] += other->counters[i];
+
+  cms->total += other->total;
+  return CMS_OK;
+}
+
+
+long long cms_total(const cms_ptr cms)
+{
+  CHECK_INSTANCE(cms);
+  return cms->total;
+}
+
+
+size_t cms_width(const cms_ptr cms)
+{
+  CHECK_INSTANCE(cms);
+  return cms->width;
+}
+
+
+unsigned cms_depth(const cms_ptr cms)
+{
+  CHECK_INSTANCE(cms);
+  return cms->depth;
+}
+
+
+size_t cms_serialized_size(const cms_ptr cms)
+{
+  CHECK_INSTANCE(cms);
+  return CMS_HEADER_SIZE + cms->width * cms->depth * sizeof(long long);
+}
+
+
+/* Header: magic, kind (1 byte), depth (1 byte), 2 zero bytes, width
+   (8 bytes) and total (8 bytes), followed by the counters, 8 bytes
+   each */
+size_t cms_serialize(const cms_ptr cms, unsigned char* buf)
+{
+  size_t i, n;
+  CHECK_INSTANCE(cms);
+
+  cms_put(buf, CMS_MAGIC, 4);
+  buf[4] = (unsigned char) cms->kind;
+  buf[5] = (unsigned char) cms->depth;
+  buf[6] = buf[7] = 0;
+  cms_put(buf + 8, cms->width, 8);
+  cms_put(buf + 16, (unsigned long long) cms->total, 8);
+
+  n = cms->width * cms->depth;
+  for (i = 0; i < n; i ++)
+    cms_put(buf + CMS_HEADER_SIZE + i * sizeof(long long),
+            (unsigned long long) cms->counters[i], 8);
+
+  return CMS_HEADER_SIZE + n * sizeof(long long);
+}
+
+
+int cms_deserialize(const unsigned char* buf, size_t len, cms_ptr* res)
+{
+  unsigned long long width;
+  size_t i, n;
+  cms_ptr cms;
+
+  (*res) = NULL;
+  if (len < CMS_HEADER_SIZE || cms_get(buf, 4) != CMS_MAGIC)
+    return CMS_BAD_FORMAT;
+
+  width = cms_get(buf + 8, 8);
+  if (buf[4] > CMS_COUNT_SKETCH || ! buf[5] || buf[5] > CMS_MAX_DEPTH ||
+      buf[6] || buf[7] || ! width || width > CMS_MAX_WIDTH ||
+      (width & (width - 1)) ||
+      len != CMS_HEADER_SIZE + width * buf[5] * sizeof(long long))
+    return CMS_BAD_FORMAT;
+
+  if (! (cms = cms_init(width, buf[5], buf[4])))
+    return CMS_OUT_OF_MEM;
+
+  cms->total = (long long) cms_get(buf + 16, 8);
+
+  n = cms->width * cms->depth;
+  for (i = 0; i < n; i ++)
+    cms->counters[i] = (long long)
+      cms_get(buf + CMS_HEADER_SIZE + i * sizeof(long long), 8);
+
+  (*res) = cms;
+  return CMS_OK;
+}
+
+
+/* -- internal functions ---------------------------------------------------- */
+static int cms_cmp_count(const void* a, const void* b)
+{
+  long long x = *(const long long *) a, y = *(const long long *) b;
+  return (x > y) - (x < y);
+}
+
+
+/* n bytes of x, little-endian */
+static inline void cms_put(unsigned char* buf, unsigned long long x,
+                           unsigned n)
+{
+  unsigned i;
+
+  for (i = 0; i < n; i ++)
+    buf[i] = (unsigned char) (x >> (8 * i));
+}
+
+
+static inline unsigned long long cms_get(const unsigned char* buf,
+                                         unsigned n)
+{
+  unsigned long long x = 0;
+  unsigned i;
+
+  for (i = 0; i < n; i ++)
+    x |= (unsigned long long) buf[i] << (8 * i);
+
+  return x;
+}
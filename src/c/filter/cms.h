@@ -0,0 +1,77 @@
+#ifndef CMS_H
+#define CMS_H
+
+#include "common.h"
+
+/* Count-Min sketches (Cormode and Muthukrishnan) and Count sketches
+   (Charikar et al.): depth rows of width counters, each key adding
+   its count to one counter per row.
+
+   Count-Min estimates are the minimum of the key's counters, never
+   below the true count (for non-negative counts), and above it by at
+   most e / width of the total with probability 1 - exp(-depth).
+   Count sketches also add or subtract by a per-row sign and take the
+   median, which is unbiased and also works with negative counts.
+
+   Sketches of the same shape and kind merge by adding up counters.
+   The serialized form is little-endian. Keys are 64-bit hashes,
+   mixed again here; row i uses h1 + i * h2 (Kirsch and Mitzenmacher)
+   of the two halves of the mixed hash. */
+
+#define CMS_COUNT_MIN    0
+#define CMS_COUNT_SKETCH 1
+
+#define CMS_MAX_DEPTH 32
+
+/* widths are rounded up to a power of 2, at most this */
+#define CMS_MAX_WIDTH (1U << 30)
+
+#define CMS_MAGIC       0x31534d43 /* "CMS1" */
+#define CMS_HEADER_SIZE 24
+
+/* Error constants */
+#define CMS_OK            0
+#define CMS_OUT_OF_MEM   -2
+#define CMS_MISMATCH     -3
+#define CMS_BAD_FORMAT   -4
+
+typedef struct cms_t {
+  long long* counters;    /* depth rows of width               */
+  size_t width;           /* a power of 2                      */
+  unsigned depth;
+  int kind;               /* CMS_COUNT_MIN or CMS_COUNT_SKETCH */
+  long long total;        /* of the counts added               */
+} cms_t;
+typedef cms_t* cms_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* NULL if out of memory, or with depth 0 or over CMS_MAX_DEPTH */
+cms_ptr cms_init(size_t width, unsigned depth, int kind);
+void cms_deinit(cms_ptr cms);
+void cms_clear(cms_ptr cms);
+
+void cms_add(cms_ptr cms, unsigned long long hash, long long count);
+
+/* counts may be NULL, to count each hash once */
+void cms_add_batch(cms_ptr cms, const unsigned long long* hashes,
+                   const long long* counts, size_t n);
+
+long long cms_estimate(const cms_ptr cms, unsigned long long hash);
+void cms_estimate_batch(const cms_ptr cms, const unsigned long long* hashes,
+                        long long* estimates, size_t n);
+
+/* add the counts of other, which must have the same shape and kind */
+int cms_merge(cms_ptr cms, const cms_ptr other);
+
+long long cms_total(const cms_ptr cms);
+size_t cms_width(const cms_ptr cms);
+unsigned cms_depth(const cms_ptr cms);
+
+/* serialization: buf must have room for cms_serialized_size bytes.
+   cms_deserialize returns CMS_OK, CMS_OUT_OF_MEM or CMS_BAD_FORMAT */
+size_t cms_serialized_size(const cms_ptr cms);
+size_t cms_serialize(const cms_ptr cms, unsigned char* buf);
+int cms_deserialize(const unsigned char* buf, size_t len, cms_ptr* res);
+
+#endif
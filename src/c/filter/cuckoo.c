@@ -0,0 +1,226 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "cuckoo.h"
+
+#define LANES_LO 0x0001000100010001ULL
+#define LANES_HI 0x8000800080008000ULL
+
+/* the high bit of the lanes of 'word' which are zero; only the lowest
+   one is exact, borrows may flag the ones above it */
+#define ZERO_LANES(word)                                                       \
+  (((word) - LANES_LO) & ~ (word) & LANES_HI)
+
+#define FIND_LANES(word, fp)                                                   \
+  ZERO_LANES((word) ^ ((fp) * LANES_LO))
+
+/* the other bucket of a fingerprint; alternating twice gives back i */
+#define ALT_INDEX(cuckoo, i, fp)                                               \
+  (((i) ^ ((fp) * 0x5bd1e995U)) & ((cuckoo)->n_buckets - 1))
+
+/* -- internal functions ---------------------------------------------------- */
+static inline void cuckoo_split(const cuckoo_ptr cuckoo,
+                                unsigned long long hash,
+                                size_t* index, unsigned* fp);
+static inline int cuckoo_bucket_add(cuckoo_ptr cuckoo, size_t i,
+                                    unsigned fp);
+static inline int cuckoo_bucket_remove(cuckoo_ptr cuckoo, size_t i,
+                                       unsigned fp);
+static int cuckoo_place(cuckoo_ptr cuckoo, size_t i, unsigned fp);
+
+cuckoo_ptr cuckoo_init(size_t capacity)
+{
+  cuckoo_ptr cuckoo;
+  size_t n = 1;
+
+  if (! (cuckoo = (cuckoo_ptr) malloc(sizeof(cuckoo_t))))
+    return NULL;
+
+  while (n * CUCKOO_SLOTS * CUCKOO_LOAD < capacity)
+    n <<= 1;
+
+  cuckoo->n_buckets = MAX(n, 2);
+  cuckoo->seed = 0x2545F4914F6CDD1DULL;
+
+  if (! (cuckoo->buckets = (unsigned long long *)
+         malloc(cuckoo->n_buckets * sizeof(unsigned long long)))) {
+    free(cuckoo);
+    return NULL;
+  }
+
+  cuckoo_clear(cuckoo);
+  return cuckoo;
+}
+
+
+void cuckoo_deinit(cuckoo_ptr cuckoo)
+{
+  CHECK_INSTANCE(cuckoo);
+
+  free(cuckoo->buckets);
+  free(cuckoo);
+}
+
+
+void cuckoo_clear(cuckoo_ptr cuckoo)
+{
+  CHECK_INSTANCE(cuckoo);
+
+  memset(cuckoo->buckets, 0, cuckoo->n_buckets * sizeof(unsigned long long));
+  cuckoo->num = 0;
+  cuckoo->has_victim = 0;
+}
+
+
+int cuckoo_add(cuckoo_ptr cuckoo, unsigned long long hash)
+{
+  size_t i;
+  unsigned fp;
+  CHECK_INSTANCE(cuckoo);
+
+  /* the victim has to find a place first */
+  if (cuckoo->has_victim) return CUCKOO_FULL;
+
+  cuckoo_split(cuckoo, hash, &i, &fp);
+  cuckoo_place(cuckoo, i, fp);
+  cuckoo->num ++;
+
+  return CUCKOO_OK;
+}
+
+
+int cuckoo_contains(const cuckoo_ptr cuckoo, unsigned long long hash)
+{
+  size_t i, j;
+  unsigned fp;
+  CHECK_INSTANCE(cuckoo);
+
+  cuckoo_split(cuckoo, hash, &i, &fp);
+  j = ALT_INDEX(cuckoo, i, fp);
+
+  if (cuckoo->has_victim && cuckoo->victim_fp == fp &&
+      (cuckoo->victim_index == i || cuckoo->victim_index == j))
+    return 1;
+
+  return (FIND_LANES(cuckoo->buckets[i], fp) |
+          FIND_LANES(cuckoo->buckets[j], fp)) != 0;
+}
+
+
+int cuckoo_remove(cuckoo_ptr cuckoo, unsigned long long hash)
+{
+  size_t i, j;
+  unsigned fp;
+  CHECK_INSTANCE(cuckoo);
+
+  cuckoo_split(cuckoo, hash, &i, &fp);
+  j = ALT_INDEX(cuckoo, i, fp);
+
+  if (cuckoo_bucket_remove(cuckoo, i, fp) ||
+      cuckoo_bucket_remove(cuckoo, j, fp)) {
+    cuckoo->num --;
+
+    /* there is room for the victim now */
+    if (cuckoo->has_victim) {
+      cuckoo->has_victim = 0;
+      cuckoo_place(cuckoo, cuckoo->victim_index, cuckoo->victim_fp);
+    }
+
+    return CUCKOO_OK;
+  }
+
+  if (cuckoo->has_victim && cuckoo->victim_fp == fp &&
+      (cuckoo->victim_index == i || cuckoo->victim_index == j)) {
+    cuckoo->has_victim = 0;
+    cuckoo->num --;
+    return CUCKOO_OK;
+  }
+
+  return CUCKOO_NOT_FOUND;
+}
+
+
+size_t cuckoo_n(const cuckoo_ptr cuckoo)
+{
+  CHECK_INSTANCE(cuckoo);
+  return cuckoo->num;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+
+/* low bits pick the bucket, the top 16 bits are the fingerprint (never
+   0, which marks empty slots) */
+static inline void cuckoo_split(const cuckoo_ptr cuckoo,
+                                unsigned long long hash,
+                                size_t* index, unsigned* fp)
+{
+  hash = MIX64(hash);
+
+  (*index) = (size_t) hash & (cuckoo->n_buckets - 1);
+  (*fp) = (unsigned)(hash >> 48);
+  if (! (*fp)) (*fp) = 1;
+}
+
+
+static inline int cuckoo_bucket_add(cuckoo_ptr cuckoo, size_t i,
+                                    unsigned fp)
+{
+  unsigned long long word = cuckoo->buckets[i], free_lanes;
+
+  if (! (free_lanes = ZERO_LANES(word))) return 0;
+
+  cuckoo->buckets[i] = word | ((unsigned long long) fp
+                               << (CTZ64(free_lanes) & ~15));
+  return 1;
+}
+
+
+static inline int cuckoo_bucket_remove(cuckoo_ptr cuckoo, size_t i,
+                                       unsigned fp)
+{
+  unsigned long long word = cuckoo->buckets[i], lanes;
+
+  if (! (lanes = FIND_LANES(word, fp))) return 0;
+
+  cuckoo->buckets[i] = word & ~ (0xFFFFULL << (CTZ64(lanes) & ~15));
+  return 1;
+}
+
+
+/* Put fp in bucket i or its alternate, kicking fingerprints out to
+   their own alternate buckets as needed. The last one kicked out
+   becomes the victim if the kicks run out. */
+static int cuckoo_place(cuckoo_ptr cuckoo, size_t i, unsigned fp)
+{
+  unsigned long long word;
+  unsigned kick, shift, old;
+
+  if (cuckoo_bucket_add(cuckoo, i, fp)) return CUCKOO_OK;
+
+  i = ALT_INDEX(cuckoo, i, fp);
+  if (cuckoo_bucket_add(cuckoo, i, fp)) return CUCKOO_OK;
+
+  for (kick = 0; kick < CUCKOO_MAX_KICKS; kick ++) {
+    cuckoo->seed ^= cuckoo->seed << 13;
+    cuckoo->seed ^= cuckoo->seed >> 7;
+    cuckoo->seed ^= cuckoo->seed << 17;
+
+    shift = 16 * (unsigned)(cuckoo->seed % CUCKOO_SLOTS);
+    word = cuckoo->buckets[i];
+    old = (unsigned)(word >> shift) & 0xFFFF;
+    cuckoo->buckets[i] = (word & ~ (0xFFFFULL << shift))
+      | ((unsigned long long) fp << shift);
+
+    fp = old;
+    i = ALT_INDEX(cuckoo, i, fp);
+    if (cuckoo_bucket_add(cuckoo, i, fp)) return CUCKOO_OK;
+  }
+
+  cuckoo->has_victim = 1;
+  cuckoo->victim_index = i;
+  cuckoo->victim_fp = fp;
+
+  return CUCKOO_FULL;
+}
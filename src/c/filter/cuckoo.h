@@ -0,0 +1,55 @@
+#ifndef CUCKOO_H
+#define CUCKOO_H
+
+#include "common.h"
+
+/* Cuckoo filters (Fan et al.), which unlike Bloom filters can delete
+   keys. Each key keeps a 16-bit fingerprint in one of its two buckets
+   of 4 slots; a bucket is a single 64-bit word, searched for a
+   fingerprint with a few word operations (SWAR) instead of a loop.
+
+   Keys are 64-bit hashes, mixed again here. Only keys that were added
+   must be removed, or other keys may be lost. The false positive rate
+   is about 8 / 2^16 = 0.012%. */
+
+#define CUCKOO_SLOTS 4
+#define CUCKOO_MAX_KICKS 500
+
+/* target load, of the slots */
+#define CUCKOO_LOAD 0.95
+
+/* Error constants */
+#define CUCKOO_OK          0
+#define CUCKOO_NOT_FOUND  -1
+#define CUCKOO_FULL       -3
+
+typedef struct cuckoo_t {
+  unsigned long long* buckets;
+  size_t n_buckets;    /* a power of 2 */
+  size_t num;
+
+  /* the last key kicked out when the filter filled up */
+  int has_victim;
+  size_t victim_index;
+  unsigned victim_fp;
+
+  unsigned long long seed;
+} cuckoo_t;
+typedef cuckoo_t* cuckoo_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+cuckoo_ptr cuckoo_init(size_t capacity);
+void cuckoo_deinit(cuckoo_ptr cuckoo);
+void cuckoo_clear(cuckoo_ptr cuckoo);
+
+/* CUCKOO_FULL if there is no more room, the filter is unchanged */
+int cuckoo_add(cuckoo_ptr cuckoo, unsigned long long hash);
+
+/* 0 if hash is not in the filter, 1 if it probably is */
+int cuckoo_contains(const cuckoo_ptr cuckoo, unsigned long long hash);
+
+int cuckoo_remove(cuckoo_ptr cuckoo, unsigned long long hash);
+
+size_t cuckoo_n(const cuckoo_ptr cuckoo);
+
+#endif
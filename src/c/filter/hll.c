@@ -0,0 +1,574 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "hll.h"
+
+#include <math.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define N_REGISTERS(hll)                                                       \
+  ((size_t) 1 << (hll)->p)
+
+/* sparse sketches turn dense when bigger than the registers */
+#define SPARSE_MAX(hll)                                                        \
+  (N_REGISTERS(hll) / sizeof(unsigned))
+
+#define ENTRY(index, rank)                                                     \
+  (((unsigned)(index) << 6) | (rank))
+
+#define ENTRY_INDEX(e)                                                         \
+  ((e) >> 6)
+
+#define ENTRY_RANK(e)                                                          \
+  ((e) & 63)
+
+/* -- internal functions ---------------------------------------------------- */
+static inline unsigned hll_rank(unsigned long long w, unsigned none);
+static inline void hll_set(unsigned p, unsigned char* registers,
+                           unsigned entry);
+static inline int hll_add_entry(hll_ptr hll, unsigned entry);
+static int hll_flush(hll_ptr hll);
+static int hll_to_dense(hll_ptr hll);
+static unsigned hll_sorted_tmp(const hll_ptr hll, unsigned* tmp);
+static size_t hll_merge_entries(const unsigned* a, size_t na,
+                                const unsigned* b, size_t nb,
+                                unsigned char* out);
+static double hll_sigma(double x);
+static double hll_tau(double x);
+static int hll_cmp_entry(const void* a, const void* b);
+static inline void hll_put32(unsigned char* buf, unsigned x);
+static inline unsigned hll_get32(const unsigned char* buf);
+
+hll_ptr hll_init(unsigned p)
+{
+  hll_ptr hll;
+
+  if (p < HLL_MIN_P || p > HLL_MAX_P) return NULL;
+  if (! (hll = (hll_ptr) malloc(sizeof(hll_t)))) return NULL;
+
+  hll->p = p;
+  hll->registers = NULL;
+  hll->sparse = NULL;
+  hll->n_sparse = hll->sparse_size = 0;
+  hll->n_tmp = 0;
+
+  if (p < HLL_SPARSE_MIN_P && hll_to_dense(hll) != HLL_OK) {
+    free(hll);
+    return NULL;
+  }
+
+  return hll;
+}
+
+
+void hll_deinit(hll_ptr hll)
+{
+  CHECK_INSTANCE(hll);
+
+  free(hll->registers);
+  free(hll->sparse);
+  free(hll);
+}
+
+
+void hll_clear(hll_ptr hll)
+{
+  CHECK_INSTANCE(hll);
+
+  /* dense sketches stay dense, the memory is there already */
+  if (hll->registers)
+    memset(hll->registers, 0, N_REGISTERS(hll));
+
+  hll->n_sparse = 0;
+  hll->n_tmp = 0;
+}
+
+
+int hll_add(hll_ptr hll, unsigned long long hash)
+{
+  CHECK_INSTANCE(hll);
+
+  hash = MIX64(hash);
+  return hll_add_entry(hll, ENTRY(hash >> (64 - HLL_SPARSE_P),
+                                  hll_rank(hash << HLL_SPARSE_P,
+                                           64 - HLL_SPARSE_P + 1)));
+}
+
+
+int hll_add_batch(hll_ptr hll, const unsigned long long* hashes, size_t n)
+{
+  unsigned long long hash;
+  unsigned char rank;
+  size_t i;
+  int res;
+  CHECK_INSTANCE(hll);
+
+  for (i = 0; i < n && ! hll->registers; i ++)
+    if ((res = hll_add(hll, hashes[i])) != HLL_OK) return res;
+
+  /* dense: straight to the registers */
+  for (; i < n; i ++) {
+    hash = MIX64(hashes[i]);
+    rank = hll_rank(hash << hll->p, 64 - hll->p + 1);
+    if (hll->registers[hash >> (64 - hll->p)] < rank)
+      hll->registers[hash >> (64 - hll->p)] = rank;
+  }
+
+  return HLL_OK;
+}
+
+
+/* Ertl, "New cardinality estimation algorithms for HyperLogLog
+   sketches" (2017), from the histogram of the register values */
+double hll_count(const hll_ptr hll)
+{
+  unsigned tmp[HLL_TMP_SIZE], n_tmp;
+  unsigned hist[64], q, k;
+  size_t i, m, used;
+  double z;
+  CHECK_INSTANCE(hll);
+
+  if (! hll->registers) {
+    n_tmp = hll_sorted_tmp(hll, tmp);
+    used = hll_merge_entries(hll->sparse, hll->n_sparse, tmp, n_tmp, NULL);
+
+    /* linear counting, over 2^HLL_SPARSE_P buckets */
+    z = (double) (1ULL << HLL_SPARSE_P);
+    return z * log(z / (z - used));
+  }
+
+  m = N_REGISTERS(hll);
+  q = 64 - hll->p;
+
+  memset(hist, 0, sizeof(hist));
+  for (i = 0; i < m; i ++)
+    hist[hll->registers[i]] ++;
+
+  z = m * hll_tau(1.0 - (double) hist[q + 1] / m);
+  for (k = q; k >= 1; k --)
+    z = 0.5 * (z + hist[k]);
+  z += m * hll_sigma((double) hist[0] / m);
+
+  return (m / (2 * log(2))) * m / z;
+}
+
+
+int hll_merge(hll_ptr hll, const hll_ptr other)
+{
+  size_t i, m;
+  int res;
+  CHECK_INSTANCE(hll);
+  CHECK_INSTANCE(other);
+
+  if (hll->p != other->p) return HLL_MISMATCH;
+
+  if (! other->registers) {
+    for (i = 0; i < other->n_sparse; i ++)
+      if ((res = hll_add_entry(hll, other->sparse[i])) != HLL_OK)
+        return res;
+
+    for (i = 0; i < other->n_tmp; i ++)
+      if ((res = hll_add_entry(hll, other->tmp[i])) != HLL_OK)
+        return res;
+
+    return HLL_OK;
+  }
+
+  if (! hll->registers && (res = hll_to_dense(hll)) != HLL_OK)
+    return res;
+
+  m = N_REGISTERS(hll);
+  i = 0;
+
+#ifdef __SSE2__
+  for (; i + 16 <= m; i += 16) {
+    __m128i a = _mm_loadu_si128((const __m128i*) (hll->registers + i));
+    __m128i b = _mm_loadu_si128((const __m128i*) (other->registers + i));
+    _mm_storeu_si128((__m128i*) (hll->registers + i), _mm_max_epu8(a, b));
+  }
+#endif
+
+  for (; i < m; i ++)
+    hll->registers[i] = MAX(hll->registers[i], other->registers[i]);
+
+  return HLL_OK;
+}
+
+
+unsigned hll_precision(const hll_ptr hll)
+{
+  CHECK_INSTANCE(hll);
+  return hll->p;
+}
+
+
+int hll_is_sparse(const hll_ptr hll)
+{
+  CHECK_INSTANCE(hll);
+  return ! hll->registers;
+}
+
+
+size_t hll_serialized_size(const hll_ptr hll)
+{
+  unsigned tmp[HLL_TMP_SIZE], n_tmp;
+  size_t num;
+  CHECK_INSTANCE(hll);
+
+  if (hll->registers)
+    return HLL_HEADER_SIZE + N_REGISTERS(hll);
+
+  n_tmp = hll_sorted_tmp(hll, tmp);
+  num = hll_merge_entries(hll->sparse, hll->n_sparse, tmp, n_tmp, NULL);
+
+  /* as hll_serialize, dense past the sparse bound */
+  if (num > SPARSE_MAX(hll))
+    return HLL_HEADER_SIZE + N_REGISTERS(hll);
+
+  return HLL_HEADER_SIZE + num * sizeof(unsigned);
+}
+
+
+/* Header: magic, p (1 byte), sparse (1 byte), 2 zero bytes and the
+   number of entries, followed by the registers or the sparse
+   entries, 4 bytes each. The buffered entries can take a sparse
+   sketch past SPARSE_MAX; that one is written dense, as the next
+   flush would make it */
+size_t hll_serialize(const hll_ptr hll, unsigned char* buf)
+{
+  unsigned tmp[HLL_TMP_SIZE], n_tmp;
+  size_t num, i;
+  CHECK_INSTANCE(hll);
+
+  hll_put32(buf, HLL_MAGIC);
+  buf[4] = (unsigned char) hll->p;
+  buf[6] = buf[7] = 0;
+
+  if (hll->registers) {
+    num = N_REGISTERS(hll);
+    memcpy(buf + HLL_HEADER_SIZE, hll->registers, num);
+    buf[5] = 0;
+    hll_put32(buf + 8, (unsigned) num);
+
+    return HLL_HEADER_SIZE + num;
+  }
+
+  n_tmp = hll_sorted_tmp(hll, tmp);
+  num = hll_merge_entries(hll->sparse, hll->n_sparse, tmp, n_tmp, NULL);
+
+  if (num > SPARSE_MAX(hll)) {
+    num = N_REGISTERS(hll);
+    memset(buf + HLL_HEADER_SIZE, 0, num);
+
+    for (i = 0; i < hll->n_sparse; i ++)
+      hll_set(hll->p, buf + HLL_HEADER_SIZE, hll->sparse[i]);
+
+    for (i = 0; i < n_tmp; i ++)
+      hll_set(hll->p, buf + HLL_HEADER_SIZE, tmp[i]);
+
+    buf[5] = 0;
+    hll_put32(buf + 8, (unsigned) num);
+
+    return HLL_HEADER_SIZE + num;
+  }
+
+  (void) hll_merge_entries(hll->sparse, hll->n_sparse, tmp, n_tmp,
+                           buf + HLL_HEADER_SIZE);
+  buf[5] = 1;
+  hll_put32(buf + 8, (unsigned) num);
+
+  return HLL_HEADER_SIZE + num * sizeof(unsigned);
+}
+
+
+int hll_deserialize(const unsigned char* buf, size_t len, hll_ptr* res)
+{
+  unsigned p, sparse, e, prev = 0;
+  size_t num, i;
+  hll_ptr hll;
+
+  (*res) = NULL;
+  if (len < HLL_HEADER_SIZE || hll_get32(buf) != HLL_MAGIC)
+    return HLL_BAD_FORMAT;
+
+  p = buf[4];
+  sparse = buf[5];
+  num = hll_get32(buf + 8);
+
+  if (p < HLL_MIN_P || p > HLL_MAX_P || sparse > 1 || buf[6] || buf[7] ||
+      (sparse && p < HLL_SPARSE_MIN_P) ||
+      (sparse && num > ((size_t) 1 << p) / sizeof(unsigned)) ||
+      (! sparse && num != ((size_t) 1 << p)) ||
+      len != HLL_HEADER_SIZE + num * (sparse ? sizeof(unsigned) : 1))
+    return HLL_BAD_FORMAT;
+
+  if (! (hll = hll_init(p))) return HLL_OUT_OF_MEM;
+  buf += HLL_HEADER_SIZE;
+
+  if (! sparse) {
+    for (i = 0; i < num; i ++)
+      if (buf[i] > 64 - p + 1) goto bad;
+
+    if (! hll->registers && hll_to_dense(hll) != HLL_OK) {
+      hll_deinit(hll);
+      return HLL_OUT_OF_MEM;
+    }
+
+    memcpy(hll->registers, buf, num);
+  }
+
+  else {
+    if (num + HLL_TMP_SIZE > hll->sparse_size) {
+      hll->sparse_size = num + HLL_TMP_SIZE;
+      if (! (hll->sparse = (unsigned *)
+             malloc(hll->sparse_size * sizeof(unsigned)))) {
+        hll_deinit(hll);
+        return HLL_OUT_OF_MEM;
+      }
+    }
+
+    /* entries must be sorted by index, with valid ranks */
+    for (i = 0; i < num; i ++) {
+      e = hll_get32(buf + i * sizeof(unsigned));
+      if ((i && ENTRY_INDEX(e) <= ENTRY_INDEX(prev)) ||
+          ENTRY_INDEX(e) >> HLL_SPARSE_P ||
+          ! ENTRY_RANK(e) || ENTRY_RANK(e) > 64 - HLL_SPARSE_P + 1)
+        goto bad;
+
+      hll->sparse[i] = prev = e;
+    }
+
+    hll->n_sparse = num;
+  }
+
+  (*res) = hll;
+  return HLL_OK;
+
+ bad:
+  hll_deinit(hll);
+  return HLL_BAD_FORMAT;
+}
+
+
+/* -- internal functions ---------------------------------------------------- */
+
+/* position of the first 1 bit of w, from 1; none if w is 0 */
+static inline unsigned hll_rank(unsigned long long w, unsigned none)
+{
+  return w ? (unsigned) CLZ64(w) + 1 : none;
+}
+
+
+/* Set the register of a sparse entry. Its index has HLL_SPARSE_P -
+   p bits more than the register's: if any of them is set, the rank
+   at precision p is within them */
+static inline void hll_set(unsigned p, unsigned char* registers,
+                           unsigned entry)
+{
+  unsigned extra = HLL_SPARSE_P - p;
+  unsigned low = ENTRY_INDEX(entry) & ((1U << extra) - 1);
+  unsigned rank = low
+    ? extra - (63 - CLZ64(low))
+    : extra + ENTRY_RANK(entry);
+  unsigned char* reg = &registers[ENTRY_INDEX(entry) >> extra];
+
+  if (*reg < rank) *reg = rank;
+}
+
+
+static inline int hll_add_entry(hll_ptr hll, unsigned entry)
+{
+  if (hll->registers) {
+    hll_set(hll->p, hll->registers, entry);
+    return HLL_OK;
+  }
+
+  hll->tmp[hll->n_tmp ++] = entry;
+  if (hll->n_tmp < HLL_TMP_SIZE) return HLL_OK;
+
+  return hll_flush(hll);
+}
+
+
+/* Merge the buffered entries into the sparse array, in place from
+   the back, or go dense when the array gets too big */
+static int hll_flush(hll_ptr hll)
+{
+  unsigned tmp[HLL_TMP_SIZE], n_tmp, e;
+  size_t size, i, j, out;
+  unsigned* sparse;
+
+  n_tmp = hll_sorted_tmp(hll, tmp);
+
+  if (hll->n_sparse + n_tmp > SPARSE_MAX(hll))
+    return hll_to_dense(hll);
+
+  if (hll->n_sparse + n_tmp > hll->sparse_size) {
+    size = MAX(hll->sparse_size * 2, 2 * HLL_TMP_SIZE);
+    if (! (sparse = (unsigned *)
+           realloc(hll->sparse, size * sizeof(unsigned))))
+      return HLL_OUT_OF_MEM;
+
+    hll->sparse = sparse;
+    hll->sparse_size = size;
+  }
+
+  /* out never catches up with i: it stays at least j ahead of it */
+  sparse = hll->sparse;
+  i = hll->n_sparse;
+  j = n_tmp;
+  out = hll->n_sparse + n_tmp;
+
+  while (j) {
+    if (i && ENTRY_INDEX(sparse[i - 1]) > ENTRY_INDEX(tmp[j - 1]))
+      e = sparse[-- i];
+    else if (i && ENTRY_INDEX(sparse[i - 1]) == ENTRY_INDEX(tmp[j - 1])) {
+      -- i; -- j;
+      e = MAX(sparse[i], tmp[j]);
+    }
+    else e = tmp[-- j];
+
+    sparse[-- out] = e;
+  }
+
+  /* close the gap left by duplicates */
+  if (out > i) {
+    memmove(sparse + i, sparse + out,
+            (hll->n_sparse + n_tmp - out) * sizeof(unsigned));
+  }
+
+  hll->n_sparse = i + (hll->n_sparse + n_tmp - out);
+  hll->n_tmp = 0;
+
+  return HLL_OK;
+}
+
+
+static int hll_to_dense(hll_ptr hll)
+{
+  size_t i;
+
+  if (! (hll->registers = (unsigned char *) calloc(N_REGISTERS(hll), 1)))
+    return HLL_OUT_OF_MEM;
+
+  for (i = 0; i < hll->n_sparse; i ++)
+    hll_set(hll->p, hll->registers, hll->sparse[i]);
+
+  for (i = 0; i < hll->n_tmp; i ++)
+    hll_set(hll->p, hll->registers, hll->tmp[i]);
+
+  free(hll->sparse);
+  hll->sparse = NULL;
+  hll->n_sparse = hll->sparse_size = 0;
+  hll->n_tmp = 0;
+
+  return HLL_OK;
+}
+
+
+/* the buffered entries, sorted and one per index (with the max rank) */
+static unsigned hll_sorted_tmp(const hll_ptr hll, unsigned* tmp)
+{
+  unsigned i, n = 0;
+
+  if (! hll->n_tmp) return 0;
+
+  memcpy(tmp, hll->tmp, hll->n_tmp * sizeof(unsigned));
+  qsort(tmp, hll->n_tmp, sizeof(unsigned), hll_cmp_entry);
+
+  /* entries of the same index sort by rank, keep the last one */
+  for (i = 1; i < hll->n_tmp; i ++) {
+    if (ENTRY_INDEX(tmp[i]) != ENTRY_INDEX(tmp[n])) n ++;
+    tmp[n] = tmp[i];
+  }
+
+  return n + 1;
+}
+
+
+/* Merge two sorted entry arrays, one entry per index, into out
+   (little-endian) if not NULL. Returns the number of entries */
+static size_t hll_merge_entries(const unsigned* a, size_t na,
+                                const unsigned* b, size_t nb,
+                                unsigned char* out)
+{
+  size_t i = 0, j = 0, num = 0;
+  unsigned e;
+
+  while (i < na || j < nb) {
+    if (j == nb || (i < na && ENTRY_INDEX(a[i]) < ENTRY_INDEX(b[j])))
+      e = a[i ++];
+    else if (i == na || ENTRY_INDEX(b[j]) < ENTRY_INDEX(a[i]))
+      e = b[j ++];
+    else {
+      e = MAX(a[i], b[j]);
+      i ++; j ++;
+    }
+
+    if (out) hll_put32(out + num * sizeof(unsigned), e);
+    num ++;
+  }
+
+  return num;
+}
+
+
+static double hll_sigma(double x)
+{
+  double y = 1, z = x, old;
+
+  if (x == 1) return INFINITY;
+
+  do {
+    x *= x;
+    old = z;
+    z += x * y;
+    y += y;
+  } while (z != old);
+
+  return z;
+}
+
+
+static double hll_tau(double x)
+{
+  double y = 1, z = 1 - x, old;
+
+  if (x == 0 || x == 1) return 0;
+
+  do {
+    x = sqrt(x);
+    old = z;
+    y *= 0.5;
+    z -= (1 - x) * (1 - x) * y;
+  } while (z != old);
+
+  return z / 3;
+}
+
+
+static int hll_cmp_entry(const void* a, const void* b)
+{
+  unsigned x = *(const unsigned *) a, y = *(const unsigned *) b;
+  return (x > y) - (x < y);
+}
+
+
+static inline void hll_put32(unsigned char* buf, unsigned x)
+{
+  buf[0] = x;
+  buf[1] = x >> 8;
+  buf[2] = x >> 16;
+  buf[3] = x >> 24;
+}
+
+
+static inline unsigned hll_get32(const unsigned char* buf)
+{
+  return buf[0] | (buf[1] << 8) | (buf[2] << 16) | ((unsigned) buf[3] << 24);
+}
@@ -0,0 +1,80 @@
+#ifndef HLL_H
+#define HLL_H
+
+#include "common.h"
+
+/* HyperLogLog distinct counters, with 2^p one-byte registers.
+
+   Small sketches start sparse (as in HLL++): a sorted array of
+   (index, rank) pairs at the finer precision HLL_SPARSE_P, plus a
+   small unsorted buffer of recent additions merged into it in
+   batches. They turn dense once the array would be bigger than the
+   registers. Estimates use Ertl's improved estimator, which needs no
+   empirical bias tables; sparse sketches use linear counting at the
+   sparse precision, which is almost exact there.
+
+   Sketches of the same precision merge into the union of their keys,
+   dense registers with a byte-wise max (16 at a time with SSE2). The
+   serialized form is little-endian, so sketches can be shipped
+   between machines. Keys are 64-bit hashes, mixed again here. */
+
+#define HLL_MIN_P 4
+#define HLL_MAX_P 18
+
+/* sparse entries are (index << 6 | rank), with a HLL_SPARSE_P bit
+   index. Sketches with fewer than 2^HLL_SPARSE_MIN_P registers are
+   always dense */
+#define HLL_SPARSE_P     25
+#define HLL_SPARSE_MIN_P 10
+
+/* additions buffered before being merged into the sparse array */
+#define HLL_TMP_SIZE 128
+
+#define HLL_MAGIC       0x314c4c48 /* "HLL1" */
+#define HLL_HEADER_SIZE 12
+
+/* Error constants */
+#define HLL_OK            0
+#define HLL_OUT_OF_MEM   -2
+#define HLL_MISMATCH     -3
+#define HLL_BAD_FORMAT   -4
+
+typedef struct hll_t {
+  unsigned p;
+  unsigned char* registers;    /* 2^p, NULL while sparse            */
+
+  unsigned* sparse;            /* sorted, one entry per index       */
+  size_t n_sparse;
+  size_t sparse_size;
+
+  unsigned tmp[HLL_TMP_SIZE];  /* unsorted, may repeat indexes      */
+  unsigned n_tmp;
+} hll_t;
+typedef hll_t* hll_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* NULL if p is out of HLL_MIN_P .. HLL_MAX_P, or out of memory */
+hll_ptr hll_init(unsigned p);
+void hll_deinit(hll_ptr hll);
+void hll_clear(hll_ptr hll);
+
+int hll_add(hll_ptr hll, unsigned long long hash);
+int hll_add_batch(hll_ptr hll, const unsigned long long* hashes, size_t n);
+
+/* estimated number of distinct hashes added */
+double hll_count(const hll_ptr hll);
+
+/* add the keys of other, which must have the same precision */
+int hll_merge(hll_ptr hll, const hll_ptr other);
+
+unsigned hll_precision(const hll_ptr hll);
+int hll_is_sparse(const hll_ptr hll);
+
+/* serialization: buf must have room for hll_serialized_size bytes.
+   hll_deserialize returns HLL_OK, HLL_OUT_OF_MEM or HLL_BAD_FORMAT */
+size_t hll_serialized_size(const hll_ptr hll);
+size_t hll_serialize(const hll_ptr hll, unsigned char* buf);
+int hll_deserialize(const unsigned char* buf, size_t len, hll_ptr* res);
+
+#endif
@@ -0,0 +1,653 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "graph.h"
+#include "pq/pq.h"
+
+#include <math.h>
+#include <stdint.h>
+
+#ifdef ATOMICS_UNSUPPORTED
+#error "graph traversal needs the __atomic builtins of gcc or clang"
+#endif
+
+#define WORD_BITS 64
+
+#define BIT_TEST(bits, i)                                                      \
+  (((bits)[(i) / WORD_BITS] >> ((i) % WORD_BITS)) & 1)
+
+#define BIT_SET(bits, i)                                                       \
+  ((bits)[(i) / WORD_BITS] |= 1ULL << ((i) % WORD_BITS))
+
+#define N_WORDS(n)                                                             \
+  (((size_t)(n) + WORD_BITS - 1) / WORD_BITS)
+
+#define DEGREE(offsets, u)                                                     \
+  ((offsets)[(u) + 1] - (offsets)[u])
+
+/* OpenMP directives, the code runs sequentially without OpenMP */
+#ifdef _OPENMP
+#define PARALLEL(directive)                                                    \
+  _Pragma(#directive)
+#else
+#define PARALLEL(directive)
+#endif
+
+/* top-down BFS threads buffer this many discovered nodes at a time */
+#define BFS_LOCAL_SIZE 256
+
+/* -- internal functions ---------------------------------------------------- */
+static size_t* graph_csr(unsigned n, const unsigned* from, const unsigned* to,
+                         size_t m, int both_ways, unsigned* targets,
+                         const double* weights, double* arc_weights);
+static unsigned graph_bfs_top_down(graph_ptr graph, unsigned level,
+                                   const unsigned* frontier, unsigned n_f,
+                                   unsigned* next, unsigned* levels,
+                                   unsigned* parents, size_t* m_f);
+static unsigned graph_bfs_bottom_up(graph_ptr graph, unsigned level,
+                                    const unsigned long long* frontier,
+                                    unsigned long long* next,
+                                    unsigned* levels, unsigned* parents,
+                                    size_t* m_f);
+static inline unsigned graph_find(unsigned* labels, unsigned x);
+static inline void graph_link(unsigned* labels, unsigned x, unsigned y);
+static inline int graph_builder_reserve(graph_builder_ptr builder, size_t m);
+
+graph_ptr graph_from_edges(unsigned n, int directed,
+                           const unsigned* sources, const unsigned* targets,
+                           const double* weights, size_t m)
+{
+  size_t i, arcs;
+  unsigned max_id = 0;
+  graph_ptr graph;
+
+  for (i = 0; i < m; i ++)
+    max_id = MAX(max_id, MAX(sources[i], targets[i]));
+
+  if (m) n = MAX(n, max_id + 1);
+  arcs = directed ? m : 2 * m;
+
+  if (! (graph = (graph_ptr) malloc(sizeof(graph_t))))
+    return NULL;
+
+  graph->n = n;
+  graph->m = arcs;
+  graph->directed = directed;
+  graph->offsets = graph->in_offsets = NULL;
+  graph->in_sources = NULL;
+  graph->weights = NULL;
+
+  graph->targets = (unsigned *) malloc(MAX(arcs, 1) * sizeof(unsigned));
+  if (weights)
+    graph->weights = (double *) malloc(MAX(arcs, 1) * sizeof(double));
+
+  if (! graph->targets || (weights && ! graph->weights) ||
+      ! (graph->offsets = graph_csr(n, sources, targets, m, ! directed,
+                                    graph->targets, weights,
+                                    graph->weights))) {
+    graph_deinit(graph);
+    return NULL;
+  }
+
+  /* every arc has its way back already */
+  if (! directed) {
+    graph->in_offsets = graph->offsets;
+    graph->in_sources = graph->targets;
+  }
+
+  /* incoming arcs are built along, so that traversals only read */
+  else if (! (graph->in_sources = (unsigned *)
+              malloc(MAX(arcs, 1) * sizeof(unsigned))) ||
+           ! (graph->in_offsets = graph_csr(n, targets, sources, m, 0,
+                                            graph->in_sources,
+                                            NULL, NULL))) {
+    graph_deinit(graph);
+    return NULL;
+  }
+
+  return graph;
+}
+
+
+void graph_deinit(graph_ptr graph)
+{
+  CHECK_INSTANCE(graph);
+
+  if (graph->in_offsets != graph->offsets) {
+    free(graph->in_offsets);
+    free(graph->in_sources);
+  }
+
+  free(graph->offsets);
+  free(graph->targets);
+  free(graph->weights);
+  free(graph);
+}
+
+
+unsigned graph_n(const graph_ptr graph)
+{
+  CHECK_INSTANCE(graph);
+  return graph->n;
+}
+
+
+size_t graph_m(const graph_ptr graph)
+{
+  CHECK_INSTANCE(graph);
+  return graph->m;
+}
+
+
+size_t graph_degree(const graph_ptr graph, unsigned node)
+{
+  CHECK_INSTANCE(graph);
+
+  if (node >= graph->n) return 0;
+  return DEGREE(graph->offsets, node);
+}
+
+
+size_t graph_neighbors(const graph_ptr graph, unsigned node,
+                       unsigned** targets, double** weights)
+{
+  CHECK_INSTANCE(graph);
+
+  if (node >= graph->n) return 0;
+
+  (*targets) = graph->targets + graph->offsets[node];
+  if (weights)
+    (*weights) = graph->weights ? graph->weights + graph->offsets[node] : NULL;
+
+  return DEGREE(graph->offsets, node);
+}
+
+
+/* Direction-optimizing BFS. Small frontiers are expanded top-down, a
+   queue of nodes at a time; large ones bottom-up, every unreached node
+   looking for a parent among its incoming arcs in a frontier bitmap,
+   which stops at the first one found. Each step runs in parallel. */
+long graph_bfs(graph_ptr graph, unsigned source,
+               unsigned* levels, unsigned* parents)
+{
+  long i, reached = 1;
+  unsigned n, n_f, level, *frontier = NULL, *next = NULL, *tmp;
+  unsigned long long *front_bits = NULL, *next_bits = NULL, *tmp_bits;
+  size_t m_f, m_u, w;
+  int top_down = 1, res = GRAPH_OUT_OF_MEM;
+  CHECK_INSTANCE(graph);
+
+  n = graph->n;
+  if (source >= n) return GRAPH_OUT_OF_BOUNDS;
+
+  if (! (frontier = (unsigned *) malloc(n * sizeof(unsigned))) ||
+      ! (next = (unsigned *) malloc(n * sizeof(unsigned))) ||
+      ! (front_bits = (unsigned long long *)
+         calloc(N_WORDS(n), sizeof(unsigned long long))) ||
+      ! (next_bits = (unsigned long long *)
+         calloc(N_WORDS(n), sizeof(unsigned long long))))
+    goto leave;
+
+PARALLEL(omp parallel for)
+  for (i = 0; i < (long) n; i ++) {
+    levels[i] = GRAPH_NONE;
+    if (parents) parents[i] = GRAPH_NONE;
+  }
+
+  levels[source] = 0;
+  if (parents) parents[source] = source;
+
+  frontier[0] = source;
+  n_f = 1;
+  m_f = DEGREE(graph->offsets, source);
+  m_u = graph->m;
+
+  for (level = 0; n_f; level ++) {
+    if (top_down && m_f > m_u / GRAPH_BFS_ALPHA) {
+      memset(front_bits, 0, N_WORDS(n) * sizeof(unsigned long long));
+      for (i = 0; i < (long) n_f; i ++)
+        BIT_SET(front_bits, frontier[i]);
+
+      top_down = 0;
+    }
+    else if (! top_down && n_f < n / GRAPH_BFS_BETA) {
+      for (w = 0, n_f = 0; w < N_WORDS(n); w ++) {
+        unsigned long long bits = front_bits[w];
+        for (; bits; bits &= bits - 1)
+          frontier[n_f ++] = w * WORD_BITS + CTZ64(bits);
+      }
+
+      top_down = 1;
+    }
+
+    m_u -= MIN(m_u, m_f);
+
+    if (top_down) {
+      n_f = graph_bfs_top_down(graph, level, frontier, n_f, next,
+                               levels, parents, &m_f);
+      tmp = frontier; frontier = next; next = tmp;
+    }
+    else {
+      n_f = graph_bfs_bottom_up(graph, level, front_bits, next_bits,
+                                levels, parents, &m_f);
+      tmp_bits = front_bits; front_bits = next_bits; next_bits = tmp_bits;
+    }
+
+    reached += n_f;
+  }
+
+  res = GRAPH_OK;
+
+ leave:
+  free(frontier);
+  free(next);
+  free(front_bits);
+  free(next_bits);
+
+  return res == GRAPH_OK ? reached : res;
+}
+
+
+/* Union-find over all arcs, linked in parallel with CAS (as in
+   uf_union_batch). Roots are always the smallest node of their set.
+   Arc direction is ignored, so directed graphs get their weakly
+   connected components; undirected ones link each edge once. */
+long graph_components(graph_ptr graph, unsigned* labels)
+{
+  long u;
+  unsigned v, k = 0;
+  size_t e;
+  CHECK_INSTANCE(graph);
+
+PARALLEL(omp parallel for)
+  for (u = 0; u < (long) graph->n; u ++)
+    labels[u] = u;
+
+PARALLEL(omp parallel for private(e, v) schedule(dynamic, 1024))
+  for (u = 0; u < (long) graph->n; u ++) {
+    for (e = graph->offsets[u]; e < graph->offsets[u + 1]; e ++) {
+      v = graph->targets[e];
+
+      if (graph->directed || v < (unsigned) u)
+        graph_link(labels, u, v);
+    }
+  }
+
+PARALLEL(omp parallel for)
+  for (u = 0; u < (long) graph->n; u ++)
+    ATOMIC_STORE(&labels[u], graph_find(labels, u), RELAXED);
+
+  /* roots come before the other nodes of their set, so they are
+     relabeled first */
+  for (u = 0; u < (long) graph->n; u ++)
+    labels[u] = labels[u] == u ? k ++ : labels[labels[u]];
+
+  return k;
+}
+
+
+int graph_dijkstra(graph_ptr graph, unsigned source,
+                   double* dist, unsigned* parents)
+{
+  unsigned u, v, *handles;
+  size_t e;
+  double d;
+  pq_key_t key;
+  generic_ptr data;
+  pq_ptr pq;
+  CHECK_INSTANCE(graph);
+
+  if (source >= graph->n) return GRAPH_OUT_OF_BOUNDS;
+
+  if (graph->weights) {
+    for (e = 0; e < graph->m; e ++)
+      if (! (graph->weights[e] >= 0)) return GRAPH_BAD_WEIGHT;  /* also NaN */
+  }
+
+  if (! (handles = (unsigned *) malloc(graph->n * sizeof(unsigned))))
+    return GRAPH_OUT_OF_MEM;
+
+  if (! (pq = pq_init(0, PQ_KEY_DOUBLE, NULL))) {
+    free(handles);
+    return GRAPH_OUT_OF_MEM;
+  }
+
+  for (u = 0; u < graph->n; u ++) {
+    dist[u] = HUGE_VAL;
+    handles[u] = PQ_NO_HANDLE;
+    if (parents) parents[u] = GRAPH_NONE;
+  }
+
+  key.d = dist[source] = 0;
+  if (parents) parents[source] = source;
+  if (pq_push(pq, key, (generic_ptr)(uintptr_t) source, &handles[source])
+      != PQ_OK)
+    goto oom;
+
+  while (pq_pop(pq, &key, &data) == PQ_OK) {
+    u = (unsigned)(uintptr_t) data;
+
+    for (e = graph->offsets[u]; e < graph->offsets[u + 1]; e ++) {
+      v = graph->targets[e];
+      d = dist[u] + (graph->weights ? graph->weights[e] : 1.0);
+      if (d >= dist[v]) continue;
+
+      key.d = dist[v] = d;
+      if (parents) parents[v] = u;
+
+      /* settled nodes are never relaxed again, so a stale handle can
+         only mean v is not queued */
+      if (pq_decrease_key(pq, handles[v], key) == PQ_BAD_HANDLE &&
+          pq_push(pq, key, (generic_ptr)(uintptr_t) v, &handles[v]) != PQ_OK)
+        goto oom;
+    }
+  }
+
+  pq_deinit(pq);
+  free(handles);
+  return GRAPH_OK;
+
+ oom:
+  pq_deinit(pq);
+  free(handles);
+  return GRAPH_OUT_OF_MEM;
+}
+
+
+graph_builder_ptr graph_builder_init(unsigned n, int directed)
+{
+  graph_builder_ptr builder;
+
+  if (! (builder = (graph_builder_ptr) malloc(sizeof(graph_builder_t))))
+    return NULL;
+
+  builder->n = n;
+  builder->directed = directed;
+
+  builder->sources = builder->targets = NULL;
+  builder->weights = NULL;
+  builder->num = builder->n_size = 0;
+
+  if (graph_builder_reserve(builder, GRAPH_INIT_EDGES) != GRAPH_OK) {
+    graph_builder_deinit(builder);
+    return NULL;
+  }
+
+  return builder;
+}
+
+
+void graph_builder_deinit(graph_builder_ptr builder)
+{
+  CHECK_INSTANCE(builder);
+
+  free(builder->sources);
+  free(builder->targets);
+  free(builder->weights);
+  free(builder);
+}
+
+
+int graph_builder_add_edge(graph_builder_ptr builder, unsigned source,
+                           unsigned target, double weight)
+{
+  return graph_builder_add_edges(builder, &source, &target, &weight, 1);
+}
+
+
+/* Add m edges, weights may be NULL (all 1). The builder only keeps
+   weights once some edge has a weight other than 1. */
+int graph_builder_add_edges(graph_builder_ptr builder,
+                            const unsigned* sources, const unsigned* targets,
+                            const double* weights, size_t m)
+{
+  size_t i;
+  CHECK_INSTANCE(builder);
+
+  if (graph_builder_reserve(builder, m) != GRAPH_OK)
+    return GRAPH_OUT_OF_MEM;
+
+  if (weights && ! builder->weights) {
+    for (i = 0; i < m && weights[i] == 1.0; i ++)
+      ;
+
+    if (i < m) {
+      if (! (builder->weights = (double *)
+             malloc(builder->n_size * sizeof(double))))
+        return GRAPH_OUT_OF_MEM;
+
+      for (i = 0; i < builder->num; i ++)
+        builder->weights[i] = 1.0;
+    }
+  }
+
+  memcpy(builder->sources + builder->num, sources, m * sizeof(unsigned));
+  memcpy(builder->targets + builder->num, targets, m * sizeof(unsigned));
+
+  if (builder->weights) {
+    for (i = 0; i < m; i ++)
+      builder->weights[builder->num + i] = weights ? weights[i] : 1.0;
+  }
+
+  builder->num += m;
+  return GRAPH_OK;
+}
+
+
+graph_ptr graph_builder_freeze(graph_builder_ptr builder)
+{
+  CHECK_INSTANCE(builder);
+
+  return graph_from_edges(builder->n, builder->directed,
+                          builder->sources, builder->targets,
+                          builder->weights, builder->num);
+}
+
+/* -- internal functions ---------------------------------------------------- */
+
+/* Counting sort of m edges by 'from' into targets (and arc_weights),
+   both ways if requested. Returns the n + 1 offsets, NULL if out of
+   memory. Arcs of each node keep the order of the edges. */
+static size_t* graph_csr(unsigned n, const unsigned* from, const unsigned* to,
+                         size_t m, int both_ways, unsigned* targets,
+                         const double* weights, double* arc_weights)
+{
+  size_t i, *offsets, *next;
+  unsigned u;
+
+  if (! (offsets = (size_t *) calloc((size_t) n + 1, sizeof(size_t))))
+    return NULL;
+
+  if (! (next = (size_t *) malloc(MAX(n, 1) * sizeof(size_t)))) {
+    free(offsets);
+    return NULL;
+  }
+
+  for (i = 0; i < m; i ++) {
+    offsets[from[i] + 1] ++;
+    if (both_ways) offsets[to[i] + 1] ++;
+  }
+
+  for (u = 0; u < n; u ++) {
+    offsets[u + 1] += offsets[u];
+    next[u] = offsets[u];
+  }
+
+  for (i = 0; i < m; i ++) {
+    if (arc_weights) arc_weights[next[from[i]]] = weights[i];
+    targets[next[from[i]] ++] = to[i];
+
+    if (both_ways) {
+      if (arc_weights) arc_weights[next[to[i]]] = weights[i];
+      targets[next[to[i]] ++] = from[i];
+    }
+  }
+
+  free(next);
+  return offsets;
+}
+
+
+/* Expand the frontier queue into 'next'. Nodes are claimed with a CAS
+   on their level, and each thread collects its own in a small buffer
+   which it appends to 'next' a batch at a time. Returns the size of
+   the new frontier, its arcs count goes in m_f. */
+static unsigned graph_bfs_top_down(graph_ptr graph, unsigned level,
+                                   const unsigned* frontier, unsigned n_f,
+                                   unsigned* next, unsigned* levels,
+                                   unsigned* parents, size_t* m_f)
+{
+  unsigned n_next = 0;
+  size_t m_next = 0;
+
+PARALLEL(omp parallel reduction(+: m_next))
+  {
+    unsigned local[BFS_LOCAL_SIZE], n_local = 0, u, v, none, pos;
+    long i;
+    size_t e;
+
+PARALLEL(omp for schedule(dynamic, 64))
+    for (i = 0; i < (long) n_f; i ++) {
+      u = frontier[i];
+
+      for (e = graph->offsets[u]; e < graph->offsets[u + 1]; e ++) {
+        v = graph->targets[e];
+        if (ATOMIC_LOAD(&levels[v], RELAXED) != GRAPH_NONE) continue;
+
+        none = GRAPH_NONE;
+        if (! ATOMIC_CAS(&levels[v], &none, level + 1, RELAXED)) continue;
+
+        if (parents) parents[v] = u;
+        m_next += DEGREE(graph->offsets, v);
+
+        local[n_local ++] = v;
+        if (n_local == BFS_LOCAL_SIZE) {
+          pos = ATOMIC_FETCH_ADD(&n_next, n_local, RELAXED);
+          memcpy(next + pos, local, n_local * sizeof(unsigned));
+          n_local = 0;
+        }
+      }
+    }
+
+    if (n_local) {
+      pos = ATOMIC_FETCH_ADD(&n_next, n_local, RELAXED);
+      memcpy(next + pos, local, n_local * sizeof(unsigned));
+    }
+  }
+
+  (*m_f) = m_next;
+  return n_next;
+}
+
+
+/* Each unreached node looks for a parent in the frontier bitmap. Work
+   is split by bitmap words, so every word of 'next' (and every level)
+   has a single writer and no atomics are needed. */
+static unsigned graph_bfs_bottom_up(graph_ptr graph, unsigned level,
+                                    const unsigned long long* frontier,
+                                    unsigned long long* next,
+                                    unsigned* levels, unsigned* parents,
+                                    size_t* m_f)
+{
+  long w;
+  unsigned n_next = 0;
+  size_t m_next = 0;
+
+PARALLEL(omp parallel for schedule(dynamic, 16) reduction(+: n_next, m_next))
+  for (w = 0; w < (long) N_WORDS(graph->n); w ++) {
+    unsigned long long bits = 0;
+    unsigned v, u, last = MIN((unsigned)(w + 1) * WORD_BITS, graph->n);
+    size_t e;
+
+    for (v = (unsigned) w * WORD_BITS; v < last; v ++) {
+      if (levels[v] != GRAPH_NONE) continue;
+
+      for (e = graph->in_offsets[v]; e < graph->in_offsets[v + 1]; e ++) {
+        u = graph->in_sources[e];
+        if (! BIT_TEST(frontier, u)) continue;
+
+        levels[v] = level + 1;
+        if (parents) parents[v] = u;
+
+        bits |= 1ULL << (v % WORD_BITS);
+        n_next ++;
+        m_next += DEGREE(graph->offsets, v);
+        break;
+      }
+    }
+
+    next[w] = bits;
+  }
+
+  (*m_f) = m_next;
+  return n_next;
+}
+
+
+/* root of x's set, halving the path on the way. Concurrent links
+   may move x further up meanwhile: a failed CAS only means that, and
+   the grandparent is still an ancestor of x */
+static inline unsigned graph_find(unsigned* labels, unsigned x)
+{
+  unsigned p, gp;
+
+  while ((p = ATOMIC_LOAD(&labels[x], RELAXED)) != x) {
+    gp = ATOMIC_LOAD(&labels[p], RELAXED);
+    if (gp != p) (void) ATOMIC_CAS(&labels[x], &p, gp, RELAXED);
+    x = gp;
+  }
+
+  return x;
+}
+
+
+/* join the sets of x and y, the bigger root going under the smaller
+   one. The CAS fails if that root was linked meanwhile, then both are
+   looked up again */
+static inline void graph_link(unsigned* labels, unsigned x, unsigned y)
+{
+  unsigned tmp;
+
+  for (;;) {
+    x = graph_find(labels, x);
+    y = graph_find(labels, y);
+    if (x == y) return;
+
+    if (x < y) {
+      tmp = x; x = y; y = tmp;
+    }
+
+    tmp = x;
+    if (ATOMIC_CAS(&labels[x], &tmp, y, RELAXED)) return;
+  }
+}
+
+
+static inline int graph_builder_reserve(graph_builder_ptr builder, size_t m)
+{
+  size_t size;
+  void *sources, *targets, *weights;
+
+  if (builder->num + m <= builder->n_size) return GRAPH_OK;
+
+  size = MAX(2 * builder->n_size, builder->num + m);
+
+  if (! (sources = realloc(builder->sources, size * sizeof(unsigned))))
+    return GRAPH_OUT_OF_MEM;
+  builder->sources = (unsigned *) sources;
+
+  if (! (targets = realloc(builder->targets, size * sizeof(unsigned))))
+    return GRAPH_OUT_OF_MEM;
+  builder->targets = (unsigned *) targets;
+
+  if (builder->weights) {
+    if (! (weights = realloc(builder->weights, size * sizeof(double))))
+      return GRAPH_OUT_OF_MEM;
+    builder->weights = (double *) weights;
+  }
+
+  builder->n_size = size;
+  return GRAPH_OK;
+}
@@ -0,0 +1,108 @@
+#ifndef GRAPH_H
+#define GRAPH_H
+
+#include "common.h"
+
+/* Directed and undirected graphs in compressed sparse row (CSR) form.
+   Nodes are unboxed ids 0 .. n - 1; the arcs leaving node u are
+   targets[offsets[u]] .. targets[offsets[u + 1] - 1], with optional
+   double weights alongside. Undirected edges are stored as two arcs.
+
+   Graphs are immutable once built, either straight from edge arrays
+   (graph_from_edges) or through a builder collecting edges one batch
+   at a time (graph_builder_xxx). BFS and connected components run in
+   parallel when built with OpenMP. */
+
+/* Direction-optimizing BFS switches to bottom-up steps when the
+   frontier has more than 1/ALPHA of the unexplored arcs, and back to
+   top-down when it has fewer than 1/BETA of the nodes (Beamer et al.) */
+#define GRAPH_BFS_ALPHA 14
+#define GRAPH_BFS_BETA  24
+
+#define GRAPH_INIT_EDGES 1024
+
+/* levels/parents/labels of unreached nodes */
+#define GRAPH_NONE ((unsigned) -1)
+
+/* Error constants */
+#define GRAPH_OK              0
+#define GRAPH_OUT_OF_BOUNDS  -1
+#define GRAPH_OUT_OF_MEM     -2
+#define GRAPH_BAD_WEIGHT     -4
+
+typedef struct graph_t {
+  unsigned n;          /* number of nodes                         */
+  size_t m;            /* number of arcs                          */
+  int directed;
+
+  size_t* offsets;     /* n + 1 entries                           */
+  unsigned* targets;   /* m entries                               */
+  double* weights;     /* m entries, NULL for unweighted graphs   */
+
+  /* incoming arcs, for bottom-up BFS steps. The graph itself for
+     undirected graphs, built along with directed ones */
+  size_t* in_offsets;
+  unsigned* in_sources;
+} graph_t;
+typedef graph_t* graph_ptr;
+
+typedef struct graph_builder_t {
+  unsigned n;
+  int directed;
+
+  unsigned* sources;
+  unsigned* targets;
+  double* weights;     /* NULL until the first weighted edge */
+  size_t num;
+  size_t n_size;
+} graph_builder_t;
+typedef graph_builder_t* graph_builder_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* Build a graph of (at least) n nodes from m edges sources[i] ->
+   targets[i]. weights may be NULL. The arrays are copied. */
+graph_ptr graph_from_edges(unsigned n, int directed,
+                           const unsigned* sources, const unsigned* targets,
+                           const double* weights, size_t m);
+void graph_deinit(graph_ptr graph);
+
+unsigned graph_n(const graph_ptr graph);
+size_t graph_m(const graph_ptr graph);
+size_t graph_degree(const graph_ptr graph, unsigned node);
+
+/* arcs leaving 'node', weights is set to NULL for unweighted graphs */
+size_t graph_neighbors(const graph_ptr graph, unsigned node,
+                       unsigned** targets, double** weights);
+
+/* Breadth-first search from 'source'. levels (and parents, if not
+   NULL) must have room for n entries, GRAPH_NONE marks unreached
+   nodes. Returns the number of nodes reached, or a negative error. */
+long graph_bfs(graph_ptr graph, unsigned source,
+               unsigned* levels, unsigned* parents);
+
+/* (Weakly) connected components: labels get ids 0 .. k - 1 in order of
+   their smallest node. Returns k, or a negative error. */
+long graph_components(graph_ptr graph, unsigned* labels);
+
+/* Single source shortest paths over non-negative weights (1 for
+   unweighted graphs). dist (and parents, if not NULL) must have room
+   for n entries, unreached nodes get HUGE_VAL and GRAPH_NONE. Returns
+   GRAPH_BAD_WEIGHT if any weight is negative or NaN. */
+int graph_dijkstra(graph_ptr graph, unsigned source,
+                   double* dist, unsigned* parents);
+
+/* builders */
+graph_builder_ptr graph_builder_init(unsigned n, int directed);
+void graph_builder_deinit(graph_builder_ptr builder);
+
+int graph_builder_add_edge(graph_builder_ptr builder, unsigned source,
+                           unsigned target, double weight);
+int graph_builder_add_edges(graph_builder_ptr builder,
+                            const unsigned* sources, const unsigned* targets,
+                            const double* weights, size_t m);
+
+/* the builder is left untouched, and can be reused */
+graph_ptr graph_builder_freeze(graph_builder_ptr builder);
+
+#endif
@@ -21,6 +21,13 @@ static inline int ht_allocate_table(ht_ptr this);
 static inline int ht_new_chunk(ht_ptr this);
 static inline void ht_free_entry(ht_ptr this, ht_entry_ptr entry);
 static inline int ht_grow(ht_ptr this);
+static int ht_rehash(ht_ptr this, int prime_index);
+static int ht_filter_build(ht_ptr this, size_t capacity);
+static inline int ht_filter_contains(ht_ptr this, unsigned hash);
+static inline void ht_filter_add(ht_ptr this, unsigned hash);
+static inline int ht_cuckoo_add(ht_ptr this, cuckoo_ptr cuckoo,
+                                unsigned hash);
+static inline void ht_cuckoo_remove(ht_ptr this, unsigned hash);
 
 #ifdef HT_STATS
 typedef struct _ht_profile_struct {
@@ -49,10 +56,16 @@ ht_ptr ht_init(hash_func_ptr hash_func,
   this->value_free_func = value_free_func;
 
   this->entries = 0;
+  this->stamp = 0;
   this->prime_index = 0;
 
   this->chunks = NULL;
 
+  this->filter = HT_FILTER_NONE;
+  this->bloom = NULL;
+  this->cuckoo = NULL;
+  this->stashed = 0;
+
   /* First chunk setup */
   if (!ht_new_chunk(this)) {
     free(this);
@@ -156,6 +169,10 @@ void ht_deinit(ht_ptr this)
     chunk = next_chunk;
   }
 
+  /* Free the filter */
+  if (this->bloom) bloom_deinit(this->bloom);
+  if (this->cuckoo) cuckoo_deinit(this->cuckoo);
+
   /* Free the hash table structure */
   free(this);
 }
@@ -192,6 +209,7 @@ void ht_clear(ht_ptr this)
   }
 
   this->entries = 0;
+  ++ this->stamp;
   this->prime_index = 0;
 
   this->chunks = NULL;
@@ -202,6 +220,10 @@ void ht_clear(ht_ptr this)
 
   tmp = ht_allocate_table(this);
   assert(tmp);
+
+  /* An empty filter, for the new table size */
+  if (this->filter != HT_FILTER_NONE)
+    ht_filter_build(this, this->next_rehash + 1);
 }
 
 
@@ -210,7 +232,7 @@ int ht_insert(ht_ptr this, generic_ptr key, generic_ptr value)
   CHECK_INSTANCE(this);
 
   ht_entry_ptr rover, newentry;
-  unsigned index;
+  unsigned hash, index;
 
   /* If there are too many items in the table with respect to the
    * table size, the number of hash collisions increases and
@@ -221,14 +243,16 @@ int ht_insert(ht_ptr this, generic_ptr key, generic_ptr value)
   }
 
   /* Generate the hash of the key and hence the index into the table */
-  index = this->hash_func(key) % this->table_size;
+  hash = this->hash_func(key);
+  index = hash % this->table_size;
 
   /* Traverse the chain at this location and look for an existing
-   * entry with the same key */
+   * entry with the same key. Keys with different hashes can not be
+   * equal, so cmp_func is only called on the others. */
   rover = this->table[index];
 
   while (rover != NULL) {
-    if (!(this->cmp_func(rover->key, key))) {
+    if (rover->hash == hash && !(this->cmp_func(rover->key, key))) {
 
       /* Same key: overwrite this entry with new data */
       ht_free_entry(this, rover);
@@ -252,6 +276,7 @@ int ht_insert(ht_ptr this, generic_ptr key, generic_ptr value)
 
   newentry->key = key;
   newentry->value = value;
+  newentry->hash = hash;
 
   /* Link into the list */
   newentry->next = this->table[index];
@@ -259,6 +284,10 @@ int ht_insert(ht_ptr this, generic_ptr key, generic_ptr value)
 
   /* Maintain the count of the number of entries */
   ++ this->entries;
+  ++ this->stamp;
+
+  if (this->filter != HT_FILTER_NONE)
+    ht_filter_add(this, hash);
 
   /* Added successfully */
   return 1;
@@ -269,17 +298,23 @@ generic_ptr ht_find(ht_ptr this, generic_ptr key)
   CHECK_INSTANCE(this);
 
   ht_entry_ptr rover;
+  unsigned hash;
   int index;
 
-  /* Generate the hash of the key and hence the index into the table */
-  index = this->hash_func(key) % this->table_size;
+  /* Definite misses end here, before touching the table */
+  hash = this->hash_func(key);
+  if (this->filter != HT_FILTER_NONE && !ht_filter_contains(this, hash))
+    return NULL;
+
+  /* Generate the index into the table */
+  index = hash % this->table_size;
 
   /* Walk the chain at this index until the corresponding entry is
    * found */
   rover = this->table[index];
 
   while (rover != NULL) {
-    if (!(this->cmp_func(key, rover->key))) {
+    if (rover->hash == hash && !(this->cmp_func(key, rover->key))) {
 
       /* Found the entry.  Return the data. */
       return rover->value;
@@ -298,11 +333,13 @@ int ht_delete(ht_ptr this, generic_ptr key)
 
   ht_entry_dptr rover;
   ht_entry_ptr entry;
+  unsigned hash;
   int index;
   int result;
 
   /* Generate the hash of the key and hence the index into the table */
-  index = this->hash_func(key) % this->table_size;
+  hash = this->hash_func(key);
+  index = hash % this->table_size;
 
   /* Rover points at the pointer which points at the current entry
    * in the chain being inspected.  ie. the entry in the table, or
@@ -314,7 +351,7 @@ int ht_delete(ht_ptr this, generic_ptr key)
 
   while (*rover != NULL) {
 
-    if (!(this->cmp_func(key, (*rover)->key))) {
+    if ((*rover)->hash == hash && !(this->cmp_func(key, (*rover)->key))) {
 
       /* This is the entry to delete */
       entry = *rover;
@@ -322,11 +359,16 @@ int ht_delete(ht_ptr this, generic_ptr key)
       /* Unlink from the list */
       *rover = entry->next;
 
+      /* Bloom filters keep it until they are rebuilt */
+      if (this->filter == HT_FILTER_CUCKOO)
+        ht_cuckoo_remove(this, hash);
+
       /* Destroy the entry structure */
       ht_free_entry(this, entry);
 
       /* Track count of entries */
       --this->entries;
+      ++this->stamp;
       result = 1;
       break;
     }
@@ -338,6 +380,43 @@ int ht_delete(ht_ptr this, generic_ptr key)
   return result;
 }
 
+int ht_set_filter(ht_ptr this, int filter)
+{
+  CHECK_INSTANCE(this);
+
+  if (filter == this->filter) return 1;
+  this->filter = filter;
+
+  if (filter == HT_FILTER_NONE) {
+    if (this->bloom) bloom_deinit(this->bloom);
+    if (this->cuckoo) cuckoo_deinit(this->cuckoo);
+
+    this->bloom = NULL;
+    this->cuckoo = NULL;
+    return 1;
+  }
+
+  return ht_filter_build(this, this->next_rehash + 1);
+}
+
+int ht_reserve(ht_ptr this, size_t n)
+{
+  CHECK_INSTANCE(this);
+  int prime_index = this->prime_index;
+
+  /* Find the smallest table that holds n entries without growing */
+  while (ht_primes[prime_index] / 2 < n) {
+    if (prime_index + 1 >= ht_num_primes)
+      return 0;
+    ++ prime_index;
+  }
+
+  if (prime_index == this->prime_index)
+    return 1;
+
+  return ht_rehash(this, prime_index);
+}
+
 size_t ht_count(ht_ptr this)
 {
   CHECK_INSTANCE(this);
@@ -353,6 +432,7 @@ ht_iterator_ptr ht_iter(ht_ptr this)
   int chain;
 
   res->hash = this;
+  res->stamp = this->stamp;
 
   /* Default value of next if no entries are found. */
   res->next_entry = NULL;
@@ -396,8 +476,8 @@ generic_ptr ht_iter_next(ht_iterator_ptr this, generic_dptr value_p)
   generic_ptr result;
   int chain;
 
-  /* No more entries? */
-  if (this->next_entry == NULL) {
+  /* No more entries, or none we can trust? */
+  if (this->next_entry == NULL || ht_iter_changed(this)) {
     return NULL;
   }
 
@@ -438,6 +518,13 @@ generic_ptr ht_iter_next(ht_iterator_ptr this, generic_dptr value_p)
   return result;
 }
 
+int ht_iter_changed(ht_iterator_ptr this)
+{
+  CHECK_INSTANCE(this);
+
+  return this->stamp != this->hash->stamp;
+}
+
 /* Internal function used to allocate the table on hash table creation
  * and when growing the table */
 static inline int ht_allocate_table(ht_ptr this)
@@ -491,6 +578,15 @@ static inline void ht_free_entry(ht_ptr this, ht_entry_ptr entry)
 }
 
 static inline int ht_grow(ht_ptr this)
+{
+  if (this->prime_index + 1 >= ht_num_primes)
+    return 0;
+
+  return ht_rehash(this, this->prime_index + 1);
+}
+
+/* Relink all entries into a new table of size ht_primes[prime_index] */
+static int ht_rehash(ht_ptr this, int prime_index)
 {
   ht_entry_dptr old_table;
   int old_table_size;
@@ -504,7 +600,7 @@ static inline int ht_grow(ht_ptr this)
   old_prime_index = this->prime_index;
 
   /* Allocate a new, larger table */
-  this->prime_index ++;
+  this->prime_index = prime_index;
 
   if (!ht_allocate_table(this)) {
 
@@ -524,7 +620,7 @@ static inline int ht_grow(ht_ptr this)
       next = rover->next;
 
       /* Find the index into the new table */
-      index = this->hash_func(rover->key) % this->table_size;
+      index = rover->hash % this->table_size;
 
       /* Link this entry into the chain */
       rover->next = this->table[index];
@@ -537,10 +633,129 @@ static inline int ht_grow(ht_ptr this)
 
   /* Free the old table */
   free(old_table);
+  ++ this->stamp;
+
+  /* Resize the filter, which also drops deleted keys from Bloom
+   * filters. Stored hashes spare calls to hash_func. */
+  if (this->filter != HT_FILTER_NONE)
+    ht_filter_build(this, this->next_rehash + 1);
 
   return 1;
 }
 
+/* Build a filter for the current entries, with room for capacity
+ * keys. Returns 0 if out of memory, in which case the table is left
+ * without a filter, as it is when a cuckoo filter still overflows its
+ * stash after HT_CUCKOO_RETRIES doublings. */
+static int ht_filter_build(ht_ptr this, size_t capacity)
+{
+  bloom_ptr bloom = NULL;
+  cuckoo_ptr cuckoo = NULL;
+  ht_entry_ptr rover;
+  size_t i;
+  int full, retries = 0;
+
+  do {
+    full = 0;
+    this->stashed = 0;
+
+    if (this->filter == HT_FILTER_BLOOM) {
+      if (!(bloom = bloom_init(capacity, HT_BLOOM_FPP)))
+        break;
+    }
+    else if (!(cuckoo = cuckoo_init(capacity)))
+      break;
+
+    for (i=0; i<this->table_size && !full; ++i) {
+      for (rover = this->table[i]; rover != NULL; rover = rover->next) {
+        if (bloom) bloom_add(bloom, rover->hash);
+        else if (!ht_cuckoo_add(this, cuckoo, rover->hash)) {
+
+          /* Unlucky, try again with more room */
+          cuckoo_deinit(cuckoo);
+          cuckoo = NULL;
+          capacity *= 2;
+          full = 1;
+          break;
+        }
+      }
+    }
+  } while (full && retries++ < HT_CUCKOO_RETRIES);
+
+  if (this->bloom) bloom_deinit(this->bloom);
+  if (this->cuckoo) cuckoo_deinit(this->cuckoo);
+
+  this->bloom = bloom;
+  this->cuckoo = cuckoo;
+
+  if (!bloom && !cuckoo) {
+    this->filter = HT_FILTER_NONE;
+    this->stashed = 0;
+
+    /* out of memory, unless the keys defeated the filter */
+    return full;
+  }
+
+  return 1;
+}
+
+static inline int ht_filter_contains(ht_ptr this, unsigned hash)
+{
+  int i;
+
+  if (this->filter == HT_FILTER_BLOOM)
+    return bloom_contains(this->bloom, hash);
+
+  if (cuckoo_contains(this->cuckoo, hash))
+    return 1;
+
+  for (i=0; i<this->stashed; ++i)
+    if (this->stash[i] == hash)
+      return 1;
+
+  return 0;
+}
+
+static inline void ht_filter_add(ht_ptr this, unsigned hash)
+{
+  if (this->filter == HT_FILTER_BLOOM)
+    bloom_add(this->bloom, hash);
+
+  /* The new entry is already linked, a rebuild takes it in */
+  else if (!ht_cuckoo_add(this, this->cuckoo, hash))
+    ht_filter_build(this, 2 * (this->next_rehash + 1));
+}
+
+/* Add hash to the cuckoo filter, or else to the stash; 0 if both are
+ * full */
+static inline int ht_cuckoo_add(ht_ptr this, cuckoo_ptr cuckoo,
+                                unsigned hash)
+{
+  if (cuckoo_add(cuckoo, hash) == CUCKOO_OK)
+    return 1;
+
+  if (this->stashed == HT_CUCKOO_STASH)
+    return 0;
+
+  this->stash[this->stashed++] = hash;
+  return 1;
+}
+
+/* Copies of a hash are all alike, so drop a stashed one first */
+static inline void ht_cuckoo_remove(ht_ptr this, unsigned hash)
+{
+  int i;
+
+  for (i=0; i<this->stashed; ++i) {
+    if (this->stash[i] == hash) {
+      this->stash[i] = this->stash[--this->stashed];
+      return;
+    }
+  }
+
+  cuckoo_remove(this->cuckoo, hash);
+}
+
 #ifdef HT_STATS
 static int _ht_profile_cmp(const void *a, const void *b)
 {
@@ -2,13 +2,29 @@
 #define HT_INCLUDED
 
 #include "common.h"
+#include "filter/bloom.h"
+#include "filter/cuckoo.h"
 
 #define CHUNK_SIZE 2048
 
+/* optional filters of the key hashes, see ht_set_filter */
+#define HT_FILTER_NONE   0
+#define HT_FILTER_BLOOM  1
+#define HT_FILTER_CUCKOO 2
+
+#define HT_BLOOM_FPP 0.01
+
+/* hashes kept beside a full cuckoo filter, and how many times a
+   rebuild doubles its room before dropping the filter (no room helps
+   more than 8 keys sharing a hash) */
+#define HT_CUCKOO_STASH   8
+#define HT_CUCKOO_RETRIES 2
+
 /* -- Typedefs -------------------------------------------------------------- */
 typedef struct ht_entry_struct {
   generic_ptr key;
   generic_ptr value;
+  unsigned hash;
   struct ht_entry_struct* next;
 } ht_entry;
 typedef ht_entry* ht_entry_ptr;
@@ -34,12 +50,21 @@ typedef struct ht_struct {
 
   size_t entries;
   size_t next_rehash;
+  unsigned stamp;  /* bumped by every insertion, deletion and rehash */
 
   int prime_index;
 
   /* for efficient node mgmt */
   ht_chunk_ptr chunks;
 
+  /* filter of the key hashes, answering most misses without walking
+     the chains (and calling cmp_func) */
+  int filter;
+  bloom_ptr bloom;
+  cuckoo_ptr cuckoo;
+  unsigned stash[HT_CUCKOO_STASH];
+  int stashed;
+
 } ht;
 typedef ht* ht_ptr;
 typedef ht** ht_dptr;
@@ -49,6 +74,7 @@ typedef struct ht_iterator_struct {
   ht_ptr hash;
   ht_entry_ptr next_entry;
   int next_chain;
+  unsigned stamp;
 } ht_iterator;
 typedef ht_iterator* ht_iterator_ptr;
 typedef ht_iterator** ht_iterator_dptr;
@@ -74,10 +100,25 @@ int ht_delete(ht_ptr this,
 
 size_t ht_count(ht_ptr this);
 
+/* Grow the table to hold n entries without rehashing, ahead of a bulk
+   load. Returns 0 if out of memory, the table is left as it was. */
+int ht_reserve(ht_ptr this, size_t n);
+
+/* Keep a filter (HT_FILTER_xxx) of the keys, for workloads where most
+   lookups miss. Bloom filters are cheaper to update but keep deleted
+   keys until the table grows; cuckoo filters forget them at once, but
+   fall back to no filter when too many keys share a hash. Returns 0 if
+   out of memory. */
+int ht_set_filter(ht_ptr this, int filter);
+
 /* iterators */
 ht_iterator_ptr ht_iter(ht_ptr hash);
 void ht_iter_deinit(ht_iterator_ptr this);
 int ht_iter_has_more(ht_iterator_ptr this);
 generic_ptr ht_iter_next(ht_iterator_ptr this, generic_dptr value);
 
+/* was the table modified since the iterator was created? Its next
+   entry may then be gone; ht_iter_next returns NULL. */
+int ht_iter_changed(ht_iterator_ptr this);
+
 #endif
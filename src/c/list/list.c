@@ -0,0 +1,260 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "list.h"
+
+#define NODE_OF(ptr)                                                           \
+  DLIST_ENTRY(ptr, list_node_t, link)
+
+/* -- internal functions ---------------------------------------------------- */
+static inline list_node_ptr list_node_new(list_ptr list, generic_ptr data);
+static inline void list_node_release(list_ptr list, list_node_ptr node);
+
+list_ptr list_init(free_func_ptr free_func)
+{
+  list_ptr list;
+
+  if (! (list = (list_ptr) malloc(sizeof(list_t))))
+    return NULL;
+
+  dlist_init(&list->links);
+  list->free = free_func;
+
+  list->chunks = list->last_chunk = NULL;
+  list->free_nodes = list->last_free = NULL;
+
+  return list;
+}
+
+
+void list_deinit(list_ptr list)
+{
+  list_chunk_ptr chunk, next;
+  CHECK_INSTANCE(list);
+
+  list_clear(list);
+
+  for (chunk = list->chunks; chunk; chunk = next) {
+    next = chunk->next;
+    free(chunk);
+  }
+
+  free(list);
+}
+
+
+/* Release all items (with 'free', if any). Nodes are kept for reuse. */
+void list_clear(list_ptr list)
+{
+  dlist_link_ptr link;
+  CHECK_INSTANCE(list);
+
+  while ((link = dlist_pop_front(&list->links))) {
+    if (list->free) list->free(NODE_OF(link)->data);
+    list_node_release(list, NODE_OF(link));
+  }
+}
+
+
+list_node_ptr list_push_front(list_ptr list, generic_ptr data)
+{
+  CHECK_INSTANCE(list);
+  return list_insert_before(list, list_first(list), data);
+}
+
+
+list_node_ptr list_push_back(list_ptr list, generic_ptr data)
+{
+  CHECK_INSTANCE(list);
+  return list_insert_before(list, NULL, data);
+}
+
+
+/* Insert before 'pos', or at the end if pos is NULL */
+list_node_ptr list_insert_before(list_ptr list, list_node_ptr pos,
+                                 generic_ptr data)
+{
+  list_node_ptr node;
+  CHECK_INSTANCE(list);
+
+  if (! (node = list_node_new(list, data)))
+    return NULL;
+
+  dlist_insert_before(&list->links,
+                      pos ? &pos->link : dlist_end(&list->links),
+                      &node->link);
+  return node;
+}
+
+
+generic_ptr list_remove(list_ptr list, list_node_ptr node)
+{
+  generic_ptr data;
+  CHECK_INSTANCE(list);
+  assert(node);
+
+  data = node->data;
+
+  dlist_unlink(&list->links, &node->link);
+  list_node_release(list, node);
+
+  return data;
+}
+
+
+int list_pop_front(list_ptr list, generic_dptr data)
+{
+  CHECK_INSTANCE(list);
+
+  if (! list->links.num) return LIST_EMPTY;
+
+  (*data) = list_remove(list, list_first(list));
+  return LIST_OK;
+}
+
+
+int list_pop_back(list_ptr list, generic_dptr data)
+{
+  CHECK_INSTANCE(list);
+
+  if (! list->links.num) return LIST_EMPTY;
+
+  (*data) = list_remove(list, list_last(list));
+  return LIST_OK;
+}
+
+
+/* Navigation, NULL past either end */
+list_node_ptr list_first(list_ptr list)
+{
+  dlist_link_ptr link = dlist_first(&list->links);
+  return link ? NODE_OF(link) : NULL;
+}
+
+
+list_node_ptr list_last(list_ptr list)
+{
+  dlist_link_ptr link = dlist_last(&list->links);
+  return link ? NODE_OF(link) : NULL;
+}
+
+
+list_node_ptr list_next(list_ptr list, list_node_ptr node)
+{
+  dlist_link_ptr link = node->link.next;
+  return link != dlist_end(&list->links) ? NODE_OF(link) : NULL;
+}
+
+
+list_node_ptr list_prev(list_ptr list, list_node_ptr node)
+{
+  dlist_link_ptr link = node->link.prev;
+  return link != dlist_end(&list->links) ? NODE_OF(link) : NULL;
+}
+
+
+/* O(1): src nodes live in src chunks, so the chunks (and the released
+   nodes in them) are handed over as well. src is left empty, with no
+   storage of its own. */
+void list_splice(list_ptr list, list_ptr src)
+{
+  CHECK_INSTANCE(list);
+  CHECK_INSTANCE(src);
+
+  if (list == src) return;
+
+  dlist_splice(&list->links, dlist_end(&list->links), &src->links);
+
+  if (src->chunks) {
+    src->last_chunk->next = list->chunks;
+    list->chunks = src->chunks;
+    if (! list->last_chunk) list->last_chunk = src->last_chunk;
+  }
+
+  if (src->free_nodes) {
+    src->last_free->link.next =
+      list->free_nodes ? &list->free_nodes->link : NULL;
+
+    if (! list->free_nodes) list->last_free = src->last_free;
+    list->free_nodes = src->free_nodes;
+  }
+
+  src->chunks = src->last_chunk = NULL;
+  src->free_nodes = src->last_free = NULL;
+}
+
+
+unsigned list_n(const list_ptr list)
+{
+  CHECK_INSTANCE(list);
+  return list->links.num;
+}
+
+
+void list_iter_init(list_iterator_ptr iter, list_ptr list, int dir)
+{
+  CHECK_INSTANCE(iter);
+  CHECK_INSTANCE(list);
+
+  iter->dir = dir;
+  iter->end = dlist_end(&list->links);
+  iter->next = dir == LIST_ITER_FORWARD
+    ? list->links.head.next : list->links.head.prev;
+}
+
+
+/* Fetch the next item, 0 at the end. The node after the one returned
+   is prefetched, so its cache miss overlaps with the caller's work. */
+int list_iter_next(list_iterator_ptr iter, generic_dptr data)
+{
+  dlist_link_ptr link = iter->next;
+
+  if (link == iter->end) return 0;
+
+  iter->next = iter->dir == LIST_ITER_FORWARD ? link->next : link->prev;
+  PREFETCH(iter->next);
+
+  (*data) = NODE_OF(link)->data;
+  return 1;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static inline list_node_ptr list_node_new(list_ptr list, generic_ptr data)
+{
+  list_node_ptr node;
+  list_chunk_ptr chunk;
+
+  if ((node = list->free_nodes)) {
+    if (! (list->free_nodes =
+           node->link.next ? NODE_OF(node->link.next) : NULL))
+      list->last_free = NULL;
+  }
+
+  else {
+    if (! list->chunks || list->chunks->used == LIST_CHUNK_SIZE) {
+      if (! (chunk = (list_chunk_ptr) malloc(sizeof(list_chunk_t))))
+        return NULL;
+
+      chunk->used = 0;
+      chunk->next = list->chunks;
+      list->chunks = chunk;
+      if (! list->last_chunk) list->last_chunk = chunk;
+    }
+
+    node = list->chunks->nodes + list->chunks->used ++;
+  }
+
+  node->data = data;
+  return node;
+}
+
+
+static inline void list_node_release(list_ptr list, list_node_ptr node)
+{
+  if (! list->free_nodes) list->last_free = node;
+
+  node->link.next = list->free_nodes ? &list->free_nodes->link : NULL;
+  list->free_nodes = node;
+}
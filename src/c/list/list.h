@@ -0,0 +1,297 @@
+#ifndef LIST_H
+#define LIST_H
+
+#include <stddef.h>
+#include "common.h"
+
+/* Linked lists, in two flavours:
+
+   - intrusive singly (slist) and doubly (dlist) linked lists. Links
+     are embedded in the user's structs, and list operations never
+     allocate. DLIST_ENTRY gets back from a link to its struct. These
+     are all O(1) and defined inline.
+
+   - list_t, a doubly linked list of generic_ptr items whose nodes come
+     from chunks, as ht entries do (no malloc per item). Nodes act as
+     handles for O(1) insertion and removal.
+
+   List heads hold self references (dlist) and must not be copied. */
+
+#define LIST_CHUNK_SIZE 1024
+
+/* Error constants */
+#define LIST_OK      0
+#define LIST_EMPTY  -1
+
+/* struct 'type' embedding 'link' as its 'member' field */
+#define DLIST_ENTRY(link, type, member)                                        \
+  ((type *)((char *)(link) - offsetof(type, member)))
+
+/* -- Intrusive singly linked lists ----------------------------------------- */
+typedef struct slist_link_t {
+  struct slist_link_t* next;
+} slist_link_t;
+typedef slist_link_t* slist_link_ptr;
+
+typedef struct slist_t {
+  slist_link_ptr head;
+  slist_link_ptr tail;
+  unsigned num;
+} slist_t;
+typedef slist_t* slist_ptr;
+
+/* the node after the current one is prefetched on each step */
+#define slist_foreach(list, link)                                              \
+  for ((link) = (list)->head;                                                  \
+       (link) && (PREFETCH((link)->next), 1);                                  \
+       (link) = (link)->next)
+
+static inline void slist_init(slist_ptr list)
+{
+  list->head = list->tail = NULL;
+  list->num = 0;
+}
+
+static inline void slist_push_front(slist_ptr list, slist_link_ptr link)
+{
+  if (! (link->next = list->head)) list->tail = link;
+  list->head = link;
+  list->num ++;
+}
+
+static inline void slist_push_back(slist_ptr list, slist_link_ptr link)
+{
+  link->next = NULL;
+  if (list->tail) list->tail->next = link;
+  else list->head = link;
+
+  list->tail = link;
+  list->num ++;
+}
+
+/* NULL if the list is empty */
+static inline slist_link_ptr slist_pop_front(slist_ptr list)
+{
+  slist_link_ptr link = list->head;
+
+  if (link) {
+    if (! (list->head = link->next)) list->tail = NULL;
+    list->num --;
+  }
+
+  return link;
+}
+
+static inline void slist_insert_after(slist_ptr list, slist_link_ptr pos,
+                                      slist_link_ptr link)
+{
+  if (! (link->next = pos->next)) list->tail = link;
+  pos->next = link;
+  list->num ++;
+}
+
+/* unlinking needs the previous link in singly linked lists */
+static inline slist_link_ptr slist_remove_after(slist_ptr list,
+                                                slist_link_ptr pos)
+{
+  slist_link_ptr link = pos->next;
+
+  if (link) {
+    if (! (pos->next = link->next)) list->tail = pos;
+    list->num --;
+  }
+
+  return link;
+}
+
+/* move all of 'src' at the end of 'list', src is left empty */
+static inline void slist_splice(slist_ptr list, slist_ptr src)
+{
+  if (! src->head) return;
+
+  if (list->tail) list->tail->next = src->head;
+  else list->head = src->head;
+
+  list->tail = src->tail;
+  list->num += src->num;
+
+  slist_init(src);
+}
+
+/* -- Intrusive doubly linked lists ----------------------------------------- */
+typedef struct dlist_link_t {
+  struct dlist_link_t* next;
+  struct dlist_link_t* prev;
+} dlist_link_t;
+typedef dlist_link_t* dlist_link_ptr;
+
+/* circular, 'head' is a sentinel: head.next is the first link and
+   head.prev the last one */
+typedef struct dlist_t {
+  dlist_link_t head;
+  unsigned num;
+} dlist_t;
+typedef dlist_t* dlist_ptr;
+
+#define dlist_end(list)                                                        \
+  (&(list)->head)
+
+/* the node after the current one is prefetched on each step */
+#define dlist_foreach(list, link)                                              \
+  for ((link) = (list)->head.next;                                             \
+       (link) != dlist_end(list) && (PREFETCH((link)->next), 1);               \
+       (link) = (link)->next)
+
+#define dlist_foreach_reverse(list, link)                                      \
+  for ((link) = (list)->head.prev;                                             \
+       (link) != dlist_end(list) && (PREFETCH((link)->prev), 1);               \
+       (link) = (link)->prev)
+
+static inline void dlist_init(dlist_ptr list)
+{
+  list->head.next = list->head.prev = &list->head;
+  list->num = 0;
+}
+
+/* NULL if the list is empty */
+static inline dlist_link_ptr dlist_first(dlist_ptr list)
+{
+  return list->num ? list->head.next : NULL;
+}
+
+static inline dlist_link_ptr dlist_last(dlist_ptr list)
+{
+  return list->num ? list->head.prev : NULL;
+}
+
+/* insert before 'pos', which may be dlist_end(list) */
+static inline void dlist_insert_before(dlist_ptr list, dlist_link_ptr pos,
+                                       dlist_link_ptr link)
+{
+  link->next = pos;
+  link->prev = pos->prev;
+  pos->prev->next = link;
+  pos->prev = link;
+  list->num ++;
+}
+
+static inline void dlist_push_front(dlist_ptr list, dlist_link_ptr link)
+{
+  dlist_insert_before(list, list->head.next, link);
+}
+
+static inline void dlist_push_back(dlist_ptr list, dlist_link_ptr link)
+{
+  dlist_insert_before(list, &list->head, link);
+}
+
+static inline void dlist_unlink(dlist_ptr list, dlist_link_ptr link)
+{
+  link->prev->next = link->next;
+  link->next->prev = link->prev;
+  link->next = link->prev = NULL;
+  list->num --;
+}
+
+static inline dlist_link_ptr dlist_pop_front(dlist_ptr list)
+{
+  dlist_link_ptr link = dlist_first(list);
+  if (link) dlist_unlink(list, link);
+  return link;
+}
+
+static inline dlist_link_ptr dlist_pop_back(dlist_ptr list)
+{
+  dlist_link_ptr link = dlist_last(list);
+  if (link) dlist_unlink(list, link);
+  return link;
+}
+
+/* move all of 'src' before 'pos' in 'list', src is left empty */
+static inline void dlist_splice(dlist_ptr list, dlist_link_ptr pos,
+                                dlist_ptr src)
+{
+  if (! src->num) return;
+
+  src->head.next->prev = pos->prev;
+  src->head.prev->next = pos;
+  pos->prev->next = src->head.next;
+  pos->prev = src->head.prev;
+
+  list->num += src->num;
+  dlist_init(src);
+}
+
+/* -- Pooled lists of generic items ----------------------------------------- */
+typedef struct list_node_t {
+  dlist_link_t link;
+  generic_ptr data;
+} list_node_t;
+typedef list_node_t* list_node_ptr;
+
+/* node chunks */
+typedef struct list_chunk_t {
+  unsigned used;
+  struct list_chunk_t* next;
+  list_node_t nodes[LIST_CHUNK_SIZE];
+} list_chunk_t;
+typedef list_chunk_t* list_chunk_ptr;
+
+typedef struct list_t {
+  dlist_t links;
+  free_func_ptr free;
+
+  /* for efficient node mgmt. Released nodes are chained through
+     link.next, both lists keep their tail for O(1) splicing */
+  list_chunk_ptr chunks;
+  list_chunk_ptr last_chunk;
+  list_node_ptr free_nodes;
+  list_node_ptr last_free;
+} list_t;
+typedef list_t* list_ptr;
+
+typedef struct list_iterator_t {
+  dlist_link_ptr next;
+  dlist_link_ptr end;
+  int dir;
+} list_iterator_t;
+typedef list_iterator_t* list_iterator_ptr;
+
+#define LIST_ITER_FORWARD   1
+#define LIST_ITER_BACKWARD -1
+
+#define list_node_data(node)                                                   \
+  ((node)->data)
+
+/* -- Function prototypes --------------------------------------------------- */
+list_ptr list_init(free_func_ptr free);
+void list_deinit(list_ptr list);
+void list_clear(list_ptr list);
+
+/* return the new node, NULL if out of memory */
+list_node_ptr list_push_front(list_ptr list, generic_ptr data);
+list_node_ptr list_push_back(list_ptr list, generic_ptr data);
+list_node_ptr list_insert_before(list_ptr list, list_node_ptr pos,
+                                 generic_ptr data);
+
+/* O(1) by handle, data is handed back and not released */
+generic_ptr list_remove(list_ptr list, list_node_ptr node);
+
+int list_pop_front(list_ptr list, generic_dptr data);
+int list_pop_back(list_ptr list, generic_dptr data);
+
+list_node_ptr list_first(list_ptr list);
+list_node_ptr list_last(list_ptr list);
+list_node_ptr list_next(list_ptr list, list_node_ptr node);
+list_node_ptr list_prev(list_ptr list, list_node_ptr node);
+
+/* move all of 'src', nodes and their chunks, to the end of 'list' */
+void list_splice(list_ptr list, list_ptr src);
+
+unsigned list_n(const list_ptr list);
+
+/* iterators */
+void list_iter_init(list_iterator_ptr iter, list_ptr list, int dir);
+int list_iter_next(list_iterator_ptr iter, generic_dptr data);
+
+#endif
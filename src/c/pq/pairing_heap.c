@@ -0,0 +1,280 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "pairing_heap.h"
+
+#define IS_FREE(node)                                                          \
+  ((node)->prev == (node))
+
+/* -- internal functions ---------------------------------------------------- */
+static inline pairing_heap_node_ptr pairing_heap_node_new(pairing_heap_ptr heap);
+static inline void pairing_heap_node_release(pairing_heap_ptr heap,
+                                             pairing_heap_node_ptr node);
+static inline pairing_heap_node_ptr pairing_heap_meld(pairing_heap_ptr heap,
+                                                      pairing_heap_node_ptr a,
+                                                      pairing_heap_node_ptr b);
+static inline void pairing_heap_cut(pairing_heap_node_ptr node);
+static pairing_heap_node_ptr pairing_heap_combine(pairing_heap_ptr heap,
+                                                  pairing_heap_node_ptr first);
+
+pairing_heap_ptr pairing_heap_init(cmp_func_ptr cmp,
+                                   free_func_ptr key_free,
+                                   free_func_ptr data_free)
+{
+  pairing_heap_ptr heap;
+
+  if (! (heap = (pairing_heap_ptr) malloc(sizeof(pairing_heap_t))))
+    return NULL;
+
+  heap->root = NULL;
+  heap->num = 0;
+
+  heap->cmp = cmp;
+  heap->key_free = key_free;
+  heap->data_free = data_free;
+
+  heap->chunks = NULL;
+  heap->used = 0;
+  heap->free_nodes = NULL;
+
+  return heap;
+}
+
+
+void pairing_heap_deinit(pairing_heap_ptr heap)
+{
+  unsigned i, used;
+  pairing_heap_chunk_ptr chunk, next;
+  pairing_heap_node_ptr node;
+  CHECK_INSTANCE(heap);
+
+  /* all chunks but the first are fully handed out */
+  for (chunk = heap->chunks, used = heap->used; chunk; chunk = next) {
+    for (i = 0; i < used; i ++) {
+      node = chunk->nodes + i;
+      if (IS_FREE(node)) continue;
+
+      if (heap->key_free) heap->key_free(node->key);
+      if (heap->data_free) heap->data_free(node->data);
+    }
+
+    next = chunk->next;
+    used = PAIRING_HEAP_CHUNK_SIZE;
+    free(chunk);
+  }
+
+  free(heap);
+}
+
+
+/* Queue 'data' with priority 'key', O(1). The returned node is a
+   handle to the item until it is popped or removed. */
+pairing_heap_node_ptr pairing_heap_push(pairing_heap_ptr heap,
+                                        generic_ptr key, generic_ptr data)
+{
+  pairing_heap_node_ptr node;
+  CHECK_INSTANCE(heap);
+
+  if (! (node = pairing_heap_node_new(heap)))
+    return NULL;
+
+  node->key = key;
+  node->data = data;
+  node->child = node->sibling = node->prev = NULL;
+
+  heap->root = heap->root ? pairing_heap_meld(heap, heap->root, node) : node;
+  heap->num ++;
+
+  return node;
+}
+
+
+int pairing_heap_peek(pairing_heap_ptr heap, generic_dptr key,
+                      generic_dptr data)
+{
+  CHECK_INSTANCE(heap);
+
+  if (! heap->root) return PAIRING_HEAP_EMPTY;
+
+  if (key) (*key) = heap->root->key;
+  if (data) (*data) = heap->root->data;
+
+  return PAIRING_HEAP_OK;
+}
+
+
+/* Remove the item with the smallest key, amortized O(log(n)).
+   Ownership of key and data is transferred to the caller. */
+int pairing_heap_pop(pairing_heap_ptr heap, generic_dptr key,
+                     generic_dptr data)
+{
+  CHECK_INSTANCE(heap);
+
+  if (! heap->root) return PAIRING_HEAP_EMPTY;
+
+  pairing_heap_remove(heap, heap->root, key, data);
+  return PAIRING_HEAP_OK;
+}
+
+
+/* Lower the key of a queued item, O(1). A key greater than the
+   current one is rejected with PAIRING_HEAP_BAD_KEY. The old key is
+   released with key_free, unless it is 'key' itself. */
+int pairing_heap_decrease_key(pairing_heap_ptr heap,
+                              pairing_heap_node_ptr node, generic_ptr key)
+{
+  CHECK_INSTANCE(heap);
+  assert(node && ! IS_FREE(node));
+
+  if (heap->cmp(key, node->key) > 0) return PAIRING_HEAP_BAD_KEY;
+
+  if (heap->key_free && key != node->key) heap->key_free(node->key);
+  node->key = key;
+
+  if (node != heap->root) {
+    pairing_heap_cut(node);
+    heap->root = pairing_heap_meld(heap, heap->root, node);
+  }
+
+  return PAIRING_HEAP_OK;
+}
+
+
+/* Remove a queued item, amortized O(log(n)). Ownership of key and data
+   is transferred to the caller. */
+void pairing_heap_remove(pairing_heap_ptr heap, pairing_heap_node_ptr node,
+                         generic_dptr key, generic_dptr data)
+{
+  pairing_heap_node_ptr sub;
+  CHECK_INSTANCE(heap);
+  assert(node && ! IS_FREE(node));
+
+  if (key) (*key) = node->key;
+  if (data) (*data) = node->data;
+
+  sub = pairing_heap_combine(heap, node->child);
+
+  if (node == heap->root)
+    heap->root = sub;
+
+  else {
+    pairing_heap_cut(node);
+    if (sub) heap->root = pairing_heap_meld(heap, heap->root, sub);
+  }
+
+  pairing_heap_node_release(heap, node);
+  heap->num --;
+}
+
+
+unsigned pairing_heap_n(const pairing_heap_ptr heap)
+{
+  CHECK_INSTANCE(heap);
+  return heap->num;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static inline pairing_heap_node_ptr pairing_heap_node_new(pairing_heap_ptr heap)
+{
+  pairing_heap_node_ptr node;
+  pairing_heap_chunk_ptr chunk;
+
+  if ((node = heap->free_nodes)) {
+    heap->free_nodes = node->sibling;
+    return node;
+  }
+
+  if (! heap->chunks || heap->used == PAIRING_HEAP_CHUNK_SIZE) {
+    if (! (chunk = (pairing_heap_chunk_ptr)
+           malloc(sizeof(pairing_heap_chunk_t))))
+      return NULL;
+
+    chunk->next = heap->chunks;
+    heap->chunks = chunk;
+    heap->used = 0;
+  }
+
+  return heap->chunks->nodes + heap->used ++;
+}
+
+
+static inline void pairing_heap_node_release(pairing_heap_ptr heap,
+                                             pairing_heap_node_ptr node)
+{
+  node->prev = node;
+  node->sibling = heap->free_nodes;
+  heap->free_nodes = node;
+}
+
+
+/* Link two roots, the greater becomes the leftmost child of the other.
+   The sibling links of the result are left for the caller to fix. */
+static inline pairing_heap_node_ptr pairing_heap_meld(pairing_heap_ptr heap,
+                                                      pairing_heap_node_ptr a,
+                                                      pairing_heap_node_ptr b)
+{
+  pairing_heap_node_ptr tmp;
+
+  if (heap->cmp(b->key, a->key) < 0) {
+    tmp = a; a = b; b = tmp;
+  }
+
+  b->prev = a;
+  b->sibling = a->child;
+  if (a->child) a->child->prev = b;
+  a->child = b;
+
+  a->prev = a->sibling = NULL;
+  return a;
+}
+
+
+/* Detach a non-root node (and its subtree) from its parent */
+static inline void pairing_heap_cut(pairing_heap_node_ptr node)
+{
+  if (node->prev->child == node)
+    node->prev->child = node->sibling;
+  else
+    node->prev->sibling = node->sibling;
+
+  if (node->sibling) node->sibling->prev = node->prev;
+  node->prev = node->sibling = NULL;
+}
+
+
+/* Two-pass pairing of a list of siblings into a single tree: meld
+   adjacent pairs left to right, then fold the results right to left.
+   The first pass stacks its results through the sibling links, so no
+   extra memory is needed. */
+static pairing_heap_node_ptr pairing_heap_combine(pairing_heap_ptr heap,
+                                                  pairing_heap_node_ptr first)
+{
+  pairing_heap_node_ptr a, b, next, stack = NULL;
+
+  while (first) {
+    a = first;
+    b = a->sibling;
+
+    if (b) {
+      next = b->sibling;
+      a = pairing_heap_meld(heap, a, b);
+    }
+    else next = NULL;
+
+    a->sibling = stack;
+    stack = a;
+    first = next;
+  }
+
+  if (! stack) return NULL;
+
+  for (a = stack, stack = stack->sibling; stack; stack = next) {
+    next = stack->sibling;
+    a = pairing_heap_meld(heap, a, stack);
+  }
+
+  a->prev = a->sibling = NULL;
+  return a;
+}
@@ -0,0 +1,72 @@
+#ifndef PAIRING_HEAP_H
+#define PAIRING_HEAP_H
+
+#include "common.h"
+
+/* Pairing heap over generic keys ordered by a cmp_func_ptr (smaller
+   keys first). Push, meld and decrease-key are O(1), pop is amortized
+   O(log(n)). Nodes double as handles for decrease-key and remove. */
+
+#define PAIRING_HEAP_CHUNK_SIZE 1024
+
+/* Error constants */
+#define PAIRING_HEAP_OK       0
+#define PAIRING_HEAP_EMPTY   -1
+#define PAIRING_HEAP_BAD_KEY -4
+
+typedef struct pairing_heap_node_t {
+  generic_ptr key;
+  generic_ptr data;
+  struct pairing_heap_node_t* child;    /* leftmost child          */
+  struct pairing_heap_node_t* sibling;  /* next sibling (or free)  */
+  struct pairing_heap_node_t* prev;     /* left sibling, or parent,
+                                           or itself when free     */
+} pairing_heap_node_t;
+typedef pairing_heap_node_t* pairing_heap_node_ptr;
+
+/* node chunks */
+typedef struct pairing_heap_chunk_t {
+  struct pairing_heap_chunk_t* next;
+  pairing_heap_node_t nodes[PAIRING_HEAP_CHUNK_SIZE];
+} pairing_heap_chunk_t;
+typedef pairing_heap_chunk_t* pairing_heap_chunk_ptr;
+
+typedef struct pairing_heap_t {
+  pairing_heap_node_ptr root;
+  unsigned num;
+
+  cmp_func_ptr cmp;
+  free_func_ptr key_free;
+  free_func_ptr data_free;
+
+  /* for efficient node mgmt */
+  pairing_heap_chunk_ptr chunks;
+  unsigned used;  /* nodes handed out of the first chunk */
+  pairing_heap_node_ptr free_nodes;
+} pairing_heap_t;
+typedef pairing_heap_t* pairing_heap_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+pairing_heap_ptr pairing_heap_init(cmp_func_ptr cmp,
+                                   free_func_ptr key_free,
+                                   free_func_ptr data_free);
+void pairing_heap_deinit(pairing_heap_ptr heap);
+
+/* returns the node holding the item, NULL if out of memory */
+pairing_heap_node_ptr pairing_heap_push(pairing_heap_ptr heap,
+                                        generic_ptr key, generic_ptr data);
+
+int pairing_heap_peek(pairing_heap_ptr heap, generic_dptr key,
+                      generic_dptr data);
+int pairing_heap_pop(pairing_heap_ptr heap, generic_dptr key,
+                     generic_dptr data);
+
+/* handle based operations */
+int pairing_heap_decrease_key(pairing_heap_ptr heap,
+                              pairing_heap_node_ptr node, generic_ptr key);
+void pairing_heap_remove(pairing_heap_ptr heap, pairing_heap_node_ptr node,
+                         generic_dptr key, generic_dptr data);
+
+unsigned pairing_heap_n(const pairing_heap_ptr heap);
+
+#endif
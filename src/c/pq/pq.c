@@ -0,0 +1,388 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "pq.h"
+
+/* heap position 0 (the root) lives at slot PQ_OFFSET */
+#define HEAP(pq)                                                               \
+  ((pq)->heap + PQ_OFFSET)
+
+#define PARENT(p)                                                              \
+  (((p) - 1) / PQ_ARITY)
+
+#define FIRST_CHILD(p)                                                         \
+  ((p) * PQ_ARITY + 1)
+
+#define LESS(pq, a, b)                                                         \
+  ((pq)->key_type == PQ_KEY_DOUBLE ? (a).d < (b).d : (a).l < (b).l)
+
+#define IS_QUEUED(pq, h)                                                       \
+  ((h) < (pq)->n_handles && (pq)->pos[h] < (pq)->num &&                        \
+   HEAP(pq)[(pq)->pos[h]].handle == (h))
+
+/* -- internal functions ---------------------------------------------------- */
+static inline int pq_reserve(pq_ptr pq, unsigned n);
+static inline unsigned pq_handle_new(pq_ptr pq, generic_ptr data);
+static inline void pq_handle_release(pq_ptr pq, unsigned handle);
+static inline void pq_sift_up(pq_ptr pq, unsigned p, pq_entry_t entry);
+static inline void pq_sift_down(pq_ptr pq, unsigned p, pq_entry_t entry);
+static inline void pq_take(pq_ptr pq, unsigned p);
+
+/* Allocate an empty queue with room for 'size' items. Priorities are
+   either doubles or long longs (PQ_KEY_xxx), queued data are released
+   with 'free' (if not NULL) when the queue is cleared or destroyed. */
+pq_ptr pq_init(unsigned size, int key_type, free_func_ptr free_func)
+{
+  pq_ptr pq;
+
+  if (! (pq = (pq_ptr) malloc(sizeof(pq_t))))
+    return NULL;
+
+  pq->heap = NULL;
+  pq->num = pq->n_size = 0;
+  pq->key_type = key_type;
+
+  pq->pos = NULL;
+  pq->pos_size = pq->n_handles = 0;
+  pq->free_handle = PQ_NO_HANDLE;
+
+  if (! (pq->data = array_init(size, NULL, free_func))) {
+    free(pq);
+    return NULL;
+  }
+
+  if (pq_reserve(pq, MAX(PQ_INIT_SIZE, size)) != PQ_OK) {
+    pq_deinit(pq);
+    return NULL;
+  }
+
+  return pq;
+}
+
+
+void pq_deinit(pq_ptr pq)
+{
+  CHECK_INSTANCE(pq);
+
+  /* released handles hold NULL data, so only queued items get freed */
+  array_deinit(pq->data);
+
+  free(pq->heap);
+  free(pq->pos);
+  free(pq);
+}
+
+
+/* Queue 'data' with priority 'key', O(log(n)). If 'handle' is not NULL
+   it receives a handle for later pq_decrease_key/pq_remove calls. */
+int pq_push(pq_ptr pq, pq_key_t key, generic_ptr data, unsigned* handle)
+{
+  pq_entry_t entry;
+  CHECK_INSTANCE(pq);
+
+  if (pq_reserve(pq, 1) != PQ_OK) return PQ_OUT_OF_MEM;
+
+  entry.key = key;
+  entry.handle = pq_handle_new(pq, data);
+
+  pq_sift_up(pq, pq->num ++, entry);
+
+  if (handle) (*handle) = entry.handle;
+  return PQ_OK;
+}
+
+
+int pq_peek(pq_ptr pq, pq_key_t* key, generic_dptr data)
+{
+  CHECK_INSTANCE(pq);
+
+  if (! pq->num) return PQ_EMPTY;
+
+  if (key) (*key) = HEAP(pq)->key;
+  if (data) array_fetch(pq->data, HEAP(pq)->handle, data);
+
+  return PQ_OK;
+}
+
+
+/* Remove the item with the smallest priority, O(log(n)). Ownership of
+   the item is transferred to the caller. */
+int pq_pop(pq_ptr pq, pq_key_t* key, generic_dptr data)
+{
+  CHECK_INSTANCE(pq);
+
+  if (pq_peek(pq, key, data) != PQ_OK) return PQ_EMPTY;
+
+  pq_take(pq, 0);
+  return PQ_OK;
+}
+
+
+/* Queue n items at once. The whole heap is rebuilt bottom-up (Floyd),
+   which is O(num + n) rather than O(n log(num + n)) for n pushes. If
+   'handles' is not NULL, it receives the handle of each item. */
+int pq_heapify(pq_ptr pq, const pq_key_t* keys, generic_dptr data,
+               unsigned n, unsigned* handles)
+{
+  unsigned i, p;
+  pq_entry_ptr heap;
+  CHECK_INSTANCE(pq);
+
+  if (! n) return PQ_OK;
+  if (pq_reserve(pq, n) != PQ_OK) return PQ_OUT_OF_MEM;
+
+  heap = HEAP(pq);
+  for (i = 0; i < n; i ++) {
+    p = pq->num ++;
+
+    heap[p].key = keys[i];
+    heap[p].handle = pq_handle_new(pq, data ? data[i] : NULL);
+    pq->pos[heap[p].handle] = p;
+
+    if (handles) handles[i] = heap[p].handle;
+  }
+
+  if (pq->num > 1) {
+    for (p = PARENT(pq->num - 1) + 1; p --; )
+      pq_sift_down(pq, p, heap[p]);
+  }
+
+  return PQ_OK;
+}
+
+
+int pq_fetch(pq_ptr pq, unsigned handle, pq_key_t* key, generic_dptr data)
+{
+  CHECK_INSTANCE(pq);
+
+  if (! IS_QUEUED(pq, handle)) return PQ_BAD_HANDLE;
+
+  if (key) (*key) = HEAP(pq)[pq->pos[handle]].key;
+  if (data) array_fetch(pq->data, handle, data);
+
+  return PQ_OK;
+}
+
+
+/* Lower the priority of a queued item, O(log(n)). Raising it is an
+   error (PQ_BAD_KEY), use pq_update for that. */
+int pq_decrease_key(pq_ptr pq, unsigned handle, pq_key_t key)
+{
+  unsigned p;
+  pq_entry_t entry;
+  CHECK_INSTANCE(pq);
+
+  if (! IS_QUEUED(pq, handle)) return PQ_BAD_HANDLE;
+
+  p = pq->pos[handle];
+  entry = HEAP(pq)[p];
+  if (LESS(pq, entry.key, key)) return PQ_BAD_KEY;
+
+  entry.key = key;
+  pq_sift_up(pq, p, entry);
+
+  return PQ_OK;
+}
+
+
+/* Change the priority of a queued item either way, O(log(n)) */
+int pq_update(pq_ptr pq, unsigned handle, pq_key_t key)
+{
+  unsigned p;
+  pq_entry_t entry;
+  CHECK_INSTANCE(pq);
+
+  if (! IS_QUEUED(pq, handle)) return PQ_BAD_HANDLE;
+
+  p = pq->pos[handle];
+  entry = HEAP(pq)[p];
+
+  if (LESS(pq, key, entry.key)) {
+    entry.key = key;
+    pq_sift_up(pq, p, entry);
+  }
+  else {
+    entry.key = key;
+    pq_sift_down(pq, p, entry);
+  }
+
+  return PQ_OK;
+}
+
+
+/* Remove a queued item, O(log(n)). Ownership of the item is
+   transferred to the caller. */
+int pq_remove(pq_ptr pq, unsigned handle, generic_dptr data)
+{
+  CHECK_INSTANCE(pq);
+
+  if (! IS_QUEUED(pq, handle)) return PQ_BAD_HANDLE;
+
+  if (data) array_fetch(pq->data, handle, data);
+
+  pq_take(pq, pq->pos[handle]);
+  return PQ_OK;
+}
+
+
+unsigned pq_n(const pq_ptr pq)
+{
+  CHECK_INSTANCE(pq);
+  return pq->num;
+}
+
+
+/* Release all queued items, handles are recycled from scratch */
+void pq_clear(pq_ptr pq)
+{
+  unsigned i;
+  generic_ptr data;
+  CHECK_INSTANCE(pq);
+
+  for (i = 0; i < pq->n_handles; i ++) {
+    array_fetch(pq->data, i, &data);
+    if (data && pq->data->free) pq->data->free(data);
+
+    array_insert(pq->data, i, NULL);
+  }
+
+  pq->num = 0;
+  pq->n_handles = 0;
+  pq->free_handle = PQ_NO_HANDLE;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+
+/* Make room for n more items, in the heap as well as in the handle
+   tables. Capacities double, so growth is amortized O(1). */
+static inline int pq_reserve(pq_ptr pq, unsigned n)
+{
+  pq_entry_ptr heap;
+  unsigned* pos;
+  unsigned size;
+
+  if (pq->num + n > pq->n_size) {
+    size = MAX(2 * pq->n_size, pq->num + n);
+
+    /* cache line alignment keeps each group of siblings in one line */
+    if (posix_memalign((void **) &heap, 64,
+                       (PQ_OFFSET + size) * sizeof(pq_entry_t)))
+      return PQ_OUT_OF_MEM;
+
+    if (pq->heap) {
+      memcpy(heap, pq->heap, (PQ_OFFSET + pq->num) * sizeof(pq_entry_t));
+      free(pq->heap);
+    }
+
+    pq->heap = heap;
+    pq->n_size = size;
+  }
+
+  if (pq->n_handles + n > pq->pos_size) {
+    size = MAX(2 * pq->pos_size, pq->n_handles + n);
+
+    if (! (pos = (unsigned *) realloc(pq->pos, size * sizeof(unsigned))))
+      return PQ_OUT_OF_MEM;
+
+    pq->pos = pos;
+    pq->pos_size = size;
+
+    if (array_reserve(pq->data, size) != ARRAY_OK)
+      return PQ_OUT_OF_MEM;
+  }
+
+  return PQ_OK;
+}
+
+
+/* Grab a handle for 'data', room must have been reserved already */
+static inline unsigned pq_handle_new(pq_ptr pq, generic_ptr data)
+{
+  unsigned handle;
+
+  if (pq->free_handle != PQ_NO_HANDLE) {
+    handle = pq->free_handle;
+    pq->free_handle = pq->pos[handle];
+  }
+  else handle = pq->n_handles ++;
+
+  array_insert(pq->data, handle, data);
+  return handle;
+}
+
+
+static inline void pq_handle_release(pq_ptr pq, unsigned handle)
+{
+  array_insert(pq->data, handle, NULL);
+
+  pq->pos[handle] = pq->free_handle;
+  pq->free_handle = handle;
+}
+
+
+/* Move 'entry' from the hole at position p towards the root */
+static inline void pq_sift_up(pq_ptr pq, unsigned p, pq_entry_t entry)
+{
+  unsigned parent;
+  pq_entry_ptr heap = HEAP(pq);
+
+  while (p) {
+    parent = PARENT(p);
+    if (! LESS(pq, entry.key, heap[parent].key)) break;
+
+    heap[p] = heap[parent];
+    pq->pos[heap[p].handle] = p;
+    p = parent;
+  }
+
+  heap[p] = entry;
+  pq->pos[entry.handle] = p;
+}
+
+
+/* Move 'entry' from the hole at position p towards the leaves */
+static inline void pq_sift_down(pq_ptr pq, unsigned p, pq_entry_t entry)
+{
+  unsigned child, best, last;
+  pq_entry_ptr heap = HEAP(pq);
+
+  while ((child = FIRST_CHILD(p)) < pq->num) {
+    last = MIN(child + PQ_ARITY, pq->num);
+
+    for (best = child ++; child < last; child ++) {
+      if (LESS(pq, heap[child].key, heap[best].key)) best = child;
+    }
+
+    if (! LESS(pq, heap[best].key, entry.key)) break;
+
+    /* the next line of siblings is needed right after this move */
+    PREFETCH(heap + FIRST_CHILD(best));
+
+    heap[p] = heap[best];
+    pq->pos[heap[p].handle] = p;
+    p = best;
+  }
+
+  heap[p] = entry;
+  pq->pos[entry.handle] = p;
+}
+
+
+/* Drop the item at position p, filling the hole with the last one */
+static inline void pq_take(pq_ptr pq, unsigned p)
+{
+  pq_entry_ptr heap = HEAP(pq);
+  pq_entry_t last;
+
+  pq_handle_release(pq, heap[p].handle);
+
+  last = heap[-- pq->num];
+  if (p == pq->num) return;
+
+  if (p && LESS(pq, last.key, heap[PARENT(p)].key))
+    pq_sift_up(pq, p, last);
+  else
+    pq_sift_down(pq, p, last);
+}
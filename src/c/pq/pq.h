@@ -0,0 +1,81 @@
+#ifndef PQ_H
+#define PQ_H
+
+#include "common.h"
+#include "array/array.h"
+
+/* Heap fan-out. With 16 bytes per entry, the four children of a node
+   fill exactly one 64 bytes cache line (see PQ_OFFSET). */
+#define PQ_ARITY 4
+
+/* The root is stored at slot PQ_OFFSET of the (cache line aligned)
+   heap, so that the children of every node start on a line boundary */
+#define PQ_OFFSET (PQ_ARITY - 1)
+
+#define PQ_INIT_SIZE 256
+
+/* Error constants */
+#define PQ_OK           0
+#define PQ_EMPTY       -1
+#define PQ_OUT_OF_MEM  -2
+#define PQ_BAD_HANDLE  -3
+#define PQ_BAD_KEY     -4
+
+/* Priority types */
+#define PQ_KEY_DOUBLE   0
+#define PQ_KEY_LONG     1
+
+/* Handles are stable for as long as the item stays in the queue */
+#define PQ_NO_HANDLE  ((unsigned) -1)
+
+/* Priorities are compared natively, smaller ones come out first */
+typedef union pq_key_t {
+  double d;
+  long long l;
+} pq_key_t;
+
+typedef struct pq_entry_t {
+  pq_key_t key;
+  unsigned handle;
+} pq_entry_t;
+typedef pq_entry_t* pq_entry_ptr;
+
+typedef struct pq_t {
+  pq_entry_ptr heap;  /* PQ_OFFSET + n_size entries, 64 bytes aligned */
+  unsigned num;       /* number of queued items                       */
+  unsigned n_size;    /* heap capacity (in entries)                   */
+  int key_type;       /* one of PQ_KEY_xxx                            */
+
+  /* per-handle state. 'pos' holds the heap position of queued items,
+     and chains unused handles together in a free list */
+  array_ptr data;
+  unsigned* pos;
+  unsigned pos_size;
+  unsigned n_handles;
+  unsigned free_handle;
+} pq_t;
+typedef pq_t* pq_ptr;
+typedef pq_t** pq_dptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+pq_ptr pq_init(unsigned size, int key_type, free_func_ptr free);
+void pq_deinit(pq_ptr pq);
+
+int pq_push(pq_ptr pq, pq_key_t key, generic_ptr data, unsigned* handle);
+int pq_peek(pq_ptr pq, pq_key_t* key, generic_dptr data);
+int pq_pop(pq_ptr pq, pq_key_t* key, generic_dptr data);
+
+/* bulk load of n items, O(num + n) */
+int pq_heapify(pq_ptr pq, const pq_key_t* keys, generic_dptr data,
+               unsigned n, unsigned* handles);
+
+/* handle based operations */
+int pq_fetch(pq_ptr pq, unsigned handle, pq_key_t* key, generic_dptr data);
+int pq_decrease_key(pq_ptr pq, unsigned handle, pq_key_t key);
+int pq_update(pq_ptr pq, unsigned handle, pq_key_t key);
+int pq_remove(pq_ptr pq, unsigned handle, generic_dptr data);
+
+unsigned pq_n(const pq_ptr pq);
+void pq_clear(pq_ptr pq);
+
+#endif
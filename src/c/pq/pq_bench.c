@@ -0,0 +1,222 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+
+/* Dijkstra on a random graph with each of the priority queue engines.
+   Exits with status 1 if the engines disagree on the distances.
+   Usage: pq_bench [nodes [degree [max_weight]]] */
+#include <stdint.h>
+#include <time.h>
+
+#include "pq.h"
+#include "radix_heap.h"
+#include "pairing_heap.h"
+
+#define INFINITE ((unsigned long long) -1)
+
+typedef struct graph_t {
+  unsigned n;
+  unsigned* offsets;   /* n + 1 entries */
+  unsigned* targets;
+  unsigned* weights;
+} graph_t;
+
+static unsigned long long* dist;
+static unsigned* handles;
+static pairing_heap_node_ptr* nodes;
+
+/* -- internal functions ---------------------------------------------------- */
+static void graph_random(graph_t* g, unsigned n, unsigned degree,
+                         unsigned max_weight);
+static unsigned long long checksum(unsigned n);
+static int key_cmp(const generic_ptr a, generic_ptr b);
+static double run(const char* name, void (*dijkstra)(graph_t* g),
+                  graph_t* g, unsigned long long* sum);
+
+static void dijkstra_pq(graph_t* g)
+{
+  unsigned u, v, e;
+  pq_key_t key;
+  generic_ptr data;
+  pq_ptr pq = pq_init(0, PQ_KEY_LONG, NULL);
+
+  key.l = dist[0] = 0;
+  pq_push(pq, key, (generic_ptr) 0, &handles[0]);
+
+  while (pq_pop(pq, &key, &data) == PQ_OK) {
+    u = (unsigned)(uintptr_t) data;
+
+    for (e = g->offsets[u]; e < g->offsets[u + 1]; e ++) {
+      v = g->targets[e];
+      if (dist[u] + g->weights[e] >= dist[v]) continue;
+
+      key.l = dist[v] = dist[u] + g->weights[e];
+      if (pq_decrease_key(pq, handles[v], key) == PQ_BAD_HANDLE)
+        pq_push(pq, key, (generic_ptr)(uintptr_t) v, &handles[v]);
+    }
+  }
+
+  pq_deinit(pq);
+}
+
+/* no decrease-key, stale entries are skipped instead */
+static void dijkstra_radix(graph_t* g)
+{
+  unsigned u, v, e;
+  unsigned long long key;
+  generic_ptr data;
+  radix_heap_ptr heap = radix_heap_init(NULL);
+
+  dist[0] = 0;
+  radix_heap_push(heap, 0, (generic_ptr) 0);
+
+  while (radix_heap_pop(heap, &key, &data) == RADIX_HEAP_OK) {
+    u = (unsigned)(uintptr_t) data;
+    if (key > dist[u]) continue;
+
+    for (e = g->offsets[u]; e < g->offsets[u + 1]; e ++) {
+      v = g->targets[e];
+      if (dist[u] + g->weights[e] >= dist[v]) continue;
+
+      dist[v] = dist[u] + g->weights[e];
+      radix_heap_push(heap, dist[v], (generic_ptr)(uintptr_t) v);
+    }
+  }
+
+  radix_heap_deinit(heap);
+}
+
+/* keys point into dist[], which always holds the current key */
+static void dijkstra_pairing(graph_t* g)
+{
+  unsigned u, v, e;
+  generic_ptr key;
+  pairing_heap_ptr heap = pairing_heap_init(key_cmp, NULL, NULL);
+
+  dist[0] = 0;
+  nodes[0] = pairing_heap_push(heap, &dist[0], NULL);
+
+  while (pairing_heap_pop(heap, &key, NULL) == PAIRING_HEAP_OK) {
+    u = (unsigned)((unsigned long long *) key - dist);
+    nodes[u] = NULL;
+
+    for (e = g->offsets[u]; e < g->offsets[u + 1]; e ++) {
+      v = g->targets[e];
+      if (dist[u] + g->weights[e] >= dist[v]) continue;
+
+      dist[v] = dist[u] + g->weights[e];
+      if (nodes[v])
+        pairing_heap_decrease_key(heap, nodes[v], &dist[v]);
+      else
+        nodes[v] = pairing_heap_push(heap, &dist[v], NULL);
+    }
+  }
+
+  pairing_heap_deinit(heap);
+}
+
+int main(int argc, char** argv)
+{
+  graph_t g;
+  unsigned n = argc > 1 ? atoi(argv[1]) : 1 << 20;
+  unsigned degree = argc > 2 ? atoi(argv[2]) : 8;
+  unsigned max_weight = argc > 3 ? atoi(argv[3]) : 1000;
+  double base;
+  unsigned long long expected, sum;
+  int res = 0;
+
+  srand(42);
+  graph_random(&g, n, degree, max_weight);
+
+  dist = (unsigned long long *) malloc(n * sizeof(unsigned long long));
+  handles = (unsigned *) malloc(n * sizeof(unsigned));
+  nodes = (pairing_heap_node_ptr *) malloc(n * sizeof(pairing_heap_node_ptr));
+
+  printf("%u nodes, %u edges, weights in [1, %u]\n",
+         n, g.offsets[n], max_weight);
+
+  base = run("4-ary heap", dijkstra_pq, &g, &expected);
+  printf("\n");
+
+  printf("  (%.2fx)\n", base / run("radix heap", dijkstra_radix, &g, &sum));
+  if (sum != expected) res = 1;
+
+  printf("  (%.2fx)\n", base / run("pairing heap", dijkstra_pairing, &g, &sum));
+  if (sum != expected) res = 1;
+
+  if (res) fprintf(stderr, "checksum mismatch\n");
+
+  free(g.offsets); free(g.targets); free(g.weights);
+  free(dist); free(handles); free(nodes);
+
+  return res;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static void graph_random(graph_t* g, unsigned n, unsigned degree,
+                         unsigned max_weight)
+{
+  unsigned u, e;
+
+  g->n = n;
+  g->offsets = (unsigned *) malloc((n + 1) * sizeof(unsigned));
+  g->targets = (unsigned *) malloc((size_t) n * degree * sizeof(unsigned));
+  g->weights = (unsigned *) malloc((size_t) n * degree * sizeof(unsigned));
+
+  for (u = 0, e = 0; u < n; u ++) {
+    g->offsets[u] = e;
+    for (; e < (u + 1) * degree; e ++) {
+      g->targets[e] = rand() % n;
+      g->weights[e] = 1 + rand() % max_weight;
+    }
+  }
+  g->offsets[n] = e;
+}
+
+
+static unsigned long long checksum(unsigned n)
+{
+  unsigned u;
+  unsigned long long res = 0;
+
+  for (u = 0; u < n; u ++)
+    if (dist[u] != INFINITE) res += dist[u];
+
+  return res;
+}
+
+
+static int key_cmp(const generic_ptr a, generic_ptr b)
+{
+  unsigned long long x = *(unsigned long long *) a;
+  unsigned long long y = *(unsigned long long *) b;
+
+  return (x > y) - (x < y);
+}
+
+
+static double run(const char* name, void (*dijkstra)(graph_t* g),
+                  graph_t* g, unsigned long long* sum)
+{
+  clock_t start;
+  double elapsed;
+  unsigned u;
+
+  for (u = 0; u < g->n; u ++) {
+    dist[u] = INFINITE;
+    handles[u] = PQ_NO_HANDLE;
+    nodes[u] = NULL;
+  }
+
+  start = clock();
+  dijkstra(g);
+  elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  (*sum) = checksum(g->n);
+  printf("%-14s %8.3fs  checksum %llu", name, elapsed, *sum);
+  fflush(stdout);
+
+  return elapsed;
+}
@@ -0,0 +1,214 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "radix_heap.h"
+
+#define BUCKET_OF(heap, key)                                                   \
+  ((key) == (heap)->last ? 0 : 64 - CLZ64((key) ^ (heap)->last))
+
+/* -- internal functions ---------------------------------------------------- */
+static inline int radix_heap_reserve(radix_heap_bucket_ptr bucket,
+                                     unsigned n);
+static inline void radix_heap_add(radix_heap_ptr heap, unsigned b,
+                                  unsigned long long key, generic_ptr data);
+static int radix_heap_refill(radix_heap_ptr heap);
+
+radix_heap_ptr radix_heap_init(free_func_ptr free_func)
+{
+  radix_heap_ptr heap;
+
+  if (! (heap = (radix_heap_ptr) malloc(sizeof(radix_heap_t))))
+    return NULL;
+
+  memset(heap->buckets, 0, sizeof(heap->buckets));
+  heap->mask = 0;
+  heap->last = 0;
+  heap->num = 0;
+  heap->free = free_func;
+
+  return heap;
+}
+
+
+void radix_heap_deinit(radix_heap_ptr heap)
+{
+  unsigned b;
+  CHECK_INSTANCE(heap);
+
+  radix_heap_clear(heap);
+
+  for (b = 0; b < RADIX_HEAP_BUCKETS; b ++)
+    free(heap->buckets[b].entries);
+
+  free(heap);
+}
+
+
+/* Queue 'data' with priority 'key', O(1). Keys below the last one
+   popped are rejected with RADIX_HEAP_BAD_KEY. */
+int radix_heap_push(radix_heap_ptr heap, unsigned long long key,
+                    generic_ptr data)
+{
+  unsigned b;
+  CHECK_INSTANCE(heap);
+
+  if (key < heap->last) return RADIX_HEAP_BAD_KEY;
+
+  b = BUCKET_OF(heap, key);
+  if (radix_heap_reserve(heap->buckets + b, 1) != RADIX_HEAP_OK)
+    return RADIX_HEAP_OUT_OF_MEM;
+
+  radix_heap_add(heap, b, key, data);
+  heap->num ++;
+
+  return RADIX_HEAP_OK;
+}
+
+
+/* Smallest key in the heap. This may redistribute a bucket, and so
+   fail with RADIX_HEAP_OUT_OF_MEM; the heap is left untouched then. */
+int radix_heap_peek(radix_heap_ptr heap, unsigned long long* key,
+                    generic_dptr data)
+{
+  int res;
+  radix_heap_bucket_ptr bucket;
+  CHECK_INSTANCE(heap);
+
+  if (! heap->num) return RADIX_HEAP_EMPTY;
+
+  bucket = heap->buckets;
+  if (! bucket->num && (res = radix_heap_refill(heap)) != RADIX_HEAP_OK)
+    return res;
+
+  if (key) (*key) = heap->last;
+  if (data) (*data) = bucket->entries[bucket->num - 1].data;
+
+  return RADIX_HEAP_OK;
+}
+
+
+int radix_heap_pop(radix_heap_ptr heap, unsigned long long* key,
+                   generic_dptr data)
+{
+  int res;
+
+  if ((res = radix_heap_peek(heap, key, data)) != RADIX_HEAP_OK)
+    return res;
+
+  heap->buckets[0].num --;
+  heap->num --;
+
+  return RADIX_HEAP_OK;
+}
+
+
+unsigned radix_heap_n(const radix_heap_ptr heap)
+{
+  CHECK_INSTANCE(heap);
+  return heap->num;
+}
+
+
+/* Release all queued items. Bucket storage is kept for reuse. */
+void radix_heap_clear(radix_heap_ptr heap)
+{
+  unsigned b, i;
+  radix_heap_bucket_ptr bucket;
+  CHECK_INSTANCE(heap);
+
+  for (b = 0; b < RADIX_HEAP_BUCKETS; b ++) {
+    bucket = heap->buckets + b;
+
+    if (heap->free) {
+      for (i = 0; i < bucket->num; i ++)
+        heap->free(bucket->entries[i].data);
+    }
+
+    bucket->num = 0;
+  }
+
+  heap->mask = 0;
+  heap->last = 0;
+  heap->num = 0;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static inline int radix_heap_reserve(radix_heap_bucket_ptr bucket,
+                                     unsigned n)
+{
+  unsigned size;
+  radix_heap_entry_ptr entries;
+
+  if (bucket->num + n <= bucket->n_size) return RADIX_HEAP_OK;
+
+  size = MAX(RADIX_HEAP_INIT_SIZE, MAX(2 * bucket->n_size, bucket->num + n));
+  if (! (entries = (radix_heap_entry_ptr)
+         realloc(bucket->entries, size * sizeof(radix_heap_entry_t))))
+    return RADIX_HEAP_OUT_OF_MEM;
+
+  bucket->entries = entries;
+  bucket->n_size = size;
+
+  return RADIX_HEAP_OK;
+}
+
+
+/* Append to bucket b, room must have been reserved already */
+static inline void radix_heap_add(radix_heap_ptr heap, unsigned b,
+                                  unsigned long long key, generic_ptr data)
+{
+  radix_heap_bucket_ptr bucket = heap->buckets + b;
+  radix_heap_entry_ptr entry = bucket->entries + bucket->num ++;
+
+  entry->key = key;
+  entry->data = data;
+
+  if (b) heap->mask |= 1ULL << (b - 1);
+}
+
+
+/* Bucket 0 is empty: advance 'last' to the smallest key of the first
+   non-empty bucket and spread that bucket over the lower ones. Every
+   entry moves to a strictly lower bucket, hence the amortized bound.
+   Target buckets are sized up front, so nothing moves on failure. */
+static int radix_heap_refill(radix_heap_ptr heap)
+{
+  unsigned b, i, counts[RADIX_HEAP_BUCKETS];
+  unsigned long long last;
+  radix_heap_bucket_ptr bucket;
+  radix_heap_entry_ptr entry;
+
+  assert(heap->mask);
+  b = 1 + CTZ64(heap->mask);
+  bucket = heap->buckets + b;
+
+  last = bucket->entries[0].key;
+  for (i = 1; i < bucket->num; i ++)
+    last = MIN(last, bucket->entries[i].key);
+
+  memset(counts, 0, b * sizeof(unsigned));
+  for (i = 0; i < bucket->num; i ++) {
+    entry = bucket->entries + i;
+    counts[entry->key == last ? 0 : 64 - CLZ64(entry->key ^ last)] ++;
+  }
+
+  for (i = 0; i < b; i ++) {
+    if (counts[i] &&
+        radix_heap_reserve(heap->buckets + i, counts[i]) != RADIX_HEAP_OK)
+      return RADIX_HEAP_OUT_OF_MEM;
+  }
+
+  heap->last = last;
+  for (i = 0; i < bucket->num; i ++) {
+    entry = bucket->entries + i;
+    radix_heap_add(heap, BUCKET_OF(heap, entry->key), entry->key,
+                   entry->data);
+  }
+
+  bucket->num = 0;
+  heap->mask &= ~(1ULL << (b - 1));
+
+  return RADIX_HEAP_OK;
+}
@@ -0,0 +1,60 @@
+#ifndef RADIX_HEAP_H
+#define RADIX_HEAP_H
+
+#include "common.h"
+
+/* Monotone priority queue for unsigned integer keys: no key may be
+   pushed below the last one popped, as in Dijkstra's algorithm with
+   non-negative weights. Push is O(1), pop is amortized O(log(C)) where
+   C is the largest key spread, and there are no key comparisons
+   beyond a handful of bit tricks. */
+
+/* bucket 0 holds keys equal to 'last', bucket b > 0 keys whose highest
+   bit differing from 'last' is bit b - 1 */
+#define RADIX_HEAP_BUCKETS 65
+
+#define RADIX_HEAP_INIT_SIZE 16
+
+/* Error constants */
+#define RADIX_HEAP_OK           0
+#define RADIX_HEAP_EMPTY       -1
+#define RADIX_HEAP_OUT_OF_MEM  -2
+#define RADIX_HEAP_BAD_KEY     -4
+
+typedef struct radix_heap_entry_t {
+  unsigned long long key;
+  generic_ptr data;
+} radix_heap_entry_t;
+typedef radix_heap_entry_t* radix_heap_entry_ptr;
+
+typedef struct radix_heap_bucket_t {
+  radix_heap_entry_ptr entries;
+  unsigned num;
+  unsigned n_size;
+} radix_heap_bucket_t;
+typedef radix_heap_bucket_t* radix_heap_bucket_ptr;
+
+typedef struct radix_heap_t {
+  radix_heap_bucket_t buckets[RADIX_HEAP_BUCKETS];
+  unsigned long long mask;  /* bit b - 1 set <=> bucket b not empty */
+  unsigned long long last;  /* last key popped (0 initially)        */
+  unsigned num;
+  free_func_ptr free;
+} radix_heap_t;
+typedef radix_heap_t* radix_heap_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+radix_heap_ptr radix_heap_init(free_func_ptr free);
+void radix_heap_deinit(radix_heap_ptr heap);
+
+int radix_heap_push(radix_heap_ptr heap, unsigned long long key,
+                    generic_ptr data);
+int radix_heap_peek(radix_heap_ptr heap, unsigned long long* key,
+                    generic_dptr data);
+int radix_heap_pop(radix_heap_ptr heap, unsigned long long* key,
+                   generic_dptr data);
+
+unsigned radix_heap_n(const radix_heap_ptr heap);
+void radix_heap_clear(radix_heap_ptr heap);
+
+#endif
@@ -0,0 +1,306 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "ring.h"
+
+#include <stdint.h>
+#include <sched.h>
+#include <time.h>
+
+#define SINGLE_PRODUCER(ring)                                                  \
+  ((ring)->mode == RING_SPSC)
+
+#define SINGLE_CONSUMER(ring)                                                  \
+  ((ring)->mode != RING_MPMC)
+
+#define CELL(ring, pos)                                                        \
+  ((ring)->cells + ((pos) & (ring)->mask))
+
+/* -- internal functions ---------------------------------------------------- */
+static inline long long ring_now_us(void);
+static inline int ring_backoff(unsigned* round, long long deadline);
+
+ring_ptr ring_init(unsigned size, int mode, free_func_ptr free_func)
+{
+  size_t i, n_cells;
+  ring_ptr ring;
+
+  for (n_cells = RING_MIN_SIZE; n_cells < size; n_cells <<= 1)
+    ;
+
+  /* keep head and tail on cache lines of their own */
+  if (posix_memalign((void **) &ring, CACHE_LINE_SIZE, sizeof(ring_t)))
+    return NULL;
+
+  if (posix_memalign((void **) &ring->cells, CACHE_LINE_SIZE,
+                     n_cells * sizeof(ring_cell_t))) {
+    free(ring);
+    return NULL;
+  }
+
+  /* cell i is free for the enqueue at position i */
+  for (i = 0; i < n_cells; i ++) {
+    ring->cells[i].seq = i;
+    ring->cells[i].data = NULL;
+  }
+
+  ring->mask = n_cells - 1;
+  ring->mode = mode;
+  ring->free = free_func;
+  ring->tail = ring->head = 0;
+
+  return ring;
+}
+
+
+void ring_deinit(ring_ptr ring)
+{
+  generic_ptr data;
+  CHECK_INSTANCE(ring);
+
+  while (ring_dequeue(ring, &data) == RING_OK) {
+    if (ring->free) ring->free(data);
+  }
+
+  free(ring->cells);
+  free(ring);
+}
+
+
+int ring_enqueue(ring_ptr ring, generic_ptr data)
+{
+  size_t pos;
+  intptr_t diff;
+  ring_cell_ptr cell;
+  CHECK_INSTANCE(ring);
+
+  pos = ATOMIC_LOAD(&ring->tail, RELAXED);
+  for (;;) {
+    cell = CELL(ring, pos);
+    diff = (intptr_t) ATOMIC_LOAD(&cell->seq, ACQUIRE) - (intptr_t) pos;
+
+    if (! diff) {
+      if (SINGLE_PRODUCER(ring)) {
+        ATOMIC_STORE(&ring->tail, pos + 1, RELAXED);
+        break;
+      }
+
+      if (ATOMIC_CAS(&ring->tail, &pos, pos + 1, RELAXED)) break;
+    }
+
+    /* the cell still holds the item of the previous lap */
+    else if (diff < 0) return RING_FULL;
+
+    /* another producer got here first */
+    else pos = ATOMIC_LOAD(&ring->tail, RELAXED);
+  }
+
+  cell->data = data;
+  ATOMIC_STORE(&cell->seq, pos + 1, RELEASE);
+
+  return RING_OK;
+}
+
+
+int ring_dequeue(ring_ptr ring, generic_dptr data)
+{
+  size_t pos;
+  intptr_t diff;
+  ring_cell_ptr cell;
+  CHECK_INSTANCE(ring);
+
+  pos = ATOMIC_LOAD(&ring->head, RELAXED);
+  for (;;) {
+    cell = CELL(ring, pos);
+    diff = (intptr_t) ATOMIC_LOAD(&cell->seq, ACQUIRE) - (intptr_t)(pos + 1);
+
+    if (! diff) {
+      if (SINGLE_CONSUMER(ring)) {
+        ATOMIC_STORE(&ring->head, pos + 1, RELAXED);
+        break;
+      }
+
+      if (ATOMIC_CAS(&ring->head, &pos, pos + 1, RELAXED)) break;
+    }
+
+    /* the cell has not been filled for this lap yet */
+    else if (diff < 0) return RING_EMPTY;
+
+    /* another consumer got here first */
+    else pos = ATOMIC_LOAD(&ring->head, RELAXED);
+  }
+
+  (*data) = cell->data;
+  ATOMIC_STORE(&cell->seq, pos + ring->mask + 1, RELEASE);
+
+  return RING_OK;
+}
+
+
+/* Enqueue up to n items with a single CAS. Free cells are counted from
+   the enqueue position first, then claimed all at once. */
+unsigned ring_enqueue_many(ring_ptr ring, generic_dptr items, unsigned n)
+{
+  size_t pos;
+  unsigned i, k;
+  intptr_t diff;
+  CHECK_INSTANCE(ring);
+
+  if (! n) return 0;
+
+  pos = ATOMIC_LOAD(&ring->tail, RELAXED);
+  for (;;) {
+    for (k = 0; k < n; k ++) {
+      if (ATOMIC_LOAD(&CELL(ring, pos + k)->seq, ACQUIRE) != pos + k) break;
+    }
+
+    if (! k) {
+      diff = (intptr_t) ATOMIC_LOAD(&CELL(ring, pos)->seq, ACQUIRE) -
+        (intptr_t) pos;
+
+      if (diff < 0) return 0;
+      pos = ATOMIC_LOAD(&ring->tail, RELAXED);
+      continue;
+    }
+
+    if (SINGLE_PRODUCER(ring)) {
+      ATOMIC_STORE(&ring->tail, pos + k, RELAXED);
+      break;
+    }
+
+    if (ATOMIC_CAS(&ring->tail, &pos, pos + k, RELAXED)) break;
+  }
+
+  for (i = 0; i < k; i ++) {
+    CELL(ring, pos + i)->data = items[i];
+    ATOMIC_STORE(&CELL(ring, pos + i)->seq, pos + i + 1, RELEASE);
+  }
+
+  return k;
+}
+
+
+/* Dequeue up to n items with a single CAS, see ring_enqueue_many */
+unsigned ring_dequeue_many(ring_ptr ring, generic_dptr items, unsigned n)
+{
+  size_t pos;
+  unsigned i, k;
+  intptr_t diff;
+  CHECK_INSTANCE(ring);
+
+  if (! n) return 0;
+
+  pos = ATOMIC_LOAD(&ring->head, RELAXED);
+  for (;;) {
+    for (k = 0; k < n; k ++) {
+      if (ATOMIC_LOAD(&CELL(ring, pos + k)->seq, ACQUIRE) != pos + k + 1)
+        break;
+    }
+
+    if (! k) {
+      diff = (intptr_t) ATOMIC_LOAD(&CELL(ring, pos)->seq, ACQUIRE) -
+        (intptr_t)(pos + 1);
+
+      if (diff < 0) return 0;
+      pos = ATOMIC_LOAD(&ring->head, RELAXED);
+      continue;
+    }
+
+    if (SINGLE_CONSUMER(ring)) {
+      ATOMIC_STORE(&ring->head, pos + k, RELAXED);
+      break;
+    }
+
+    if (ATOMIC_CAS(&ring->head, &pos, pos + k, RELAXED)) break;
+  }
+
+  for (i = 0; i < k; i ++) {
+    items[i] = CELL(ring, pos + i)->data;
+    ATOMIC_STORE(&CELL(ring, pos + i)->seq, pos + i + ring->mask + 1,
+                 RELEASE);
+  }
+
+  return k;
+}
+
+
+int ring_enqueue_wait(ring_ptr ring, generic_ptr data, long timeout_us)
+{
+  unsigned round = 0;
+  long long deadline = timeout_us < 0 ? -1 : ring_now_us() + timeout_us;
+
+  while (ring_enqueue(ring, data) == RING_FULL) {
+    if (! ring_backoff(&round, deadline)) return RING_TIMEOUT;
+  }
+
+  return RING_OK;
+}
+
+
+int ring_dequeue_wait(ring_ptr ring, generic_dptr data, long timeout_us)
+{
+  unsigned round = 0;
+  long long deadline = timeout_us < 0 ? -1 : ring_now_us() + timeout_us;
+
+  while (ring_dequeue(ring, data) == RING_EMPTY) {
+    if (! ring_backoff(&round, deadline)) return RING_TIMEOUT;
+  }
+
+  return RING_OK;
+}
+
+
+unsigned ring_n(const ring_ptr ring)
+{
+  size_t head, tail;
+  CHECK_INSTANCE(ring);
+
+  head = ATOMIC_LOAD(&ring->head, RELAXED);
+  tail = ATOMIC_LOAD(&ring->tail, RELAXED);
+
+  /* positions are read at different times, clamp to a sane value */
+  if (tail < head) return 0;
+  return (unsigned) MIN(tail - head, ring->mask + 1);
+}
+
+
+unsigned ring_capacity(const ring_ptr ring)
+{
+  CHECK_INSTANCE(ring);
+  return (unsigned)(ring->mask + 1);
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static inline long long ring_now_us(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+
+/* Wait a little before the next attempt, longer on each round. Returns
+   0 once the deadline (if any, < 0 means none) has passed. */
+static inline int ring_backoff(unsigned* round, long long deadline)
+{
+  struct timespec pause;
+
+  if ((*round) < RING_SPINS) CPU_RELAX();
+
+  else if ((*round) < RING_SPINS + RING_YIELDS) sched_yield();
+
+  else {
+    pause.tv_sec = 0;
+    pause.tv_nsec = RING_SLEEP_NS;
+    nanosleep(&pause, NULL);
+  }
+
+  (*round) ++;
+
+  /* spinning is too short to bother with the clock */
+  if (deadline < 0 || (*round) <= RING_SPINS) return 1;
+  return ring_now_us() < deadline;
+}
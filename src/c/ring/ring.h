@@ -0,0 +1,77 @@
+#ifndef RING_H
+#define RING_H
+
+#include "common.h"
+
+#ifdef ATOMICS_UNSUPPORTED
+#error "the ring buffer needs the __atomic builtins of gcc or clang"
+#endif
+
+/* Bounded lock-free queue of generic_ptr items (D. Vyukov's design).
+   Each cell carries a sequence number telling producers and consumers
+   whether it is free or full for the current lap, so the only shared
+   counters are the enqueue and dequeue positions, each on its own
+   cache line. Single producer/consumer modes replace the CAS on their
+   side with a plain store. */
+
+#define RING_MIN_SIZE 2
+
+/* Error constants */
+#define RING_OK           0
+#define RING_EMPTY       -1
+#define RING_OUT_OF_MEM  -2
+#define RING_FULL        -3
+#define RING_TIMEOUT     -4
+
+/* Modes, by number of concurrent producers and consumers */
+#define RING_MPMC         0
+#define RING_SPSC         1
+#define RING_MPSC         2
+
+/* Waiting: spin for a while, then yield the CPU, then sleep */
+#define RING_SPINS       64
+#define RING_YIELDS      64
+#define RING_SLEEP_NS    50000
+
+typedef struct ring_cell_t {
+  size_t seq;
+  generic_ptr data;
+} ring_cell_t;
+typedef ring_cell_t* ring_cell_ptr;
+
+typedef struct ring_t {
+  ring_cell_ptr cells;
+  size_t mask;            /* number of cells - 1, a power of 2 less 1 */
+  int mode;               /* one of RING_xxx modes                    */
+  free_func_ptr free;
+
+  size_t tail CACHE_ALIGNED;   /* next position to enqueue */
+  size_t head CACHE_ALIGNED;   /* next position to dequeue */
+} ring_t;
+typedef ring_t* ring_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* size is rounded up to a power of 2 */
+ring_ptr ring_init(unsigned size, int mode, free_func_ptr free);
+
+/* not thread-safe, left over items are released with 'free' */
+void ring_deinit(ring_ptr ring);
+
+/* non-blocking, RING_FULL/RING_EMPTY when there's no room/item */
+int ring_enqueue(ring_ptr ring, generic_ptr data);
+int ring_dequeue(ring_ptr ring, generic_dptr data);
+
+/* non-blocking, return the number of items actually moved */
+unsigned ring_enqueue_many(ring_ptr ring, generic_dptr items, unsigned n);
+unsigned ring_dequeue_many(ring_ptr ring, generic_dptr items, unsigned n);
+
+/* blocking, timeout_us < 0 waits forever, RING_TIMEOUT on timeout */
+int ring_enqueue_wait(ring_ptr ring, generic_ptr data, long timeout_us);
+int ring_dequeue_wait(ring_ptr ring, generic_dptr data, long timeout_us);
+
+/* approximate under concurrent access */
+unsigned ring_n(const ring_ptr ring);
+unsigned ring_capacity(const ring_ptr ring);
+
+#endif
@@ -0,0 +1,491 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "ttl.h"
+
+#include <time.h>
+
+#define SLOT_MASK (TTL_SLOTS - 1)
+
+#define BUCKET(table, hash)                                                    \
+  (MIX64(hash) & (table)->mask)
+
+#define ENTRY(l)                                                               \
+  DLIST_ENTRY(l, ttl_entry_t, link)
+
+/* the slot index of time t at level l */
+#define SLOT(t, l)                                                             \
+  ((unsigned) ((t) >> ((l) * TTL_BITS)) & SLOT_MASK)
+
+/* the ticks spanned by a slot of level l */
+#define SPAN(l)                                                                \
+  (1ULL << ((l) * TTL_BITS))
+
+/* -- internal functions ---------------------------------------------------- */
+static inline ttl_entry_ptr ttl_lookup(ttl_ptr table, generic_ptr key,
+                                       unsigned hash);
+static inline void ttl_tick(ttl_ptr table);
+static ttl_entry_ptr ttl_entry_new(ttl_ptr table);
+static void ttl_remove(ttl_ptr table, ttl_entry_ptr e);
+static void ttl_schedule(ttl_ptr table, ttl_entry_ptr e, ttl_time_t ttl);
+static void ttl_place(ttl_ptr table, ttl_entry_ptr e);
+static void ttl_unschedule(ttl_ptr table, ttl_entry_ptr e);
+static void ttl_cascade(ttl_ptr table, dlist_ptr slot);
+static void ttl_grow(ttl_ptr table);
+
+ttl_ptr ttl_init(hash_func_ptr hash_func,
+                 cmp_func_ptr cmp_func,
+                 free_func_ptr key_free_func,
+                 free_func_ptr value_free_func,
+                 ttl_clock_func_ptr clock)
+{
+  ttl_ptr table;
+  unsigned l, s;
+
+  if (! (table = (ttl_ptr) malloc(sizeof(ttl_t))))
+    return NULL;
+
+  if (! (table->buckets = (ttl_entry_ptr*)
+         calloc(TTL_INIT_BUCKETS, sizeof(ttl_entry_ptr)))) {
+    free(table);
+    return NULL;
+  }
+
+  table->mask = TTL_INIT_BUCKETS - 1;
+
+  table->hash_func = hash_func;
+  table->cmp_func = cmp_func;
+  table->key_free_func = key_free_func;
+  table->value_free_func = value_free_func;
+  table->clock = clock;
+
+  table->num = 0;
+  table->now = clock ? clock() : 0;
+
+  for (l = 0; l < TTL_LEVELS; ++ l) {
+    for (s = 0; s < TTL_SLOTS; ++ s)
+      dlist_init(&table->wheel[l][s]);
+    table->occupied[l] = 0;
+  }
+  dlist_init(&table->overflow);
+
+  table->chunks = NULL;
+  table->chunk_used = TTL_CHUNK_SIZE;
+  table->free_entries = NULL;
+
+  return table;
+}
+
+
+void ttl_deinit(ttl_ptr table)
+{
+  CHECK_INSTANCE(table);
+
+  ttl_clear(table);
+
+  free(table->buckets);
+  free(table);
+}
+
+
+void ttl_clear(ttl_ptr table)
+{
+  ttl_entry_ptr e;
+  ttl_chunk_ptr chunk;
+  size_t i;
+  unsigned l, s;
+
+  CHECK_INSTANCE(table);
+
+  for (i = 0; i <= table->mask; ++ i)
+    for (e = table->buckets[i]; e; e = e->next) {
+      if (table->key_free_func)
+        table->key_free_func(e->key);
+      if (table->value_free_func)
+        table->value_free_func(e->value);
+    }
+
+  while ((chunk = table->chunks)) {
+    table->chunks = chunk->next;
+    free(chunk);
+  }
+
+  memset(table->buckets, 0, (table->mask + 1) * sizeof(ttl_entry_ptr));
+  table->num = 0;
+
+  for (l = 0; l < TTL_LEVELS; ++ l) {
+    for (s = 0; s < TTL_SLOTS; ++ s)
+      dlist_init(&table->wheel[l][s]);
+    table->occupied[l] = 0;
+  }
+  dlist_init(&table->overflow);
+
+  table->chunk_used = TTL_CHUNK_SIZE;
+  table->free_entries = NULL;
+}
+
+
+int ttl_insert(ttl_ptr table, generic_ptr key, generic_ptr value,
+               ttl_time_t ttl)
+{
+  ttl_entry_ptr e;
+  unsigned hash;
+  size_t i;
+
+  CHECK_INSTANCE(table);
+
+  ttl_tick(table);
+  hash = table->hash_func(key);
+
+  if ((e = ttl_lookup(table, key, hash))) {
+    if (table->key_free_func)
+      table->key_free_func(e->key);
+    if (table->value_free_func)
+      table->value_free_func(e->value);
+
+    e->key = key;
+    e->value = value;
+
+    ttl_unschedule(table, e);
+    ttl_schedule(table, e, ttl);
+    return TTL_OK;
+  }
+
+  /* keep chains short; when out of memory they just get longer */
+  if (table->num > table->mask)
+    ttl_grow(table);
+
+  if (! (e = ttl_entry_new(table)))
+    return TTL_OUT_OF_MEM;
+
+  e->key = key;
+  e->value = value;
+  e->hash = hash;
+
+  i = BUCKET(table, hash);
+  e->next = table->buckets[i];
+  table->buckets[i] = e;
+  ++ table->num;
+
+  ttl_schedule(table, e, ttl);
+  return TTL_OK;
+}
+
+
+generic_ptr ttl_find(ttl_ptr table, generic_ptr key)
+{
+  ttl_entry_ptr e;
+
+  CHECK_INSTANCE(table);
+
+  ttl_tick(table);
+
+  e = ttl_lookup(table, key, table->hash_func(key));
+  return e ? e->value : NULL;
+}
+
+
+int ttl_delete(ttl_ptr table, generic_ptr key)
+{
+  ttl_entry_ptr e;
+
+  CHECK_INSTANCE(table);
+
+  ttl_tick(table);
+
+  if (! (e = ttl_lookup(table, key, table->hash_func(key))))
+    return TTL_NOT_FOUND;
+
+  ttl_remove(table, e);
+  return TTL_OK;
+}
+
+
+int ttl_set_ttl(ttl_ptr table, generic_ptr key, ttl_time_t ttl)
+{
+  ttl_entry_ptr e;
+
+  CHECK_INSTANCE(table);
+
+  ttl_tick(table);
+
+  if (! (e = ttl_lookup(table, key, table->hash_func(key))))
+    return TTL_NOT_FOUND;
+
+  ttl_unschedule(table, e);
+  ttl_schedule(table, e, ttl);
+  return TTL_OK;
+}
+
+
+size_t ttl_advance(ttl_ptr table, ttl_time_t now)
+{
+  dlist_ptr slot;
+  dlist_link_ptr l;
+  ttl_time_t next, when;
+  unsigned long long later;
+  unsigned level, s;
+  size_t expired = 0;
+
+  CHECK_INSTANCE(table);
+
+  while (table->now < now) {
+
+    /* the overflow bound may be stale, from removed entries */
+    if (table->overflow.num &&
+        (table->overflow_min & ~ (SPAN(TTL_LEVELS) - 1)) <= table->now) {
+      table->overflow_min = ~ 0ULL;
+      ttl_cascade(table, &table->overflow);
+    }
+
+    /* the next time a slot is due: at each level, the first occupied
+       slot past the current one (the ones before are empty, entries
+       expire later than now) */
+    next = now;
+    for (level = 0; level < TTL_LEVELS; ++ level) {
+      later = table->occupied[level] &
+        ~ ((2ULL << SLOT(table->now, level)) - 1);
+      if (! later)
+        continue;
+
+      when = (table->now & ~ (SPAN(level + 1) - 1)) |
+        ((ttl_time_t) CTZ64(later) << (level * TTL_BITS));
+      next = MIN(next, when);
+    }
+
+    if (table->overflow.num) {
+      when = table->overflow_min & ~ (SPAN(TTL_LEVELS) - 1);
+      next = MIN(next, when);
+    }
+
+    table->now = next;
+
+    /* cascade the slots due now, top down: entries land below the
+       slots yet to be cascaded */
+    if (table->overflow.num &&
+        (table->overflow_min & ~ (SPAN(TTL_LEVELS) - 1)) <= next) {
+      table->overflow_min = ~ 0ULL;
+      ttl_cascade(table, &table->overflow);
+    }
+
+    for (level = TTL_LEVELS - 1; level > 0; -- level) {
+      if (next & (SPAN(level) - 1))
+        continue;
+
+      s = SLOT(next, level);
+      if (table->occupied[level] & (1ULL << s)) {
+        table->occupied[level] &= ~ (1ULL << s);
+        ttl_cascade(table, &table->wheel[level][s]);
+      }
+    }
+
+    /* level 0 slots hold the entries expiring exactly now */
+    s = SLOT(next, 0);
+    if (table->occupied[0] & (1ULL << s)) {
+      slot = &table->wheel[0][s];
+
+      while ((l = dlist_first(slot))) {
+        ttl_remove(table, ENTRY(l));
+        ++ expired;
+      }
+    }
+  }
+
+  return expired;
+}
+
+
+ttl_time_t ttl_now(ttl_ptr table)
+{
+  CHECK_INSTANCE(table);
+
+  return table->now;
+}
+
+
+size_t ttl_count(ttl_ptr table)
+{
+  CHECK_INSTANCE(table);
+
+  return table->num;
+}
+
+
+ttl_time_t ttl_clock_ms(void)
+{
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (ttl_time_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/* -- internal functions ---------------------------------------------------- */
+static inline ttl_entry_ptr ttl_lookup(ttl_ptr table, generic_ptr key,
+                                       unsigned hash)
+{
+  ttl_entry_ptr e;
+
+  /* keys with different hashes can not be equal */
+  for (e = table->buckets[BUCKET(table, hash)]; e; e = e->next)
+    if (e->hash == hash && ! table->cmp_func(key, e->key))
+      return e;
+
+  return NULL;
+}
+
+
+/* expire what is due, for tables with a clock */
+static inline void ttl_tick(ttl_ptr table)
+{
+  if (table->clock)
+    ttl_advance(table, table->clock());
+}
+
+
+static ttl_entry_ptr ttl_entry_new(ttl_ptr table)
+{
+  ttl_entry_ptr e;
+  ttl_chunk_ptr chunk;
+
+  if ((e = table->free_entries)) {
+    table->free_entries = e->next;
+    return e;
+  }
+
+  if (table->chunk_used == TTL_CHUNK_SIZE) {
+    if (! (chunk = (ttl_chunk_ptr) malloc(sizeof(ttl_chunk_t))))
+      return NULL;
+
+    chunk->next = table->chunks;
+    table->chunks = chunk;
+    table->chunk_used = 0;
+  }
+
+  return &table->chunks->entries[table->chunk_used ++];
+}
+
+
+static void ttl_remove(ttl_ptr table, ttl_entry_ptr e)
+{
+  ttl_entry_ptr* p;
+
+  for (p = &table->buckets[BUCKET(table, e->hash)]; *p != e; p = &(*p)->next)
+    ;
+  *p = e->next;
+  -- table->num;
+
+  ttl_unschedule(table, e);
+
+  if (table->key_free_func)
+    table->key_free_func(e->key);
+  if (table->value_free_func)
+    table->value_free_func(e->value);
+
+  e->next = table->free_entries;
+  table->free_entries = e;
+}
+
+
+static void ttl_schedule(ttl_ptr table, ttl_entry_ptr e, ttl_time_t ttl)
+{
+  if (ttl == TTL_NEVER) {
+    e->where = TTL_OFF_WHEEL;
+    return;
+  }
+
+  e->expires = table->now + ttl;
+  ttl_place(table, e);
+}
+
+
+/* link e to the slot of its expiry time, at the level of the highest
+   bit where it differs from now */
+static void ttl_place(ttl_ptr table, ttl_entry_ptr e)
+{
+  unsigned long long diff;
+  unsigned level, s;
+
+  diff = e->expires ^ table->now;
+  level = diff ? (63 - CLZ64(diff)) / TTL_BITS : 0;
+
+  if (level >= TTL_LEVELS) {
+    if (! table->overflow.num || e->expires < table->overflow_min)
+      table->overflow_min = e->expires;
+
+    e->where = TTL_OVERFLOW;
+    dlist_push_back(&table->overflow, &e->link);
+    return;
+  }
+
+  s = SLOT(e->expires, level);
+  e->where = level * TTL_SLOTS + s;
+  dlist_push_back(&table->wheel[level][s], &e->link);
+  table->occupied[level] |= 1ULL << s;
+}
+
+
+static void ttl_unschedule(ttl_ptr table, ttl_entry_ptr e)
+{
+  dlist_ptr slot;
+
+  if (e->where == TTL_OFF_WHEEL)
+    return;
+
+  if (e->where == TTL_OVERFLOW)
+    dlist_unlink(&table->overflow, &e->link);
+  else {
+    slot = &table->wheel[e->where / TTL_SLOTS][e->where % TTL_SLOTS];
+    dlist_unlink(slot, &e->link);
+
+    if (! slot->num)
+      table->occupied[e->where / TTL_SLOTS] &= ~ (1ULL << e->where % TTL_SLOTS);
+  }
+
+  e->where = TTL_OFF_WHEEL;
+}
+
+
+/* move the entries of a due slot to the levels below; overflow
+   entries may go back to the overflow list */
+static void ttl_cascade(ttl_ptr table, dlist_ptr slot)
+{
+  dlist_t due;
+  dlist_link_ptr l;
+  ttl_entry_ptr e;
+
+  dlist_init(&due);
+  dlist_splice(&due, dlist_end(&due), slot);
+
+  while ((l = dlist_pop_front(&due))) {
+    e = ENTRY(l);
+    assert(e->expires >= table->now);
+    ttl_place(table, e);
+  }
+}
+
+
+static void ttl_grow(ttl_ptr table)
+{
+  ttl_entry_ptr* buckets;
+  ttl_entry_ptr e, next;
+  size_t i, old_size = table->mask + 1;
+
+  if (! (buckets = (ttl_entry_ptr*)
+         calloc(2 * old_size, sizeof(ttl_entry_ptr))))
+    return;
+
+  table->mask = 2 * old_size - 1;
+
+  /* stored hashes, no calls to hash_func */
+  for (i = 0; i < old_size; ++ i)
+    for (e = table->buckets[i]; e; e = next) {
+      next = e->next;
+      e->next = buckets[BUCKET(table, e->hash)];
+      buckets[BUCKET(table, e->hash)] = e;
+    }
+
+  free(table->buckets);
+  table->buckets = buckets;
+}
@@ -0,0 +1,126 @@
+#ifndef TTL_H
+#define TTL_H
+
+#include "common.h"
+#include "list/list.h"
+
+/* Hash tables whose entries expire.
+
+   Entries live in a chained hash table, as in ht, and those with a
+   time to live are also linked into a hierarchical timing wheel:
+   TTL_LEVELS wheels of TTL_SLOTS slots, level l slots spanning
+   TTL_SLOTS^l ticks. An entry goes to the level of the highest bit
+   where its expiry time differs from the current time, so that level
+   0 slots hold entries expiring at one tick, and higher slots are
+   cascaded down when time reaches them. Expiry times past the top
+   level wait on an overflow list, cascaded once per top level turn.
+
+   Time moves with ttl_advance, and, if the table has a clock, before
+   every insertion, lookup and deletion. Per-level occupancy bitmaps
+   let time jump straight to the next non-empty slot, so advancing
+   costs O(1) amortized per entry (each one is cascaded at most
+   TTL_LEVELS times), however far it goes. Expired entries go to the
+   key and value free functions. */
+
+#define TTL_BITS           6
+#define TTL_SLOTS          (1 << TTL_BITS)
+#define TTL_LEVELS         4
+
+/* entries never expire */
+#define TTL_NEVER          0
+
+#define TTL_CHUNK_SIZE     1024
+#define TTL_INIT_BUCKETS   64
+
+/* Error constants */
+#define TTL_OK             0
+#define TTL_NOT_FOUND     -1
+#define TTL_OUT_OF_MEM    -2
+
+/* time, in ticks */
+typedef unsigned long long ttl_time_t;
+typedef ttl_time_t (*ttl_clock_func_ptr)(void);
+
+/* the wheel position of an entry */
+#define TTL_OFF_WHEEL      0xffff
+#define TTL_OVERFLOW       0xfffe
+
+typedef struct ttl_entry_t {
+  generic_ptr key;
+  generic_ptr value;
+  unsigned hash;
+  unsigned short where;              /* level * TTL_SLOTS + slot     */
+  ttl_time_t expires;
+  struct ttl_entry_t* next;          /* chain, or free list          */
+  dlist_link_t link;                 /* wheel slot                   */
+} ttl_entry_t;
+typedef ttl_entry_t* ttl_entry_ptr;
+
+typedef struct ttl_chunk_t {
+  struct ttl_chunk_t* next;
+  ttl_entry_t entries[TTL_CHUNK_SIZE];
+} ttl_chunk_t;
+typedef ttl_chunk_t* ttl_chunk_ptr;
+
+typedef struct ttl_t {
+  ttl_entry_ptr* buckets;
+  size_t mask;                       /* buckets - 1, a power of 2    */
+
+  hash_func_ptr hash_func;
+  cmp_func_ptr cmp_func;
+  free_func_ptr key_free_func;
+  free_func_ptr value_free_func;
+  ttl_clock_func_ptr clock;
+
+  size_t num;
+  ttl_time_t now;
+
+  dlist_t wheel[TTL_LEVELS][TTL_SLOTS];
+  unsigned long long occupied[TTL_LEVELS];
+  dlist_t overflow;
+  ttl_time_t overflow_min;           /* a lower bound, once removed  */
+
+  ttl_chunk_ptr chunks;
+  size_t chunk_used;
+  ttl_entry_ptr free_entries;
+} ttl_t;
+typedef ttl_t* ttl_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* constructor. Without a clock (NULL), time only moves with
+   ttl_advance, and starts at 0 */
+ttl_ptr ttl_init(hash_func_ptr hash_func,
+                 cmp_func_ptr cmp_func,
+                 free_func_ptr key_free_func,
+                 free_func_ptr value_free_func,
+                 ttl_clock_func_ptr clock);
+
+/* destructor */
+void ttl_deinit(ttl_ptr table);
+
+/* remove all entries */
+void ttl_clear(ttl_ptr table);
+
+/* insert or replace, expiring ttl ticks from now (or TTL_NEVER) */
+int ttl_insert(ttl_ptr table, generic_ptr key, generic_ptr value,
+               ttl_time_t ttl);
+
+/* the value of key, NULL if missing or expired */
+generic_ptr ttl_find(ttl_ptr table, generic_ptr key);
+
+int ttl_delete(ttl_ptr table, generic_ptr key);
+
+/* a new time to live for key, from now */
+int ttl_set_ttl(ttl_ptr table, generic_ptr key, ttl_time_t ttl);
+
+/* move time forward to now, expiring entries; the number expired */
+size_t ttl_advance(ttl_ptr table, ttl_time_t now);
+
+ttl_time_t ttl_now(ttl_ptr table);
+size_t ttl_count(ttl_ptr table);
+
+/* a monotonic clock, in milliseconds */
+ttl_time_t ttl_clock_ms(void);
+
+#endif
@@ -0,0 +1,307 @@
+/** Highly Optimized Python Structures
+ *
+ * (c) 2011 Marco Pensallorto <marco DOT pensallorto AT gmail DOT com>
+ *
+ **/
+#include "uf.h"
+
+#ifdef ATOMICS_UNSUPPORTED
+#error "union-find needs the __atomic builtins of gcc or clang"
+#endif
+
+/* OpenMP directives, the code runs sequentially without OpenMP */
+#ifdef _OPENMP
+#define PARALLEL(directive)                                                    \
+  _Pragma(#directive)
+#else
+#define PARALLEL(directive)
+#endif
+
+/* -- internal functions ---------------------------------------------------- */
+static inline unsigned uf_root(unsigned* parents, unsigned x);
+static inline unsigned uf_root_atomic(unsigned* parents, unsigned x);
+static inline int uf_link(uf_ptr uf, unsigned x, unsigned y);
+static inline int uf_link_atomic(uf_ptr uf, unsigned x, unsigned y);
+
+uf_ptr uf_init(unsigned n)
+{
+  uf_ptr uf = (uf_ptr) malloc(sizeof(uf_t));
+  if (! uf) return NULL;
+
+  uf->parents = NULL;
+  uf->ranks = NULL;
+  uf->n = uf->n_size = uf->sets = 0;
+
+  if (uf_resize(uf, n) != UF_OK) {
+    uf_deinit(uf);
+    return NULL;
+  }
+
+  return uf;
+}
+
+
+void uf_deinit(uf_ptr uf)
+{
+  CHECK_INSTANCE(uf);
+
+  free(uf->parents);
+  free(uf->ranks);
+  free(uf);
+}
+
+
+int uf_resize(uf_ptr uf, unsigned n)
+{
+  unsigned size, x;
+  unsigned* parents;
+  unsigned char* ranks;
+  CHECK_INSTANCE(uf);
+
+  if (n == UF_NONE) return UF_OUT_OF_MEM;
+
+  if (n > uf->n_size || ! uf->parents) {
+    size = MAX(uf->n_size, UF_INIT_SIZE);
+    while (size < n)
+      size = (size > UF_NONE / 2) ? UF_NONE - 1 : size * 2;
+
+    if (! (parents = (unsigned *)
+           realloc(uf->parents, (size_t) size * sizeof(unsigned))))
+      return UF_OUT_OF_MEM;
+    uf->parents = parents;
+
+    if (! (ranks = (unsigned char *) realloc(uf->ranks, size)))
+      return UF_OUT_OF_MEM;
+    uf->ranks = ranks;
+
+    uf->n_size = size;
+  }
+
+  for (x = uf->n; x < n; x ++) {
+    uf->parents[x] = x;
+    uf->ranks[x] = 0;
+  }
+
+  if (n > uf->n) {
+    uf->sets += n - uf->n;
+    uf->n = n;
+  }
+
+  return UF_OK;
+}
+
+
+unsigned uf_size(uf_ptr uf)
+{
+  CHECK_INSTANCE(uf);
+  return uf->n;
+}
+
+
+unsigned uf_sets(uf_ptr uf)
+{
+  CHECK_INSTANCE(uf);
+  return uf->sets;
+}
+
+
+unsigned uf_find(uf_ptr uf, unsigned x)
+{
+  CHECK_INSTANCE(uf);
+
+  if (x >= uf->n) return UF_NONE;
+  return uf_root(uf->parents, x);
+}
+
+
+int uf_union(uf_ptr uf, unsigned x, unsigned y)
+{
+  CHECK_INSTANCE(uf);
+
+  if (x >= uf->n || y >= uf->n) return UF_OUT_OF_BOUNDS;
+  return uf_link(uf, x, y);
+}
+
+
+int uf_same(uf_ptr uf, unsigned x, unsigned y)
+{
+  CHECK_INSTANCE(uf);
+
+  if (x >= uf->n || y >= uf->n) return UF_OUT_OF_BOUNDS;
+  return uf_root(uf->parents, x) == uf_root(uf->parents, y);
+}
+
+
+unsigned uf_find_concurrent(uf_ptr uf, unsigned x)
+{
+  CHECK_INSTANCE(uf);
+
+  if (x >= uf->n) return UF_NONE;
+  return uf_root_atomic(uf->parents, x);
+}
+
+
+int uf_union_concurrent(uf_ptr uf, unsigned x, unsigned y)
+{
+  CHECK_INSTANCE(uf);
+
+  if (x >= uf->n || y >= uf->n) return UF_OUT_OF_BOUNDS;
+  return uf_link_atomic(uf, x, y);
+}
+
+
+long uf_union_batch(uf_ptr uf, const unsigned* xs, const unsigned* ys,
+                    size_t m)
+{
+  long i, merged = 0;
+  CHECK_INSTANCE(uf);
+
+  for (i = 0; i < (long) m; i ++)
+    if (xs[i] >= uf->n || ys[i] >= uf->n) return UF_OUT_OF_BOUNDS;
+
+#ifdef _OPENMP
+  if (m >= UF_PARALLEL_MIN) {
+PARALLEL(omp parallel for schedule(static, 4096) reduction(+: merged))
+    for (i = 0; i < (long) m; i ++)
+      merged += uf_link_atomic(uf, xs[i], ys[i]);
+
+    return merged;
+  }
+#endif
+
+  for (i = 0; i < (long) m; i ++) {
+    if (i + UF_PREFETCH_AHEAD < (long) m) {
+      PREFETCH(&uf->parents[xs[i + UF_PREFETCH_AHEAD]]);
+      PREFETCH(&uf->parents[ys[i + UF_PREFETCH_AHEAD]]);
+    }
+
+    merged += uf_link(uf, xs[i], ys[i]);
+  }
+
+  return merged;
+}
+
+
+long uf_find_batch(uf_ptr uf, const unsigned* xs, unsigned* roots,
+                   size_t m)
+{
+  long i;
+  CHECK_INSTANCE(uf);
+
+  for (i = 0; i < (long) m; i ++)
+    if (xs[i] >= uf->n) return UF_OUT_OF_BOUNDS;
+
+#ifdef _OPENMP
+  if (m >= UF_PARALLEL_MIN) {
+PARALLEL(omp parallel for schedule(static, 4096))
+    for (i = 0; i < (long) m; i ++)
+      roots[i] = uf_root_atomic(uf->parents, xs[i]);
+
+    return m;
+  }
+#endif
+
+  for (i = 0; i < (long) m; i ++) {
+    if (i + UF_PREFETCH_AHEAD < (long) m)
+      PREFETCH(&uf->parents[xs[i + UF_PREFETCH_AHEAD]]);
+
+    roots[i] = uf_root(uf->parents, xs[i]);
+  }
+
+  return m;
+}
+
+
+long uf_labels(uf_ptr uf, unsigned* labels)
+{
+  unsigned x, r, k = 0;
+  CHECK_INSTANCE(uf);
+
+  for (x = 0; x < uf->n; x ++)
+    labels[x] = UF_NONE;
+
+  /* a set is labelled when its smallest member is met */
+  for (x = 0; x < uf->n; x ++) {
+    r = uf_root(uf->parents, x);
+    if (labels[r] == UF_NONE) labels[r] = k ++;
+    labels[x] = labels[r];
+  }
+
+  return k;
+}
+
+
+/* -- internal functions ---------------------------------------------------- */
+static inline unsigned uf_root(unsigned* parents, unsigned x)
+{
+  /* path halving: every other node on the path skips its parent */
+  while (parents[x] != x) {
+    parents[x] = parents[parents[x]];
+    x = parents[x];
+  }
+
+  return x;
+}
+
+
+/* As uf_root, concurrent unions may link the root under another one
+   meanwhile. A failed CAS only means somebody else moved x further up
+   already, and the grandparent is still an ancestor of x */
+static inline unsigned uf_root_atomic(unsigned* parents, unsigned x)
+{
+  unsigned p, gp;
+
+  while ((p = ATOMIC_LOAD(&parents[x], RELAXED)) != x) {
+    gp = ATOMIC_LOAD(&parents[p], RELAXED);
+    if (gp != p) (void) ATOMIC_CAS(&parents[x], &p, gp, RELAXED);
+    x = gp;
+  }
+
+  return x;
+}
+
+
+static inline int uf_link(uf_ptr uf, unsigned x, unsigned y)
+{
+  unsigned tmp;
+
+  x = uf_root(uf->parents, x);
+  y = uf_root(uf->parents, y);
+  if (x == y) return 0;
+
+  /* the shallower tree goes under the deeper one */
+  if (uf->ranks[x] > uf->ranks[y]) {
+    tmp = x; x = y; y = tmp;
+  }
+  else if (uf->ranks[x] == uf->ranks[y])
+    uf->ranks[y] ++;
+
+  uf->parents[x] = y;
+  uf->sets --;
+
+  return 1;
+}
+
+
+static inline int uf_link_atomic(uf_ptr uf, unsigned x, unsigned y)
+{
+  unsigned tmp;
+
+  for (;;) {
+    x = uf_root_atomic(uf->parents, x);
+    y = uf_root_atomic(uf->parents, y);
+    if (x == y) return 0;
+
+    /* bigger ids go under smaller ones. The CAS fails if x is no
+       longer a root, then both are looked up again */
+    if (x < y) {
+      tmp = x; x = y; y = tmp;
+    }
+
+    tmp = x;
+    if (ATOMIC_CAS(&uf->parents[x], &tmp, y, RELAXED)) {
+      (void) ATOMIC_FETCH_ADD(&uf->sets, (unsigned) -1, RELAXED);
+      return 1;
+    }
+  }
+}
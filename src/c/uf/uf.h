@@ -0,0 +1,84 @@
+#ifndef UF_H
+#define UF_H
+
+#include "common.h"
+
+/* Disjoint sets (union-find) over unboxed ids 0 .. n - 1. Parents and
+   ranks are two flat arrays, grown geometrically as ids are added.
+   Sequential unions link by rank, finds halve paths as they go.
+
+   Concurrent unions (uf_union_concurrent, and batches when built with
+   OpenMP) are lock-free: a root is linked with a CAS on its parent,
+   and path halving CASes too. They link the bigger root id under the
+   smaller one instead of by rank: links made concurrently all go the
+   same way, so that no interleaving can close a cycle. Concurrent and
+   sequential operations must not run at the same time, nor together
+   with uf_resize. */
+
+#define UF_INIT_SIZE 1024
+
+/* find of an out of range id */
+#define UF_NONE ((unsigned) -1)
+
+/* batches shorter than this run sequentially, even with OpenMP */
+#define UF_PARALLEL_MIN 65536
+
+/* batch loops prefetch the parents of the ids this far ahead */
+#define UF_PREFETCH_AHEAD 8
+
+/* Error constants */
+#define UF_OK              0
+#define UF_OUT_OF_BOUNDS  -1
+#define UF_OUT_OF_MEM     -2
+
+typedef struct uf_t {
+  unsigned* parents;
+  unsigned char* ranks;
+
+  unsigned n;          /* number of ids                             */
+  unsigned n_size;     /* size of the arrays                        */
+  unsigned sets;       /* number of disjoint sets                   */
+} uf_t;
+typedef uf_t* uf_ptr;
+
+/* -- Function prototypes --------------------------------------------------- */
+
+/* n singleton sets {0} .. {n - 1} */
+uf_ptr uf_init(unsigned n);
+void uf_deinit(uf_ptr uf);
+
+/* grow to n ids, the new ones as singletons; never shrinks */
+int uf_resize(uf_ptr uf, unsigned n);
+
+unsigned uf_size(uf_ptr uf);
+unsigned uf_sets(uf_ptr uf);
+
+/* the representative of x's set, UF_NONE if x is out of range */
+unsigned uf_find(uf_ptr uf, unsigned x);
+
+/* merge the sets of x and y: 1 if merged, 0 if already the same set,
+   or UF_OUT_OF_BOUNDS */
+int uf_union(uf_ptr uf, unsigned x, unsigned y);
+
+/* whether x and y are in the same set, or UF_OUT_OF_BOUNDS */
+int uf_same(uf_ptr uf, unsigned x, unsigned y);
+
+/* as uf_find and uf_union, safe to run from many threads at once */
+unsigned uf_find_concurrent(uf_ptr uf, unsigned x);
+int uf_union_concurrent(uf_ptr uf, unsigned x, unsigned y);
+
+/* m unions xs[i], ys[i], in parallel when built with OpenMP. Returns
+   the number of merges, or UF_OUT_OF_BOUNDS (and changes nothing) if
+   any id is out of range */
+long uf_union_batch(uf_ptr uf, const unsigned* xs, const unsigned* ys,
+                    size_t m);
+
+/* roots[i] gets the representative of xs[i]; in parallel as above */
+long uf_find_batch(uf_ptr uf, const unsigned* xs, unsigned* roots,
+                   size_t m);
+
+/* labels (n entries) get set ids 0 .. k - 1, in order of their
+   smallest member. Returns k */
+long uf_labels(uf_ptr uf, unsigned* labels);
+
+#endif
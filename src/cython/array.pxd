@@ -9,6 +9,10 @@ cdef extern from "array/array.h":
         pass
     ctypedef array_iterator_struct* array_iterator_ptr
 
+    # stack/embeddable iterator
+    ctypedef struct array_iterator_t:
+        int dir
+
     # value ptrs
     ctypedef void* generic_ptr
     ctypedef void** generic_dptr
@@ -29,17 +33,36 @@ cdef extern from "array/array.h":
     array_iterator_ptr array_iter(array_ptr array,
                               int dir)
 
+    array_ptr array_init_segmented(cmp_func_ptr compare,
+                                   free_func_ptr free)
+
+    array_ptr array_init_sparse(cmp_func_ptr compare,
+                                free_func_ptr free)
+
+    array_ptr array_open_mapped(char* path,
+                                int mode)
+
     # destructors
-    void array_deinit(array_ptr array)
+    void array_deinit(array_ptr array) nogil
     void array_iter_deinit(array_iterator_ptr iter_)
 
     # iterators
+    void array_iter_init(array_iterator_t* iter_,
+                         array_ptr array,
+                         int dir)
+
     int array_iter_next(array_iterator_ptr iter_,
                         generic_dptr value_p)
 
+    unsigned array_iter_next_batch(array_iterator_t* iter_,
+                                   generic_dptr out,
+                                   unsigned max)
+
+    int array_iter_changed(array_iterator_t* iter_)
+
 
     # number of entries
-    int array_n(array_ptr array)
+    int array_n(array_ptr array) nogil
 
     # number of occurrences
     int array_count(array_ptr array, generic_ptr key)
@@ -47,18 +70,72 @@ cdef extern from "array/array.h":
     # getter
     int array_fetch (array_ptr array,
                      unsigned index,
-                     generic_dptr out)
+                     generic_dptr out) nogil
 
     # insertion
     int array_insert (array_ptr array,
                       unsigned ndx,
-           	      generic_ptr key)
+           	      generic_ptr key) nogil
 
     # deletion
+    int array_insert_before(array_ptr array,
+                            unsigned ndx,
+                            generic_ptr key)
+
     int array_delete(array_ptr array,
                      unsigned index,
                      generic_dptr item_p)
 
     # find element
     int array_find (array_ptr array,
-                    generic_ptr key)
+                    generic_ptr key) nogil
+
+    # next non-NULL slot
+    int array_next_occupied(array_ptr array,
+                            unsigned* index)
+
+    # bulk operations
+    array_ptr array_dup(array_ptr old)
+
+    array_ptr array_join(array_ptr array1,
+                         array_ptr array2)
+
+    int array_append(array_ptr array1,
+                     array_ptr array2)
+
+    int array_extend(array_ptr array,
+                     generic_dptr items,
+                     unsigned n)
+
+    int array_slice(array_ptr array,
+                    unsigned start,
+                    unsigned stop,
+                    generic_dptr out)
+
+    int array_sort(array_ptr array,
+                   cmp_func_ptr compare) nogil
+
+    # sorted arrays
+    unsigned array_lower_bound(array_ptr array,
+                               generic_ptr key)
+
+    unsigned array_upper_bound(array_ptr array,
+                               generic_ptr key)
+
+    int array_bsearch(array_ptr array,
+                      generic_ptr key)
+
+    int array_eytzinger(array_ptr array)
+
+    # capacity management
+    int array_reserve(array_ptr array,
+                      unsigned size)
+
+    int array_shrink_to_fit(array_ptr array)
+
+    # mapped arrays
+    int array_sync(array_ptr array,
+                   int async) nogil
+
+    int array_advise(array_ptr array,
+                     int advice) nogil
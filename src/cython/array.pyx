@@ -1,9 +1,19 @@
 # file: array.pyx
 cimport array
+cimport lock
 
 cdef extern from "Python.h":
+    ctypedef void PyObject
     cdef void Py_INCREF(obj)
     cdef void Py_DECREF(obj)
+    cdef object PySequence_Fast(object o, char* m)
+    cdef Py_ssize_t PySequence_Fast_GET_SIZE(object o)
+    cdef PyObject** PySequence_Fast_ITEMS(object o)
+    cdef object PyList_New(Py_ssize_t n)
+    cdef int PySlice_GetIndicesEx(object slice, Py_ssize_t length,
+                                  Py_ssize_t* start, Py_ssize_t* stop,
+                                  Py_ssize_t* step,
+                                  Py_ssize_t* slicelength) except -1
 
 cdef int cmp_callback(object a, object b):
     return cmp(a, b)
@@ -11,63 +21,126 @@ cdef int cmp_callback(object a, object b):
 cdef void free_callback(object obj):
     Py_DECREF(obj)
 
-cdef class ArrayForwardIterator(object):
-     cdef array.array_iterator_ptr _iterator
-
-     def __init__(self, Array obj):
-         self._iterator = array.array_iter(obj._array, 1)  # forward
-         if self._iterator is NULL:
-            raise MemoryError()
+# orders the slots of mapped arrays, which hold signed machine integers
+cdef int word_slot_cmp(generic_ptr a, generic_ptr b) nogil:
+    cdef Py_ssize_t x = (<Py_ssize_t*> a)[0]
+    cdef Py_ssize_t y = (<Py_ssize_t*> b)[0]
+    return (x > y) - (x < y)
+
+cdef void incref_items(generic_dptr items, unsigned n):
+    cdef unsigned i
+    for i from 0 <= i < n:
+        if items[i] is not NULL:
+            Py_INCREF(<object> items[i])
+
+# error codes, mapping modes and access hints, see array.h
+cdef int ARRAY_BAD_LAYOUT = -4
+cdef int ARRAY_MAP_RDONLY = 1
+cdef int ARRAY_MAP_RDWR = 2
+
+_advices = {
+    'normal': 0,
+    'random': 1,
+    'sequential': 2,
+    'willneed': 3,
+    'dontneed': 4,
+}
+
+# number of items fetched per C call by iterators
+DEF ITER_BATCH = 64
+
+cdef class ArrayIterator(object):
+     """Iterates over an Array, fetching items from C in batches. The
+     C iterator is embedded, so there is no allocation per iterator.
+     Batched items are referenced until handed out.
+     """
+     cdef Array _owner
+     cdef array.array_iterator_t _iterator
+     cdef generic_ptr _batch[ITER_BATCH]
+     cdef unsigned _pos, _len
+
+     def __init__(self, Array obj, int dir):
+         self._owner = obj
+         array.array_iter_init(&self._iterator, obj._array, dir)
+         self._pos = self._len = 0
 
      def __dealloc__(self):
-         assert self._iterator is not NULL
-         array.array_iter_deinit(self._iterator)
+         cdef unsigned i
+         for i from self._pos <= i < self._len:
+             if self._batch[i] is not NULL:
+                 Py_DECREF(<object> self._batch[i])
 
      def __iter__(self):
          return self
 
      def __next__(self):
-         cdef int res
-         cdef generic_ptr item = NULL
+         cdef generic_ptr item
 
-         assert self._iterator is not NULL
+         if array.array_iter_changed(&self._iterator):
+             raise RuntimeError("array changed size during iteration")
 
-         if (array.array_iter_next(self._iterator,
-                               &item) == 0):
-             raise StopIteration()
+         if self._pos == self._len:
+             self._len = array.array_iter_next_batch(&self._iterator,
+                                                     self._batch,
+                                                     ITER_BATCH)
+             self._pos = 0
+             if self._len == 0:
+                 raise StopIteration()
 
-         return (<object> item)
+             incref_items(self._batch, self._len)
 
-cdef class ArrayBackwardIterator(object):
-     cdef array.array_iterator_ptr _iterator
+         item = self._batch[self._pos]
+         self._pos += 1
+
+         if item is NULL:
+             return None
 
+         item_obj = <object> item
+
+         # explicit reference counting decrement, of the batch reference
+         Py_DECREF(item_obj)
+         return item_obj
+
+cdef class ArrayForwardIterator(ArrayIterator):
      def __init__(self, Array obj):
-         self._iterator = array.array_iter(obj._array, -1)  # backward
-         if self._iterator is NULL:
-            raise MemoryError()
+         ArrayIterator.__init__(self, obj, 1)  # forward
 
-     def __dealloc__(self):
-         assert self._iterator is not NULL
-         array.array_iter_deinit(self._iterator)
+cdef class ArrayBackwardIterator(ArrayIterator):
+     def __init__(self, Array obj):
+         ArrayIterator.__init__(self, obj, -1)  # backward
+
+cdef class ArrayItemIterator(object):
+     """Iterates over (index, value) pairs of non-empty slots. Sparse
+     arrays skip empty pages and holes without looking at them.
+     """
+     cdef Array _owner
+     cdef unsigned _index
+
+     def __init__(self, Array obj):
+         self._owner = obj
+         self._index = 0
 
      def __iter__(self):
          return self
 
      def __next__(self):
-         cdef int res
-         cdef generic_ptr item = NULL
-         assert self._iterator is not NULL
+         cdef generic_ptr value = NULL
+         cdef unsigned ndx = self._index
 
-         if (array.array_iter_next(self._iterator,
-                               &item) == 0):
+         if (array.array_next_occupied(self._owner._array, &ndx) == 0):
              raise StopIteration()
 
-         return (<object> item)
+         array.array_fetch(self._owner._array, ndx, &value)
+         self._index = ndx + 1
+
+         return (ndx, <object> value)
 
 cdef class Array(object):
      cdef array.array_ptr _array
+     cdef bint _segmented
+     cdef bint _sparse
 
-     def __init__(self, seq=None):
+     def __init__(self, seq=None, segmented=False, sparse=False):
          """Python ctor
          """
          if seq is not None:
@@ -83,12 +156,23 @@ cdef class Array(object):
                  except AttributeError:
                      raise ValueError("Iterable sequence expected")
 
-     def __cinit__(self):
-         """C ctor
+     def __cinit__(self, seq=None, segmented=False, sparse=False):
+         """C ctor. Segmented arrays grow a block at a time and never
+         move their elements. Sparse arrays only allocate memory for
+         pages actually written to.
          """
-         self._array = array.array_init(0, # pick default initial size
-                                        <cmp_func_ptr> cmp_callback,
-                                        <free_func_ptr> free_callback)
+         self._segmented = segmented
+         self._sparse = sparse
+         if sparse:
+             self._array = array.array_init_sparse(<cmp_func_ptr> cmp_callback,
+                                                   <free_func_ptr> free_callback)
+         elif segmented:
+             self._array = array.array_init_segmented(<cmp_func_ptr> cmp_callback,
+                                                      <free_func_ptr> free_callback)
+         else:
+             self._array = array.array_init(0, # pick default initial size
+                                            <cmp_func_ptr> cmp_callback,
+                                            <free_func_ptr> free_callback)
 
          if self._array is NULL:
             raise MemoryError()
@@ -112,13 +196,35 @@ cdef class Array(object):
 
          return True
 
-     def __getitem__(self, unsigned ndx):
-         """__getitem__(y) <==> T[y], T[s:e], O(log(n))
+     def __getitem__(self, object ndx):
+         """__getitem__(y) <==> T[y], T[s:e], O(1), O(e-s)
          """
          cdef int res
          cdef generic_ptr value = NULL
+         cdef Py_ssize_t start, stop, step, n, i
+         cdef PyObject** items
          assert self._array is not NULL
 
+         if isinstance(ndx, slice):
+             PySlice_GetIndicesEx(ndx, array.array_n(self._array),
+                                  &start, &stop, &step, &n)
+             if step != 1:
+                 return [ self[i] for i in range(start, stop, step) ]
+
+             # copy out directly into the list storage
+             res_list = PyList_New(n)
+             items = PySequence_Fast_ITEMS(res_list)
+             if (array.array_slice(self._array, start, start + n,
+                                   <generic_dptr> items) != 0):
+                 raise IndexError()
+
+             for i from 0 <= i < n:
+                 if items[i] is NULL:
+                     items[i] = <PyObject*> None
+                 Py_INCREF(<object> items[i])
+
+             return res_list
+
          if (array.array_fetch(self._array, ndx,
                                &value) != 0):
              raise ValueError()
@@ -156,45 +262,175 @@ cdef class Array(object):
          assert self._array is not NULL
          return ArrayBackwardIterator(self)
 
+     def __add__(Array self, Array other):
+         """__add__(y) <==> T + y, O(n + m)
+         """
+         cdef Array res = Array()
+         assert self._array is not NULL
+
+         if (array.array_reserve(res._array,
+                                 array.array_n(self._array) +
+                                 array.array_n(other._array)) != 0):
+             raise MemoryError()
+
+         res.extend(self)
+         res.extend(other)
+         return res
+
+     def iteritems(self):
+         """a.iteritems() -> iterator over (index, value) of non-empty slots
+         """
+         assert self._array is not NULL
+         return ArrayItemIterator(self)
+
      def append(self, object obj):
          """a.append(object) -- append object to end
          """
-         pass
+         assert self._array is not NULL
+
+         # explicit reference counting increment
+         Py_INCREF(obj)
+         if (array.array_insert(self._array, array.array_n(self._array),
+                                <generic_ptr> obj) != 0):
+             Py_DECREF(obj)
+             raise MemoryError()
+
+     def copy(self):
+         """a.copy() -> a shallow copy of a, O(n)
+         """
+         cdef Array res = Array(segmented=self._segmented,
+                                sparse=self._sparse)
+         assert self._array is not NULL
+
+         res.extend(self)
+         return res
 
      def count(self, object value):
          """a.count(value) -> integer -- return number of occurrences of value
          """
-         pass
+         assert self._array is not NULL
+         return array.array_count(self._array, <generic_ptr> value)
 
      def extend(self, object iterable):
          """a.extend(iterable) -- extend list by appending elements from the iterable
          """
-         pass
+         cdef Array other
+         cdef unsigned n, i
+         cdef generic_dptr items
+         cdef generic_ptr value
+         assert self._array is not NULL
+
+         if isinstance(iterable, Array):
+             other = <Array> iterable
+             n = array.array_n(self._array)
+             if (array.array_append(self._array, other._array) != 0):
+                 raise MemoryError()
+
+             # take one more reference on every copied element
+             for i from n <= i < array.array_n(self._array):
+                 array.array_fetch(self._array, i, &value)
+                 if value is not NULL:
+                     Py_INCREF(<object> value)
+             return
+
+         if isinstance(iterable, (list, tuple)):
+             # grow once, then bulk copy the sequence storage
+             seq = PySequence_Fast(iterable, "Iterable sequence expected")
+             n = PySequence_Fast_GET_SIZE(seq)
+             items = <generic_dptr> PySequence_Fast_ITEMS(seq)
+
+             if (array.array_extend(self._array, items, n) != 0):
+                 raise MemoryError()
+
+             incref_items(items, n)
+             return
+
+         for obj in iterable:
+             self.append(obj)
 
      def index(self, object obj):
-         """a.index(value, [start, [stop]]) -> integer -- return first
-         index of value.  Raises ValueError if the value is not
-         present.
+         """a.index(value) -> integer -- return first index of value.
+         Raises ValueError if the value is not present.
          """
-         pass
+         cdef int res
+         assert self._array is not NULL
+
+         res = array.array_find(self._array, <generic_ptr> obj)
+         if res == -1:
+             raise ValueError("value not in array")
+
+         return res
 
-     def insert(self, unsigned index, object obj):
-         """a.insert(index, object) -- insert object before index
+     def insert(self, Py_ssize_t index, object obj):
+         """a.insert(index, object) -- insert object before index,
+         O(1) amortized for edits clustered around the same spot
          """
-         pass
+         cdef Py_ssize_t n
+         assert self._array is not NULL
+
+         n = array.array_n(self._array)
+         if index < 0:
+             index = max(0, index + n)
+         if index > n:
+             index = n
+
+         # explicit reference counting increment
+         Py_INCREF(obj)
+         if (array.array_insert_before(self._array, index,
+                                       <generic_ptr> obj) != 0):
+             Py_DECREF(obj)
+             raise MemoryError()
 
      def pop(self, index=None):
          """L.pop([index]) -> item -- remove and return item at index
          (default last).  Raises IndexError if list is empty or
          index is out of range.
          """
-         pass
+         cdef Py_ssize_t n, ndx
+         cdef generic_ptr value = NULL
+         assert self._array is not NULL
+
+         n = array.array_n(self._array)
+         if n == 0:
+             raise IndexError("pop from empty array")
+
+         ndx = n - 1 if index is None else index
+         if ndx < 0:
+             ndx = ndx + n
+         if ndx < 0 or ndx >= n:
+             raise IndexError("pop index out of range")
+
+         array.array_delete(self._array, ndx, &value)
+         if value is NULL:
+             return None
+
+         value_obj = <object> value
+
+         # explicit reference counting decrement
+         Py_DECREF(value_obj)
+         return value_obj
 
      def remove(self, value):
          """L.remove(value) -- remove first occurrence of value.
          Raises ValueError if the value is not present.
          """
-         pass
+         cdef int res
+         cdef generic_ptr item = NULL
+         assert self._array is not NULL
+
+         res = array.array_find(self._array, <generic_ptr> value)
+         if res == -1:
+             raise ValueError("value not in array")
+
+         array.array_delete(self._array, res, &item)
+
+         # explicit reference counting decrement
+         Py_DECREF(<object> item)
+
+     def __delitem__(self, Py_ssize_t index):
+         """__delitem__(y) <==> del T[y]
+         """
+         self.pop(index)
 
      def reverse(self, ):
          """L.reverse() -- reverse *IN PLACE*
@@ -207,6 +443,22 @@ cdef class Array(object):
          """
          pass
 
+     def reserve(self, unsigned size):
+         """a.reserve(size) -- make room for at least size elements
+         """
+         assert self._array is not NULL
+
+         if (array.array_reserve(self._array, size) != 0):
+             raise MemoryError()
+
+     def shrink_to_fit(self):
+         """a.shrink_to_fit() -- release unused room
+         """
+         assert self._array is not NULL
+
+         if (array.array_shrink_to_fit(self._array) != 0):
+             raise MemoryError()
+
      def is_empty(self):
          """is_empty() -> True if len(T) == 0, O(1)
          """
@@ -241,3 +493,300 @@ cdef class Array(object):
      #     """
      #     for (k, v) in E.iteritems():
      #         self.__setitem__(k, v)
+
+
+cdef class SortedArray(object):
+     """Sorted index. Built from an iterable, then queried by binary
+     search. With eytzinger=True elements are laid out in BFS order
+     for faster lookups on large indexes, at the price of rank queries
+     (bisect_left, bisect_right) and insertions.
+     """
+     cdef array.array_ptr _array
+     cdef bint _eytzinger
+
+     def __cinit__(self, seq=None, eytzinger=False):
+         """C ctor
+         """
+         self._array = array.array_init(0, # pick default initial size
+                                        <cmp_func_ptr> cmp_callback,
+                                        <free_func_ptr> free_callback)
+         if self._array is NULL:
+            raise MemoryError()
+
+     def __init__(self, seq=None, eytzinger=False):
+         """Python ctor
+         """
+         cdef unsigned n
+         cdef generic_dptr items
+
+         if seq is not None:
+             seq = sorted(seq)
+             if None in seq:
+                 raise ValueError("None can not be indexed")
+
+             n = len(seq)
+             items = <generic_dptr> PySequence_Fast_ITEMS(seq)
+             if (array.array_extend(self._array, items, n) != 0):
+                 raise MemoryError()
+
+             incref_items(items, n)
+
+         if eytzinger:
+             if (array.array_eytzinger(self._array) != 0):
+                 raise MemoryError()
+             self._eytzinger = True
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._array is not NULL
+         array.array_deinit(self._array)
+
+     def __len__(self):
+         """__len__() <==> len(T), O(1)
+         """
+         assert self._array is not NULL
+         return array.array_n(self._array)
+
+     def __contains__(self, object key):
+         """__contains__(k) -> True if T has a key k, else False, O(log(n))
+         """
+         assert self._array is not NULL
+         return array.array_bsearch(self._array,
+                                    <generic_ptr> key) != -1
+
+     def insert(self, object key):
+         """insert(k) -- add k, keeping items sorted, O(n)
+         """
+         cdef int res
+         assert self._array is not NULL
+         if key is None:
+             raise ValueError("None can not be indexed")
+
+         # explicit reference counting increment
+         Py_INCREF(key)
+         res = array.array_insert_before(self._array,
+                                         array.array_upper_bound(self._array,
+                                                                 <generic_ptr> key),
+                                         <generic_ptr> key)
+         if res != 0:
+             Py_DECREF(key)
+             if res == ARRAY_BAD_LAYOUT:
+                 raise ValueError("the Eytzinger layout is read-only")
+             raise MemoryError()
+
+     cdef object _item(self, unsigned ndx, object default):
+         cdef generic_ptr value = NULL
+
+         if (array.array_fetch(self._array, ndx, &value) != 0):
+             return default
+
+         return <object> value
+
+     def ceiling(self, object key, default=None):
+         """ceiling(k[,d]) -> smallest item >= k, else d, O(log(n))
+         """
+         assert self._array is not NULL
+         return self._item(array.array_lower_bound(self._array,
+                                                   <generic_ptr> key),
+                           default)
+
+     def higher(self, object key, default=None):
+         """higher(k[,d]) -> smallest item > k, else d, O(log(n))
+         """
+         assert self._array is not NULL
+         return self._item(array.array_upper_bound(self._array,
+                                                   <generic_ptr> key),
+                           default)
+
+     def bisect_left(self, object key):
+         """bisect_left(k) -> number of items < k, O(log(n))
+         """
+         assert self._array is not NULL
+         if self._eytzinger:
+             raise ValueError("rank queries need the sorted layout")
+
+         return array.array_lower_bound(self._array, <generic_ptr> key)
+
+     def bisect_right(self, object key):
+         """bisect_right(k) -> number of items <= k, O(log(n))
+         """
+         assert self._array is not NULL
+         if self._eytzinger:
+             raise ValueError("rank queries need the sorted layout")
+
+         return array.array_upper_bound(self._array, <generic_ptr> key)
+
+
+cdef class MappedArray(object):
+     """File-backed array of machine integers. Storage is paged in on
+     demand; several processes can open the same file with mode 'r'.
+     With locked=True, several Python threads can share the array,
+     scans, sorts and syncs running without the GIL and reads in
+     parallel.
+     """
+     cdef array.array_ptr _array
+     cdef lock.lock_ptr _lock
+
+     def __cinit__(self, char* path, mode='r', locked=False):
+         """C ctor
+         """
+         if mode == 'r':
+             self._array = array.array_open_mapped(path, ARRAY_MAP_RDONLY)
+         elif mode == 'w':
+             self._array = array.array_open_mapped(path, ARRAY_MAP_RDWR)
+         else:
+             raise ValueError("mode must be 'r' or 'w'")
+
+         if self._array is NULL:
+            raise IOError("Could not map %s" % path)
+
+         self._lock = lock.lock_init(1 if locked else 0)
+         if locked and self._lock is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._array is not NULL:
+             with nogil:
+                 array.array_deinit(self._array)
+         lock.lock_deinit(self._lock)
+
+     def __len__(self):
+         """__len__() <==> len(T), O(1)
+         """
+         cdef int res
+         assert self._array is not NULL
+
+         if self._lock is NULL:
+             res = array.array_n(self._array)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = array.array_n(self._array)
+                 lock.lock_release(self._lock)
+
+         return res
+
+     def __contains__(self, Py_ssize_t value):
+         """__contains__(v) -> True if v is in T, else False, O(n)
+         """
+         cdef int res
+         assert self._array is not NULL
+
+         if self._lock is NULL:
+             res = array.array_find(self._array, <generic_ptr> value)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = array.array_find(self._array, <generic_ptr> value)
+                 lock.lock_release(self._lock)
+
+         return res != -1
+
+     def __getitem__(self, unsigned ndx):
+         """__getitem__(y) <==> T[y], O(1)
+         """
+         cdef generic_ptr value = NULL
+         cdef int res
+         assert self._array is not NULL
+
+         if self._lock is NULL:
+             res = array.array_fetch(self._array, ndx, &value)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = array.array_fetch(self._array, ndx, &value)
+                 lock.lock_release(self._lock)
+
+         if res != 0:
+             raise IndexError()
+
+         return <Py_ssize_t> value
+
+     def __setitem__(self, unsigned ndx, Py_ssize_t value):
+         """__setitem__(i, v) <==> T[i] = v, O(1)
+         """
+         cdef int res
+         assert self._array is not NULL
+
+         if self._lock is NULL:
+             res = array.array_insert(self._array, ndx, <generic_ptr> value)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = array.array_insert(self._array, ndx, <generic_ptr> value)
+                 lock.lock_release(self._lock)
+
+         if res != 0:
+             raise IOError("Could not write to mapped array")
+
+     def append(self, Py_ssize_t value):
+         """a.append(int) -- append int to end
+         """
+         cdef int res
+         assert self._array is not NULL
+
+         if self._lock is NULL:
+             res = array.array_insert(self._array, array.array_n(self._array),
+                                      <generic_ptr> value)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = array.array_insert(self._array, array.array_n(self._array),
+                                          <generic_ptr> value)
+                 lock.lock_release(self._lock)
+
+         if res != 0:
+             raise IOError("Could not write to mapped array")
+
+     def sort(self):
+         """a.sort() -- sort *IN PLACE*, in ascending order
+         """
+         cdef int res
+         assert self._array is not NULL
+
+         if self._lock is NULL:
+             res = array.array_sort(self._array, <cmp_func_ptr> word_slot_cmp)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = array.array_sort(self._array, <cmp_func_ptr> word_slot_cmp)
+                 lock.lock_release(self._lock)
+
+         if res != 0:
+             raise IOError("Could not write to mapped array")
+
+     def sync(self, async=False):
+         """sync([async]) -- flush contents to the backing file
+         """
+         cdef int res
+         cdef int is_async = 1 if async else 0
+         assert self._array is not NULL
+
+         if self._lock is NULL:
+             res = array.array_sync(self._array, is_async)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = array.array_sync(self._array, is_async)
+                 lock.lock_release(self._lock)
+
+         if res != 0:
+             raise IOError("Could not sync mapped array")
+
+     def advise(self, advice):
+         """advise(hint) -- hint the expected access pattern, one of
+         'normal', 'random', 'sequential', 'willneed', 'dontneed'
+         """
+         cdef int hint = _advices[advice]
+         assert self._array is not NULL
+
+         if self._lock is NULL:
+             array.array_advise(self._array, hint)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 array.array_advise(self._array, hint)
+                 lock.lock_release(self._lock)
@@ -0,0 +1,85 @@
+# file: art.pxd
+
+cdef extern from "art/art.h":
+
+    ctypedef struct art_tree_t:
+        pass
+    ctypedef art_tree_t* art_tree_ptr
+
+    ctypedef struct art_iterator_t:
+        pass
+    ctypedef art_iterator_t* art_iterator_ptr
+
+    # value ptrs
+    ctypedef void* generic_ptr
+    ctypedef void** generic_dptr
+
+    # func ptrs
+    ctypedef void (*free_func_ptr)(generic_ptr data)
+
+    # constants
+    int ART_ITER_FORWARD
+    int ART_ITER_BACKWARD
+    int ART_OK
+    int ART_REPLACED
+    int ART_OUT_OF_MEM
+
+    # constructors
+    art_tree_ptr art_init()
+    art_iterator_ptr art_iter(art_tree_ptr tree,
+                              unsigned char* prefix,
+                              size_t len,
+                              int dir)
+
+    # destructors
+    void art_deinit(art_tree_ptr tree,
+                    free_func_ptr free_value)
+
+    void art_iter_free(art_iterator_ptr iter_)
+
+    # iterators
+    int art_iter_next(art_iterator_ptr iter_,
+                      unsigned char** key_p,
+                      size_t* len_p,
+                      generic_dptr value_p)
+
+    # number of entries
+    size_t art_count(art_tree_ptr tree)
+
+    # deletion
+    void art_clear(art_tree_ptr tree,
+                   free_func_ptr free_value)
+
+    int art_delete(art_tree_ptr tree,
+                   unsigned char* key,
+                   size_t len,
+                   generic_dptr value_p)
+
+    # insertion
+    int art_insert(art_tree_ptr tree,
+                   unsigned char* key,
+                   size_t len,
+                   generic_ptr value,
+                   generic_dptr old_p)
+
+    # lookups
+    int art_find(art_tree_ptr tree,
+                 unsigned char* key,
+                 size_t len,
+                 generic_dptr value_p)
+
+    int art_longest_prefix(art_tree_ptr tree,
+                           unsigned char* key,
+                           size_t len,
+                           size_t* match_len,
+                           generic_dptr value_p)
+
+    int art_first(art_tree_ptr tree,
+                  unsigned char** key_p,
+                  size_t* len_p,
+                  generic_dptr value_p)
+
+    int art_last(art_tree_ptr tree,
+                 unsigned char** key_p,
+                 size_t* len_p,
+                 generic_dptr value_p)
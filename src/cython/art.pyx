@@ -0,0 +1,261 @@
+# file: art.pyx
+cimport art
+
+cdef extern from "Python.h":
+    cdef void Py_INCREF(obj)
+    cdef void Py_DECREF(obj)
+
+cdef void free_callback(object obj):
+    Py_DECREF(obj)
+
+# keys are bytes, text is stored UTF-8 encoded
+cdef bytes as_key(object key):
+    if isinstance(key, bytes):
+        return key
+    if isinstance(key, unicode):
+        return (<unicode> key).encode('utf-8')
+    raise TypeError("keys must be bytes or str")
+
+cdef class RadixTreeIterator(object):
+     cdef art.art_iterator_ptr _iterator
+     cdef RadixTree _tree
+     cdef unsigned long _version
+
+     def __init__(self, RadixTree tree, prefix=b'', reverse=False):
+         cdef bytes p = as_key(prefix)
+         self._tree = tree
+         self._version = tree._version
+         self._iterator = art.art_iter(tree._tree, p, len(p),
+                                       art.ART_ITER_BACKWARD if reverse
+                                       else art.ART_ITER_FORWARD)
+         if self._iterator is NULL:
+             raise MemoryError()
+
+     def __cinit__(self, *args, **kwargs):
+         self._iterator = NULL
+
+     def __dealloc__(self):
+         if self._iterator is not NULL:
+             art.art_iter_free(self._iterator)
+
+     def __iter__(self):
+         return self
+
+     def __next__(self):
+         cdef int res
+         cdef unsigned char* key = NULL
+         cdef size_t length = 0
+         cdef generic_ptr value = NULL
+         assert self._iterator is not NULL
+
+         if self._version != self._tree._version:
+             raise RuntimeError("RadixTree changed size during iteration")
+
+         res = art.art_iter_next(self._iterator, &key, &length, &value)
+         if res == art.ART_OUT_OF_MEM:
+             raise MemoryError()
+         if res == 0:
+             raise StopIteration()
+
+         return (key[:length], <object> value)
+
+cdef class RadixTree(object):
+     """A mapping of byte strings (str keys are UTF-8 encoded) to
+     objects, as an adaptive radix tree: lookups cost O(len(key)) byte
+     steps, whatever the number of keys, and never compare whole keys
+     but at the end. Iteration is in key order, and can be restricted
+     to the keys with a given prefix.
+     """
+     cdef art.art_tree_ptr _tree
+     cdef unsigned long _version
+
+     def __init__(self, seq=None):
+         """Python ctor
+         """
+         if seq is not None:
+             if hasattr(seq, 'items'):
+                 seq = seq.items()
+             for (k, v) in seq:
+                 self[k] = v
+
+     def __cinit__(self, *args, **kwargs):
+         """C ctor
+         """
+         self._tree = art.art_init()
+         if self._tree is NULL:
+             raise MemoryError()
+         self._version = 0
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._tree is not NULL
+         art.art_deinit(self._tree, <free_func_ptr> free_callback)
+
+     def __len__(self):
+         """__len__() <==> len(T), O(1)
+         """
+         assert self._tree is not NULL
+         return art.art_count(self._tree)
+
+     def __contains__(self, object key):
+         """__contains__(k) -> True if T has a key k, else False,
+         O(len(k))
+         """
+         cdef bytes k = as_key(key)
+         assert self._tree is not NULL
+         return art.art_find(self._tree, k, len(k), NULL) == 1
+
+     def __getitem__(self, object key):
+         """__getitem__(k) <==> T[k], O(len(k))
+         """
+         cdef bytes k = as_key(key)
+         cdef generic_ptr value = NULL
+         assert self._tree is not NULL
+
+         if art.art_find(self._tree, k, len(k), &value) == 0:
+             raise KeyError(key)
+
+         return <object> value
+
+     def __setitem__(self, object key, object value):
+         """__setitem__(k, v) <==> T[k] = v, O(len(k))
+         """
+         cdef bytes k = as_key(key)
+         cdef generic_ptr old = NULL
+         cdef int res
+         assert self._tree is not NULL
+
+         res = art.art_insert(self._tree, k, len(k), <generic_ptr> value,
+                              &old)
+         if res == art.ART_OUT_OF_MEM:
+             raise MemoryError()
+
+         # explicit reference counting
+         Py_INCREF(value)
+         if res == art.ART_REPLACED:
+             Py_DECREF(<object> old)
+         else:
+             self._version += 1
+
+     def __delitem__(self, object key):
+         """__delitem__(k) <==> del T[k], O(len(k))
+         """
+         cdef bytes k = as_key(key)
+         cdef generic_ptr value = NULL
+         assert self._tree is not NULL
+
+         if art.art_delete(self._tree, k, len(k), &value) == 0:
+             raise KeyError(key)
+
+         self._version += 1
+         Py_DECREF(<object> value)
+
+     def get(self, object key, default=None):
+         """get(k[,d]) -> T[k] if k in T, else d, O(len(k))
+         """
+         cdef bytes k = as_key(key)
+         cdef generic_ptr value = NULL
+         assert self._tree is not NULL
+
+         if art.art_find(self._tree, k, len(k), &value) == 0:
+             return default
+
+         return <object> value
+
+     def pop(self, object key, default=None):
+         """pop(k[,d]) -> v, remove k and return its value, or d if k
+         is not in T, O(len(k))
+         """
+         cdef bytes k = as_key(key)
+         cdef generic_ptr value = NULL
+         assert self._tree is not NULL
+
+         if art.art_delete(self._tree, k, len(k), &value) == 0:
+             return default
+
+         self._version += 1
+         value_obj = <object> value
+         Py_DECREF(value_obj)
+
+         return value_obj
+
+     def longest_prefix(self, object key):
+         """longest_prefix(k) -> (p, v), the longest key p of T which is
+         a prefix of k, and its value. Raises KeyError if there is none,
+         O(len(k))
+         """
+         cdef bytes k = as_key(key)
+         cdef size_t match_len = 0
+         cdef generic_ptr value = NULL
+         assert self._tree is not NULL
+
+         if art.art_longest_prefix(self._tree, k, len(k),
+                                   &match_len, &value) == 0:
+             raise KeyError(key)
+
+         return (k[:match_len], <object> value)
+
+     def __min__(self):
+         """__min__() <==> min(T), get min item (k,v) of T
+         """
+         cdef unsigned char* key = NULL
+         cdef size_t length = 0
+         cdef generic_ptr value = NULL
+         assert self._tree is not NULL
+
+         if art.art_first(self._tree, &key, &length, &value) == 0:
+             raise ValueError()
+
+         return (key[:length], <object> value)
+
+     def __max__(self):
+         """__max__() <==> max(T), get max item (k,v) of T
+         """
+         cdef unsigned char* key = NULL
+         cdef size_t length = 0
+         cdef generic_ptr value = NULL
+         assert self._tree is not NULL
+
+         if art.art_last(self._tree, &key, &length, &value) == 0:
+             raise ValueError()
+
+         return (key[:length], <object> value)
+
+     def __iter__(self):
+         """__iter__() <==> iter(T), (k, v) items in key order
+         """
+         return RadixTreeIterator(self)
+
+     def __reversed__(self):
+         """__reversed__() <==> reversed(T)
+         """
+         return RadixTreeIterator(self, b'', True)
+
+     def iter_prefix(self, object prefix, reverse=False):
+         """iter_prefix(p[, reverse]) -> iterator over the (k, v) items
+         of T whose keys start with p, in key order
+         """
+         return RadixTreeIterator(self, prefix, reverse)
+
+     def items(self, prefix=b'', reverse=False):
+         """items([prefix[, reverse]]) -> list of (k, v) items of T
+         """
+         return list(RadixTreeIterator(self, prefix, reverse))
+
+     def keys(self, prefix=b'', reverse=False):
+         """keys([prefix[, reverse]]) -> list of the keys of T
+         """
+         return [k for (k, v) in RadixTreeIterator(self, prefix, reverse)]
+
+     def values(self, prefix=b'', reverse=False):
+         """values([prefix[, reverse]]) -> list of the values of T
+         """
+         return [v for (k, v) in RadixTreeIterator(self, prefix, reverse)]
+
+     def clear(self):
+         """clear() -> None, remove all items from T, O(n)
+         """
+         assert self._tree is not NULL
+         art.art_clear(self._tree, <free_func_ptr> free_callback)
+         self._version += 1
@@ -22,10 +22,15 @@ cdef extern from "avl/avl.h":
     ctypedef int (*cmp_func_ptr)(generic_ptr a,
                                  generic_ptr b)
 
+    # constants
+    int AVL_OUT_OF_MEM
+
     # constructors
     avl_tree_ptr avl_init(cmp_func_ptr compare)
     avl_iterator_ptr avl_iter(avl_tree_ptr tree,
                               int dir)
+    avl_iterator_ptr avl_iter_key(avl_tree_ptr tree,
+                                  generic_ptr key)
 
     # destructors
     void avl_deinit(avl_tree_ptr avl,
@@ -39,6 +44,8 @@ cdef extern from "avl/avl.h":
                       generic_dptr key_p,
                       generic_dptr value_p)
 
+    int avl_iter_changed(avl_iterator_ptr iter_)
+
     # number of entries
     int avl_count(avl_tree_ptr avl)
 
@@ -60,6 +67,12 @@ cdef extern from "avl/avl.h":
                     generic_ptr key,
                     generic_ptr value)
 
+    # bulk insertion of sorted items into an empty tree
+    int avl_build_sorted (avl_tree_ptr tree,
+                          generic_dptr keys,
+                          generic_dptr values,
+                          int n)
+
     # find element
     int avl_find (avl_tree_ptr tree,
                   generic_ptr key,
@@ -1,9 +1,21 @@
 # file: avl.pyx
 cimport avl
 
+from operator import itemgetter
+
 cdef extern from "Python.h":
+    ctypedef void PyObject
     cdef void Py_INCREF(obj)
     cdef void Py_DECREF(obj)
+    cdef bint PyDict_Check(object o)
+    cdef int PyDict_Next(object p, Py_ssize_t* pos,
+                         PyObject** key, PyObject** value)
+    cdef bint PyList_Check(object o)
+    cdef bint PyTuple_Check(object o)
+    cdef object PySequence_Fast(object o, char* m)
+    cdef Py_ssize_t PySequence_Fast_GET_SIZE(object o)
+    cdef PyObject** PySequence_Fast_ITEMS(object o)
+    cdef object PyList_New(Py_ssize_t n)
 
 cdef int cmp_callback(object a, object b):
     return cmp(a, b)
@@ -11,59 +23,187 @@ cdef int cmp_callback(object a, object b):
 cdef void free_callback(object obj):
     Py_DECREF(obj)
 
+cdef class Avl
+
+# what iterators and views yield
+cdef enum:
+    ITEMS = 0
+    KEYS = 1
+    VALUES = 2
+
+cdef inline object item_of(int kind, generic_ptr key, generic_ptr value):
+    if kind == KEYS:
+        return <object> key
+    if kind == VALUES:
+        return <object> value
+
+    # hold both before the tuple is allocated, which may run the gc
+    k = <object> key
+    v = <object> value
+    return (k, v)
+
 cdef class AvlForwardIterator(object):
      cdef avl.avl_iterator_ptr _iterator
+     cdef Avl _owner
+     cdef int _kind
 
-     def __init__(self, Avl obj):
+     def __init__(self, Avl obj, int kind=ITEMS):
          self._iterator = avl.avl_iter(obj._tree, 0)  # forward
          if self._iterator is NULL:
             raise MemoryError()
+         self._owner = obj
+         self._kind = kind
 
      def __dealloc__(self):
-         assert self._iterator is not NULL
-         avl.avl_iter_free(self._iterator)
+         if self._iterator is not NULL:
+             avl.avl_iter_free(self._iterator)
 
      def __iter__(self):
          return self
 
      def __next__(self):
-         cdef int res
          cdef generic_ptr key = NULL
          cdef generic_ptr value = NULL
          assert self._iterator is not NULL
 
+         if avl.avl_iter_changed(self._iterator):
+             raise RuntimeError("Avl changed during iteration")
+
          if (avl.avl_iter_next(self._iterator,
                                &key, &value) == 0):
              raise StopIteration()
 
-         return (<object> key, <object> value)
+         return item_of(self._kind, key, value)
 
 cdef class AvlBackwardIterator(object):
      cdef avl.avl_iterator_ptr _iterator
+     cdef Avl _owner
+     cdef int _kind
 
-     def __init__(self, Avl obj):
+     def __init__(self, Avl obj, int kind=ITEMS):
          self._iterator = avl.avl_iter(obj._tree, 1)  # backward
          if self._iterator is NULL:
             raise MemoryError()
+         self._owner = obj
+         self._kind = kind
 
      def __dealloc__(self):
-         assert self._iterator is not NULL
-         avl.avl_iter_free(self._iterator)
+         if self._iterator is not NULL:
+             avl.avl_iter_free(self._iterator)
 
      def __iter__(self):
          return self
 
      def __next__(self):
-         cdef int res
          cdef generic_ptr key = NULL
          cdef generic_ptr value = NULL
          assert self._iterator is not NULL
 
+         if avl.avl_iter_changed(self._iterator):
+             raise RuntimeError("Avl changed during iteration")
+
          if (avl.avl_iter_next(self._iterator,
                                &key, &value) == 0):
              raise StopIteration()
 
-         return (<object> key, <object> value)
+         return item_of(self._kind, key, value)
+
+cdef class AvlView(object):
+     """A live view of the keys, values or items of an Avl, iterated
+     in order without building intermediate lists
+     """
+     cdef Avl _owner
+     cdef int _kind
+
+     def __len__(self):
+         return avl.avl_count(self._owner._tree)
+
+     def __iter__(self):
+         return AvlForwardIterator(self._owner, self._kind)
+
+     def __reversed__(self):
+         return AvlBackwardIterator(self._owner, self._kind)
+
+cdef class AvlKeysView(AvlView):
+     def __init__(self, Avl obj):
+         self._owner = obj
+         self._kind = KEYS
+
+     def __contains__(self, key):
+         return key in self._owner
+
+cdef class AvlValuesView(AvlView):
+     def __init__(self, Avl obj):
+         self._owner = obj
+         self._kind = VALUES
+
+     def __contains__(self, value):
+         for v in AvlForwardIterator(self._owner, VALUES):
+             if v is value or v == value:
+                 return True
+         return False
+
+cdef class AvlItemsView(AvlView):
+     def __init__(self, Avl obj):
+         self._owner = obj
+         self._kind = ITEMS
+
+     def __contains__(self, item):
+         cdef generic_ptr k = NULL
+         cdef generic_ptr v = NULL
+         cdef avl.avl_iterator_ptr iter_
+         (key, value) = item
+
+         # only the run of (duplicate) keys equal to key
+         iter_ = avl.avl_iter_key(self._owner._tree, <generic_ptr> key)
+         if iter_ is NULL:
+             raise MemoryError()
+
+         try:
+             while avl.avl_iter_next(iter_, &k, &v):
+                 if <object> v is value or <object> v == value:
+                     return True
+             if avl.avl_iter_changed(iter_):
+                 raise RuntimeError("Avl changed during iteration")
+         finally:
+             avl.avl_iter_free(iter_)
+
+         return False
+
+cdef list_of(Avl obj, int kind, int dir):
+    # fill a list of the final length straight from the C iterator.
+    # Making the items may run the gc, and __del__ methods may change
+    # the tree: the list then goes, NULL slots and all
+    cdef Py_ssize_t i, n
+    cdef generic_ptr key = NULL
+    cdef generic_ptr value = NULL
+    cdef PyObject** items
+    cdef avl.avl_iterator_ptr iter_
+
+    n = avl.avl_count(obj._tree)
+    res = PyList_New(n)
+    items = PySequence_Fast_ITEMS(res)
+
+    iter_ = avl.avl_iter(obj._tree, dir)
+    if iter_ is NULL:
+        raise MemoryError()
+
+    try:
+        for i from 0 <= i < n:
+            if avl.avl_iter_next(iter_, &key, &value) == 0:
+                raise RuntimeError("Avl changed during iteration")
+            item = item_of(kind, key, value)
+
+            # the list owns a reference to each item
+            Py_INCREF(item)
+            items[i] = <PyObject*> item
+
+        if avl.avl_iter_changed(iter_):
+            raise RuntimeError("Avl changed during iteration")
+    finally:
+        avl.avl_iter_free(iter_)
+
+    return res
 
 cdef class Avl(object):
      cdef avl.avl_tree_ptr _tree
@@ -72,18 +212,70 @@ cdef class Avl(object):
          """Python ctor
          """
          if seq is not None:
+             self._load(seq)
+
+     cdef _load(self, seq):
+         # into an empty tree, the items are sorted (stably, so that
+         # duplicates keep their order) and the tree built balanced in
+         # O(n), otherwise they are inserted one at a time
+         cdef Py_ssize_t i, n, pos = 0
+         cdef PyObject* key
+         cdef PyObject* value
+         cdef PyObject** items
+         assert self._tree is not NULL
+
+         if PyDict_Check(seq):
+             pairs = []
+             while PyDict_Next(seq, &pos, &key, &value):
+                 pairs.append((<object> key, <object> value))
+
+         elif PyList_Check(seq) or PyTuple_Check(seq):
+             pairs = seq
+
+         else:
              try:
-                 for (k, v) in seq.__getattribute__('iteritems')():
-                     self.__setitem__(k, v)
+                 pairs = list(seq.__getattribute__('iteritems')())
 
              except AttributeError:
                  try:
-                     for (k, v) in seq.__getattribute__('__iter__')():
-                         self.__setitem__(k, v)
+                     pairs = list(seq.__getattribute__('__iter__')())
 
                  except AttributeError:
                      raise ValueError("Iterable sequence expected")
 
+         fast = PySequence_Fast(pairs, "Iterable sequence expected")
+         n = PySequence_Fast_GET_SIZE(fast)
+         items = PySequence_Fast_ITEMS(fast)
+
+         if avl.avl_count(self._tree) > 0:
+             for i from 0 <= i < n:
+                 (k, v) = <object> items[i]
+                 self.__setitem__(k, v)
+             return
+
+         keys = [None] * n
+         values = [None] * n
+         for i from 0 <= i < n:
+             (keys[i], values[i]) = <object> items[i]
+
+         for i from 1 <= i < n:
+             if cmp_callback(keys[i - 1], keys[i]) > 0:
+                 pairs = sorted(zip(keys, values), key=itemgetter(0))
+                 keys = [k for (k, v) in pairs]
+                 values = [v for (k, v) in pairs]
+                 break
+
+         if avl.avl_build_sorted(self._tree,
+                                 <generic_dptr> PySequence_Fast_ITEMS(keys),
+                                 <generic_dptr> PySequence_Fast_ITEMS(values),
+                                 n) == 0:
+             raise MemoryError()
+
+         # explicit reference counting increment
+         for i from 0 <= i < n:
+             Py_INCREF(keys[i])
+             Py_INCREF(values[i])
+
      def __cinit__(self):
          """C ctor
          """
@@ -135,9 +327,13 @@ cdef class Avl(object):
          Py_INCREF(key)
          Py_INCREF(value)
 
-         avl.avl_insert(self._tree,
-                        <generic_ptr> key,
-                        <generic_ptr> value)
+         if avl.avl_insert(self._tree,
+                           <generic_ptr> key,
+                           <generic_ptr> value) == avl.AVL_OUT_OF_MEM:
+             # explicit reference counting decrement
+             Py_DECREF(key)
+             Py_DECREF(value)
+             raise MemoryError()
 
      def insert(self, object key, object value=None):
 
@@ -147,9 +343,13 @@ cdef class Avl(object):
          Py_INCREF(key)
          Py_INCREF(value)
 
-         avl.avl_insert(self._tree,
-                        <generic_ptr> key,
-                        <generic_ptr> value)
+         if avl.avl_insert(self._tree,
+                           <generic_ptr> key,
+                           <generic_ptr> value) == avl.AVL_OUT_OF_MEM:
+             # explicit reference counting decrement
+             Py_DECREF(key)
+             Py_DECREF(value)
+             raise MemoryError()
 
      def __len__(self):
          """__len__() <==> len(T), O(1)
@@ -230,61 +430,61 @@ cdef class Avl(object):
          return <object> value
 
      def items(self, reverse=False):
-         """items([reverse]) -> list (k, v) items of T, O(n)
+         """items([reverse]) -> list of the (k, v) items of T, O(n)
          """
-         res = []
-
-         if not reverse:
-             iter_ = iter(self)
-         else:
-             iter_ = reversed(self)
-
-         try:
-             while True:
-                 res.append(iter_.next())
-
-         except StopIteration:
-             pass
-
-         return res
+         assert self._tree is not NULL
+         return list_of(self, ITEMS, 1 if reverse else 0)
 
      def keys(self, reverse=False):
-         """keys([reverse]) -> list for keys of T, O(n)
+         """keys([reverse]) -> list of the keys of T, O(n)
          """
-         res = []
-
-         if not reverse:
-             iter_ = iter(self)
-         else:
-             iter_ = reversed(self)
-
-         try:
-             while True:
-                 res.append(iter_.next()[0])
+         assert self._tree is not NULL
+         return list_of(self, KEYS, 1 if reverse else 0)
 
-         except StopIteration:
-             pass
+     def values(self, reverse=False):
+         """values([reverse]) -> list of the values of T, O(n)
+         """
+         assert self._tree is not NULL
+         return list_of(self, VALUES, 1 if reverse else 0)
 
-         return res
+     def iteritems(self, reverse=False):
+         """iteritems([reverse]) -> an iterator over the (k, v) items of T
+         """
+         assert self._tree is not NULL
+         if reverse:
+             return AvlBackwardIterator(self, ITEMS)
+         return AvlForwardIterator(self, ITEMS)
 
-     def values(self, reverse=False):
-         """values([reverse]) -> generator for values of T, O(n)
+     def iterkeys(self, reverse=False):
+         """iterkeys([reverse]) -> an iterator over the keys of T
          """
-         res = []
+         assert self._tree is not NULL
+         if reverse:
+             return AvlBackwardIterator(self, KEYS)
+         return AvlForwardIterator(self, KEYS)
 
-         if not reverse:
-             iter_ = iter(self)
-         else:
-             iter_ = reversed(self)
+     def itervalues(self, reverse=False):
+         """itervalues([reverse]) -> an iterator over the values of T
+         """
+         assert self._tree is not NULL
+         if reverse:
+             return AvlBackwardIterator(self, VALUES)
+         return AvlForwardIterator(self, VALUES)
 
-         try:
-             while True:
-                 res.append(iter_.next()[1])
+     def viewitems(self):
+         """viewitems() -> a live view of the (k, v) items of T
+         """
+         return AvlItemsView(self)
 
-         except StopIteration:
-             pass
+     def viewkeys(self):
+         """viewkeys() -> a live view of the keys of T
+         """
+         return AvlKeysView(self)
 
-         return res
+     def viewvalues(self):
+         """viewvalues() -> a live view of the values of T
+         """
+         return AvlValuesView(self)
 
      def __delitem__(self, object key):
          """__delitem__(y) <==> del T[y], del[s:e], O(log(n))
@@ -339,5 +539,4 @@ cdef class Avl(object):
      def update(self, E):
          """update(E) -> None. Update T from dict/iterable E, O(E*log(n))
          """
-         for (k, v) in E.iteritems():
-             self.__setitem__(k, v)
+         self._load(E)
@@ -0,0 +1,98 @@
+# file: bdd.pxd
+cdef extern from "bdd/bdd.h":
+
+    ctypedef struct bdd_mgr_t:
+        pass
+    ctypedef bdd_mgr_t* bdd_mgr_ptr
+
+    # node ids
+    ctypedef unsigned bdd_t
+
+    # constants
+    int BDD_OK
+    int BDD_OUT_OF_MEM
+
+    bdd_t BDD_FALSE
+    bdd_t BDD_TRUE
+    bdd_t BDD_NONE
+
+    # constructors
+    bdd_mgr_ptr bdd_init(unsigned nvars,
+                         unsigned cache_size)
+
+    # destructors
+    void bdd_deinit(bdd_mgr_ptr mgr)
+
+    # external references
+    bdd_t bdd_ref(bdd_mgr_ptr mgr,
+                  bdd_t f)
+
+    void bdd_deref(bdd_mgr_ptr mgr,
+                   bdd_t f)
+
+    # variables
+    bdd_t bdd_var(bdd_mgr_ptr mgr,
+                  unsigned v)
+
+    unsigned bdd_nvars(bdd_mgr_ptr mgr)
+    unsigned bdd_var_level(bdd_mgr_ptr mgr,
+                           unsigned v)
+
+    # nodes
+    unsigned bdd_top_var(bdd_mgr_ptr mgr,
+                         bdd_t f)
+
+    bdd_t bdd_low(bdd_mgr_ptr mgr,
+                  bdd_t f)
+
+    bdd_t bdd_high(bdd_mgr_ptr mgr,
+                   bdd_t f)
+
+    # operations
+    bdd_t bdd_ite(bdd_mgr_ptr mgr,
+                  bdd_t f,
+                  bdd_t g,
+                  bdd_t h)
+
+    bdd_t bdd_not(bdd_mgr_ptr mgr,
+                  bdd_t f)
+
+    bdd_t bdd_and(bdd_mgr_ptr mgr,
+                  bdd_t f,
+                  bdd_t g)
+
+    bdd_t bdd_or(bdd_mgr_ptr mgr,
+                 bdd_t f,
+                 bdd_t g)
+
+    bdd_t bdd_xor(bdd_mgr_ptr mgr,
+                  bdd_t f,
+                  bdd_t g)
+
+    bdd_t bdd_implies(bdd_mgr_ptr mgr,
+                      bdd_t f,
+                      bdd_t g)
+
+    bdd_t bdd_restrict(bdd_mgr_ptr mgr,
+                       bdd_t f,
+                       unsigned v,
+                       int value)
+
+    bdd_t bdd_exists(bdd_mgr_ptr mgr,
+                     bdd_t f,
+                     unsigned v)
+
+    double bdd_sat_count(bdd_mgr_ptr mgr,
+                         bdd_t f)
+
+    long bdd_size(bdd_mgr_ptr mgr,
+                  bdd_t f)
+
+    # memory management
+    unsigned bdd_live(bdd_mgr_ptr mgr)
+    void bdd_gc(bdd_mgr_ptr mgr)
+
+    # variable reordering
+    int bdd_reorder(bdd_mgr_ptr mgr)
+    void bdd_auto_reorder(bdd_mgr_ptr mgr,
+                          int enable)
@@ -0,0 +1,264 @@
+# file: bdd.pyx
+cimport bdd
+
+cdef class BDD
+cdef class BDDManager
+
+cdef BDD wrap(BDDManager manager, bdd.bdd_t f):
+    cdef BDD res
+
+    if f == bdd.BDD_NONE:
+        raise MemoryError()
+
+    res = BDD.__new__(BDD)
+    res._manager = manager
+
+    # the BDD stays alive for as long as the Python object does
+    res._f = bdd.bdd_ref(manager._mgr, f)
+    return res
+
+cdef class BDDManager(object):
+     """A manager of reduced ordered BDDs over variables 0, 1, ...
+     BDDs are hash-consed, so that equivalent ones are the same node.
+     Dead nodes are collected as needed, and variables can be
+     reordered (by sifting) to keep BDDs small.
+     """
+     cdef bdd.bdd_mgr_ptr _mgr
+     cdef int _auto_reorder
+
+     def __cinit__(self, unsigned nvars=0, unsigned cache_size=0):
+         """C ctor, variables are also added on first use
+         """
+         self._mgr = bdd.bdd_init(nvars, cache_size)
+         if self._mgr is NULL:
+             raise MemoryError()
+         self._auto_reorder = 0
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._mgr is not NULL
+         bdd.bdd_deinit(self._mgr)
+
+     def __len__(self):
+         """x.__len__() <==> len(x), the number of nodes in use
+         """
+         assert self._mgr is not NULL
+         return bdd.bdd_live(self._mgr)
+
+     property nvars:
+         """the number of variables
+         """
+         def __get__(self):
+             assert self._mgr is not NULL
+             return bdd.bdd_nvars(self._mgr)
+
+     property true:
+         """the constant true BDD
+         """
+         def __get__(self):
+             return wrap(self, bdd.BDD_TRUE)
+
+     property false:
+         """the constant false BDD
+         """
+         def __get__(self):
+             return wrap(self, bdd.BDD_FALSE)
+
+     property auto_reorder:
+         """whether variables are sifted whenever the number of nodes
+         doubles
+         """
+         def __get__(self):
+             return self._auto_reorder != 0
+
+         def __set__(self, enable):
+             assert self._mgr is not NULL
+             self._auto_reorder = 1 if enable else 0
+             bdd.bdd_auto_reorder(self._mgr, self._auto_reorder)
+
+     def var(self, unsigned v):
+         """M.var(v) -> BDD -- the function of variable v
+         """
+         assert self._mgr is not NULL
+         return wrap(self, bdd.bdd_var(self._mgr, v))
+
+     def level(self, unsigned v):
+         """M.level(v) -> the position of variable v in the order
+         """
+         assert self._mgr is not NULL
+         if v >= bdd.bdd_nvars(self._mgr):
+             raise IndexError("no such variable")
+         return bdd.bdd_var_level(self._mgr, v)
+
+     def ite(self, BDD f not None, BDD g not None, BDD h not None):
+         """M.ite(f, g, h) -> BDD -- if f then g else h
+         """
+         assert self._mgr is not NULL
+         if f._manager is not self or g._manager is not self or \
+                h._manager is not self:
+             raise ValueError("BDDs of a different manager")
+         return wrap(self, bdd.bdd_ite(self._mgr, f._f, g._f, h._f))
+
+     def gc(self):
+         """M.gc() -- release the nodes no BDD refers to
+         """
+         assert self._mgr is not NULL
+         bdd.bdd_gc(self._mgr)
+
+     def reorder(self):
+         """M.reorder() -- sift all variables once
+         """
+         assert self._mgr is not NULL
+         if bdd.bdd_reorder(self._mgr) != bdd.BDD_OK:
+             raise MemoryError()
+
+cdef class BDD(object):
+     """A boolean function, built from the variables of a BDDManager
+     with the ~, &, |, ^ and >> (implication) operators. Equivalent
+     BDDs compare (and hash) equal in O(1).
+     """
+     cdef BDDManager _manager
+     cdef bdd.bdd_t _f
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._manager is not None:
+             bdd.bdd_deref(self._manager._mgr, self._f)
+
+     cdef bdd.bdd_mgr_ptr _mgr_of(self, BDD other) except NULL:
+         if other._manager is not self._manager:
+             raise ValueError("BDDs of a different manager")
+         return self._manager._mgr
+
+     def __invert__(self):
+         """x.__invert__() <==> ~x
+         """
+         return wrap(self._manager, bdd.bdd_not(self._manager._mgr, self._f))
+
+     def __and__(x, y):
+         """x.__and__(y) <==> x&y
+         """
+         cdef BDD f, g
+         if not isinstance(x, BDD) or not isinstance(y, BDD):
+             return NotImplemented
+         f = x
+         g = y
+         return wrap(f._manager, bdd.bdd_and(f._mgr_of(g), f._f, g._f))
+
+     def __or__(x, y):
+         """x.__or__(y) <==> x|y
+         """
+         cdef BDD f, g
+         if not isinstance(x, BDD) or not isinstance(y, BDD):
+             return NotImplemented
+         f = x
+         g = y
+         return wrap(f._manager, bdd.bdd_or(f._mgr_of(g), f._f, g._f))
+
+     def __xor__(x, y):
+         """x.__xor__(y) <==> x^y
+         """
+         cdef BDD f, g
+         if not isinstance(x, BDD) or not isinstance(y, BDD):
+             return NotImplemented
+         f = x
+         g = y
+         return wrap(f._manager, bdd.bdd_xor(f._mgr_of(g), f._f, g._f))
+
+     def __rshift__(x, y):
+         """x.__rshift__(y) <==> x>>y, x implies y
+         """
+         cdef BDD f, g
+         if not isinstance(x, BDD) or not isinstance(y, BDD):
+             return NotImplemented
+         f = x
+         g = y
+         return wrap(f._manager, bdd.bdd_implies(f._mgr_of(g), f._f, g._f))
+
+     def __richcmp__(x, y, int op):
+         """x == y and x != y, by equivalence of the functions
+         """
+         cdef BDD f, g
+         if op not in (2, 3) or not isinstance(x, BDD) or \
+                not isinstance(y, BDD):
+             return NotImplemented
+         f = x
+         g = y
+         same = f._manager is g._manager and f._f == g._f
+         return same if op == 2 else not same
+
+     def __hash__(self):
+         """x.__hash__() <==> hash(x)
+         """
+         return self._f
+
+     property is_true:
+         """whether this is the constant true
+         """
+         def __get__(self):
+             return self._f == bdd.BDD_TRUE
+
+     property is_false:
+         """whether this is the constant false
+         """
+         def __get__(self):
+             return self._f == bdd.BDD_FALSE
+
+     property var:
+         """the top variable, None for constants
+         """
+         def __get__(self):
+             if self._f == bdd.BDD_TRUE or self._f == bdd.BDD_FALSE:
+                 return None
+             return bdd.bdd_top_var(self._manager._mgr, self._f)
+
+     property low:
+         """the cofactor for var = 0, None for constants
+         """
+         def __get__(self):
+             if self._f == bdd.BDD_TRUE or self._f == bdd.BDD_FALSE:
+                 return None
+             return wrap(self._manager,
+                         bdd.bdd_low(self._manager._mgr, self._f))
+
+     property high:
+         """the cofactor for var = 1, None for constants
+         """
+         def __get__(self):
+             if self._f == bdd.BDD_TRUE or self._f == bdd.BDD_FALSE:
+                 return None
+             return wrap(self._manager,
+                         bdd.bdd_high(self._manager._mgr, self._f))
+
+     def restrict(self, unsigned v, value):
+         """B.restrict(v, value) -> BDD -- B with variable v set
+         """
+         return wrap(self._manager,
+                     bdd.bdd_restrict(self._manager._mgr, self._f, v,
+                                      1 if value else 0))
+
+     def exists(self, unsigned v):
+         """B.exists(v) -> BDD -- B with variable v existentially
+         quantified
+         """
+         return wrap(self._manager,
+                     bdd.bdd_exists(self._manager._mgr, self._f, v))
+
+     def sat_count(self):
+         """B.sat_count() -> the number of satisfying assignments over
+         all the manager variables
+         """
+         cdef double res = bdd.bdd_sat_count(self._manager._mgr, self._f)
+         if res < 0:
+             raise MemoryError()
+         return res
+
+     def node_count(self):
+         """B.node_count() -> the number of nodes, constants included
+         """
+         cdef long res = bdd.bdd_size(self._manager._mgr, self._f)
+         if res < 0:
+             raise MemoryError()
+         return res
@@ -0,0 +1,77 @@
+# file: cache.pxd
+
+cdef extern from "cache/cache.h":
+
+    ctypedef struct cache_t:
+        pass
+    ctypedef cache_t* cache_ptr
+
+    ctypedef struct cache_stats_t:
+        unsigned long hits
+        unsigned long misses
+        unsigned long evictions
+
+    # value ptrs
+    ctypedef void* generic_ptr
+
+    # func ptrs
+    ctypedef void (*free_func_ptr)(generic_ptr data)
+    ctypedef unsigned (*hash_func_ptr)(generic_ptr a)
+    ctypedef int (*cmp_func_ptr)(generic_ptr a,
+                                 generic_ptr b)
+    ctypedef size_t (*cache_size_func_ptr)(generic_ptr key,
+                                           generic_ptr value)
+
+    # constants
+    int CACHE_LRU
+    int CACHE_CLOCK
+    int CACHE_OK
+    int CACHE_NOT_FOUND
+    int CACHE_OUT_OF_MEM
+    int CACHE_TOO_BIG
+
+    # constructors
+    cache_ptr cache_init(hash_func_ptr hash_func,
+                         cmp_func_ptr cmp_func,
+                         free_func_ptr key_free_func,
+                         free_func_ptr value_free_func,
+                         int policy,
+                         size_t max_entries,
+                         size_t max_bytes,
+                         cache_size_func_ptr size_func)
+
+    # destructors
+    void cache_deinit(cache_ptr cache)
+
+    void cache_clear(cache_ptr cache)
+
+    # insertion
+    int cache_put(cache_ptr cache,
+                  generic_ptr key,
+                  generic_ptr value)
+
+    int cache_put_sized(cache_ptr cache,
+                        generic_ptr key,
+                        generic_ptr value,
+                        size_t size)
+
+    # lookups
+    generic_ptr cache_get(cache_ptr cache,
+                          generic_ptr key)
+
+    generic_ptr cache_peek(cache_ptr cache,
+                           generic_ptr key)
+
+    # deletion
+    int cache_delete(cache_ptr cache,
+                     generic_ptr key)
+
+    void cache_resize(cache_ptr cache,
+                      size_t max_entries,
+                      size_t max_bytes)
+
+    size_t cache_count(cache_ptr cache)
+    size_t cache_bytes(cache_ptr cache)
+    size_t cache_max_bytes(cache_ptr cache)
+    void cache_get_stats(cache_ptr cache,
+                         cache_stats_t* stats)
@@ -0,0 +1,183 @@
+# file: cache.pyx
+cimport cache
+from keys cimport keys_hash, keys_cmp
+
+import sys
+
+cdef extern from "Python.h":
+    cdef void Py_INCREF(obj)
+    cdef void Py_DECREF(obj)
+
+cdef void free_callback(object obj):
+    Py_DECREF(obj)
+
+_policies = {
+    'lru': cache.CACHE_LRU,
+    'clock': cache.CACHE_CLOCK,
+}
+
+cdef class LRUCache(object):
+     """A bounded mapping, evicting the least recently used entries.
+     It holds at most maxsize entries and, if maxbytes is given, at
+     most maxbytes of values as measured by getsizeof (sys.getsizeof
+     by default); 0 means no bound. policy 'clock' approximates LRU,
+     making hits cheaper. Lookups and updates run entirely in C.
+     """
+     cdef cache.cache_ptr _cache
+     cdef object _getsizeof
+
+     def __cinit__(self, size_t maxsize=128, size_t maxbytes=0,
+                   getsizeof=None, policy='lru'):
+         """C ctor
+         """
+         if policy not in _policies:
+             raise ValueError("policy must be 'lru' or 'clock'")
+
+         if getsizeof is None and maxbytes:
+             getsizeof = sys.getsizeof
+         self._getsizeof = getsizeof
+
+         self._cache = cache.cache_init(<hash_func_ptr> keys_hash,
+                                        <cmp_func_ptr> keys_cmp,
+                                        <free_func_ptr> free_callback,
+                                        <free_func_ptr> free_callback,
+                                        _policies[policy],
+                                        maxsize, maxbytes, NULL)
+         if self._cache is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._cache is not NULL:
+             cache.cache_deinit(self._cache)
+
+     def __len__(self):
+         """x.__len__() <==> len(x)
+         """
+         assert self._cache is not NULL
+         return cache.cache_count(self._cache)
+
+     def __contains__(self, object key):
+         """__contains__(k) -> True if C has a key k, else False. Does
+         not count as a use of k
+         """
+         assert self._cache is not NULL
+         return cache.cache_peek(self._cache, <generic_ptr> key) != NULL
+
+     def __getitem__(self, object key):
+         """__getitem__(k) <==> C[k], raises KeyError on a miss
+         """
+         cdef generic_ptr value
+         assert self._cache is not NULL
+
+         value = cache.cache_get(self._cache, <generic_ptr> key)
+         if value == NULL:
+             raise KeyError(key)
+
+         return <object> value
+
+     def get(self, object key, default=None):
+         """get(k[,d]) -> C[k] if k in C, else d
+         """
+         cdef generic_ptr value
+         assert self._cache is not NULL
+
+         value = cache.cache_get(self._cache, <generic_ptr> key)
+         if value == NULL:
+             return default
+
+         return <object> value
+
+     def __setitem__(self, object key, object value):
+         """__setitem__(k, v) <==> C[k] = v
+         """
+         self.put(key, value)
+
+     def put(self, object key, object value):
+         """put(k, v) -> None, insert or replace k, evicting the least
+         recently used entries as needed. Raises ValueError if v alone
+         exceeds maxbytes
+         """
+         cdef int res
+         cdef size_t size = 0
+         assert self._cache is not NULL
+
+         if self._getsizeof is not None:
+             size = self._getsizeof(value)
+
+         # explicit reference counting increment
+         Py_INCREF(key)
+         Py_INCREF(value)
+
+         res = cache.cache_put_sized(self._cache, <generic_ptr> key,
+                                     <generic_ptr> value, size)
+         if res != cache.CACHE_OK:
+             Py_DECREF(key)
+             Py_DECREF(value)
+
+             if res == cache.CACHE_TOO_BIG:
+                 raise ValueError("value exceeds maxbytes")
+             raise MemoryError()
+
+     def __delitem__(self, object key):
+         """__delitem__(k) <==> del C[k]
+         """
+         assert self._cache is not NULL
+         if cache.cache_delete(self._cache,
+                               <generic_ptr> key) != cache.CACHE_OK:
+             raise KeyError(key)
+
+     def clear(self):
+         """clear() -> None, remove all entries. Counters are kept
+         """
+         assert self._cache is not NULL
+         cache.cache_clear(self._cache)
+
+     def resize(self, size_t maxsize, maxbytes=None):
+         """resize(maxsize[, maxbytes]) -> None, new bounds, evicting
+         as needed. Without maxbytes the byte budget is kept; 0 drops it
+         """
+         cdef size_t nbytes
+         assert self._cache is not NULL
+         if maxbytes is None:
+             nbytes = cache.cache_max_bytes(self._cache)
+         else:
+             nbytes = maxbytes
+         if nbytes and self._getsizeof is None:
+             raise ValueError("no getsizeof for a byte budget")
+         cache.cache_resize(self._cache, maxsize, nbytes)
+
+     property currbytes:
+         """the total size of the values
+         """
+         def __get__(self):
+             assert self._cache is not NULL
+             return cache.cache_bytes(self._cache)
+
+     property hits:
+         """the number of lookups which found their key
+         """
+         def __get__(self):
+             cdef cache.cache_stats_t stats
+             assert self._cache is not NULL
+             cache.cache_get_stats(self._cache, &stats)
+             return stats.hits
+
+     property misses:
+         """the number of lookups which did not find their key
+         """
+         def __get__(self):
+             cdef cache.cache_stats_t stats
+             assert self._cache is not NULL
+             cache.cache_get_stats(self._cache, &stats)
+             return stats.misses
+
+     property evictions:
+         """the number of entries evicted to stay within bounds
+         """
+         def __get__(self):
+             cdef cache.cache_stats_t stats
+             assert self._cache is not NULL
+             cache.cache_get_stats(self._cache, &stats)
+             return stats.evictions
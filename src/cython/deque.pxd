@@ -0,0 +1,68 @@
+# file: deque.pxd
+cdef extern from "deque/deque.h":
+
+    ctypedef struct deque_t:
+        pass
+    ctypedef deque_t* deque_ptr
+
+    # value ptrs
+    ctypedef void* generic_ptr
+    ctypedef void** generic_dptr
+
+    # func ptrs
+    ctypedef void (*free_func_ptr)(generic_ptr data)
+
+    # constructors
+    deque_ptr deque_init(free_func_ptr free)
+
+    # destructors
+    void deque_deinit(deque_ptr deque)
+    void deque_clear(deque_ptr deque)
+
+    # number of entries
+    unsigned deque_n(deque_ptr deque)
+
+    # both ends
+    int deque_push_back(deque_ptr deque,
+                        generic_ptr item)
+
+    int deque_push_front(deque_ptr deque,
+                         generic_ptr item)
+
+    int deque_pop_back(deque_ptr deque,
+                       generic_dptr item)
+
+    int deque_pop_front(deque_ptr deque,
+                        generic_dptr item)
+
+    int deque_peek_back(deque_ptr deque,
+                        generic_dptr item)
+
+    int deque_peek_front(deque_ptr deque,
+                         generic_dptr item)
+
+    # random access
+    int deque_fetch(deque_ptr deque,
+                    unsigned index,
+                    generic_dptr item)
+
+    int deque_set(deque_ptr deque,
+                  unsigned index,
+                  generic_ptr item)
+
+    # batches
+    int deque_extend_back(deque_ptr deque,
+                          generic_dptr items,
+                          unsigned n)
+
+    int deque_extend_front(deque_ptr deque,
+                           generic_dptr items,
+                           unsigned n)
+
+    unsigned deque_pop_many_front(deque_ptr deque,
+                                  generic_dptr items,
+                                  unsigned n)
+
+    unsigned deque_pop_many_back(deque_ptr deque,
+                                 generic_dptr items,
+                                 unsigned n)
@@ -0,0 +1,272 @@
+# file: deque.pyx
+cimport deque
+
+cdef extern from "Python.h":
+    ctypedef void PyObject
+    cdef void Py_INCREF(obj)
+    cdef void Py_DECREF(obj)
+    cdef object PySequence_Fast(object o, char* m)
+    cdef Py_ssize_t PySequence_Fast_GET_SIZE(object o)
+    cdef PyObject** PySequence_Fast_ITEMS(object o)
+    cdef object PyList_New(Py_ssize_t n)
+
+cdef void free_callback(object obj):
+    Py_DECREF(obj)
+
+cdef class DequeIterator(object):
+     cdef Deque _owner
+     cdef unsigned _next
+
+     def __init__(self, Deque obj):
+         self._owner = obj
+         self._next = 0
+
+     def __iter__(self):
+         return self
+
+     def __next__(self):
+         cdef generic_ptr value = NULL
+
+         if (deque.deque_fetch(self._owner._deque, self._next, &value) != 0):
+             raise StopIteration()
+
+         self._next = self._next + 1
+         return <object> value
+
+cdef class Deque(object):
+     """A double ended queue, stored in fixed-size blocks. Appending
+     and popping at either end is O(1), and so is indexing.
+     """
+     cdef deque.deque_ptr _deque
+
+     def __init__(self, iterable=None):
+         """Python ctor
+         """
+         if iterable is not None:
+             self.extend(iterable)
+
+     def __cinit__(self, iterable=None):
+         """C ctor
+         """
+         self._deque = deque.deque_init(<free_func_ptr> free_callback)
+         if self._deque is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._deque is not NULL
+         deque.deque_deinit(self._deque)
+
+     cdef unsigned _index(self, Py_ssize_t index) except? 0:
+         cdef Py_ssize_t n = deque.deque_n(self._deque)
+         if index < 0:
+             index = index + n
+         if index < 0 or index >= n:
+             raise IndexError("deque index out of range")
+         return index
+
+     cdef object _take(self, generic_ptr value):
+         value_obj = <object> value
+
+         # explicit reference counting decrement
+         Py_DECREF(value_obj)
+         return value_obj
+
+     def __len__(self):
+         """x.__len__() <==> len(x)
+         """
+         assert self._deque is not NULL
+         return deque.deque_n(self._deque)
+
+     def __nonzero__(self):
+         """x.__nonzero__() <==> x != 0
+         """
+         assert self._deque is not NULL
+         return deque.deque_n(self._deque) != 0
+
+     def __iter__(self):
+         """x.__iter__() <==> iter(x)
+         """
+         return DequeIterator(self)
+
+     def __getitem__(self, Py_ssize_t index):
+         """x.__getitem__(y) <==> x[y], O(1)
+         """
+         cdef generic_ptr value = NULL
+         assert self._deque is not NULL
+
+         deque.deque_fetch(self._deque, self._index(index), &value)
+         return <object> value
+
+     def __setitem__(self, Py_ssize_t index, object obj):
+         """x.__setitem__(i, y) <==> x[i]=y, O(1)
+         """
+         cdef unsigned ndx = self._index(index)
+         cdef generic_ptr old = NULL
+         assert self._deque is not NULL
+
+         deque.deque_fetch(self._deque, ndx, &old)
+
+         # explicit reference counting increment
+         Py_INCREF(obj)
+         deque.deque_set(self._deque, ndx, <generic_ptr> obj)
+         Py_DECREF(<object> old)
+
+     def append(self, object obj):
+         """D.append(obj) -- add obj to the right side
+         """
+         assert self._deque is not NULL
+
+         # explicit reference counting increment
+         Py_INCREF(obj)
+         if deque.deque_push_back(self._deque, <generic_ptr> obj) != 0:
+             Py_DECREF(obj)
+             raise MemoryError()
+
+     def appendleft(self, object obj):
+         """D.appendleft(obj) -- add obj to the left side
+         """
+         assert self._deque is not NULL
+
+         # explicit reference counting increment
+         Py_INCREF(obj)
+         if deque.deque_push_front(self._deque, <generic_ptr> obj) != 0:
+             Py_DECREF(obj)
+             raise MemoryError()
+
+     def pop(self):
+         """D.pop() -> obj -- remove and return the rightmost object.
+         Raises IndexError if the deque is empty.
+         """
+         cdef generic_ptr value = NULL
+         assert self._deque is not NULL
+
+         if deque.deque_pop_back(self._deque, &value) != 0:
+             raise IndexError("pop from an empty deque")
+
+         return self._take(value)
+
+     def popleft(self):
+         """D.popleft() -> obj -- remove and return the leftmost
+         object. Raises IndexError if the deque is empty.
+         """
+         cdef generic_ptr value = NULL
+         assert self._deque is not NULL
+
+         if deque.deque_pop_front(self._deque, &value) != 0:
+             raise IndexError("pop from an empty deque")
+
+         return self._take(value)
+
+     def extend(self, iterable):
+         """D.extend(iterable) -- add all objects from iterable to the
+         right side, a block at a time
+         """
+         cdef Py_ssize_t i, n
+         cdef PyObject** items
+         assert self._deque is not NULL
+
+         fast = PySequence_Fast(iterable, "Iterable sequence expected")
+         n = PySequence_Fast_GET_SIZE(fast)
+         items = PySequence_Fast_ITEMS(fast)
+
+         if deque.deque_extend_back(self._deque, <generic_dptr> items, n) != 0:
+             raise MemoryError()
+
+         # explicit reference counting increment
+         for i from 0 <= i < n:
+             Py_INCREF(<object> items[i])
+
+     def extendleft(self, iterable):
+         """D.extendleft(iterable) -- add all objects from iterable to
+         the left side, in reverse order
+         """
+         cdef Py_ssize_t i, n
+         cdef PyObject** items
+         assert self._deque is not NULL
+
+         fast = PySequence_Fast(iterable, "Iterable sequence expected")
+         n = PySequence_Fast_GET_SIZE(fast)
+         items = PySequence_Fast_ITEMS(fast)
+
+         if deque.deque_extend_front(self._deque, <generic_dptr> items, n) != 0:
+             raise MemoryError()
+
+         # explicit reference counting increment
+         for i from 0 <= i < n:
+             Py_INCREF(<object> items[i])
+
+     def popmany(self, Py_ssize_t n, right=False):
+         """D.popmany(n[, right]) -> list -- remove and return up to n
+         objects from the left side (the right side if right is true),
+         in the order they are popped
+         """
+         cdef PyObject** items
+         assert self._deque is not NULL
+
+         n = min(max(n, 0), deque.deque_n(self._deque))
+
+         # the list takes over the references held by the deque
+         res_list = PyList_New(n)
+         items = PySequence_Fast_ITEMS(res_list)
+         if right:
+             deque.deque_pop_many_back(self._deque, <generic_dptr> items, n)
+         else:
+             deque.deque_pop_many_front(self._deque, <generic_dptr> items, n)
+
+         return res_list
+
+     def clear(self):
+         """D.clear() -> None.  Remove all objects from D.
+         """
+         assert self._deque is not NULL
+         deque.deque_clear(self._deque)
+
+cdef class Stack(Deque):
+     """A LIFO stack, objects are pushed and popped at the right side
+     of a Deque
+     """
+     def push(self, object obj):
+         """S.push(obj) -- push obj on top of the stack
+         """
+         Deque.append(self, obj)
+
+     def top(self):
+         """S.top() -> obj -- the object on top of the stack. Raises
+         IndexError if the stack is empty.
+         """
+         cdef generic_ptr value = NULL
+         assert self._deque is not NULL
+
+         if deque.deque_peek_back(self._deque, &value) != 0:
+             raise IndexError("top of an empty stack")
+
+         return <object> value
+
+cdef class Queue(Deque):
+     """A FIFO queue, objects are put at the right side of a Deque and
+     got from the left side
+     """
+     def put(self, object obj):
+         """Q.put(obj) -- put obj at the end of the queue
+         """
+         Deque.append(self, obj)
+
+     def get(self):
+         """Q.get() -> obj -- remove and return the object at the head
+         of the queue. Raises IndexError if the queue is empty.
+         """
+         return Deque.popleft(self)
+
+     def peek(self):
+         """Q.peek() -> obj -- the object at the head of the queue.
+         Raises IndexError if the queue is empty.
+         """
+         cdef generic_ptr value = NULL
+         assert self._deque is not NULL
+
+         if deque.deque_peek_front(self._deque, &value) != 0:
+             raise IndexError("peek into an empty queue")
+
+         return <object> value
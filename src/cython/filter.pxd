@@ -0,0 +1,164 @@
+# file: filter.pxd
+cdef extern from "filter/bloom.h":
+
+    ctypedef struct bloom_t:
+        pass
+    ctypedef bloom_t* bloom_ptr
+
+    # constructors
+    bloom_ptr bloom_init(size_t capacity,
+                         double fpp)
+
+    # destructors
+    void bloom_deinit(bloom_ptr bloom) nogil
+
+    void bloom_clear(bloom_ptr bloom) nogil
+
+    # keys are hashes
+    void bloom_add(bloom_ptr bloom,
+                   unsigned long long hash) nogil
+
+    int bloom_contains(bloom_ptr bloom,
+                       unsigned long long hash) nogil
+
+    size_t bloom_n(bloom_ptr bloom) nogil
+
+cdef extern from "filter/cuckoo.h":
+
+    ctypedef struct cuckoo_t:
+        pass
+    ctypedef cuckoo_t* cuckoo_ptr
+
+    # constants
+    int CUCKOO_OK
+    int CUCKOO_NOT_FOUND
+    int CUCKOO_FULL
+
+    # constructors
+    cuckoo_ptr cuckoo_init(size_t capacity)
+
+    # destructors
+    void cuckoo_deinit(cuckoo_ptr cuckoo) nogil
+
+    void cuckoo_clear(cuckoo_ptr cuckoo) nogil
+
+    # keys are hashes
+    int cuckoo_add(cuckoo_ptr cuckoo,
+                   unsigned long long hash) nogil
+
+    int cuckoo_contains(cuckoo_ptr cuckoo,
+                        unsigned long long hash) nogil
+
+    int cuckoo_remove(cuckoo_ptr cuckoo,
+                      unsigned long long hash) nogil
+
+    size_t cuckoo_n(cuckoo_ptr cuckoo) nogil
+
+cdef extern from "filter/hll.h":
+
+    ctypedef struct hll_t:
+        pass
+    ctypedef hll_t* hll_ptr
+
+    # constants
+    int HLL_MIN_P
+    int HLL_MAX_P
+
+    int HLL_OK
+    int HLL_OUT_OF_MEM
+    int HLL_MISMATCH
+    int HLL_BAD_FORMAT
+
+    # constructors
+    hll_ptr hll_init(unsigned p)
+
+    # destructors
+    void hll_deinit(hll_ptr hll) nogil
+
+    void hll_clear(hll_ptr hll) nogil
+
+    # keys are hashes
+    int hll_add(hll_ptr hll,
+                unsigned long long hash) nogil
+
+    int hll_add_batch(hll_ptr hll,
+                      unsigned long long* hashes,
+                      size_t n) nogil
+
+    double hll_count(hll_ptr hll) nogil
+
+    int hll_merge(hll_ptr hll,
+                  hll_ptr other) nogil
+
+    unsigned hll_precision(hll_ptr hll)
+    int hll_is_sparse(hll_ptr hll) nogil
+
+    # serialization
+    size_t hll_serialized_size(hll_ptr hll) nogil
+
+    size_t hll_serialize(hll_ptr hll,
+                         unsigned char* buf) nogil
+
+    int hll_deserialize(unsigned char* buf,
+                        size_t len,
+                        hll_ptr* res)
+
+cdef extern from "filter/cms.h":
+
+    ctypedef struct cms_t:
+        pass
+    ctypedef cms_t* cms_ptr
+
+    # constants
+    int CMS_COUNT_MIN
+    int CMS_COUNT_SKETCH
+
+    int CMS_OK
+    int CMS_OUT_OF_MEM
+    int CMS_MISMATCH
+    int CMS_BAD_FORMAT
+
+    # constructors
+    cms_ptr cms_init(size_t width,
+                     unsigned depth,
+                     int kind)
+
+    # destructors
+    void cms_deinit(cms_ptr cms) nogil
+
+    void cms_clear(cms_ptr cms) nogil
+
+    # keys are hashes
+    void cms_add(cms_ptr cms,
+                 unsigned long long hash,
+                 long long count) nogil
+
+    void cms_add_batch(cms_ptr cms,
+                       unsigned long long* hashes,
+                       long long* counts,
+                       size_t n) nogil
+
+    long long cms_estimate(cms_ptr cms,
+                           unsigned long long hash) nogil
+
+    void cms_estimate_batch(cms_ptr cms,
+                            unsigned long long* hashes,
+                            long long* estimates,
+                            size_t n) nogil
+
+    int cms_merge(cms_ptr cms,
+                  cms_ptr other) nogil
+
+    long long cms_total(cms_ptr cms) nogil
+    size_t cms_width(cms_ptr cms)
+    unsigned cms_depth(cms_ptr cms)
+
+    # serialization
+    size_t cms_serialized_size(cms_ptr cms) nogil
+
+    size_t cms_serialize(cms_ptr cms,
+                         unsigned char* buf) nogil
+
+    int cms_deserialize(unsigned char* buf,
+                        size_t len,
+                        cms_ptr* res)
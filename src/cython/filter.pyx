@@ -0,0 +1,637 @@
+# file: filter.pyx
+cimport filter
+cimport lock
+
+import numpy as np
+cimport numpy as np
+
+np.import_array()
+
+cdef extern from "Python.h":
+    object PyBytes_FromStringAndSize(char* s, Py_ssize_t len)
+    char* PyBytes_AS_STRING(object obj)
+
+# the hashes of the objects of an iterable, as an array
+cdef np.ndarray hashes_of(objs):
+    return np.array([hash(obj) for obj in objs],
+                    dtype=np.int64).view(np.uint64)
+
+cdef lock.lock_ptr lock_of(locked) except? NULL:
+    cdef lock.lock_ptr res = lock.lock_init(1 if locked else 0)
+    if locked and res is NULL:
+        raise MemoryError()
+    return res
+
+cdef class BloomFilter(object):
+     """A Bloom filter of hashable objects: membership tests may give
+     false positives (about fpp of them), never false negatives.
+     Objects can not be removed. With locked=True, several Python
+     threads can share the filter, tests running in parallel.
+     """
+     cdef filter.bloom_ptr _bloom
+     cdef lock.lock_ptr _lock
+
+     def __cinit__(self, size_t capacity, double fpp=0.01, locked=False):
+         """C ctor, room for capacity objects at the given rate of
+         false positives
+         """
+         self._bloom = filter.bloom_init(capacity, fpp)
+         if self._bloom is NULL:
+             raise MemoryError()
+         self._lock = lock_of(locked)
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._bloom is not NULL:
+             with nogil:
+                 filter.bloom_deinit(self._bloom)
+         lock.lock_deinit(self._lock)
+
+     def __len__(self):
+         """x.__len__() <==> len(x), the number of objects added
+         """
+         cdef size_t res
+         assert self._bloom is not NULL
+
+         if self._lock is NULL:
+             res = filter.bloom_n(self._bloom)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = filter.bloom_n(self._bloom)
+                 lock.lock_release(self._lock)
+
+         return res
+
+     def __contains__(self, object obj):
+         """__contains__(x) -> False if x was never added, True if it
+         probably was
+         """
+         cdef unsigned long long h = <unsigned long long> <long long> hash(obj)
+         cdef int res
+         assert self._bloom is not NULL
+
+         if self._lock is NULL:
+             res = filter.bloom_contains(self._bloom, h)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = filter.bloom_contains(self._bloom, h)
+                 lock.lock_release(self._lock)
+
+         return res != 0
+
+     def add(self, object obj):
+         """F.add(x) -- add x to the filter
+         """
+         cdef unsigned long long h = <unsigned long long> <long long> hash(obj)
+         assert self._bloom is not NULL
+
+         if self._lock is NULL:
+             filter.bloom_add(self._bloom, h)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 filter.bloom_add(self._bloom, h)
+                 lock.lock_release(self._lock)
+
+     def clear(self):
+         """F.clear() -> None.  Remove all objects from F.
+         """
+         assert self._bloom is not NULL
+
+         if self._lock is NULL:
+             filter.bloom_clear(self._bloom)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 filter.bloom_clear(self._bloom)
+                 lock.lock_release(self._lock)
+
+cdef class CuckooFilter(object):
+     """A cuckoo filter of hashable objects: like a Bloom filter, with
+     fewer false positives (about 0.012%), and objects can be removed.
+     With locked=True, several Python threads can share the filter,
+     tests running in parallel.
+     """
+     cdef filter.cuckoo_ptr _cuckoo
+     cdef lock.lock_ptr _lock
+
+     def __cinit__(self, size_t capacity, locked=False):
+         """C ctor, room for (at least) capacity objects
+         """
+         self._cuckoo = filter.cuckoo_init(capacity)
+         if self._cuckoo is NULL:
+             raise MemoryError()
+         self._lock = lock_of(locked)
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._cuckoo is not NULL:
+             with nogil:
+                 filter.cuckoo_deinit(self._cuckoo)
+         lock.lock_deinit(self._lock)
+
+     def __len__(self):
+         """x.__len__() <==> len(x), the number of objects in F
+         """
+         cdef size_t res
+         assert self._cuckoo is not NULL
+
+         if self._lock is NULL:
+             res = filter.cuckoo_n(self._cuckoo)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = filter.cuckoo_n(self._cuckoo)
+                 lock.lock_release(self._lock)
+
+         return res
+
+     def __contains__(self, object obj):
+         """__contains__(x) -> False if x is not in F, True if it
+         probably is
+         """
+         cdef unsigned long long h = <unsigned long long> <long long> hash(obj)
+         cdef int res
+         assert self._cuckoo is not NULL
+
+         if self._lock is NULL:
+             res = filter.cuckoo_contains(self._cuckoo, h)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = filter.cuckoo_contains(self._cuckoo, h)
+                 lock.lock_release(self._lock)
+
+         return res != 0
+
+     def add(self, object obj):
+         """F.add(x) -- add x to the filter. Raises OverflowError if
+         the filter is full.
+         """
+         cdef unsigned long long h = <unsigned long long> <long long> hash(obj)
+         cdef int res
+         assert self._cuckoo is not NULL
+
+         if self._lock is NULL:
+             res = filter.cuckoo_add(self._cuckoo, h)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = filter.cuckoo_add(self._cuckoo, h)
+                 lock.lock_release(self._lock)
+
+         if res != filter.CUCKOO_OK:
+             raise OverflowError("cuckoo filter is full")
+
+     def remove(self, object obj):
+         """F.remove(x) -- remove x, which must have been added before.
+         Raises KeyError if x is not in F.
+         """
+         cdef unsigned long long h = <unsigned long long> <long long> hash(obj)
+         cdef int res
+         assert self._cuckoo is not NULL
+
+         if self._lock is NULL:
+             res = filter.cuckoo_remove(self._cuckoo, h)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = filter.cuckoo_remove(self._cuckoo, h)
+                 lock.lock_release(self._lock)
+
+         if res != filter.CUCKOO_OK:
+             raise KeyError(obj)
+
+     def clear(self):
+         """F.clear() -> None.  Remove all objects from F.
+         """
+         assert self._cuckoo is not NULL
+
+         if self._lock is NULL:
+             filter.cuckoo_clear(self._cuckoo)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 filter.cuckoo_clear(self._cuckoo)
+                 lock.lock_release(self._lock)
+
+cdef class HyperLogLog(object):
+     """A HyperLogLog counter of distinct hashable objects, in 2^p bytes
+     at most (p from 4 to 18), with a relative error of about 1.04 /
+     sqrt(2^p). Small counts are kept exactly, in less memory.
+     Counters of the same precision merge into the count of the union.
+     With locked=True, several Python threads can share the counter.
+     """
+     cdef filter.hll_ptr _hll
+     cdef lock.lock_ptr _lock
+
+     def __cinit__(self, unsigned p=14, locked=False, *args, **kwargs):
+         """C ctor
+         """
+         if p < filter.HLL_MIN_P or p > filter.HLL_MAX_P:
+             raise ValueError("precision out of range")
+         self._hll = filter.hll_init(p)
+         if self._hll is NULL:
+             raise MemoryError()
+         self._lock = lock_of(locked)
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._hll is not NULL:
+             with nogil:
+                 filter.hll_deinit(self._hll)
+         lock.lock_deinit(self._lock)
+
+     def __len__(self):
+         """x.__len__() <==> len(x), the estimated number of distinct
+         objects added
+         """
+         return int(self.count() + 0.5)
+
+     property p:
+         """the precision
+         """
+         def __get__(self):
+             return filter.hll_precision(self._hll)
+
+     property sparse:
+         """whether the sparse representation is still in use
+         """
+         def __get__(self):
+             cdef int res
+
+             if self._lock is NULL:
+                 res = filter.hll_is_sparse(self._hll)
+             else:
+                 with nogil:
+                     lock.lock_read(self._lock)
+                     res = filter.hll_is_sparse(self._hll)
+                     lock.lock_release(self._lock)
+
+             return res != 0
+
+     def count(self):
+         """H.count() -> the estimated number of distinct objects added
+         """
+         cdef double res
+
+         if self._lock is NULL:
+             res = filter.hll_count(self._hll)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = filter.hll_count(self._hll)
+                 lock.lock_release(self._lock)
+
+         return res
+
+     def add(self, object obj):
+         """H.add(x) -- add x to the counter
+         """
+         cdef unsigned long long h = <unsigned long long> <long long> hash(obj)
+         cdef int res
+
+         if self._lock is NULL:
+             res = filter.hll_add(self._hll, h)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = filter.hll_add(self._hll, h)
+                 lock.lock_release(self._lock)
+
+         if res != filter.HLL_OK:
+             raise MemoryError()
+
+     def update(self, objs):
+         """H.update(iterable) -- add all the objects of an iterable
+         """
+         self.add_hashes(hashes_of(objs))
+
+     def add_hashes(self, hashes):
+         """H.add_hashes(hashes) -- add a NumPy array (or sequence) of
+         64-bit hashes, natively (and without the GIL if locked)
+         """
+         cdef int res
+         cdef size_t n
+         cdef np.ndarray[np.uint64_t, ndim=1, mode="c"] h
+
+         h = np.ascontiguousarray(hashes, dtype=np.uint64)
+         n = len(h)
+         if self._lock is NULL:
+             res = filter.hll_add_batch(self._hll,
+                                        <unsigned long long*> h.data, n)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = filter.hll_add_batch(self._hll,
+                                            <unsigned long long*> h.data, n)
+                 lock.lock_release(self._lock)
+         if res != filter.HLL_OK:
+             raise MemoryError()
+
+     def merge(self, HyperLogLog other not None):
+         """H.merge(other) -- add the objects counted by other
+         """
+         cdef int res
+
+         if self._lock is NULL or other._lock is NULL:
+             # an unlocked side is only safe under the GIL
+             lock.lock_write_read(self._lock, other._lock)
+             res = filter.hll_merge(self._hll, other._hll)
+             lock.lock_release_both(self._lock, other._lock)
+         else:
+             with nogil:
+                 lock.lock_write_read(self._lock, other._lock)
+                 res = filter.hll_merge(self._hll, other._hll)
+                 lock.lock_release_both(self._lock, other._lock)
+
+         if res == filter.HLL_MISMATCH:
+             raise ValueError("counters of different precisions")
+         if res != filter.HLL_OK:
+             raise MemoryError()
+
+     def clear(self):
+         """H.clear() -> None.  Reset H to no objects.
+         """
+         if self._lock is NULL:
+             filter.hll_clear(self._hll)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 filter.hll_clear(self._hll)
+                 lock.lock_release(self._lock)
+
+     def to_bytes(self):
+         """H.to_bytes() -> the counter in a portable binary form, for
+         HyperLogLog.from_bytes
+         """
+         cdef size_t size = 0
+         cdef unsigned char* buf
+
+         # the size may change until the lock is taken
+         while True:
+             res = PyBytes_FromStringAndSize(NULL, size)
+             buf = <unsigned char*> PyBytes_AS_STRING(res)
+             if self._lock is NULL:
+                 if filter.hll_serialized_size(self._hll) == size:
+                     filter.hll_serialize(self._hll, buf)
+                 else:
+                     size = filter.hll_serialized_size(self._hll)
+                     buf = NULL
+             else:
+                 with nogil:
+                     lock.lock_read(self._lock)
+                     if filter.hll_serialized_size(self._hll) == size:
+                         filter.hll_serialize(self._hll, buf)
+                     else:
+                         size = filter.hll_serialized_size(self._hll)
+                         buf = NULL
+                     lock.lock_release(self._lock)
+             if buf is not NULL:
+                 return res
+
+     @staticmethod
+     def from_bytes(bytes data not None, locked=False):
+         """HyperLogLog.from_bytes(data[, locked]) -> HyperLogLog -- a
+         counter from its to_bytes form. Raises ValueError on malformed
+         data.
+         """
+         cdef HyperLogLog res
+         cdef filter.hll_ptr hll
+         cdef int err
+
+         err = filter.hll_deserialize(<unsigned char*> PyBytes_AS_STRING(data),
+                                      len(data), &hll)
+         if err == filter.HLL_BAD_FORMAT:
+             raise ValueError("malformed HyperLogLog data")
+         if err != filter.HLL_OK:
+             raise MemoryError()
+
+         res = HyperLogLog(filter.hll_precision(hll), locked)
+         filter.hll_deinit(res._hll)
+         res._hll = hll
+         return res
+
+cdef class CountMinSketch(object):
+     """Approximate counts of hashable objects in fixed memory: depth
+     rows of width counters. Estimates are never below the true counts,
+     and above by at most e / width of the total, with probability
+     1 - exp(-depth). With signed=True it is a Count sketch instead,
+     whose estimates are unbiased and allow negative counts. Sketches
+     of the same shape and kind merge by adding up their counts.
+     With locked=True, several Python threads can share the sketch,
+     estimates running in parallel.
+     """
+     cdef filter.cms_ptr _cms
+     cdef lock.lock_ptr _lock
+
+     def __cinit__(self, size_t width=2048, unsigned depth=5,
+                   object signed=False, locked=False, *args, **kwargs):
+         """C ctor, width is rounded up to a power of 2
+         """
+         self._cms = filter.cms_init(width, depth,
+                                     filter.CMS_COUNT_SKETCH if signed
+                                     else filter.CMS_COUNT_MIN)
+         if self._cms is NULL:
+             if depth == 0 or depth > 32:
+                 raise ValueError("depth out of range")
+             raise MemoryError()
+         self._lock = lock_of(locked)
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._cms is not NULL:
+             with nogil:
+                 filter.cms_deinit(self._cms)
+         lock.lock_deinit(self._lock)
+
+     property width:
+         """the number of counters per row
+         """
+         def __get__(self):
+             return filter.cms_width(self._cms)
+
+     property depth:
+         """the number of rows
+         """
+         def __get__(self):
+             return filter.cms_depth(self._cms)
+
+     property total:
+         """the sum of all the counts added
+         """
+         def __get__(self):
+             cdef long long res
+
+             if self._lock is NULL:
+                 res = filter.cms_total(self._cms)
+             else:
+                 with nogil:
+                     lock.lock_read(self._lock)
+                     res = filter.cms_total(self._cms)
+                     lock.lock_release(self._lock)
+
+             return res
+
+     def __getitem__(self, object obj):
+         """x.__getitem__(y) <==> x[y], the estimated count of y
+         """
+         cdef unsigned long long h = <unsigned long long> <long long> hash(obj)
+         cdef long long res
+
+         if self._lock is NULL:
+             res = filter.cms_estimate(self._cms, h)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = filter.cms_estimate(self._cms, h)
+                 lock.lock_release(self._lock)
+
+         return res
+
+     def add(self, object obj, long long count=1):
+         """S.add(x[, count]) -- count x (count more times)
+         """
+         cdef unsigned long long h = <unsigned long long> <long long> hash(obj)
+
+         if self._lock is NULL:
+             filter.cms_add(self._cms, h, count)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 filter.cms_add(self._cms, h, count)
+                 lock.lock_release(self._lock)
+
+     def update(self, objs):
+         """S.update(iterable) -- count all the objects of an iterable
+         """
+         self.add_hashes(hashes_of(objs))
+
+     def add_hashes(self, hashes, counts=None):
+         """S.add_hashes(hashes[, counts]) -- count a NumPy array (or
+         sequence) of 64-bit hashes, each once or by the matching entry
+         of counts, natively (and without the GIL if locked)
+         """
+         cdef size_t n
+         cdef np.ndarray[np.uint64_t, ndim=1, mode="c"] h
+         cdef np.ndarray[np.int64_t, ndim=1, mode="c"] c
+         cdef long long* cp = NULL
+
+         h = np.ascontiguousarray(hashes, dtype=np.uint64)
+         n = len(h)
+         if counts is not None:
+             c = np.ascontiguousarray(counts, dtype=np.int64)
+             if len(c) != n:
+                 raise ValueError("counts and hashes differ in length")
+             cp = <long long*> c.data
+
+         if self._lock is NULL:
+             filter.cms_add_batch(self._cms, <unsigned long long*> h.data,
+                                  cp, n)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 filter.cms_add_batch(self._cms, <unsigned long long*> h.data,
+                                      cp, n)
+                 lock.lock_release(self._lock)
+
+     def estimate_hashes(self, hashes):
+         """S.estimate_hashes(hashes) -> array of the estimated counts of
+         a NumPy array (or sequence) of 64-bit hashes
+         """
+         cdef size_t n
+         cdef np.ndarray[np.uint64_t, ndim=1, mode="c"] h
+         cdef np.ndarray[np.int64_t, ndim=1, mode="c"] res
+
+         h = np.ascontiguousarray(hashes, dtype=np.uint64)
+         n = len(h)
+         res = np.empty(n, dtype=np.int64)
+         if self._lock is NULL:
+             filter.cms_estimate_batch(self._cms,
+                                       <unsigned long long*> h.data,
+                                       <long long*> res.data, n)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 filter.cms_estimate_batch(self._cms,
+                                           <unsigned long long*> h.data,
+                                           <long long*> res.data, n)
+                 lock.lock_release(self._lock)
+         return res
+
+     def merge(self, CountMinSketch other not None):
+         """S.merge(other) -- add the counts of other
+         """
+         cdef int res
+
+         if self._lock is NULL or other._lock is NULL:
+             # an unlocked side is only safe under the GIL
+             lock.lock_write_read(self._lock, other._lock)
+             res = filter.cms_merge(self._cms, other._cms)
+             lock.lock_release_both(self._lock, other._lock)
+         else:
+             with nogil:
+                 lock.lock_write_read(self._lock, other._lock)
+                 res = filter.cms_merge(self._cms, other._cms)
+                 lock.lock_release_both(self._lock, other._lock)
+
+         if res != filter.CMS_OK:
+             raise ValueError("sketches of different shapes or kinds")
+
+     def clear(self):
+         """S.clear() -> None.  Reset all counts to 0.
+         """
+         if self._lock is NULL:
+             filter.cms_clear(self._cms)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 filter.cms_clear(self._cms)
+                 lock.lock_release(self._lock)
+
+     def to_bytes(self):
+         """S.to_bytes() -> the sketch in a portable binary form, for
+         CountMinSketch.from_bytes
+         """
+         cdef size_t size = filter.cms_serialized_size(self._cms)
+         cdef unsigned char* buf
+
+         # the shape is fixed, only the counts need the lock
+         res = PyBytes_FromStringAndSize(NULL, size)
+         buf = <unsigned char*> PyBytes_AS_STRING(res)
+         if self._lock is NULL:
+             filter.cms_serialize(self._cms, buf)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 filter.cms_serialize(self._cms, buf)
+                 lock.lock_release(self._lock)
+         return res
+
+     @staticmethod
+     def from_bytes(bytes data not None, locked=False):
+         """CountMinSketch.from_bytes(data[, locked]) -> CountMinSketch
+         -- a sketch from its to_bytes form. Raises ValueError on
+         malformed data.
+         """
+         cdef CountMinSketch res
+         cdef filter.cms_ptr cms
+         cdef int err
+
+         err = filter.cms_deserialize(<unsigned char*> PyBytes_AS_STRING(data),
+                                      len(data), &cms)
+         if err == filter.CMS_BAD_FORMAT:
+             raise ValueError("malformed CountMinSketch data")
+         if err != filter.CMS_OK:
+             raise MemoryError()
+
+         res = CountMinSketch(1, 1, locked=locked)
+         filter.cms_deinit(res._cms)
+         res._cms = cms
+         return res
@@ -0,0 +1,73 @@
+# file: graph.pxd
+cdef extern from "graph/graph.h":
+
+    ctypedef struct graph_t:
+        pass
+    ctypedef graph_t* graph_ptr
+
+    ctypedef struct graph_builder_t:
+        pass
+    ctypedef graph_builder_t* graph_builder_ptr
+
+    # constants
+    int GRAPH_OK
+    int GRAPH_OUT_OF_BOUNDS
+    int GRAPH_OUT_OF_MEM
+    int GRAPH_BAD_WEIGHT
+
+    unsigned GRAPH_NONE
+
+    # constructors
+    graph_ptr graph_from_edges(unsigned n,
+                               int directed,
+                               unsigned* sources,
+                               unsigned* targets,
+                               double* weights,
+                               size_t m) nogil
+
+    # destructors
+    void graph_deinit(graph_ptr graph) nogil
+
+    # size
+    unsigned graph_n(graph_ptr graph)
+    size_t graph_m(graph_ptr graph)
+    size_t graph_degree(graph_ptr graph,
+                        unsigned node)
+
+    size_t graph_neighbors(graph_ptr graph,
+                           unsigned node,
+                           unsigned** targets,
+                           double** weights)
+
+    # algorithms
+    long graph_bfs(graph_ptr graph,
+                   unsigned source,
+                   unsigned* levels,
+                   unsigned* parents) nogil
+
+    long graph_components(graph_ptr graph,
+                          unsigned* labels) nogil
+
+    int graph_dijkstra(graph_ptr graph,
+                       unsigned source,
+                       double* dist,
+                       unsigned* parents) nogil
+
+    # builders
+    graph_builder_ptr graph_builder_init(unsigned n,
+                                         int directed)
+
+    void graph_builder_deinit(graph_builder_ptr builder) nogil
+
+    int graph_builder_add_edge(graph_builder_ptr builder,
+                               unsigned source,
+                               unsigned target,
+                               double weight) nogil
+
+    int graph_builder_add_edges(graph_builder_ptr builder,
+                                unsigned* sources,
+                                unsigned* targets,
+                                double* weights,
+                                size_t m) nogil
+
+    graph_ptr graph_builder_freeze(graph_builder_ptr builder) nogil
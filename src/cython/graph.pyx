@@ -0,0 +1,290 @@
+# file: graph.pyx
+cimport graph
+cimport lock
+
+import numpy as np
+cimport numpy as np
+
+np.import_array()
+
+# levels and parents of unreached nodes
+NONE = graph.GRAPH_NONE
+
+cdef int check(long res) except -1:
+    if res == graph.GRAPH_OUT_OF_BOUNDS:
+        raise IndexError("node out of range")
+    if res == graph.GRAPH_OUT_OF_MEM:
+        raise MemoryError()
+    if res == graph.GRAPH_BAD_WEIGHT:
+        raise ValueError("negative or NaN edge weight")
+    return 0
+
+cdef class Graph(object):
+     """An immutable graph in compressed sparse row form. Nodes are
+     ints 0 .. n - 1, edges come as NumPy arrays (or sequences) of
+     sources and targets, with optional float weights. Traversals run
+     natively, without the GIL, and return NumPy arrays; so does the
+     build, and the graph needs no locking, being immutable.
+     """
+     cdef graph.graph_ptr _graph
+
+     def __init__(self, sources=None, targets=None, weights=None,
+                  unsigned n=0, directed=False):
+         """Python ctor, n is the minimum number of nodes
+         """
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] s
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] t
+         cdef np.ndarray[np.float64_t, ndim=1, mode="c"] w
+         cdef double* wp = NULL
+         cdef size_t m
+         cdef int dir_ = 1 if directed else 0
+
+         if sources is None:
+             sources = targets = ()
+
+         s = np.ascontiguousarray(sources, dtype=np.uint32)
+         t = np.ascontiguousarray(targets, dtype=np.uint32)
+         if len(s) != len(t):
+             raise ValueError("sources and targets differ in length")
+
+         if weights is not None:
+             w = np.ascontiguousarray(weights, dtype=np.float64)
+             if len(w) != len(s):
+                 raise ValueError("weights and sources differ in length")
+             wp = <double*> w.data
+
+         m = len(s)
+         with nogil:
+             self._graph = graph.graph_from_edges(n, dir_,
+                                                  <unsigned*> s.data,
+                                                  <unsigned*> t.data,
+                                                  wp, m)
+         if self._graph is NULL:
+             raise MemoryError()
+
+     def __cinit__(self, *args, **kwargs):
+         """C ctor
+         """
+         self._graph = NULL
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._graph is not NULL:
+             with nogil:
+                 graph.graph_deinit(self._graph)
+
+     cdef unsigned _node(self, long node) except? 0:
+         if node < 0 or node >= graph.graph_n(self._graph):
+             raise IndexError("node out of range")
+         return node
+
+     def __len__(self):
+         """x.__len__() <==> len(x), the number of nodes
+         """
+         assert self._graph is not NULL
+         return graph.graph_n(self._graph)
+
+     property n_edges:
+         """the number of arcs, undirected edges count twice
+         """
+         def __get__(self):
+             assert self._graph is not NULL
+             return graph.graph_m(self._graph)
+
+     def degree(self, long node):
+         """G.degree(u) -> the number of arcs leaving u
+         """
+         assert self._graph is not NULL
+         return graph.graph_degree(self._graph, self._node(node))
+
+     def neighbors(self, long node):
+         """G.neighbors(u) -> array of the targets of the arcs leaving u
+         """
+         cdef unsigned* targets
+         cdef size_t i, n
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] res
+         assert self._graph is not NULL
+
+         n = graph.graph_neighbors(self._graph, self._node(node),
+                                   &targets, NULL)
+         res = np.empty(n, dtype=np.uint32)
+         for i from 0 <= i < n:
+             res[i] = targets[i]
+
+         return res
+
+     def bfs(self, long source, parents=False):
+         """G.bfs(source[, parents]) -> levels, or (levels, parents) --
+         breadth-first search, NONE marks unreached nodes. Large
+         frontiers are expanded bottom-up, in parallel.
+         """
+         cdef unsigned src
+         cdef long res
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] levels
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] par
+         cdef unsigned* parp = NULL
+         assert self._graph is not NULL
+
+         src = self._node(source)
+         levels = np.empty(len(self), dtype=np.uint32)
+         if parents:
+             par = np.empty(len(self), dtype=np.uint32)
+             parp = <unsigned*> par.data
+
+         with nogil:
+             res = graph.graph_bfs(self._graph, src,
+                                   <unsigned*> levels.data, parp)
+         check(res)
+
+         if parents:
+             return levels, par
+         return levels
+
+     def components(self):
+         """G.components() -> (k, labels) -- (weakly) connected
+         components, labelled 0 .. k - 1 in order of their smallest node
+         """
+         cdef long res
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] labels
+         assert self._graph is not NULL
+
+         labels = np.empty(len(self), dtype=np.uint32)
+         with nogil:
+             res = graph.graph_components(self._graph,
+                                          <unsigned*> labels.data)
+         check(res)
+
+         return res, labels
+
+     def dijkstra(self, long source, parents=False):
+         """G.dijkstra(source[, parents]) -> dist, or (dist, parents) --
+         shortest path distances (inf if unreached) over non-negative
+         weights, unweighted graphs have all weights 1. Raises
+         ValueError on negative or NaN weights.
+         """
+         cdef unsigned src
+         cdef int res
+         cdef np.ndarray[np.float64_t, ndim=1, mode="c"] dist
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] par
+         cdef unsigned* parp = NULL
+         assert self._graph is not NULL
+
+         src = self._node(source)
+         dist = np.empty(len(self), dtype=np.float64)
+         if parents:
+             par = np.empty(len(self), dtype=np.uint32)
+             parp = <unsigned*> par.data
+
+         with nogil:
+             res = graph.graph_dijkstra(self._graph, src,
+                                        <double*> dist.data, parp)
+         check(res)
+
+         if parents:
+             return dist, par
+         return dist
+
+cdef class GraphBuilder(object):
+     """Collects edges, one at a time or in batches, for a Graph.
+     With locked=True, several Python threads can add edges to the
+     same builder, batches and freezes running without the GIL.
+     """
+     cdef graph.graph_builder_ptr _builder
+     cdef lock.lock_ptr _lock
+
+     def __cinit__(self, unsigned n=0, directed=False, locked=False):
+         """C ctor, n is the minimum number of nodes
+         """
+         self._builder = graph.graph_builder_init(n, 1 if directed else 0)
+         if self._builder is NULL:
+             raise MemoryError()
+
+         self._lock = lock.lock_init(1 if locked else 0)
+         if locked and self._lock is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._builder is not NULL:
+             with nogil:
+                 graph.graph_builder_deinit(self._builder)
+         lock.lock_deinit(self._lock)
+
+     def add_edge(self, unsigned source, unsigned target, double weight=1.0):
+         """B.add_edge(u, v[, weight]) -- add the edge u -> v
+         """
+         cdef int res
+         assert self._builder is not NULL
+
+         if self._lock is NULL:
+             res = graph.graph_builder_add_edge(self._builder, source,
+                                                target, weight)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = graph.graph_builder_add_edge(self._builder, source,
+                                                    target, weight)
+                 lock.lock_release(self._lock)
+
+         check(res)
+
+     def add_edges(self, sources, targets, weights=None):
+         """B.add_edges(sources, targets[, weights]) -- add a batch of
+         edges, from arrays or sequences
+         """
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] s
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] t
+         cdef np.ndarray[np.float64_t, ndim=1, mode="c"] w
+         cdef double* wp = NULL
+         cdef size_t m
+         cdef int res
+         assert self._builder is not NULL
+
+         s = np.ascontiguousarray(sources, dtype=np.uint32)
+         t = np.ascontiguousarray(targets, dtype=np.uint32)
+         if len(s) != len(t):
+             raise ValueError("sources and targets differ in length")
+
+         if weights is not None:
+             w = np.ascontiguousarray(weights, dtype=np.float64)
+             if len(w) != len(s):
+                 raise ValueError("weights and sources differ in length")
+             wp = <double*> w.data
+
+         m = len(s)
+         if self._lock is NULL:
+             res = graph.graph_builder_add_edges(self._builder,
+                                                 <unsigned*> s.data,
+                                                 <unsigned*> t.data,
+                                                 wp, m)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = graph.graph_builder_add_edges(self._builder,
+                                                     <unsigned*> s.data,
+                                                     <unsigned*> t.data,
+                                                     wp, m)
+                 lock.lock_release(self._lock)
+
+         check(res)
+
+     def freeze(self):
+         """B.freeze() -> Graph -- build a graph of the edges so far.
+         The builder can be reused.
+         """
+         cdef Graph res = Graph.__new__(Graph)
+         assert self._builder is not NULL
+
+         if self._lock is NULL:
+             res._graph = graph.graph_builder_freeze(self._builder)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res._graph = graph.graph_builder_freeze(self._builder)
+                 lock.lock_release(self._lock)
+         if res._graph is NULL:
+             raise MemoryError()
+
+         return res
@@ -28,6 +28,11 @@ cdef extern from "ht/ht.h":
     ctypedef unsigned (*hash_func_ptr)(generic_ptr a,
                                        generic_ptr b)
 
+    # filters
+    int HT_FILTER_NONE
+    int HT_FILTER_BLOOM
+    int HT_FILTER_CUCKOO
+
     # ctors/dctors
     ht_ptr ht_init(hash_func_ptr hash,
                    cmp_func_ptr compare,
@@ -46,9 +51,14 @@ cdef extern from "ht/ht.h":
     generic_ptr ht_iter_next(ht_iterator_ptr iter_,
                              generic_dptr value_p)
 
+    int ht_iter_changed(ht_iterator_ptr iter_)
+
     # number of entries
     size_t ht_count(ht_ptr ht)
 
+    int ht_reserve(ht_ptr ht,
+                   size_t n)
+
     # deletion
     int ht_delete (ht_ptr ht,
                    generic_ptr key_p)
@@ -61,3 +71,7 @@ cdef extern from "ht/ht.h":
     # find element
     generic_ptr ht_find (ht_ptr hash,
                          generic_ptr key)
+
+    # negative lookups
+    int ht_set_filter(ht_ptr hash,
+                      int filter)
@@ -1,70 +1,239 @@
 # file: ht.pyx
 cimport ht
+from keys cimport keys_hash, keys_cmp
 
 cdef extern from "Python.h":
+    ctypedef void PyObject
     cdef void Py_INCREF(obj)
     cdef void Py_DECREF(obj)
-
-cdef int cmp_callback(object a, object b):
-    return cmp(a, b)
-
-cdef int hash_callback(object a):
-    return hash(a)
+    cdef bint PyDict_Check(object o)
+    cdef int PyDict_Next(object p, Py_ssize_t* pos,
+                         PyObject** key, PyObject** value)
+    cdef bint PyList_Check(object o)
+    cdef bint PyTuple_Check(object o)
+    cdef object PySequence_Fast(object o, char* m)
+    cdef Py_ssize_t PySequence_Fast_GET_SIZE(object o)
+    cdef PyObject** PySequence_Fast_ITEMS(object o)
+    cdef object PyList_New(Py_ssize_t n)
 
 cdef void free_callback(object obj):
     Py_DECREF(obj)
 
+_filters = {
+    None: ht.HT_FILTER_NONE,
+    'bloom': ht.HT_FILTER_BLOOM,
+    'cuckoo': ht.HT_FILTER_CUCKOO,
+}
+
+cdef class Ht
+
+# what iterators and views yield
+cdef enum:
+    ITEMS = 0
+    KEYS = 1
+    VALUES = 2
+
+cdef inline object item_of(int kind, generic_ptr key, generic_ptr value):
+    if kind == KEYS:
+        return <object> key
+    if kind == VALUES:
+        return <object> value
+
+    # hold both before the tuple is allocated, which may run the gc
+    k = <object> key
+    v = <object> value
+    return (k, v)
+
 cdef class HtIterator(object):
     cdef ht.ht_iterator_ptr _iterator
+    cdef Ht _owner
+    cdef int _kind
 
-    def __init__(self, Ht obj):
+    def __init__(self, Ht obj, int kind=ITEMS):
         self._iterator = ht.ht_iter(obj._hash)
         if self._iterator is NULL:
             raise MemoryError()
+        self._owner = obj
+        self._kind = kind
 
     def __dealloc__(self):
-        assert self._iterator is not NULL
-        ht.ht_iter_deinit(self._iterator)
+        if self._iterator is not NULL:
+            ht.ht_iter_deinit(self._iterator)
 
     def __iter__(self):
         return self
 
     def __next__(self):
-        cdef int res
         cdef generic_ptr key = NULL
         cdef generic_ptr value = NULL
         assert self._iterator is not NULL
 
+        if ht.ht_iter_changed(self._iterator):
+            raise RuntimeError("Ht changed size during iteration")
+
         key = ht.ht_iter_next(self._iterator, &value)
         if (key == NULL):
             raise StopIteration()
 
-        return (<object> key, <object> value)
+        return item_of(self._kind, key, value)
+
+cdef class HtView(object):
+    """A live view of the keys, values or items of a Ht, iterated
+    without building intermediate lists
+    """
+    cdef Ht _owner
+    cdef int _kind
+
+    def __len__(self):
+        return ht.ht_count(self._owner._hash)
+
+    def __iter__(self):
+        return HtIterator(self._owner, self._kind)
+
+cdef class HtKeysView(HtView):
+    def __init__(self, Ht obj):
+        self._owner = obj
+        self._kind = KEYS
+
+    def __contains__(self, key):
+        return key in self._owner
+
+cdef class HtValuesView(HtView):
+    def __init__(self, Ht obj):
+        self._owner = obj
+        self._kind = VALUES
+
+    def __contains__(self, value):
+        for v in HtIterator(self._owner, VALUES):
+            if v is value or v == value:
+                return True
+        return False
+
+cdef class HtItemsView(HtView):
+    def __init__(self, Ht obj):
+        self._owner = obj
+        self._kind = ITEMS
+
+    def __contains__(self, item):
+        cdef generic_ptr res
+        (key, value) = item
+
+        res = ht.ht_find(self._owner._hash, <generic_ptr> key)
+        if res == NULL:
+            return False
+        return <object> res is value or <object> res == value
+
+cdef list_of(Ht obj, int kind):
+    # fill a list of the final length straight from the C iterator.
+    # Making the items may run the gc, and __del__ methods may change
+    # the table: the list then goes, NULL slots and all
+    cdef Py_ssize_t i, n
+    cdef generic_ptr key = NULL
+    cdef generic_ptr value = NULL
+    cdef PyObject** items
+    cdef ht.ht_iterator_ptr iter_
+
+    n = ht.ht_count(obj._hash)
+    res = PyList_New(n)
+    items = PySequence_Fast_ITEMS(res)
+
+    iter_ = ht.ht_iter(obj._hash)
+    if iter_ is NULL:
+        raise MemoryError()
+
+    try:
+        for i from 0 <= i < n:
+            key = ht.ht_iter_next(iter_, &value)
+            if key is NULL:
+                raise RuntimeError("Ht changed size during iteration")
+            item = item_of(kind, key, value)
+
+            # the list owns a reference to each item
+            Py_INCREF(item)
+            items[i] = <PyObject*> item
+
+        if ht.ht_iter_changed(iter_):
+            raise RuntimeError("Ht changed size during iteration")
+    finally:
+        ht.ht_iter_deinit(iter_)
+
+    return res
 
 cdef class Ht(object):
      cdef ht.ht_ptr _hash
 
-     def __init__(self, seq=None):
-         """Python ctor
+     def __init__(self, seq=None, filter=None):
+         """Python ctor, filter is None, 'bloom' or 'cuckoo' (see
+         set_filter)
          """
+         self.set_filter(filter)
+
          if seq is not None:
+             self._load(seq)
+
+     cdef int _insert(self, object key, object value) except -1:
+         # explicit reference counting increment
+         Py_INCREF(key)
+         Py_INCREF(value)
+
+         if ht.ht_insert(self._hash,
+                         <generic_ptr> key,
+                         <generic_ptr> value) == 0:
+             Py_DECREF(key)
+             Py_DECREF(value)
+             raise MemoryError()
+
+         return 0
+
+     cdef _load(self, seq):
+         # dicts, lists and tuples are walked in C, with the table
+         # grown once up front rather than on the way
+         cdef Py_ssize_t i, n, pos = 0
+         cdef PyObject* key
+         cdef PyObject* value
+         cdef PyObject** items
+         assert self._hash is not NULL
+
+         if PyDict_Check(seq):
+             if ht.ht_reserve(self._hash,
+                              ht.ht_count(self._hash) + len(seq)) == 0:
+                 raise MemoryError()
+
+             while PyDict_Next(seq, &pos, &key, &value):
+                 self._insert(<object> key, <object> value)
+
+         elif PyList_Check(seq) or PyTuple_Check(seq):
+             fast = PySequence_Fast(seq, "Iterable sequence expected")
+             n = PySequence_Fast_GET_SIZE(fast)
+             items = PySequence_Fast_ITEMS(fast)
+
+             if ht.ht_reserve(self._hash,
+                              ht.ht_count(self._hash) + n) == 0:
+                 raise MemoryError()
+
+             for i from 0 <= i < n:
+                 (k, v) = <object> items[i]
+                 self._insert(k, v)
+
+         else:
              try:
-                 for (k, v) in seq.__getattribute__('iteritems')():
-                     self.__setitem__(k, v)
+                 pairs = seq.__getattribute__('iteritems')()
 
              except AttributeError:
                  try:
-                     for (k, v) in seq.__getattribute__('__iter__')():
-                         self.__setitem__(k, v)
+                     pairs = seq.__getattribute__('__iter__')()
 
                  except AttributeError:
                      raise ValueError("Iterable sequence expected")
 
+             for (k, v) in pairs:
+                 self._insert(k, v)
+
      def __cinit__(self):
          """C ctor
          """
-         self._hash = ht.ht_init(<hash_func_ptr> hash_callback,
-                                 <cmp_func_ptr> cmp_callback,
+         self._hash = ht.ht_init(<hash_func_ptr> keys_hash,
+                                 <cmp_func_ptr> keys_cmp,
                                  <free_func_ptr> free_callback,
                                  <free_func_ptr> free_callback)
          if self._hash is NULL:
@@ -76,6 +245,21 @@ cdef class Ht(object):
          assert self._hash is not NULL
          ht.ht_deinit(self._hash)
 
+     def set_filter(self, filter):
+         """set_filter(f) -> None, keep a filter of the keys, so that
+         most lookups of missing keys return without comparing keys.
+         f is 'bloom' (cheaper to keep up to date), 'cuckoo' (forgets
+         deleted keys at once, but is dropped when too many keys share
+         a hash) or None.
+         """
+         assert self._hash is not NULL
+
+         if filter not in _filters:
+             raise ValueError("filter must be None, 'bloom' or 'cuckoo'")
+
+         if ht.ht_set_filter(self._hash, _filters[filter]) == 0:
+             raise MemoryError()
+
      def __contains__(self, object key):
          """__contains__(k) -> True if T has a key k, else False, O(log(n))
          """
@@ -177,63 +361,64 @@ cdef class Ht(object):
          return ht.ht_count(self._hash) == 0
 
      def items(self):
-         """items([]) -> list (k, v) items of T, O(n)
+         """items() -> list of the (k, v) items of T, O(n)
          """
-         res = []
-
-         iter_ = iter(self)
-         try:
-             while True:
-                 res.append(iter_.next())
-
-         except StopIteration:
-             pass
-
-         return res
+         assert self._hash is not NULL
+         return list_of(self, ITEMS)
 
      def keys(self):
-         """keys([]) -> list for keys of T, O(n)
+         """keys() -> list of the keys of T, O(n)
          """
-         res = []
+         assert self._hash is not NULL
+         return list_of(self, KEYS)
 
-         iter_ = iter(self)
-         try:
-             while True:
-                 res.append(iter_.next()[0])
+     def values(self):
+         """values() -> list of the values of T, O(n)
+         """
+         assert self._hash is not NULL
+         return list_of(self, VALUES)
 
-         except StopIteration:
-             pass
+     def iteritems(self):
+         """iteritems() -> an iterator over the (k, v) items of T
+         """
+         assert self._hash is not NULL
+         return HtIterator(self, ITEMS)
 
-         return res
+     def iterkeys(self):
+         """iterkeys() -> an iterator over the keys of T
+         """
+         assert self._hash is not NULL
+         return HtIterator(self, KEYS)
 
-     def values(self):
-         """values([]) -> generator for values of T, O(n)
+     def itervalues(self):
+         """itervalues() -> an iterator over the values of T
          """
-         res = []
+         assert self._hash is not NULL
+         return HtIterator(self, VALUES)
 
-         iter_ = iter(self)
-         try:
-             while True:
-                 res.append(iter_.next()[1])
+     def viewitems(self):
+         """viewitems() -> a live view of the (k, v) items of T
+         """
+         return HtItemsView(self)
 
-         except StopIteration:
-             pass
+     def viewkeys(self):
+         """viewkeys() -> a live view of the keys of T
+         """
+         return HtKeysView(self)
 
-         return res
+     def viewvalues(self):
+         """viewvalues() -> a live view of the values of T
+         """
+         return HtValuesView(self)
 
      def __delitem__(self, object key):
          """__delitem__(y) <==> del T[y], del[s:e], O(log(n))
          """
-         cdef generic_ptr value = NULL
          assert self._hash is not NULL
 
-         if (ht_delete(self._hash,
-                        <generic_ptr> key) == 0):
-             return
-
-         # explicit reference counting decrement
-         Py_DECREF(key)
-         Py_DECREF(<object> value)
+         # the entry's key and value are released by free_callback
+         ht.ht_delete(self._hash,
+                      <generic_ptr> key)
 
          return
 
@@ -243,15 +428,16 @@ cdef class Ht(object):
          cdef generic_ptr value = NULL
          assert self._hash is not NULL
 
-         if (ht_delete(self._hash,
-                        <generic_ptr> key) == 0):
+         value = ht.ht_find(self._hash,
+                            <generic_ptr> key)
+         if (value == NULL):
              return default
 
+         # hold on to the value, free_callback drops the table's reference
          value_obj = <object> value
 
-         # explicit reference counting decrement
-         Py_DECREF(key)
-         Py_DECREF(value_obj)
+         ht.ht_delete(self._hash,
+                      <generic_ptr> key)
 
          return value_obj
 
@@ -261,7 +447,6 @@ cdef class Ht(object):
          pass
 
      def update(self, E):
-         """update(E) -> None. Update T from dict/iterable E, O(E*log(n))
+         """update(E) -> None. Update T from dict/iterable E, O(E)
          """
-         for (k, v) in E.iteritems():
-             self.__setitem__(k, v)
+         self._load(E)
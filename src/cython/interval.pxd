@@ -0,0 +1,63 @@
+# file: interval.pxd
+
+cdef extern from "avl/interval.h":
+
+    ctypedef struct interval_tree:
+        pass
+    ctypedef interval_tree* interval_tree_ptr
+
+    ctypedef struct interval_iterator:
+        pass
+    ctypedef interval_iterator* interval_iterator_ptr
+
+    # value ptrs
+    ctypedef void* generic_ptr
+    ctypedef void** generic_dptr
+
+    # func ptrs
+    ctypedef void (*free_func_ptr)(generic_ptr data)
+
+    # constants
+    int INTERVAL_OK
+    int INTERVAL_OUT_OF_MEM
+    int INTERVAL_BAD_BOUNDS
+
+    # constructors
+    interval_tree_ptr interval_init()
+
+    # destructors
+    void interval_deinit(interval_tree_ptr tree,
+                         free_func_ptr free_value)
+
+    void interval_clear(interval_tree_ptr tree,
+                        free_func_ptr free_value)
+
+    # insert, delete
+    int interval_insert(interval_tree_ptr tree,
+                        double lo,
+                        double hi,
+                        generic_ptr value)
+
+    int interval_delete(interval_tree_ptr tree,
+                        double lo,
+                        double hi,
+                        generic_dptr value_p)
+
+    int interval_delete_pair(interval_tree_ptr tree,
+                             double lo,
+                             double hi,
+                             generic_ptr value)
+
+    int interval_count(interval_tree_ptr tree)
+
+    # queries
+    interval_iterator_ptr interval_iter(interval_tree_ptr tree,
+                                        double lo,
+                                        double hi)
+
+    void interval_iter_free(interval_iterator_ptr iter)
+
+    int interval_iter_next(interval_iterator_ptr iter,
+                           double* lo_p,
+                           double* hi_p,
+                           generic_dptr value_p)
@@ -0,0 +1,157 @@
+# file: interval.pyx
+cimport interval
+
+cdef extern from "Python.h":
+    cdef void Py_INCREF(obj)
+    cdef void Py_DECREF(obj)
+
+cdef double INF = float("inf")
+
+cdef void free_callback(object obj):
+    Py_DECREF(obj)
+
+cdef class IntervalTree(object):
+     """A balanced tree of closed intervals [lo, hi], each with a value.
+     Endpoints are converted to floats once, on the way in: the tree
+     itself never calls back into Python. Queries return the matching
+     (lo, hi, value) triples in order of lo.
+     """
+     cdef interval.interval_tree_ptr _tree
+     cdef long _version
+
+     def __cinit__(self):
+         """C ctor
+         """
+         self._tree = interval.interval_init()
+         if self._tree is NULL:
+             raise MemoryError()
+         self._version = 0
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._tree is not NULL
+         interval.interval_deinit(self._tree,
+                                  <interval.free_func_ptr> free_callback)
+
+     def __len__(self):
+         """x.__len__() <==> len(x)
+         """
+         assert self._tree is not NULL
+         return interval.interval_count(self._tree)
+
+     def __iter__(self):
+         """x.__iter__() <==> iter(x), all the (lo, hi, value) triples
+         """
+         return IntervalIterator(self, -INF, INF)
+
+     def insert(self, double lo, double hi, value=None):
+         """T.insert(lo, hi[, value]) -- add the interval [lo, hi]
+         """
+         cdef int res
+         assert self._tree is not NULL
+
+         res = interval.interval_insert(self._tree, lo, hi,
+                                        <interval.generic_ptr> value)
+         if res == interval.INTERVAL_BAD_BOUNDS:
+             raise ValueError("bad interval bounds")
+         if res != interval.INTERVAL_OK:
+             raise MemoryError()
+
+         Py_INCREF(value)
+         self._version += 1
+
+     def remove(self, double lo, double hi, *args):
+         """T.remove(lo, hi[, value]) -- remove an interval [lo, hi] (of
+         the very value object, if given). Raises KeyError if there is
+         none
+         """
+         cdef interval.generic_ptr value = NULL
+         cdef int found
+         assert self._tree is not NULL
+
+         if len(args) > 1:
+             raise TypeError("remove expected at most 3 arguments")
+
+         if args:
+             value = <interval.generic_ptr> args[0]
+             found = interval.interval_delete_pair(self._tree, lo, hi, value)
+         else:
+             found = interval.interval_delete(self._tree, lo, hi, &value)
+
+         if not found:
+             raise KeyError((lo, hi))
+
+         self._version += 1
+         Py_DECREF(<object> value)
+
+     def clear(self):
+         """T.clear() -- remove all intervals
+         """
+         assert self._tree is not NULL
+         interval.interval_clear(self._tree,
+                                 <interval.free_func_ptr> free_callback)
+         self._version += 1
+
+     cdef list _query(self, double lo, double hi):
+         cdef interval.interval_iterator_ptr it
+         cdef double l, h
+         cdef interval.generic_ptr value
+         cdef list res = []
+
+         it = interval.interval_iter(self._tree, lo, hi)
+         if it is NULL:
+             raise MemoryError()
+
+         while interval.interval_iter_next(it, &l, &h, &value):
+             res.append((l, h, <object> value))
+
+         interval.interval_iter_free(it)
+         return res
+
+     def overlap(self, double lo, double hi):
+         """T.overlap(lo, hi) -> list of the (lo, hi, value) triples
+         overlapping [lo, hi]
+         """
+         assert self._tree is not NULL
+         if not lo <= hi:
+             raise ValueError("bad interval bounds")
+         return self._query(lo, hi)
+
+     def stab(self, double x):
+         """T.stab(x) -> list of the (lo, hi, value) triples containing x
+         """
+         assert self._tree is not NULL
+         return self._query(x, x)
+
+cdef class IntervalIterator(object):
+     cdef IntervalTree _owner
+     cdef interval.interval_iterator_ptr _iterator
+     cdef long _version
+
+     def __cinit__(self, IntervalTree obj, double lo, double hi):
+         self._owner = obj
+         self._version = obj._version
+         self._iterator = interval.interval_iter(obj._tree, lo, hi)
+         if self._iterator is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         if self._iterator is not NULL:
+             interval.interval_iter_free(self._iterator)
+
+     def __iter__(self):
+         return self
+
+     def __next__(self):
+         cdef double lo, hi
+         cdef interval.generic_ptr value = NULL
+
+         if self._version != self._owner._version:
+             raise RuntimeError("IntervalTree changed during iteration")
+
+         if interval.interval_iter_next(self._iterator,
+                                        &lo, &hi, &value) == 0:
+             raise StopIteration()
+
+         return (lo, hi, <object> value)
@@ -0,0 +1,112 @@
+#ifndef KEYS_H
+#define KEYS_H
+
+#include <Python.h>
+#include <string.h>
+
+/* Hashing and equality of Python keys, as the hash_func_ptr and
+   cmp_func_ptr of the C hash tables. Identical keys are equal without
+   a comparison. Exact ints, strs and bytes are hashed and compared
+   right here, reusing the hashes cached in strs. Anything else goes
+   through PyObject_Hash and PyObject_RichCompareBool(==): tables need
+   equality only, never the three-way cmp().
+
+   Errors (unhashable keys, raising __eq__) can not propagate through
+   the C tables: they are reported as unraisable, the key hashes to 0
+   and compares unequal. */
+
+#if PY_MAJOR_VERSION >= 3
+typedef Py_hash_t keys_hash_t;
+#else
+typedef long keys_hash_t;
+#endif
+
+/* ints below this hash to themselves */
+#define KEYS_HASH_MODULUS                                                      \
+  (((keys_hash_t) 1 << (sizeof(keys_hash_t) == 8 ? 61 : 31)) - 1)
+
+static unsigned keys_hash(const void* key)
+{
+  PyObject* obj = (PyObject *) key;
+  keys_hash_t hash;
+  long x;
+#if PY_MAJOR_VERSION >= 3
+  int overflow;
+
+  if (PyUnicode_CheckExact(obj) &&
+      (hash = ((PyASCIIObject *) obj)->hash) != -1)
+    return (unsigned) hash;
+
+  if (PyLong_CheckExact(obj)) {
+    x = PyLong_AsLongAndOverflow(obj, &overflow);
+    if (! overflow && x > - KEYS_HASH_MODULUS && x < KEYS_HASH_MODULUS)
+      return (unsigned) (x == -1 ? -2 : x);
+  }
+#else
+  if (PyString_CheckExact(obj) &&
+      (hash = ((PyStringObject *) obj)->ob_shash) != -1)
+    return (unsigned) hash;
+
+  if (PyInt_CheckExact(obj)) {
+    x = PyInt_AS_LONG(obj);
+    return (unsigned) (x == -1 ? -2 : x);
+  }
+#endif
+
+  if ((hash = PyObject_Hash(obj)) == -1 && PyErr_Occurred()) {
+    PyErr_WriteUnraisable(obj);
+    return 0;
+  }
+
+  return (unsigned) hash;
+}
+
+/* 0 if equal */
+static int keys_cmp(const void* a, void* b)
+{
+  PyObject* x = (PyObject *) a;
+  PyObject* y = (PyObject *) b;
+  int res;
+#if PY_MAJOR_VERSION >= 3
+  long u, v;
+  int overflow_u, overflow_v;
+#endif
+
+  if (x == y) return 0;
+
+  /* mixed types go the generic way, 1 == 1.0 */
+  if (Py_TYPE(x) == Py_TYPE(y)) {
+#if PY_MAJOR_VERSION >= 3
+    if (PyUnicode_CheckExact(x))
+      return PyUnicode_Compare(x, y) != 0;
+
+    if (PyBytes_CheckExact(x))
+      return PyBytes_GET_SIZE(x) != PyBytes_GET_SIZE(y) ||
+        memcmp(PyBytes_AS_STRING(x), PyBytes_AS_STRING(y),
+               PyBytes_GET_SIZE(x));
+
+    if (PyLong_CheckExact(x)) {
+      u = PyLong_AsLongAndOverflow(x, &overflow_u);
+      v = PyLong_AsLongAndOverflow(y, &overflow_v);
+      if (! overflow_u && ! overflow_v) return u != v;
+    }
+#else
+    if (PyString_CheckExact(x))
+      return PyString_GET_SIZE(x) != PyString_GET_SIZE(y) ||
+        memcmp(PyString_AS_STRING(x), PyString_AS_STRING(y),
+               PyString_GET_SIZE(x));
+
+    if (PyInt_CheckExact(x))
+      return PyInt_AS_LONG(x) != PyInt_AS_LONG(y);
+#endif
+  }
+
+  if ((res = PyObject_RichCompareBool(x, y, Py_EQ)) < 0) {
+    PyErr_WriteUnraisable(x);
+    return 1;
+  }
+
+  return ! res;
+}
+
+#endif
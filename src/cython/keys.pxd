@@ -0,0 +1,9 @@
+# file: keys.pxd
+
+cdef extern from "keys.h":
+
+    # hash_func_ptr and cmp_func_ptr of Python keys, for hash tables
+    unsigned keys_hash(void* key)
+
+    int keys_cmp(void* a,
+                 void* b)
@@ -0,0 +1,82 @@
+# file: linkedlist.pxd
+cdef extern from "list/list.h":
+
+    ctypedef struct list_t:
+        pass
+    ctypedef list_t* list_ptr
+
+    # value ptrs
+    ctypedef void* generic_ptr
+    ctypedef void** generic_dptr
+
+    # nodes double as handles
+    ctypedef struct list_node_t:
+        generic_ptr data
+    ctypedef list_node_t* list_node_ptr
+
+    # stack/embeddable iterator
+    ctypedef struct list_iterator_t:
+        int dir
+
+    # func ptrs
+    ctypedef void (*free_func_ptr)(generic_ptr data)
+
+    # constants
+    int LIST_OK
+    int LIST_EMPTY
+
+    int LIST_ITER_FORWARD
+    int LIST_ITER_BACKWARD
+
+    # constructors
+    list_ptr list_init(free_func_ptr free)
+
+    # destructors
+    void list_deinit(list_ptr list)
+    void list_clear(list_ptr list)
+
+    # number of entries
+    unsigned list_n(list_ptr list)
+
+    # insertion
+    list_node_ptr list_push_front(list_ptr list,
+                                  generic_ptr data)
+
+    list_node_ptr list_push_back(list_ptr list,
+                                 generic_ptr data)
+
+    list_node_ptr list_insert_before(list_ptr list,
+                                     list_node_ptr pos,
+                                     generic_ptr data)
+
+    # deletion
+    generic_ptr list_remove(list_ptr list,
+                            list_node_ptr node)
+
+    int list_pop_front(list_ptr list,
+                       generic_dptr data)
+
+    int list_pop_back(list_ptr list,
+                      generic_dptr data)
+
+    # navigation
+    list_node_ptr list_first(list_ptr list)
+    list_node_ptr list_last(list_ptr list)
+
+    list_node_ptr list_next(list_ptr list,
+                            list_node_ptr node)
+
+    list_node_ptr list_prev(list_ptr list,
+                            list_node_ptr node)
+
+    # bulk operations
+    void list_splice(list_ptr list,
+                     list_ptr src)
+
+    # iterators
+    void list_iter_init(list_iterator_t* iter_,
+                        list_ptr list,
+                        int dir)
+
+    int list_iter_next(list_iterator_t* iter_,
+                       generic_dptr data)
@@ -0,0 +1,235 @@
+# file: linkedlist.pyx
+cimport linkedlist
+
+cdef extern from "Python.h":
+    cdef void Py_INCREF(obj)
+    cdef void Py_DECREF(obj)
+
+cdef class ListHandle(object):
+     """Identifies an item of a LinkedList for as long as it stays in
+     the list. The list holds the handle, the handle holds the item.
+     """
+     cdef linkedlist.list_ptr _owner
+     cdef linkedlist.list_node_ptr _node
+     cdef object _item
+
+# the list releases a handle
+cdef void release_handle(object obj):
+    cdef ListHandle handle = <ListHandle> obj
+    handle._node = NULL
+    Py_DECREF(obj)
+
+cdef class LinkedListIterator(object):
+     """Iterates over a LinkedList with an embedded C iterator. Nodes
+     are recycled on removal, so any change to the list ends the
+     iteration with a RuntimeError.
+     """
+     cdef LinkedList _owner
+     cdef linkedlist.list_iterator_t _iterator
+     cdef unsigned _stamp
+
+     def __init__(self, LinkedList obj, int dir):
+         self._owner = obj
+         self._stamp = obj._stamp
+         linkedlist.list_iter_init(&self._iterator, obj._list, dir)
+
+     def __iter__(self):
+         return self
+
+     def __next__(self):
+         cdef generic_ptr value = NULL
+
+         if self._stamp != self._owner._stamp:
+             raise RuntimeError("list changed during iteration")
+
+         if linkedlist.list_iter_next(&self._iterator, &value) == 0:
+             raise StopIteration()
+
+         return (<ListHandle> value)._item
+
+cdef class LinkedList(object):
+     """A doubly linked list, its nodes allocated from chunks. Adding
+     and removing items is O(1) at either end, and anywhere else
+     through the handles returned on insertion.
+     """
+     cdef linkedlist.list_ptr _list
+     cdef unsigned _stamp
+
+     def __init__(self, iterable=None):
+         """Python ctor
+         """
+         if iterable is not None:
+             self.extend(iterable)
+
+     def __cinit__(self, iterable=None):
+         """C ctor
+         """
+         self._list = linkedlist.list_init(<free_func_ptr> release_handle)
+         if self._list is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._list is not NULL
+         linkedlist.list_deinit(self._list)
+
+     cdef linkedlist.list_node_ptr _node(self, ListHandle handle) except NULL:
+         if handle._owner != self._list or handle._node is NULL:
+             raise KeyError(handle)
+         return handle._node
+
+     cdef ListHandle _insert(self, linkedlist.list_node_ptr pos, object obj,
+                             bint front):
+         cdef ListHandle handle = ListHandle()
+         handle._item = obj
+
+         if front:
+             handle._node = linkedlist.list_push_front(self._list,
+                                                       <generic_ptr> handle)
+         else:
+             handle._node = linkedlist.list_insert_before(self._list, pos,
+                                                          <generic_ptr> handle)
+         if handle._node is NULL:
+             raise MemoryError()
+
+         # explicit reference counting increment, the list holds the
+         # handle now
+         Py_INCREF(handle)
+         handle._owner = self._list
+         self._stamp += 1
+         return handle
+
+     cdef object _take(self, generic_ptr value):
+         cdef ListHandle handle = <ListHandle> value
+         handle._node = NULL
+         self._stamp += 1
+
+         # explicit reference counting decrement
+         Py_DECREF(handle)
+         return handle._item
+
+     def __len__(self):
+         """x.__len__() <==> len(x)
+         """
+         assert self._list is not NULL
+         return linkedlist.list_n(self._list)
+
+     def __nonzero__(self):
+         """x.__nonzero__() <==> x != 0
+         """
+         assert self._list is not NULL
+         return linkedlist.list_n(self._list) != 0
+
+     def __iter__(self):
+         """x.__iter__() <==> iter(x)
+         """
+         return LinkedListIterator(self, linkedlist.LIST_ITER_FORWARD)
+
+     def __reversed__(self):
+         """x.__reversed__() <==> reversed(x)
+         """
+         return LinkedListIterator(self, linkedlist.LIST_ITER_BACKWARD)
+
+     def __contains__(self, ListHandle handle not None):
+         """__contains__(h) -> True if the item with handle h is in L
+         """
+         assert self._list is not NULL
+         return handle._owner == self._list and handle._node is not NULL
+
+     def append(self, object obj):
+         """L.append(obj) -> handle -- add obj to the right side, O(1)
+         """
+         assert self._list is not NULL
+         return self._insert(NULL, obj, False)
+
+     def appendleft(self, object obj):
+         """L.appendleft(obj) -> handle -- add obj to the left side, O(1)
+         """
+         assert self._list is not NULL
+         return self._insert(NULL, obj, True)
+
+     def insert_before(self, ListHandle handle not None, object obj):
+         """L.insert_before(handle, obj) -> handle -- add obj before the
+         item with the given handle, O(1). Raises KeyError if handle is
+         not in L.
+         """
+         assert self._list is not NULL
+         return self._insert(self._node(handle), obj, False)
+
+     def get(self, ListHandle handle not None):
+         """L.get(handle) -> the item with the given handle. Raises
+         KeyError if handle is not in L.
+         """
+         assert self._list is not NULL
+         self._node(handle)
+         return handle._item
+
+     def remove(self, ListHandle handle not None):
+         """L.remove(handle) -> item -- remove the item with the given
+         handle, O(1). Raises KeyError if handle is not in L.
+         """
+         assert self._list is not NULL
+         return self._take(linkedlist.list_remove(self._list,
+                                                  self._node(handle)))
+
+     def pop(self):
+         """L.pop() -> obj -- remove and return the rightmost object.
+         Raises IndexError if the list is empty.
+         """
+         cdef generic_ptr value = NULL
+         assert self._list is not NULL
+
+         if linkedlist.list_pop_back(self._list, &value) != linkedlist.LIST_OK:
+             raise IndexError("pop from an empty list")
+
+         return self._take(value)
+
+     def popleft(self):
+         """L.popleft() -> obj -- remove and return the leftmost object.
+         Raises IndexError if the list is empty.
+         """
+         cdef generic_ptr value = NULL
+         assert self._list is not NULL
+
+         if linkedlist.list_pop_front(self._list, &value) != linkedlist.LIST_OK:
+             raise IndexError("pop from an empty list")
+
+         return self._take(value)
+
+     def extend(self, iterable):
+         """L.extend(iterable) -- add all objects from iterable to the
+         right side. Another LinkedList is spliced in, its nodes and
+         handles moving over; it is left empty. L.extend(L) doubles L,
+         as with lists.
+         """
+         cdef LinkedList other
+         cdef linkedlist.list_node_ptr node
+         assert self._list is not NULL
+
+         if iterable is self:
+             iterable = list(iterable)
+
+         if not isinstance(iterable, LinkedList):
+             for obj in iterable:
+                 self._insert(NULL, obj, False)
+             return
+
+         other = <LinkedList> iterable
+
+         # handles of the moved nodes now belong here
+         node = linkedlist.list_first(other._list)
+         while node is not NULL:
+             (<ListHandle> node.data)._owner = self._list
+             node = linkedlist.list_next(other._list, node)
+
+         linkedlist.list_splice(self._list, other._list)
+         self._stamp += 1
+         other._stamp += 1
+
+     def clear(self):
+         """L.clear() -> None.  Remove all items from L.
+         """
+         assert self._list is not NULL
+         linkedlist.list_clear(self._list)
+         self._stamp += 1
@@ -0,0 +1,99 @@
+#ifndef LOCK_H
+#define LOCK_H
+
+#include <stdlib.h>
+#include <pthread.h>
+
+/* Optional reader-writer lock of the wrappers that release the GIL.
+   Without the GIL, two Python threads can be inside the same C
+   structure at once; objects built with locked=True take this lock
+   around every C call, shared for lookups and exclusive for updates,
+   so that lookups still run in parallel. A NULL lock (the default)
+   makes all of the calls below no-ops.
+
+   Unlocked objects keep the GIL instead. The lock is taken with the
+   GIL released, except to merge with an unlocked object, which keeps
+   the GIL; holders of the lock never wait for the GIL, so the two can
+   not deadlock either way. Writers are preferred where supported, so
+   that a stream of lookups does not starve updates. */
+
+typedef struct lock_struct lock;
+typedef lock* lock_ptr;
+
+struct lock_struct {
+  pthread_rwlock_t rwlock;
+};
+
+/* NULL if not enabled, or out of memory (check with enabled) */
+static lock_ptr lock_init(int enabled)
+{
+  lock_ptr this;
+  pthread_rwlockattr_t attr;
+
+  if (!enabled || !(this = (lock_ptr) malloc(sizeof(lock))))
+    return NULL;
+
+  pthread_rwlockattr_init(&attr);
+#if defined(__GLIBC__) && defined(__USE_GNU)
+  pthread_rwlockattr_setkind_np(&attr,
+                                PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+  if (pthread_rwlock_init(&this->rwlock, &attr)) {
+    free(this);
+    this = NULL;
+  }
+
+  pthread_rwlockattr_destroy(&attr);
+  return this;
+}
+
+static void lock_deinit(lock_ptr this)
+{
+  if (this) {
+    pthread_rwlock_destroy(&this->rwlock);
+    free(this);
+  }
+}
+
+static inline void lock_read(lock_ptr this)
+{
+  if (this) pthread_rwlock_rdlock(&this->rwlock);
+}
+
+static inline void lock_write(lock_ptr this)
+{
+  if (this) pthread_rwlock_wrlock(&this->rwlock);
+}
+
+static inline void lock_release(lock_ptr this)
+{
+  if (this) pthread_rwlock_unlock(&this->rwlock);
+}
+
+/* Write-lock one object and read-lock another (which may be the same)
+   in address order, so that a.merge(b) and b.merge(a) can not
+   deadlock */
+static inline void lock_write_read(lock_ptr w, lock_ptr r)
+{
+  if (w == r || !r)
+    lock_write(w);
+  else if (!w)
+    lock_read(r);
+  else if (w < r) {
+    lock_write(w);
+    lock_read(r);
+  }
+  else {
+    lock_read(r);
+    lock_write(w);
+  }
+}
+
+static inline void lock_release_both(lock_ptr w, lock_ptr r)
+{
+  lock_release(w);
+  if (r != w) lock_release(r);
+}
+
+#endif
@@ -0,0 +1,22 @@
+# file: lock.pxd
+
+cdef extern from "lock.h":
+
+    ctypedef struct lock_struct:
+        pass
+    ctypedef lock_struct* lock_ptr
+
+    # optional reader-writer lock, NULL if not enabled
+    lock_ptr lock_init(int enabled)
+    void lock_deinit(lock_ptr lock)
+
+    # no-ops on a NULL lock
+    void lock_read(lock_ptr lock) nogil
+    void lock_write(lock_ptr lock) nogil
+    void lock_release(lock_ptr lock) nogil
+
+    # a pair of objects, as in merges, which can not deadlock
+    void lock_write_read(lock_ptr w,
+                         lock_ptr r) nogil
+    void lock_release_both(lock_ptr w,
+                           lock_ptr r) nogil
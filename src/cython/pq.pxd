@@ -0,0 +1,170 @@
+# file: pq.pxd
+cdef extern from "pq/pq.h":
+
+    ctypedef struct pq_t:
+        pass
+    ctypedef pq_t* pq_ptr
+
+    # priorities
+    ctypedef union pq_key_t:
+        double d
+        long long l
+
+    # value ptrs
+    ctypedef void* generic_ptr
+    ctypedef void** generic_dptr
+
+    # func ptrs
+    ctypedef void (*free_func_ptr)(generic_ptr data)
+
+    # constants
+    int PQ_OK
+    int PQ_EMPTY
+    int PQ_OUT_OF_MEM
+    int PQ_BAD_HANDLE
+    int PQ_BAD_KEY
+
+    int PQ_KEY_DOUBLE
+    int PQ_KEY_LONG
+
+    # constructors
+    pq_ptr pq_init(unsigned size,
+                   int key_type,
+                   free_func_ptr free)
+
+    # destructors
+    void pq_deinit(pq_ptr pq)
+
+    # number of entries
+    unsigned pq_n(pq_ptr pq)
+
+    # queue operations
+    int pq_push(pq_ptr pq,
+                pq_key_t key,
+                generic_ptr data,
+                unsigned* handle)
+
+    int pq_peek(pq_ptr pq,
+                pq_key_t* key,
+                generic_dptr data)
+
+    int pq_pop(pq_ptr pq,
+               pq_key_t* key,
+               generic_dptr data)
+
+    int pq_heapify(pq_ptr pq,
+                   pq_key_t* keys,
+                   generic_dptr data,
+                   unsigned n,
+                   unsigned* handles)
+
+    # handle based operations
+    int pq_fetch(pq_ptr pq,
+                 unsigned handle,
+                 pq_key_t* key,
+                 generic_dptr data)
+
+    int pq_decrease_key(pq_ptr pq,
+                        unsigned handle,
+                        pq_key_t key)
+
+    int pq_update(pq_ptr pq,
+                  unsigned handle,
+                  pq_key_t key)
+
+    int pq_remove(pq_ptr pq,
+                  unsigned handle,
+                  generic_dptr data)
+
+    void pq_clear(pq_ptr pq)
+
+cdef extern from "pq/radix_heap.h":
+
+    ctypedef struct radix_heap_t:
+        pass
+    ctypedef radix_heap_t* radix_heap_ptr
+
+    # constants
+    int RADIX_HEAP_OK
+    int RADIX_HEAP_EMPTY
+    int RADIX_HEAP_OUT_OF_MEM
+    int RADIX_HEAP_BAD_KEY
+
+    # constructors
+    radix_heap_ptr radix_heap_init(free_func_ptr free)
+
+    # destructors
+    void radix_heap_deinit(radix_heap_ptr heap)
+
+    # number of entries
+    unsigned radix_heap_n(radix_heap_ptr heap)
+
+    # queue operations
+    int radix_heap_push(radix_heap_ptr heap,
+                        unsigned long long key,
+                        generic_ptr data)
+
+    int radix_heap_peek(radix_heap_ptr heap,
+                        unsigned long long* key,
+                        generic_dptr data)
+
+    int radix_heap_pop(radix_heap_ptr heap,
+                       unsigned long long* key,
+                       generic_dptr data)
+
+    void radix_heap_clear(radix_heap_ptr heap)
+
+cdef extern from "pq/pairing_heap.h":
+
+    ctypedef struct pairing_heap_t:
+        pass
+    ctypedef pairing_heap_t* pairing_heap_ptr
+
+    # nodes double as handles
+    ctypedef struct pairing_heap_node_t:
+        generic_ptr key
+        generic_ptr data
+    ctypedef pairing_heap_node_t* pairing_heap_node_ptr
+
+    # func ptrs
+    ctypedef int (*cmp_func_ptr)(generic_ptr a,
+                                 generic_ptr b)
+
+    # constants
+    int PAIRING_HEAP_OK
+    int PAIRING_HEAP_EMPTY
+    int PAIRING_HEAP_BAD_KEY
+
+    # constructors
+    pairing_heap_ptr pairing_heap_init(cmp_func_ptr cmp,
+                                       free_func_ptr key_free,
+                                       free_func_ptr data_free)
+
+    # destructors
+    void pairing_heap_deinit(pairing_heap_ptr heap)
+
+    # number of entries
+    unsigned pairing_heap_n(pairing_heap_ptr heap)
+
+    # queue operations
+    pairing_heap_node_ptr pairing_heap_push(pairing_heap_ptr heap,
+                                            generic_ptr key,
+                                            generic_ptr data)
+
+    int pairing_heap_peek(pairing_heap_ptr heap,
+                          generic_dptr key,
+                          generic_dptr data)
+
+    int pairing_heap_pop(pairing_heap_ptr heap,
+                         generic_dptr key,
+                         generic_dptr data)
+
+    # handle based operations
+    int pairing_heap_decrease_key(pairing_heap_ptr heap,
+                                  pairing_heap_node_ptr node,
+                                  generic_ptr key)
+
+    void pairing_heap_remove(pairing_heap_ptr heap,
+                             pairing_heap_node_ptr node,
+                             generic_dptr key,
+                             generic_dptr data)
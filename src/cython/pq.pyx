@@ -0,0 +1,478 @@
+# file: pq.pyx
+cimport pq
+
+cdef extern from "Python.h":
+    ctypedef void PyObject
+    cdef void Py_INCREF(obj)
+    cdef void Py_DECREF(obj)
+    cdef object PySequence_Fast(object o, char* m)
+    cdef Py_ssize_t PySequence_Fast_GET_SIZE(object o)
+    cdef PyObject** PySequence_Fast_ITEMS(object o)
+    cdef void* PyMem_Malloc(size_t n)
+    cdef void PyMem_Free(void* p)
+
+cdef void free_callback(object obj):
+    Py_DECREF(obj)
+
+cdef int cmp_callback(object a, object b):
+    return cmp(a, b)
+
+cdef class PriorityQueue(object):
+     """A min-priority queue, built on a 4-ary heap. Priorities are
+     either floats (default) or ints (int_priorities=True) and are
+     compared natively, never calling back into Python. push()
+     returns a handle, which identifies the item for decrease_key(),
+     update() and remove() for as long as it stays queued.
+     """
+     cdef pq.pq_ptr _pq
+     cdef int _key_type
+
+     def __init__(self, seq=None, int_priorities=False):
+         """Python ctor, seq is an iterable of (priority, item) pairs
+         """
+         if seq is not None:
+             self.heapify(seq)
+
+     def __cinit__(self, seq=None, int_priorities=False):
+         """C ctor
+         """
+         self._key_type = pq.PQ_KEY_LONG if int_priorities else pq.PQ_KEY_DOUBLE
+         self._pq = pq.pq_init(0, self._key_type,
+                               <free_func_ptr> free_callback)
+         if self._pq is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._pq is not NULL
+         pq.pq_deinit(self._pq)
+
+     cdef pq.pq_key_t _key(self, object priority) except *:
+         cdef pq.pq_key_t key
+         if self._key_type == pq.PQ_KEY_LONG:
+             key.l = priority
+         else:
+             key.d = priority
+         return key
+
+     cdef object _priority(self, pq.pq_key_t key):
+         if self._key_type == pq.PQ_KEY_LONG:
+             return key.l
+         return key.d
+
+     def __len__(self):
+         """x.__len__() <==> len(x)
+         """
+         assert self._pq is not NULL
+         return pq.pq_n(self._pq)
+
+     def __nonzero__(self):
+         """x.__nonzero__() <==> x != 0
+         """
+         assert self._pq is not NULL
+         return pq.pq_n(self._pq) != 0
+
+     def __contains__(self, unsigned handle):
+         """__contains__(h) -> True if the item with handle h is queued
+         """
+         assert self._pq is not NULL
+         return pq.pq_fetch(self._pq, handle, NULL, NULL) == pq.PQ_OK
+
+     def push(self, priority, object obj):
+         """Q.push(priority, obj) -> handle -- queue obj, O(log(n))
+         """
+         cdef unsigned handle
+         cdef pq.pq_key_t key = self._key(priority)
+         assert self._pq is not NULL
+
+         # explicit reference counting increment
+         Py_INCREF(obj)
+         if pq.pq_push(self._pq, key, <generic_ptr> obj, &handle) != pq.PQ_OK:
+             Py_DECREF(obj)
+             raise MemoryError()
+
+         return handle
+
+     def heapify(self, seq):
+         """Q.heapify(seq) -- queue all (priority, item) pairs from seq
+         at once, O(len(Q) + len(seq))
+         """
+         cdef Py_ssize_t i, n
+         cdef pq.pq_key_t* keys
+         cdef generic_dptr data
+         assert self._pq is not NULL
+
+         pairs = PySequence_Fast(seq, "Iterable sequence expected")
+         n = PySequence_Fast_GET_SIZE(pairs)
+         if n == 0:
+             return
+
+         keys = <pq.pq_key_t*> PyMem_Malloc(n * sizeof(pq.pq_key_t))
+         data = <generic_dptr> PyMem_Malloc(n * sizeof(generic_ptr))
+         try:
+             if keys is NULL or data is NULL:
+                 raise MemoryError()
+
+             items = []
+             for i from 0 <= i < n:
+                 priority, obj = pairs[i]
+                 keys[i] = self._key(priority)
+                 data[i] = <generic_ptr> obj
+                 items.append(obj)
+
+             if pq.pq_heapify(self._pq, keys, data, n, NULL) != pq.PQ_OK:
+                 raise MemoryError()
+
+             # explicit reference counting increment, the queue holds
+             # a reference to each item now
+             for obj in items:
+                 Py_INCREF(obj)
+
+         finally:
+             PyMem_Free(keys)
+             PyMem_Free(data)
+
+     def peek(self):
+         """Q.peek() -> (priority, item) with the smallest priority.
+         Raises IndexError if the queue is empty.
+         """
+         cdef pq.pq_key_t key
+         cdef generic_ptr value = NULL
+         assert self._pq is not NULL
+
+         if pq.pq_peek(self._pq, &key, &value) != pq.PQ_OK:
+             raise IndexError("peek from empty queue")
+
+         return (self._priority(key), <object> value)
+
+     def pop(self):
+         """Q.pop() -> (priority, item) -- remove and return the item
+         with the smallest priority. Raises IndexError if the queue is
+         empty.
+         """
+         cdef pq.pq_key_t key
+         cdef generic_ptr value = NULL
+         assert self._pq is not NULL
+
+         if pq.pq_pop(self._pq, &key, &value) != pq.PQ_OK:
+             raise IndexError("pop from empty queue")
+
+         value_obj = <object> value
+
+         # explicit reference counting decrement
+         Py_DECREF(value_obj)
+         return (self._priority(key), value_obj)
+
+     def priority(self, unsigned handle):
+         """Q.priority(handle) -> priority of a queued item. Raises
+         KeyError if handle is not queued.
+         """
+         cdef pq.pq_key_t key
+         assert self._pq is not NULL
+
+         if pq.pq_fetch(self._pq, handle, &key, NULL) != pq.PQ_OK:
+             raise KeyError(handle)
+
+         return self._priority(key)
+
+     def decrease_key(self, unsigned handle, priority):
+         """Q.decrease_key(handle, priority) -- lower the priority of
+         a queued item. Raises KeyError if handle is not queued and
+         ValueError if priority is greater than the current one.
+         """
+         cdef int res
+         assert self._pq is not NULL
+
+         res = pq.pq_decrease_key(self._pq, handle, self._key(priority))
+         if res == pq.PQ_BAD_HANDLE:
+             raise KeyError(handle)
+         if res == pq.PQ_BAD_KEY:
+             raise ValueError("new priority is greater than current one")
+
+     def update(self, unsigned handle, priority):
+         """Q.update(handle, priority) -- change the priority of a
+         queued item. Raises KeyError if handle is not queued.
+         """
+         assert self._pq is not NULL
+
+         if (pq.pq_update(self._pq, handle, self._key(priority)) !=
+             pq.PQ_OK):
+             raise KeyError(handle)
+
+     def remove(self, unsigned handle):
+         """Q.remove(handle) -> item -- remove a queued item. Raises
+         KeyError if handle is not queued.
+         """
+         cdef generic_ptr value = NULL
+         assert self._pq is not NULL
+
+         if pq.pq_remove(self._pq, handle, &value) != pq.PQ_OK:
+             raise KeyError(handle)
+
+         value_obj = <object> value
+
+         # explicit reference counting decrement
+         Py_DECREF(value_obj)
+         return value_obj
+
+     def clear(self):
+         """Q.clear() -> None.  Remove all items from Q.
+         """
+         assert self._pq is not NULL
+         pq.pq_clear(self._pq)
+
+
+cdef class RadixHeap(object):
+     """A monotone min-priority queue for non-negative int priorities,
+     built on a radix heap: no priority may be pushed below the last
+     one popped, as in Dijkstra's algorithm. Push is O(1), pop is
+     amortized O(log(C)), C being the spread of the priorities.
+     """
+     cdef pq.radix_heap_ptr _heap
+
+     def __cinit__(self):
+         """C ctor
+         """
+         self._heap = pq.radix_heap_init(<free_func_ptr> free_callback)
+         if self._heap is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._heap is not NULL
+         pq.radix_heap_deinit(self._heap)
+
+     def __len__(self):
+         """x.__len__() <==> len(x)
+         """
+         assert self._heap is not NULL
+         return pq.radix_heap_n(self._heap)
+
+     def __nonzero__(self):
+         """x.__nonzero__() <==> x != 0
+         """
+         assert self._heap is not NULL
+         return pq.radix_heap_n(self._heap) != 0
+
+     def push(self, unsigned long long priority, object obj):
+         """H.push(priority, obj) -- queue obj, O(1). Raises ValueError
+         if priority is below the last one popped.
+         """
+         cdef int res
+         assert self._heap is not NULL
+
+         # explicit reference counting increment
+         Py_INCREF(obj)
+         res = pq.radix_heap_push(self._heap, priority, <generic_ptr> obj)
+         if res != pq.RADIX_HEAP_OK:
+             Py_DECREF(obj)
+             if res == pq.RADIX_HEAP_BAD_KEY:
+                 raise ValueError("priority is below the last one popped")
+             raise MemoryError()
+
+     def peek(self):
+         """H.peek() -> (priority, item) with the smallest priority.
+         Raises IndexError if the heap is empty.
+         """
+         cdef int res
+         cdef unsigned long long key
+         cdef generic_ptr value = NULL
+         assert self._heap is not NULL
+
+         res = pq.radix_heap_peek(self._heap, &key, &value)
+         if res == pq.RADIX_HEAP_EMPTY:
+             raise IndexError("peek from empty heap")
+         if res != pq.RADIX_HEAP_OK:
+             raise MemoryError()
+
+         return (key, <object> value)
+
+     def pop(self):
+         """H.pop() -> (priority, item) -- remove and return the item
+         with the smallest priority. Raises IndexError if the heap is
+         empty.
+         """
+         cdef int res
+         cdef unsigned long long key
+         cdef generic_ptr value = NULL
+         assert self._heap is not NULL
+
+         res = pq.radix_heap_pop(self._heap, &key, &value)
+         if res == pq.RADIX_HEAP_EMPTY:
+             raise IndexError("pop from empty heap")
+         if res != pq.RADIX_HEAP_OK:
+             raise MemoryError()
+
+         value_obj = <object> value
+
+         # explicit reference counting decrement
+         Py_DECREF(value_obj)
+         return (key, value_obj)
+
+     def clear(self):
+         """H.clear() -> None.  Remove all items from H.
+         """
+         assert self._heap is not NULL
+         pq.radix_heap_clear(self._heap)
+
+
+cdef class PairingHandle(object):
+     """Identifies an item of a PairingHeap for as long as it stays
+     queued. The heap holds the handle, the handle holds the item.
+     """
+     cdef pq.pairing_heap_ptr _owner
+     cdef pq.pairing_heap_node_ptr _node
+     cdef object _item
+
+# the heap releases a queued handle
+cdef void release_handle(object obj):
+    cdef PairingHandle handle = <PairingHandle> obj
+    handle._node = NULL
+    Py_DECREF(obj)
+
+cdef class PairingHeap(object):
+     """A min-priority queue built on a pairing heap. Priorities are
+     any comparable objects. push() returns a handle, which identifies
+     the item for decrease_key() and remove(); push and decrease_key
+     are O(1), pop is amortized O(log(n)).
+     """
+     cdef pq.pairing_heap_ptr _heap
+
+     def __cinit__(self):
+         """C ctor
+         """
+         self._heap = pq.pairing_heap_init(<cmp_func_ptr> cmp_callback,
+                                           <free_func_ptr> free_callback,
+                                           <free_func_ptr> release_handle)
+         if self._heap is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         assert self._heap is not NULL
+         pq.pairing_heap_deinit(self._heap)
+
+     cdef pq.pairing_heap_node_ptr _node(self, PairingHandle handle) except NULL:
+         if handle._owner != self._heap or handle._node is NULL:
+             raise KeyError(handle)
+         return handle._node
+
+     def __len__(self):
+         """x.__len__() <==> len(x)
+         """
+         assert self._heap is not NULL
+         return pq.pairing_heap_n(self._heap)
+
+     def __nonzero__(self):
+         """x.__nonzero__() <==> x != 0
+         """
+         assert self._heap is not NULL
+         return pq.pairing_heap_n(self._heap) != 0
+
+     def __contains__(self, PairingHandle handle not None):
+         """__contains__(h) -> True if the item with handle h is queued
+         """
+         assert self._heap is not NULL
+         return handle._owner == self._heap and handle._node is not NULL
+
+     def push(self, object priority, object obj):
+         """H.push(priority, obj) -> handle -- queue obj, O(1)
+         """
+         cdef PairingHandle handle = PairingHandle()
+         assert self._heap is not NULL
+
+         handle._item = obj
+         handle._node = pq.pairing_heap_push(self._heap,
+                                             <generic_ptr> priority,
+                                             <generic_ptr> handle)
+         if handle._node is NULL:
+             raise MemoryError()
+
+         # explicit reference counting increment, the heap holds the
+         # priority and the handle now
+         Py_INCREF(priority)
+         Py_INCREF(handle)
+         handle._owner = self._heap
+         return handle
+
+     def peek(self):
+         """H.peek() -> (priority, item) with the smallest priority.
+         Raises IndexError if the heap is empty.
+         """
+         cdef generic_ptr key = NULL
+         cdef generic_ptr value = NULL
+         assert self._heap is not NULL
+
+         if pq.pairing_heap_peek(self._heap, &key, &value) != pq.PAIRING_HEAP_OK:
+             raise IndexError("peek from empty heap")
+
+         return (<object> key, (<PairingHandle> value)._item)
+
+     def pop(self):
+         """H.pop() -> (priority, item) -- remove and return the item
+         with the smallest priority. Raises IndexError if the heap is
+         empty.
+         """
+         cdef generic_ptr key = NULL
+         cdef generic_ptr value = NULL
+         assert self._heap is not NULL
+
+         if pq.pairing_heap_pop(self._heap, &key, &value) != pq.PAIRING_HEAP_OK:
+             raise IndexError("pop from empty heap")
+
+         return self._release(key, value)
+
+     def priority(self, PairingHandle handle not None):
+         """H.priority(handle) -> priority of a queued item. Raises
+         KeyError if handle is not queued.
+         """
+         assert self._heap is not NULL
+         return <object> self._node(handle).key
+
+     def decrease_key(self, PairingHandle handle not None, object priority):
+         """H.decrease_key(handle, priority) -- lower the priority of
+         a queued item. Raises KeyError if handle is not queued and
+         ValueError if priority is greater than the current one.
+         """
+         cdef pq.pairing_heap_node_ptr node = self._node(handle)
+         assert self._heap is not NULL
+
+         # the C heap keeps the very same key object as it is
+         if <generic_ptr> priority == node.key:
+             return
+
+         if (pq.pairing_heap_decrease_key(self._heap, node,
+                                          <generic_ptr> priority) !=
+             pq.PAIRING_HEAP_OK):
+             raise ValueError("new priority is greater than current one")
+
+         # explicit reference counting increment, the old priority was
+         # released by the heap
+         Py_INCREF(priority)
+
+     def remove(self, PairingHandle handle not None):
+         """H.remove(handle) -> item -- remove a queued item. Raises
+         KeyError if handle is not queued.
+         """
+         cdef generic_ptr key = NULL
+         cdef generic_ptr value = NULL
+         cdef pq.pairing_heap_node_ptr node = self._node(handle)
+         assert self._heap is not NULL
+
+         pq.pairing_heap_remove(self._heap, node, &key, &value)
+         return self._release(key, value)[1]
+
+     cdef object _release(self, generic_ptr key, generic_ptr value):
+         cdef PairingHandle handle = <PairingHandle> value
+         priority = <object> key
+         handle._node = NULL
+
+         # explicit reference counting decrement, ownership of the
+         # priority and the handle came back from the heap
+         Py_DECREF(priority)
+         Py_DECREF(handle)
+         return (priority, handle._item)
+
@@ -0,0 +1,59 @@
+# file: ring.pxd
+cdef extern from "ring/ring.h":
+
+    ctypedef struct ring_t:
+        pass
+    ctypedef ring_t* ring_ptr
+
+    # value ptrs
+    ctypedef void* generic_ptr
+    ctypedef void** generic_dptr
+
+    # func ptrs
+    ctypedef void (*free_func_ptr)(generic_ptr data)
+
+    # constants
+    int RING_OK
+    int RING_EMPTY
+    int RING_FULL
+    int RING_TIMEOUT
+
+    int RING_MPMC
+    int RING_SPSC
+    int RING_MPSC
+
+    # constructors
+    ring_ptr ring_init(unsigned size,
+                       int mode,
+                       free_func_ptr free)
+
+    # destructors
+    void ring_deinit(ring_ptr ring)
+
+    # number of entries
+    unsigned ring_n(ring_ptr ring) nogil
+    unsigned ring_capacity(ring_ptr ring) nogil
+
+    # non-blocking operations
+    int ring_enqueue(ring_ptr ring,
+                     generic_ptr data) nogil
+
+    int ring_dequeue(ring_ptr ring,
+                     generic_dptr data) nogil
+
+    unsigned ring_enqueue_many(ring_ptr ring,
+                               generic_dptr items,
+                               unsigned n) nogil
+
+    unsigned ring_dequeue_many(ring_ptr ring,
+                               generic_dptr items,
+                               unsigned n) nogil
+
+    # blocking operations
+    int ring_enqueue_wait(ring_ptr ring,
+                          generic_ptr data,
+                          long timeout_us) nogil
+
+    int ring_dequeue_wait(ring_ptr ring,
+                          generic_dptr data,
+                          long timeout_us) nogil
@@ -0,0 +1,191 @@
+# file: ring.pyx
+cimport ring
+
+from Queue import Full, Empty
+
+cdef extern from "Python.h":
+    ctypedef void PyObject
+    cdef void Py_INCREF(obj)
+    cdef void Py_DECREF(obj)
+    cdef object PySequence_Fast(object o, char* m)
+    cdef Py_ssize_t PySequence_Fast_GET_SIZE(object o)
+    cdef PyObject** PySequence_Fast_ITEMS(object o)
+    cdef void* PyMem_Malloc(size_t n)
+    cdef void PyMem_Free(void* p)
+
+cdef void free_callback(object obj):
+    Py_DECREF(obj)
+
+_modes = {
+    'mpmc': 0,
+    'spsc': 1,
+    'mpsc': 2,
+}
+
+cdef long timeout_us(object timeout) except? -2:
+    if timeout is None:
+        return -1
+    if timeout < 0:
+        raise ValueError("'timeout' must be a non-negative number")
+    return <long> (timeout * 1000000)
+
+cdef class BoundedQueue(object):
+     """A bounded FIFO queue for handing objects between threads,
+     built on a lock-free ring buffer. maxsize is rounded up to a
+     power of 2. mode tells how many threads may put and get
+     concurrently: 'mpmc' (any), 'mpsc' (a single consumer) or
+     'spsc' (a single producer and a single consumer). Blocking
+     calls release the GIL while waiting.
+     """
+     cdef ring.ring_ptr _ring
+
+     def __cinit__(self, unsigned maxsize=1024, mode='mpmc'):
+         """C ctor
+         """
+         if mode not in _modes:
+             raise ValueError("mode must be one of %s" %
+                              ", ".join(sorted(_modes)))
+
+         self._ring = ring.ring_init(maxsize, _modes[mode],
+                                     <free_func_ptr> free_callback)
+         if self._ring is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._ring is not NULL:
+             ring.ring_deinit(self._ring)
+
+     def __len__(self):
+         """x.__len__() <==> len(x), approximate while other threads
+         are putting or getting
+         """
+         assert self._ring is not NULL
+         return ring.ring_n(self._ring)
+
+     property maxsize:
+         def __get__(self):
+             return ring.ring_capacity(self._ring)
+
+     def empty(self):
+         """Q.empty() -> True if Q is empty (not reliable!)
+         """
+         return len(self) == 0
+
+     def full(self):
+         """Q.full() -> True if Q is full (not reliable!)
+         """
+         return len(self) == self.maxsize
+
+     def put(self, object obj, block=True, timeout=None):
+         """Q.put(obj[, block[, timeout]]) -- put obj into Q. If block
+         is true, wait at most timeout seconds (forever if None) for a
+         free slot, then raise Full. Otherwise raise Full at once.
+         """
+         cdef int res
+         cdef long us = timeout_us(timeout)
+         cdef generic_ptr data = <generic_ptr> obj
+         assert self._ring is not NULL
+
+         # explicit reference counting increment
+         Py_INCREF(obj)
+         if block:
+             with nogil:
+                 res = ring.ring_enqueue_wait(self._ring, data, us)
+         else:
+             res = ring.ring_enqueue(self._ring, data)
+
+         if res != ring.RING_OK:
+             Py_DECREF(obj)
+             raise Full()
+
+     def put_nowait(self, object obj):
+         """Q.put_nowait(obj) -- same as Q.put(obj, False)
+         """
+         self.put(obj, False)
+
+     def get(self, block=True, timeout=None):
+         """Q.get([block[, timeout]]) -> obj -- remove and return the
+         oldest object in Q. If block is true, wait at most timeout
+         seconds (forever if None) for one, then raise Empty.
+         Otherwise raise Empty at once.
+         """
+         cdef int res
+         cdef long us = timeout_us(timeout)
+         cdef generic_ptr data = NULL
+         assert self._ring is not NULL
+
+         if block:
+             with nogil:
+                 res = ring.ring_dequeue_wait(self._ring, &data, us)
+         else:
+             res = ring.ring_dequeue(self._ring, &data)
+
+         if res != ring.RING_OK:
+             raise Empty()
+
+         obj = <object> data
+
+         # explicit reference counting decrement
+         Py_DECREF(obj)
+         return obj
+
+     def get_nowait(self):
+         """Q.get_nowait() -> obj -- same as Q.get(False)
+         """
+         return self.get(False)
+
+     def put_many(self, seq):
+         """Q.put_many(seq) -> integer -- put as many objects from seq
+         as there is room for, without blocking. Returns how many were
+         put, always a prefix of seq.
+         """
+         cdef Py_ssize_t i, n
+         cdef unsigned k
+         cdef PyObject** items
+         assert self._ring is not NULL
+
+         fast = PySequence_Fast(seq, "Iterable sequence expected")
+         n = PySequence_Fast_GET_SIZE(fast)
+         items = PySequence_Fast_ITEMS(fast)
+
+         # explicit reference counting increment, undone for the
+         # objects left out
+         for i from 0 <= i < n:
+             Py_INCREF(<object> items[i])
+
+         k = ring.ring_enqueue_many(self._ring, <generic_dptr> items, n)
+
+         for i from k <= i < n:
+             Py_DECREF(<object> items[i])
+
+         return k
+
+     def get_many(self, unsigned n):
+         """Q.get_many(n) -> list -- remove and return up to n of the
+         oldest objects in Q, without blocking
+         """
+         cdef unsigned i, k
+         cdef generic_dptr items
+         assert self._ring is not NULL
+
+         items = <generic_dptr> PyMem_Malloc(n * sizeof(generic_ptr))
+         if items is NULL and n:
+             raise MemoryError()
+
+         try:
+             k = ring.ring_dequeue_many(self._ring, items, n)
+
+             res = []
+             for i from 0 <= i < k:
+                 obj = <object> items[i]
+                 res.append(obj)
+
+                 # explicit reference counting decrement
+                 Py_DECREF(obj)
+
+         finally:
+             PyMem_Free(items)
+
+         return res
@@ -2,6 +2,8 @@ from distutils.core import setup
 from distutils.extension import Extension
 from Cython.Distutils import build_ext
 
+import numpy
+
 setup(
     cmdclass = {
         'build_ext': build_ext
@@ -13,13 +15,56 @@ setup(
 #                   extra_compile_args=["-O0"],
         ),
         Extension("ht", ["ht.pyx"],
-                  libraries=["ht"],
+                  libraries=["ht", "filter"],
 #                  extra_compile_args=["-O3", "-funroll-loops", "-fomit-frame-pointer"],
         ),
         Extension("array", ["array.pyx"],
                   libraries=["array"],
                   extra_compile_args=["-O0"],
 
+        ),
+        Extension("pq", ["pq.pyx"],
+                  libraries=["pq", "array"],
+        ),
+        Extension("ring", ["ring.pyx"],
+                  libraries=["ring"],
+        ),
+        Extension("deque", ["deque.pyx"],
+                  libraries=["deque"],
+        ),
+        Extension("linkedlist", ["linkedlist.pyx"],
+                  libraries=["list"],
+        ),
+        Extension("graph", ["graph.pyx"],
+                  libraries=["graph", "pq", "array"],
+                  include_dirs=[numpy.get_include()],
+                  extra_compile_args=["-fopenmp"],
+                  extra_link_args=["-fopenmp"],
+        ),
+        Extension("bdd", ["bdd.pyx"],
+                  libraries=["bdd"],
+        ),
+        Extension("filter", ["filter.pyx"],
+                  libraries=["filter"],
+                  include_dirs=[numpy.get_include()],
+        ),
+        Extension("art", ["art.pyx"],
+                  libraries=["art"],
+        ),
+        Extension("cache", ["cache.pyx"],
+                  libraries=["cache"],
+        ),
+        Extension("ttl", ["ttl.pyx"],
+                  libraries=["ttl"],
+        ),
+        Extension("interval", ["interval.pyx"],
+                  libraries=["avl"],
+        ),
+        Extension("uf", ["uf.pyx"],
+                  libraries=["uf"],
+                  include_dirs=[numpy.get_include()],
+                  extra_compile_args=["-fopenmp"],
+                  extra_link_args=["-fopenmp"],
         )
     ]
 )
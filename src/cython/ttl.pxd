@@ -0,0 +1,63 @@
+# file: ttl.pxd
+
+cdef extern from "ttl/ttl.h":
+
+    ctypedef struct ttl_t:
+        pass
+    ctypedef ttl_t* ttl_ptr
+
+    ctypedef unsigned long long ttl_time_t
+
+    # value ptrs
+    ctypedef void* generic_ptr
+
+    # func ptrs
+    ctypedef void (*free_func_ptr)(generic_ptr data)
+    ctypedef unsigned (*hash_func_ptr)(generic_ptr a)
+    ctypedef int (*cmp_func_ptr)(generic_ptr a,
+                                 generic_ptr b)
+    ctypedef ttl_time_t (*ttl_clock_func_ptr)()
+
+    # constants
+    int TTL_NEVER
+    int TTL_OK
+    int TTL_NOT_FOUND
+    int TTL_OUT_OF_MEM
+
+    # constructors
+    ttl_ptr ttl_init(hash_func_ptr hash_func,
+                     cmp_func_ptr cmp_func,
+                     free_func_ptr key_free_func,
+                     free_func_ptr value_free_func,
+                     ttl_clock_func_ptr clock)
+
+    # destructors
+    void ttl_deinit(ttl_ptr table)
+
+    void ttl_clear(ttl_ptr table)
+
+    # insertion
+    int ttl_insert(ttl_ptr table,
+                   generic_ptr key,
+                   generic_ptr value,
+                   ttl_time_t ttl)
+
+    # lookups
+    generic_ptr ttl_find(ttl_ptr table,
+                         generic_ptr key)
+
+    # deletion
+    int ttl_delete(ttl_ptr table,
+                   generic_ptr key)
+
+    int ttl_set_ttl(ttl_ptr table,
+                    generic_ptr key,
+                    ttl_time_t ttl)
+
+    # time
+    size_t ttl_advance(ttl_ptr table,
+                       ttl_time_t now)
+
+    ttl_time_t ttl_now(ttl_ptr table)
+    size_t ttl_count(ttl_ptr table)
+    ttl_time_t ttl_clock_ms()
@@ -0,0 +1,156 @@
+# file: ttl.pyx
+cimport ttl
+from keys cimport keys_hash, keys_cmp
+
+cdef extern from "Python.h":
+    cdef void Py_INCREF(obj)
+    cdef void Py_DECREF(obj)
+
+cdef void free_callback(object obj):
+    Py_DECREF(obj)
+
+# times are in seconds, kept in milliseconds
+cdef ttl.ttl_time_t to_ticks(object seconds) except? 0:
+    if seconds is None:
+        return ttl.TTL_NEVER
+    if seconds <= 0:
+        raise ValueError("ttl must be positive")
+    return max(1, <ttl.ttl_time_t> (seconds * 1000 + 0.5))
+
+cdef class TtlHt(object):
+     """A hash table whose entries expire, ttl seconds after they are
+     set (None: never). Expired entries are dropped as time goes on,
+     a few at a time on each operation, with no sweeps of the whole
+     table. Time comes from a monotonic clock or, for manual tables,
+     only from advance().
+     """
+     cdef ttl.ttl_ptr _table
+     cdef object _default_ttl
+
+     def __cinit__(self, default_ttl=None, manual=False):
+         """C ctor, default_ttl applies to T[k] = v
+         """
+         cdef ttl.ttl_clock_func_ptr clock = NULL
+         if not manual:
+             clock = ttl.ttl_clock_ms
+
+         to_ticks(default_ttl)
+         self._default_ttl = default_ttl
+         self._table = ttl.ttl_init(<hash_func_ptr> keys_hash,
+                                    <cmp_func_ptr> keys_cmp,
+                                    <free_func_ptr> free_callback,
+                                    <free_func_ptr> free_callback,
+                                    clock)
+         if self._table is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._table is not NULL:
+             ttl.ttl_deinit(self._table)
+
+     def __len__(self):
+         """x.__len__() <==> len(x), expired entries excluded as of the
+         last operation
+         """
+         assert self._table is not NULL
+         return ttl.ttl_count(self._table)
+
+     def insert(self, object key, object value=None, timeout=None):
+         """insert(k[, v[, timeout]]) -> None, set k, expiring in timeout
+         seconds (None: never)
+         """
+         cdef ttl.ttl_time_t ticks = to_ticks(timeout)
+         assert self._table is not NULL
+
+         # explicit reference counting increment
+         Py_INCREF(key)
+         Py_INCREF(value)
+
+         if ttl.ttl_insert(self._table, <generic_ptr> key,
+                           <generic_ptr> value, ticks) != ttl.TTL_OK:
+             Py_DECREF(key)
+             Py_DECREF(value)
+             raise MemoryError()
+
+     def __setitem__(self, object key, object value):
+         """__setitem__(k, v) <==> T[k] = v, expiring after the default
+         ttl
+         """
+         self.insert(key, value, self._default_ttl)
+
+     def __getitem__(self, object key):
+         """__getitem__(k) <==> T[k]
+         """
+         cdef generic_ptr value
+         assert self._table is not NULL
+
+         value = ttl.ttl_find(self._table, <generic_ptr> key)
+         if value == NULL:
+             raise KeyError(key)
+
+         return <object> value
+
+     def get(self, object key, default=None):
+         """get(k[,d]) -> T[k] if k in T, else d
+         """
+         cdef generic_ptr value
+         assert self._table is not NULL
+
+         value = ttl.ttl_find(self._table, <generic_ptr> key)
+         if value == NULL:
+             return default
+
+         return <object> value
+
+     def __contains__(self, object key):
+         """__contains__(k) -> True if T has an unexpired key k
+         """
+         assert self._table is not NULL
+         return ttl.ttl_find(self._table, <generic_ptr> key) != NULL
+
+     def __delitem__(self, object key):
+         """__delitem__(k) <==> del T[k]
+         """
+         assert self._table is not NULL
+         if ttl.ttl_delete(self._table,
+                           <generic_ptr> key) != ttl.TTL_OK:
+             raise KeyError(key)
+
+     def touch(self, object key, timeout=None):
+         """touch(k[, timeout]) -> None, k now expires in timeout seconds
+         (None: never)
+         """
+         cdef ttl.ttl_time_t ticks = to_ticks(timeout)
+         assert self._table is not NULL
+         if ttl.ttl_set_ttl(self._table, <generic_ptr> key,
+                            ticks) != ttl.TTL_OK:
+             raise KeyError(key)
+
+     def advance(self, now=None):
+         """advance([now]) -> the number of entries expired, moving
+         time to now (seconds), or to the clock time
+         """
+         cdef ttl.ttl_time_t ticks
+         assert self._table is not NULL
+
+         if now is None:
+             ticks = ttl.ttl_clock_ms()
+         else:
+             ticks = <ttl.ttl_time_t> (now * 1000 + 0.5)
+
+         return ttl.ttl_advance(self._table, ticks)
+
+     def clear(self):
+         """clear() -> None, remove all entries
+         """
+         assert self._table is not NULL
+         ttl.ttl_clear(self._table)
+
+     property now:
+         """the current time of T, in seconds
+         """
+         def __get__(self):
+             assert self._table is not NULL
+             return ttl.ttl_now(self._table) / 1000.0
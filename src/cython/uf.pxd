@@ -0,0 +1,56 @@
+# file: uf.pxd
+cdef extern from "uf/uf.h":
+
+    ctypedef struct uf_t:
+        pass
+    ctypedef uf_t* uf_ptr
+
+    # constants
+    int UF_OK
+    int UF_OUT_OF_BOUNDS
+    int UF_OUT_OF_MEM
+
+    unsigned UF_NONE
+
+    # constructors
+    uf_ptr uf_init(unsigned n)
+
+    # destructors
+    void uf_deinit(uf_ptr uf) nogil
+
+    # size
+    int uf_resize(uf_ptr uf,
+                  unsigned n) nogil
+
+    unsigned uf_size(uf_ptr uf) nogil
+    unsigned uf_sets(uf_ptr uf) nogil
+
+    # find, union
+    unsigned uf_find(uf_ptr uf,
+                     unsigned x) nogil
+
+    int uf_union(uf_ptr uf,
+                 unsigned x,
+                 unsigned y) nogil
+
+    int uf_same(uf_ptr uf,
+                unsigned x,
+                unsigned y) nogil
+
+    # finds safe to run in parallel with each other
+    unsigned uf_find_concurrent(uf_ptr uf,
+                                unsigned x) nogil
+
+    # batches
+    long uf_union_batch(uf_ptr uf,
+                        unsigned* xs,
+                        unsigned* ys,
+                        size_t m) nogil
+
+    long uf_find_batch(uf_ptr uf,
+                       unsigned* xs,
+                       unsigned* roots,
+                       size_t m) nogil
+
+    long uf_labels(uf_ptr uf,
+                   unsigned* labels) nogil
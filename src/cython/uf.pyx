@@ -0,0 +1,224 @@
+# file: uf.pyx
+cimport uf
+cimport lock
+
+import numpy as np
+cimport numpy as np
+
+np.import_array()
+
+cdef int check(long res) except -1:
+    if res == uf.UF_OUT_OF_BOUNDS:
+        raise IndexError("id out of range")
+    if res == uf.UF_OUT_OF_MEM:
+        raise MemoryError()
+    return 0
+
+cdef class UnionFind(object):
+     """Disjoint sets over the ints 0 .. n - 1. find and union take
+     either single ids or NumPy arrays (or sequences) of ids; batches
+     run natively, and in parallel when built with OpenMP.
+
+     With locked=True, several Python threads can share the sets,
+     batches running without the GIL: finds run in parallel with each
+     other, unions one at a time.
+     """
+     cdef uf.uf_ptr _uf
+     cdef lock.lock_ptr _lock
+
+     def __cinit__(self, unsigned n=0, locked=False):
+         """C ctor, n singleton sets
+         """
+         self._uf = uf.uf_init(n)
+         if self._uf is NULL:
+             raise MemoryError()
+
+         self._lock = lock.lock_init(1 if locked else 0)
+         if locked and self._lock is NULL:
+             raise MemoryError()
+
+     def __dealloc__(self):
+         """C dctor
+         """
+         if self._uf is not NULL:
+             with nogil:
+                 uf.uf_deinit(self._uf)
+         lock.lock_deinit(self._lock)
+
+     cdef unsigned _id(self, long x) except? 0:
+         if x < 0 or x >= uf.uf_size(self._uf):
+             raise IndexError("id out of range")
+         return x
+
+     def __len__(self):
+         """x.__len__() <==> len(x), the number of ids
+         """
+         assert self._uf is not NULL
+         return uf.uf_size(self._uf)
+
+     property sets:
+         """the number of disjoint sets
+         """
+         def __get__(self):
+             cdef unsigned res
+             assert self._uf is not NULL
+
+             if self._lock is NULL:
+                 res = uf.uf_sets(self._uf)
+             else:
+                 with nogil:
+                     lock.lock_read(self._lock)
+                     res = uf.uf_sets(self._uf)
+                     lock.lock_release(self._lock)
+
+             return res
+
+     def resize(self, unsigned n):
+         """U.resize(n) -- grow to n ids, the new ones as singletons
+         """
+         cdef int res
+         assert self._uf is not NULL
+
+         if self._lock is NULL:
+             res = uf.uf_resize(self._uf, n)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = uf.uf_resize(self._uf, n)
+                 lock.lock_release(self._lock)
+
+         check(res)
+
+     def find(self, x):
+         """U.find(x) -> the representative of x's set; for an array of
+         ids, the array of their representatives
+         """
+         cdef long res
+         cdef size_t i, m
+         cdef unsigned id_, root
+         cdef unsigned* xp
+         cdef unsigned* rp
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] xs
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] roots
+         assert self._uf is not NULL
+
+         if np.isscalar(x):
+             id_ = self._id(x)
+             if self._lock is NULL:
+                 root = uf.uf_find(self._uf, id_)
+             else:
+                 with nogil:
+                     lock.lock_read(self._lock)
+                     root = uf.uf_find_concurrent(self._uf, id_)
+                     lock.lock_release(self._lock)
+             return root
+
+         xs = np.ascontiguousarray(x, dtype=np.uint32)
+         m = len(xs)
+         roots = np.empty(m, dtype=np.uint32)
+         xp = <unsigned*> xs.data
+         rp = <unsigned*> roots.data
+
+         if self._lock is NULL:
+             res = uf.uf_find_batch(self._uf, xp, rp, m)
+         else:
+             with nogil:
+                 # shared with other finds, which compress paths too
+                 lock.lock_read(self._lock)
+                 res = m
+                 for i from 0 <= i < m:
+                     rp[i] = uf.uf_find_concurrent(self._uf, xp[i])
+                     if rp[i] == uf.UF_NONE:
+                         res = uf.UF_OUT_OF_BOUNDS
+                         break
+                 lock.lock_release(self._lock)
+         check(res)
+
+         return roots
+
+     def union(self, x, y):
+         """U.union(x, y) -> whether the sets of x and y were merged; for
+         arrays of ids, the number of merges
+         """
+         cdef long res
+         cdef size_t m
+         cdef int merged
+         cdef unsigned a, b
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] xs
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] ys
+         assert self._uf is not NULL
+
+         if np.isscalar(x) and np.isscalar(y):
+             a = self._id(x)
+             b = self._id(y)
+             if self._lock is NULL:
+                 merged = uf.uf_union(self._uf, a, b)
+             else:
+                 with nogil:
+                     lock.lock_write(self._lock)
+                     merged = uf.uf_union(self._uf, a, b)
+                     lock.lock_release(self._lock)
+             return merged == 1
+
+         xs = np.ascontiguousarray(x, dtype=np.uint32)
+         ys = np.ascontiguousarray(y, dtype=np.uint32)
+         m = len(xs)
+         if len(ys) != m:
+             raise ValueError("id arrays differ in length")
+
+         if self._lock is NULL:
+             res = uf.uf_union_batch(self._uf, <unsigned*> xs.data,
+                                     <unsigned*> ys.data, m)
+         else:
+             with nogil:
+                 lock.lock_write(self._lock)
+                 res = uf.uf_union_batch(self._uf, <unsigned*> xs.data,
+                                         <unsigned*> ys.data, m)
+                 lock.lock_release(self._lock)
+         check(res)
+
+         return res
+
+     def same(self, x, y):
+         """U.same(x, y) -> whether x and y are in the same set
+         """
+         cdef int res
+         cdef unsigned a, b
+         assert self._uf is not NULL
+
+         a = self._id(x)
+         b = self._id(y)
+         if self._lock is NULL:
+             res = uf.uf_same(self._uf, a, b)
+         else:
+             with nogil:
+                 lock.lock_read(self._lock)
+                 res = (uf.uf_find_concurrent(self._uf, a) ==
+                        uf.uf_find_concurrent(self._uf, b))
+                 lock.lock_release(self._lock)
+
+         return res == 1
+
+     def labels(self):
+         """U.labels() -> (k, labels) -- set ids 0 .. k - 1 of all the
+         ids, in order of the smallest member of each set
+         """
+         cdef long res = -1
+         cdef unsigned n
+         cdef np.ndarray[np.uint32_t, ndim=1, mode="c"] labels
+         assert self._uf is not NULL
+
+         # another thread may grow the sets before the lock is taken
+         while res < 0:
+             n = uf.uf_size(self._uf)
+             labels = np.empty(n, dtype=np.uint32)
+             if self._lock is NULL:
+                 res = uf.uf_labels(self._uf, <unsigned*> labels.data)
+             else:
+                 with nogil:
+                     lock.lock_write(self._lock)
+                     if uf.uf_size(self._uf) == n:
+                         res = uf.uf_labels(self._uf, <unsigned*> labels.data)
+                     lock.lock_release(self._lock)
+
+         return res, labels
@@ -2,7 +2,20 @@ import unittest
 
 from test_avl import TestAvl
 from test_ht import TestHt
-from test_array import TestArray
+from test_array import TestArray, TestSortedArray, TestMappedArray
+from test_pq import TestPriorityQueue, TestRadixHeap, TestPairingHeap
+from test_ring import TestBoundedQueue
+from test_deque import TestDeque, TestStackAndQueue
+from test_linkedlist import TestLinkedList
+from test_graph import TestGraph
+from test_bdd import TestBDD
+from test_filter import TestBloomFilter, TestCuckooFilter, \
+    TestHyperLogLog, TestCountMinSketch
+from test_art import TestRadixTree
+from test_cache import TestLRUCache
+from test_ttl import TestTtlHt
+from test_interval import TestIntervalTree
+from test_uf import TestUnionFind
 
 if __name__ == '__main__':
     suite = unittest.TestSuite()
@@ -10,5 +23,25 @@ if __name__ == '__main__':
     suite.addTest(unittest.makeSuite(TestAvl))
     suite.addTest(unittest.makeSuite(TestHt))
     suite.addTest(unittest.makeSuite(TestArray))
+    suite.addTest(unittest.makeSuite(TestSortedArray))
+    suite.addTest(unittest.makeSuite(TestMappedArray))
+    suite.addTest(unittest.makeSuite(TestPriorityQueue))
+    suite.addTest(unittest.makeSuite(TestRadixHeap))
+    suite.addTest(unittest.makeSuite(TestPairingHeap))
+    suite.addTest(unittest.makeSuite(TestBoundedQueue))
+    suite.addTest(unittest.makeSuite(TestDeque))
+    suite.addTest(unittest.makeSuite(TestStackAndQueue))
+    suite.addTest(unittest.makeSuite(TestLinkedList))
+    suite.addTest(unittest.makeSuite(TestGraph))
+    suite.addTest(unittest.makeSuite(TestBDD))
+    suite.addTest(unittest.makeSuite(TestBloomFilter))
+    suite.addTest(unittest.makeSuite(TestCuckooFilter))
+    suite.addTest(unittest.makeSuite(TestHyperLogLog))
+    suite.addTest(unittest.makeSuite(TestCountMinSketch))
+    suite.addTest(unittest.makeSuite(TestRadixTree))
+    suite.addTest(unittest.makeSuite(TestLRUCache))
+    suite.addTest(unittest.makeSuite(TestTtlHt))
+    suite.addTest(unittest.makeSuite(TestIntervalTree))
+    suite.addTest(unittest.makeSuite(TestUnionFind))
 
     unittest.TextTestRunner(verbosity=2).run(suite)
@@ -1,3 +1,5 @@
+import os
+import tempfile
 import unittest
 from hops import array
 
@@ -16,6 +18,149 @@ class TestArray(unittest.TestCase):
             self.array[i] = i
         self.assertEquals(100, len(self.array))
 
+    def testAppend(self):
+        for i in range(0, 3000):
+            self.array.append(i)
+        self.assertEquals(3000, len(self.array))
+        self.assertEquals(2999, self.array[2999])
+
+    def testExtend(self):
+        self.array.extend(range(0, 100))
+        self.array.extend(tuple(range(100, 200)))
+        self.array.extend(str(i) for i in range(0, 10))
+        self.assertEquals(210, len(self.array))
+        self.assertEquals(150, self.array[150])
+        self.assertEquals("9", self.array[209])
+
+        self.array.extend(self.array)
+        self.assertEquals(420, len(self.array))
+        self.assertEquals(150, self.array[360])
+
+    def testSlice(self):
+        self.array.extend(range(0, 100))
+        self.assertEquals(range(10, 20), self.array[10:20])
+        self.assertEquals(range(90, 100), self.array[90:])
+        self.assertEquals(range(0, 100, 10), self.array[::10])
+        self.assertEquals([], self.array[50:10])
+
+    def testCopyAndJoin(self):
+        self.array.extend(range(0, 100))
+        other = self.array.copy()
+        self.assertEquals(100, len(other))
+
+        joined = self.array + other
+        self.assertEquals(200, len(joined))
+        self.assertEquals(range(0, 100) * 2, joined[:])
+
+    def testIterators(self):
+        self.array.extend(range(0, 1000))
+        self.array[1005] = 1005
+        items = list(self.array)
+        self.assertEquals(1006, len(items))
+        self.assertEquals(range(0, 1000), items[:1000])
+        self.assertEquals([None] * 5 + [1005], items[1000:])
+        self.assertEquals(items[::-1], list(reversed(self.array)))
+
+        it = iter(self.array)
+        del self.array
+        self.assertEquals(0, it.next())
+
+    def testChangeDuringIteration(self):
+        for seg in (False, True):
+            a = array.Array(segmented=seg)
+            a.extend([str(i) for i in range(0, 100)])
+
+            def popping():
+                for x in a:
+                    a.pop()
+            self.assertRaises(RuntimeError, popping)
+            self.assertEquals(99, len(a))
+
+            def appending():
+                for x in reversed(a):
+                    a.append(x)
+            if seg:
+                # segmented growth leaves the elements in place
+                appending()
+                self.assertEquals(198, len(a))
+            else:
+                a.shrink_to_fit()
+                self.assertRaises(RuntimeError, appending)
+                self.assertEquals(100, len(a))
+
+            # items already fetched stay alive
+            it = iter(a)
+            first = it.next()
+            while len(a):
+                a.pop()
+            self.assertEquals("0", first)
+            self.assertRaises(RuntimeError, it.next)
+
+    def testInsertAndPop(self):
+        ref = []
+        for i in range(0, 10000):
+            self.array.insert(len(ref) / 2, i)
+            ref.insert(len(ref) / 2, i)
+        self.array.insert(-1, "x")
+        ref.insert(-1, "x")
+        self.assertEquals(ref, self.array[:])
+
+        for i in range(0, 5000):
+            self.assertEquals(ref.pop(len(ref) / 3),
+                              self.array.pop(len(self.array) / 3))
+        self.assertEquals(ref.pop(), self.array.pop())
+        self.assertEquals(ref, list(self.array))
+        self.assertRaises(IndexError, self.array.pop, 10 ** 6)
+
+    def testRemoveAndIndex(self):
+        self.array.extend([3, 1, 4, 1, 5])
+        self.assertEquals(2, self.array.count(1))
+        self.assertEquals(2, self.array.index(4))
+        self.array.remove(1)
+        self.assertEquals([3, 4, 1, 5], self.array[:])
+        del self.array[0]
+        self.assertEquals([4, 1, 5], self.array[:])
+        self.assertRaises(ValueError, self.array.remove, 42)
+        self.assertRaises(ValueError, self.array.index, 42)
+
+    def testSegmented(self):
+        seg = array.Array(segmented=True)
+        for i in range(0, 10000):
+            seg.append(i)
+        seg.extend(range(10000, 20000))
+        self.assertEquals(20000, len(seg))
+        self.assertEquals(range(4090, 4100), seg[4090:4100])
+        self.assertEquals(range(0, 20000), list(seg))
+        self.assertEquals(range(19999, -1, -1), list(reversed(seg)))
+        self.assertTrue(12345 in seg)
+        self.assertEquals(range(0, 20000), seg.copy()[:])
+
+        seen = []
+        for x in seg:
+            seen.append(x)
+            seg.append(x)
+            seg.extend([x, x])
+        self.assertEquals(range(0, 20000), seen)
+        self.assertEquals(80000, len(seg))
+
+    def testSparse(self):
+        sparse = array.Array(sparse=True)
+        for i in range(0, 100):
+            sparse[i * 100003] = i
+        self.assertEquals(99 * 100003 + 1, len(sparse))
+        self.assertEquals(None, sparse[7])
+        self.assertEquals(42, sparse[42 * 100003])
+        self.assertTrue(99 in sparse)
+        self.assertEquals([(i * 100003, i) for i in range(0, 100)],
+                          list(sparse.iteritems()))
+
+    def testReserve(self):
+        self.array.reserve(100000)
+        self.assertEquals(0, len(self.array))
+        self.array.extend(range(0, 10))
+        self.array.shrink_to_fit()
+        self.assertEquals(range(0, 10), self.array[:])
+
     # def testClear(self):
     #     self.assertEquals(0, len(self.array))
     #     for i in range(99, -1, -1):
@@ -87,3 +232,101 @@ class TestArray(unittest.TestCase):
     #         self.assertEquals(str(i), j)
     #         count += 1
     #     self.assertEquals(count, 100)
+
+
+class TestSortedArray(unittest.TestCase):
+    """A test class for sorted array indexes.
+    """
+    def testLookups(self):
+        for eytzinger in (False, True):
+            index = array.SortedArray(range(0, 2000, 2), eytzinger)
+            self.assertEquals(1000, len(index))
+            self.assertTrue(998 in index)
+            self.assertFalse(999 in index)
+            self.assertEquals(1000, index.ceiling(999))
+            self.assertEquals(1000, index.higher(998))
+            self.assertEquals(None, index.higher(1998))
+            self.assertEquals(-1, index.ceiling(5000, -1))
+
+    def testRanks(self):
+        index = array.SortedArray([5, 1, 3, 3, 9])
+        self.assertEquals(1, index.bisect_left(3))
+        self.assertEquals(3, index.bisect_right(3))
+        self.assertEquals(5, index.bisect_right(10))
+
+        index = array.SortedArray([5, 1, 3], eytzinger=True)
+        self.assertRaises(ValueError, index.bisect_left, 3)
+
+    def testInsert(self):
+        index = array.SortedArray([5, 1, 3])
+        index.insert(4)
+        index.insert(0)
+        self.assertEquals(5, len(index))
+        self.assertEquals(2, index.bisect_left(3))
+        self.assertEquals(4, index.ceiling(4))
+
+        # the BFS layout can not take insertions, lookups still work
+        index = array.SortedArray(range(0, 100, 2), eytzinger=True)
+        self.assertRaises(ValueError, index.insert, 51)
+        self.assertEquals(50, len(index))
+        self.assertEquals(52, index.ceiling(51))
+        self.assertFalse(51 in index)
+
+
+class TestMappedArray(unittest.TestCase):
+    """A test class for file-backed arrays.
+    """
+    def setUp(self):
+        fd, self.path = tempfile.mkstemp()
+        os.close(fd)
+        os.unlink(self.path)
+
+    def tearDown(self):
+        if os.path.exists(self.path):
+            os.unlink(self.path)
+
+    def testRoundTrip(self):
+        mapped = array.MappedArray(self.path, 'w')
+        for i in range(0, 5000):
+            mapped.append(3 * i)
+        mapped.sync()
+        del mapped
+
+        mapped = array.MappedArray(self.path, 'r')
+        mapped.advise('sequential')
+        self.assertEquals(5000, len(mapped))
+        self.assertEquals(3 * 4999, mapped[4999])
+        self.assertTrue(30 in mapped)
+
+    def testReadOnly(self):
+        array.MappedArray(self.path, 'w').append(42)
+
+        mapped = array.MappedArray(self.path, 'r')
+        self.assertRaises(IOError, mapped.append, 43)
+        self.assertEquals(1, len(mapped))
+
+    def testMissingFile(self):
+        self.assertRaises(IOError, array.MappedArray, self.path, 'r')
+
+    def testDamagedFile(self):
+        mapped = array.MappedArray(self.path, 'w')
+        for i in range(0, 100):
+            mapped.append(i)
+        del mapped
+
+        # cut short under its element count
+        with open(self.path, 'r+b') as f:
+            f.truncate(64 + 8 * 50)
+        self.assertRaises(IOError, array.MappedArray, self.path, 'r')
+        self.assertRaises(IOError, array.MappedArray, self.path, 'w')
+
+    def testSort(self):
+        mapped = array.MappedArray(self.path, 'w', locked=True)
+        for i in range(0, 1000):
+            mapped.append((i * 7919) % 1000 - 500)
+        mapped.sort()
+        self.assertEquals(range(-500, 500), [mapped[i] for i in range(0, 1000)])
+        del mapped
+
+        mapped = array.MappedArray(self.path, 'r')
+        self.assertRaises(IOError, mapped.sort)
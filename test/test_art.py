@@ -0,0 +1,99 @@
+import unittest
+from hops import art
+
+class TestRadixTree(unittest.TestCase):
+    """A test class for the art module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.tree = art.RadixTree()
+        self.urls = [b"http://example.com/" + str(i).encode() for i in range(0, 1000)]
+
+    def testInsertion(self):
+        for (i, url) in enumerate(self.urls):
+            self.tree[url] = i
+        self.assertEquals(1000, len(self.tree))
+
+        for (i, url) in enumerate(self.urls):
+            self.assertTrue(url in self.tree)
+            self.assertEquals(i, self.tree[url])
+        self.assertFalse(b"http://example.com/" in self.tree)
+        self.assertRaises(KeyError, lambda: self.tree[b"http://example.org/1"])
+
+        self.tree[self.urls[0]] = "zero"
+        self.assertEquals(1000, len(self.tree))
+        self.assertEquals("zero", self.tree[self.urls[0]])
+
+    def testPrefixKeys(self):
+        for key in (b"", b"a", b"ab", b"abc", b"ab\x00", b"b"):
+            self.tree[key] = key
+        self.assertEquals([b"", b"a", b"ab", b"ab\x00", b"abc", b"b"],
+                          self.tree.keys())
+        self.assertEquals([b"b", b"abc", b"ab\x00", b"ab", b"a", b""],
+                          self.tree.keys(reverse=True))
+
+        del self.tree[b"ab"]
+        self.assertFalse(b"ab" in self.tree)
+        self.assertTrue(b"abc" in self.tree)
+        self.assertEquals((b"", b""), min(self.tree))
+        self.assertEquals((b"b", b"b"), max(self.tree))
+
+    def testDeletion(self):
+        for url in self.urls:
+            self.tree[url] = url
+        for url in self.urls[::2]:
+            del self.tree[url]
+        self.assertEquals(500, len(self.tree))
+
+        for (i, url) in enumerate(self.urls):
+            self.assertEquals(i % 2 == 1, url in self.tree)
+        self.assertRaises(KeyError, self.tree.__delitem__, self.urls[0])
+        self.assertEquals(self.urls[1], self.tree.pop(self.urls[1]))
+        self.assertEquals(None, self.tree.pop(self.urls[1]))
+
+        self.tree.clear()
+        self.assertEquals(0, len(self.tree))
+        self.assertEquals([], self.tree.items())
+
+    def testOrder(self):
+        for url in self.urls:
+            self.tree[url] = None
+        self.assertEquals(sorted(self.urls), self.tree.keys())
+        self.assertEquals(sorted(self.urls, reverse=True),
+                          [k for (k, v) in reversed(self.tree)])
+
+    def testPrefixScan(self):
+        for url in self.urls:
+            self.tree[url] = None
+        expected = sorted([u for u in self.urls
+                           if u.startswith(b"http://example.com/12")])
+        self.assertEquals(expected, self.tree.keys(b"http://example.com/12"))
+        self.assertEquals(expected, [k for (k, v) in
+                                     self.tree.iter_prefix(b"http://example.com/12")])
+        self.assertEquals([], self.tree.keys(b"http://example.org/"))
+
+    def testLongestPrefix(self):
+        self.tree[b"/usr"] = 1
+        self.tree[b"/usr/lib"] = 2
+        self.tree[u"/usr/lib/python"] = 3
+        self.assertEquals((b"/usr/lib", 2),
+                          self.tree.longest_prefix(b"/usr/lib/perl"))
+        self.assertEquals((b"/usr/lib/python", 3),
+                          self.tree.longest_prefix(u"/usr/lib/python2.7"))
+        self.assertEquals((b"/usr", 1), self.tree.longest_prefix(b"/usr"))
+        self.assertRaises(KeyError, self.tree.longest_prefix, b"/var")
+
+    def testKeyTypes(self):
+        self.tree[u"caf\xe9"] = 1
+        self.assertTrue(u"caf\xe9".encode('utf-8') in self.tree)
+        self.assertRaises(TypeError, self.tree.__setitem__, 42, None)
+
+    def testModifiedWhileIterating(self):
+        self.tree[b"a"] = 1
+        self.tree[b"b"] = 2
+        it = iter(self.tree)
+        next(it)
+        self.tree[b"c"] = 3
+        self.assertRaises(RuntimeError, next, it)
@@ -1,4 +1,6 @@
+import gc
 import unittest
+import weakref
 from hops import avl
 
 class TestAvl(unittest.TestCase):
@@ -132,3 +134,94 @@ class TestAvl(unittest.TestCase):
         for (i, k) in zip(xrange(0, 100), items):
             self.assertEquals(99 - i, k[0])
             self.assertEquals(str(99 - i), k[1])
+
+    def testBulkLoad(self):
+        d = dict((i, str(i)) for i in range(0, 1000))
+        t = avl.Avl(d)
+        self.assertEquals(1000, len(t))
+        self.assertEquals(t.keys(), range(0, 1000))
+        self.assertEquals("999", t[999])
+
+        # unsorted, with duplicates kept in order
+        t = avl.Avl([(3, "c"), (1, "a"), (2, "b"), (1, "z")])
+        self.assertEquals(t.items(), [(1, "a"), (1, "z"), (2, "b"), (3, "c")])
+
+        t.update({0: "zero", 4: "four"})
+        self.assertEquals(t.keys(), [0, 1, 1, 2, 3, 4])
+        self.assertRaises(ValueError, avl.Avl, 42)
+
+    def testViews(self):
+        for i in range(99, -1, -1):
+            self.avl_tree.insert(i, str(i))
+
+        self.assertEquals(self.avl_tree.keys(reverse=True), range(99, -1, -1))
+        self.assertEquals(self.avl_tree.values(), map(str, range(0, 100)))
+        self.assertEquals(list(self.avl_tree.iterkeys()), range(0, 100))
+        self.assertEquals(list(self.avl_tree.iteritems(reverse=True)),
+                          self.avl_tree.items(reverse=True))
+
+        keys = self.avl_tree.viewkeys()
+        items = self.avl_tree.viewitems()
+        self.assertEquals(list(reversed(keys)), range(99, -1, -1))
+        self.assertTrue(42 in keys)
+        self.assertTrue((42, "42") in items)
+        self.assertFalse((42, "43") in items)
+        self.assertTrue("42" in self.avl_tree.viewvalues())
+
+        # duplicate keys
+        self.avl_tree.insert(42, "again")
+        self.assertTrue((42, "again") in items)
+        self.assertEquals(101, len(items))
+        for i in range(0, 10):
+            self.avl_tree.insert(7, i)
+        self.assertTrue((7, 9) in items)
+        self.assertTrue((7, "7") in items)
+        self.assertFalse((7, 10) in items)
+        self.assertFalse((100, "100") in items)
+
+    def testChangeDuringIteration(self):
+        for i in range(0, 10):
+            self.avl_tree.insert(i, str(i))
+
+        for view in (self.avl_tree.viewkeys(), self.avl_tree.viewitems()):
+            it = iter(view)
+            next(it)
+            del self.avl_tree[5]
+            self.assertRaises(RuntimeError, next, it)
+
+            it = reversed(view)
+            next(it)
+            self.avl_tree.insert(5, "5")
+            self.assertRaises(RuntimeError, next, it)
+
+    def testGcDuringListing(self):
+        # making the items may run the gc, and the callbacks of what it
+        # collects may change the tree meanwhile
+        keys = range(0, 5000)
+        for k in keys:
+            self.avl_tree[k] = str(k)
+
+        class Cycle(object):
+            pass
+
+        refs = []
+        def collected(ref):
+            refs.remove(ref)
+            if keys:
+                del self.avl_tree[keys.pop()]
+                garbage()
+
+        def garbage():
+            c = Cycle()
+            c.cycle = c
+            refs.append(weakref.ref(c, collected))
+
+        threshold = gc.get_threshold()
+        garbage()
+        gc.set_threshold(1)
+        try:
+            self.assertRaises(RuntimeError, self.avl_tree.items)
+        finally:
+            del keys[:]
+            gc.set_threshold(*threshold)
+        gc.collect()
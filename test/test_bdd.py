@@ -0,0 +1,82 @@
+import itertools
+import unittest
+from hops import bdd
+
+class TestBDD(unittest.TestCase):
+    """A test class for the bdd module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.manager = bdd.BDDManager(4)
+        self.x = [self.manager.var(i) for i in range(0, 4)]
+
+    def evaluate(self, f, values):
+        while not (f.is_true or f.is_false):
+            f = f.high if values[f.var] else f.low
+        return f.is_true
+
+    def testOperators(self):
+        x0, x1, x2, x3 = self.x
+        f = (x0 & x1) | (~x2 ^ x3)
+        g = x0 >> x1
+        for values in itertools.product([0, 1], repeat=4):
+            a, b, c, d = values
+            self.assertEquals(bool((a and b) or ((not c) != d)),
+                              self.evaluate(f, values))
+            self.assertEquals(bool((not a) or b), self.evaluate(g, values))
+
+    def testCanonical(self):
+        x0, x1, x2, x3 = self.x
+        self.assertEquals(x0 & (x1 | x2), (x0 & x1) | (x0 & x2))
+        self.assertEquals(~(x0 & x1), ~x0 | ~x1)
+        self.assertNotEquals(x0 & x1, x0 | x1)
+        self.assertTrue((x0 | ~x0).is_true)
+        self.assertTrue((x0 & ~x0).is_false)
+        self.assertEquals(self.manager.true, x3 >> x3)
+        self.assertEquals(hash(x0 ^ x1), hash(x1 ^ x0))
+        self.assertEquals(self.manager.ite(x0, x1, x2),
+                          (x0 & x1) | (~x0 & x2))
+
+    def testQuantify(self):
+        x0, x1, x2, x3 = self.x
+        f = (x0 & x1) | (x2 & x3)
+        self.assertEquals(x2 & x3, f.restrict(0, False))
+        self.assertEquals(x1 | (x2 & x3), f.restrict(0, True))
+        self.assertEquals(x1 | (x2 & x3), f.exists(0))
+        self.assertEquals(7, f.sat_count())
+        self.assertEquals(16, self.manager.true.sat_count())
+
+    def testGc(self):
+        x0, x1, x2, x3 = self.x
+        f = (x0 & x1) | (x2 & x3)
+        n = f.node_count()
+        for i in range(0, 100):
+            g = f ^ self.x[i % 4]
+        del g
+        self.manager.gc()
+        self.assertEquals(n - 2 + 3, len(self.manager))
+        self.assertEquals(7, f.sat_count())
+
+    def testReorder(self):
+        # pairs (i, i + n) are far apart in the initial order
+        n = 8
+        m = bdd.BDDManager(2 * n)
+        f = m.false
+        for i in range(0, n):
+            f = f | (m.var(i) & m.var(i + n))
+        before = f.node_count()
+        count = f.sat_count()
+
+        m.reorder()
+        self.assertTrue(f.node_count() < before)
+        self.assertEquals(2 * n + 2, f.node_count())
+        self.assertEquals(count, f.sat_count())
+        self.assertEquals(1, abs(m.level(0) - m.level(n)))
+
+        # f is the same function in the new order
+        g = m.false
+        for i in range(0, n):
+            g = g | (m.var(i) & m.var(i + n))
+        self.assertEquals(f, g)
@@ -0,0 +1,92 @@
+import unittest
+from hops import cache
+
+class TestLRUCache(unittest.TestCase):
+    """A test class for the cache module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.cache = cache.LRUCache(3)
+
+    def testGetPut(self):
+        self.cache[1] = "one"
+        self.cache.put(2, "two")
+        self.assertEquals(2, len(self.cache))
+        self.assertEquals("one", self.cache[1])
+        self.assertEquals("two", self.cache.get(2))
+        self.assertEquals(None, self.cache.get(3))
+        self.assertRaises(KeyError, lambda: self.cache[3])
+
+        self.cache[1] = "uno"
+        self.assertEquals(2, len(self.cache))
+        self.assertEquals("uno", self.cache[1])
+
+    def testEviction(self):
+        for i in range(0, 3):
+            self.cache[i] = i
+        self.cache.get(0)
+        self.cache[3] = 3
+
+        # 1 was the least recently used
+        self.assertFalse(1 in self.cache)
+        self.assertTrue(0 in self.cache)
+        self.assertEquals(3, len(self.cache))
+        self.assertEquals(1, self.cache.evictions)
+
+        self.cache.resize(1)
+        self.assertEquals([3], [k for k in range(0, 4) if k in self.cache])
+
+    def testCounters(self):
+        self.cache[1] = 1
+        self.cache.get(1)
+        self.cache.get(2)
+        self.cache.get(2)
+        self.assertEquals(1, self.cache.hits)
+        self.assertEquals(2, self.cache.misses)
+
+        # membership tests are not lookups
+        self.assertTrue(1 in self.cache)
+        self.assertEquals(1, self.cache.hits)
+
+    def testDeletion(self):
+        self.cache[1] = 1
+        del self.cache[1]
+        self.assertEquals(0, len(self.cache))
+        self.assertRaises(KeyError, self.cache.__delitem__, 1)
+
+        self.cache[2] = 2
+        self.cache.clear()
+        self.assertEquals(0, len(self.cache))
+
+    def testByteBudget(self):
+        c = cache.LRUCache(0, 10, len)
+        c["a"] = "xxxx"
+        c["b"] = "yyyy"
+        c["c"] = "zzzz"
+        self.assertFalse("a" in c)
+        self.assertEquals(8, c.currbytes)
+        self.assertRaises(ValueError, c.put, "d", "w" * 11)
+
+        # a new entry bound keeps the byte budget
+        c.resize(5)
+        c["d"] = "wwww"
+        self.assertEquals(8, c.currbytes)
+        c.resize(5, 0)
+        c["e"] = "vvvv"
+        self.assertEquals(12, c.currbytes)
+
+    def testClock(self):
+        c = cache.LRUCache(100, policy='clock')
+        for i in range(0, 100):
+            c[i] = i
+        for i in range(0, 50):
+            c.get(i)
+        for i in range(100, 150):
+            c[i] = i
+
+        # referenced entries get a second chance
+        self.assertEquals(100, len(c))
+        self.assertTrue(all([i in c for i in range(0, 50)]))
+        self.assertRaises(ValueError, cache.LRUCache, 10, 0, None, 'fifo')
@@ -0,0 +1,70 @@
+import collections
+import unittest
+from hops import deque
+
+class TestDeque(unittest.TestCase):
+    """A test class for the deque module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.deque = deque.Deque()
+
+    def testEnds(self):
+        ref = collections.deque()
+        for i in range(0, 1000):
+            self.deque.append(i)
+            self.deque.appendleft(-i)
+            ref.append(i)
+            ref.appendleft(-i)
+        self.assertEquals(list(ref), list(self.deque))
+
+        for i in range(0, 700):
+            self.assertEquals(ref.pop(), self.deque.pop())
+            self.assertEquals(ref.popleft(), self.deque.popleft())
+        self.assertEquals(list(ref), list(self.deque))
+        self.assertEquals(600, len(self.deque))
+
+        self.deque.clear()
+        self.assertFalse(self.deque)
+        self.assertRaises(IndexError, self.deque.pop)
+        self.assertRaises(IndexError, self.deque.popleft)
+
+    def testIndex(self):
+        self.deque.extend(range(0, 500))
+        self.deque.extendleft(range(0, 500))
+        self.assertEquals(1000, len(self.deque))
+        self.assertEquals(499, self.deque[0])
+        self.assertEquals(0, self.deque[500])
+        self.assertEquals(499, self.deque[-1])
+
+        self.deque[-1] = "x"
+        self.assertEquals("x", self.deque[999])
+        self.assertRaises(IndexError, self.deque.__getitem__, 1000)
+        self.assertRaises(IndexError, self.deque.__getitem__, -1001)
+
+    def testPopMany(self):
+        self.deque.extend(range(0, 1000))
+        self.assertEquals(range(0, 300), self.deque.popmany(300))
+        self.assertEquals(range(999, 989, -1), self.deque.popmany(10, True))
+        self.assertEquals(range(300, 990), self.deque.popmany(10000))
+        self.assertEquals([], self.deque.popmany(10))
+
+class TestStackAndQueue(unittest.TestCase):
+    """A test class for the stacks and queues of the deque module.
+    """
+    def testStack(self):
+        stack = deque.Stack()
+        for i in range(0, 100):
+            stack.push(i)
+        self.assertEquals(99, stack.top())
+        self.assertEquals(range(99, -1, -1), [stack.pop() for i in range(0, 100)])
+        self.assertRaises(IndexError, stack.top)
+
+    def testQueue(self):
+        queue = deque.Queue(range(0, 10))
+        queue.put(10)
+        self.assertEquals(0, queue.peek())
+        self.assertEquals(range(0, 11), [queue.get() for i in range(0, 11)])
+        self.assertRaises(IndexError, queue.get)
@@ -0,0 +1,195 @@
+import threading
+import unittest
+import numpy
+from hops import filter
+
+class TestBloomFilter(unittest.TestCase):
+    """A test class for the Bloom filters of the filter module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.filter = filter.BloomFilter(10000, 0.01)
+
+    def testMembership(self):
+        for i in range(0, 10000):
+            self.filter.add(str(i))
+        self.assertEquals(10000, len(self.filter))
+
+        for i in range(0, 10000):
+            self.assertTrue(str(i) in self.filter)
+
+        false_positives = 0
+        for i in range(10000, 110000):
+            if str(i) in self.filter:
+                false_positives += 1
+        self.assertTrue(false_positives < 2000)
+
+        self.filter.clear()
+        self.assertEquals(0, len(self.filter))
+        self.assertFalse("0" in self.filter)
+
+class TestCuckooFilter(unittest.TestCase):
+    """A test class for the cuckoo filters of the filter module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.filter = filter.CuckooFilter(10000)
+
+    def testMembership(self):
+        for i in range(0, 10000):
+            self.filter.add(i)
+        self.assertEquals(10000, len(self.filter))
+
+        for i in range(0, 10000):
+            self.assertTrue(i in self.filter)
+
+        false_positives = 0
+        for i in range(10000, 110000):
+            if i in self.filter:
+                false_positives += 1
+        self.assertTrue(false_positives < 100)
+
+    def testRemove(self):
+        for i in range(0, 1000):
+            self.filter.add(i)
+        for i in range(0, 1000, 2):
+            self.filter.remove(i)
+        self.assertEquals(500, len(self.filter))
+
+        for i in range(1, 1000, 2):
+            self.assertTrue(i in self.filter)
+        self.assertTrue(sum([i in self.filter for i in range(0, 1000, 2)]) < 5)
+        self.assertRaises(KeyError, self.filter.remove, 12345)
+
+    def testNegativeHashes(self):
+        for i in range(1, 1000):
+            self.filter.add(-i)
+        for i in range(1, 1000):
+            self.assertTrue(-i in self.filter)
+        self.filter.remove(-1)
+        self.assertEquals(998, len(self.filter))
+
+    def testFull(self):
+        f = filter.CuckooFilter(8)
+        self.assertRaises(OverflowError,
+                          lambda: [f.add(i) for i in range(0, 100)])
+
+class TestHyperLogLog(unittest.TestCase):
+    """A test class for the HyperLogLog counters of the filter module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.hll = filter.HyperLogLog(14)
+
+    def testCount(self):
+        for i in range(0, 1000):
+            self.hll.add(i)
+            self.hll.add(i)
+        self.assertTrue(self.hll.sparse)
+        self.assertTrue(abs(len(self.hll) - 1000) < 10)
+
+        self.hll.add_hashes(numpy.arange(1000, 200000, dtype=numpy.uint64))
+        self.assertFalse(self.hll.sparse)
+        self.assertTrue(abs(self.hll.count() - 200000) < 200000 * 0.05)
+
+        self.hll.clear()
+        self.assertEquals(0, len(self.hll))
+        self.assertRaises(ValueError, filter.HyperLogLog, 3)
+
+    def testMerge(self):
+        other = filter.HyperLogLog(14)
+        self.hll.update(range(0, 60000))
+        other.update(range(30000, 90000))
+        self.hll.merge(other)
+        self.assertTrue(abs(self.hll.count() - 90000) < 90000 * 0.05)
+        self.assertRaises(ValueError, self.hll.merge, filter.HyperLogLog(12))
+
+    def testBytes(self):
+        for n in (100, 100000):
+            self.hll.update(range(0, n))
+            copy = filter.HyperLogLog.from_bytes(self.hll.to_bytes())
+            self.assertEquals(self.hll.count(), copy.count())
+            self.assertEquals(self.hll.sparse, copy.sparse)
+        self.assertRaises(ValueError, filter.HyperLogLog.from_bytes, b"junk")
+
+        # up to the sparse to dense switch, buffered additions included
+        hll = filter.HyperLogLog(10)
+        i = 0
+        while hll.sparse:
+            data = hll.to_bytes()
+            copy = filter.HyperLogLog.from_bytes(data)
+            self.assertEquals(data, copy.to_bytes())
+            self.assertTrue(abs(hll.count() - copy.count()) < i * 0.1 + 1)
+            hll.add(i)
+            i += 1
+
+class TestCountMinSketch(unittest.TestCase):
+    """A test class for the Count-Min sketches of the filter module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.cms = filter.CountMinSketch(1024, 5)
+
+    def testCounts(self):
+        for i in range(0, 100):
+            self.cms.add("hot")
+        self.cms.add("warm", 10)
+        self.cms.update(str(i) for i in range(0, 1000))
+        self.assertEquals(1110, self.cms.total)
+        self.assertTrue(100 <= self.cms["hot"] < 110)
+        self.assertTrue(10 <= self.cms["warm"] < 20)
+        self.assertEquals(1024, self.cms.width)
+        self.assertEquals(5, self.cms.depth)
+
+    def testHashes(self):
+        hashes = numpy.array([1, 2, 3], dtype=numpy.uint64)
+        self.cms.add_hashes(hashes, [5, 6, 7])
+        self.cms.add_hashes(hashes)
+        self.assertEquals([6, 7, 8], list(self.cms.estimate_hashes(hashes)))
+
+    def testSigned(self):
+        cs = filter.CountMinSketch(1024, 5, signed=True)
+        cs.add("a", 10)
+        cs.add("a", -3)
+        self.assertEquals(7, cs["a"])
+        self.assertRaises(ValueError, self.cms.merge, cs)
+
+    def testMergeBytes(self):
+        other = filter.CountMinSketch(1024, 5)
+        self.cms.add("x", 3)
+        other.add("x", 4)
+        self.cms.merge(other)
+        self.assertEquals(7, self.cms["x"])
+        copy = filter.CountMinSketch.from_bytes(self.cms.to_bytes())
+        self.assertEquals(7, copy["x"])
+        self.assertEquals(7, copy.total)
+        self.assertRaises(ValueError, self.cms.merge,
+                          filter.CountMinSketch(512, 5))
+        self.assertRaises(ValueError, filter.CountMinSketch.from_bytes, b"")
+
+    def testLocked(self):
+        cms = filter.CountMinSketch(1024, 5, locked=True)
+        hashes = numpy.arange(1000, dtype=numpy.uint64)
+        def run():
+            for i in range(0, 10):
+                cms.add_hashes(hashes)
+                cms.estimate_hashes(hashes)
+        threads = [threading.Thread(target=run) for i in range(0, 4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEquals(40000, cms.total)
+        self.assertTrue(all(cms.estimate_hashes(hashes) >= 40))
+
+        # merging into itself takes the lock once
+        cms.merge(cms)
+        self.assertEquals(80000, cms.total)
@@ -0,0 +1,102 @@
+import unittest
+import numpy
+from hops import graph
+
+class TestGraph(unittest.TestCase):
+    """A test class for the graph module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        # a path 0 - 1 - 2 - 3, a triangle 4 - 5 - 6 and a lone node 7
+        self.sources = numpy.array([0, 1, 2, 4, 5, 6], dtype=numpy.uint32)
+        self.targets = numpy.array([1, 2, 3, 5, 6, 4], dtype=numpy.uint32)
+        self.graph = graph.Graph(self.sources, self.targets, n=8)
+
+    def testSize(self):
+        self.assertEquals(8, len(self.graph))
+        self.assertEquals(12, self.graph.n_edges)
+        self.assertEquals(2, self.graph.degree(1))
+        self.assertEquals(0, self.graph.degree(7))
+        self.assertEquals([0, 2], sorted(self.graph.neighbors(1)))
+        self.assertRaises(IndexError, self.graph.degree, 8)
+
+    def testBfs(self):
+        levels, parents = self.graph.bfs(0, parents=True)
+        self.assertEquals([0, 1, 2, 3], list(levels[:4]))
+        self.assertEquals([0, 0, 1, 2], list(parents[:4]))
+        for i in range(4, 8):
+            self.assertEquals(graph.NONE, levels[i])
+            self.assertEquals(graph.NONE, parents[i])
+        self.assertRaises(IndexError, self.graph.bfs, 8)
+
+    def testDirected(self):
+        g = graph.Graph(self.sources, self.targets, directed=True)
+        self.assertEquals(7, len(g))
+        self.assertEquals(6, g.n_edges)
+        levels = g.bfs(2)
+        self.assertEquals(graph.NONE, levels[0])
+        self.assertEquals(1, levels[3])
+
+    def testLargeBfs(self):
+        # a long ring with chords, so that bottom-up steps kick in
+        n = 100000
+        nodes = numpy.arange(n, dtype=numpy.uint32)
+        sources = numpy.concatenate((nodes, nodes))
+        targets = numpy.concatenate(((nodes + 1) % n, (nodes * 7919) % n))
+        g = graph.Graph(sources, targets)
+
+        levels = g.bfs(0)
+        self.assertFalse((levels == graph.NONE).any())
+
+        # every node is one level away from some neighbor
+        for u in range(1, n, 997):
+            self.assertEquals(levels[u] - 1,
+                              min(levels[v] for v in g.neighbors(u)))
+
+    def testComponents(self):
+        k, labels = self.graph.components()
+        self.assertEquals(3, k)
+        self.assertEquals([0, 0, 0, 0, 1, 1, 1, 2], list(labels))
+
+        # 100 directed chains, each shuffled across the node ids
+        n = 100000
+        perm = numpy.random.permutation(n).astype(numpy.uint32)
+        chain = numpy.arange(n - 1)
+        chain = chain[chain % 1000 != 999]
+        g = graph.Graph(perm[chain + 1], perm[chain], directed=True)
+        k, labels = g.components()
+        self.assertEquals(100, k)
+        self.assertEquals(range(0, 100), list(numpy.unique(labels)))
+        self.assertEquals(labels[perm[0]], labels[perm[999]])
+        self.assertEquals(labels[perm[1000]], labels[perm[1999]])
+        self.assertNotEquals(labels[perm[999]], labels[perm[1000]])
+        self.assertEquals(0, labels[0])
+
+    def testDijkstra(self):
+        weights = [1.0, 2.0, 0.5, 1.0, 1.0, 5.0]
+        g = graph.Graph(self.sources, self.targets, weights, n=8)
+        dist, parents = g.dijkstra(4, parents=True)
+        self.assertEquals([0.0, 1.0, 2.0], list(dist[4:7]))
+        self.assertEquals([4, 4, 5], list(parents[4:7]))
+        self.assertEquals(float("inf"), dist[0])
+
+        # unweighted graphs count hops
+        self.assertEquals([0.0, 1.0, 2.0, 3.0], list(self.graph.dijkstra(0)[:4]))
+
+        g = graph.Graph([0], [1], [-1.0])
+        self.assertRaises(ValueError, g.dijkstra, 0)
+        g = graph.Graph([0], [1], [float("nan")])
+        self.assertRaises(ValueError, g.dijkstra, 0)
+
+    def testBuilder(self):
+        b = graph.GraphBuilder(n=8)
+        b.add_edge(0, 1)
+        b.add_edges(self.sources[1:], self.targets[1:])
+        g = b.freeze()
+        self.assertEquals(list(self.graph.bfs(0)), list(g.bfs(0)))
+
+        b.add_edge(3, 7, 2.5)
+        dist = b.freeze().dijkstra(0)
+        self.assertEquals(5.5, dist[7])
@@ -1,4 +1,6 @@
+import gc
 import unittest
+import weakref
 from hops import ht
 
 class TestHt(unittest.TestCase):
@@ -31,23 +33,23 @@ class TestHt(unittest.TestCase):
         self.ht.insert(42, "Forty-two")
         self.assertEquals(self.ht.get(42, "What?!?"), "Forty-two")
 
-    # def testPopExisting(self):
-    #     self.assertEquals(0, len(self.ht))
-    #     self.ht.insert(42, "Forty-two")
-    #     self.assertEquals(1, len(self.ht))
+    def testPopExisting(self):
+        self.assertEquals(0, len(self.ht))
+        self.ht.insert(42, "Forty-two")
+        self.assertEquals(1, len(self.ht))
 
-    #     tmp = self.ht.pop(42)
-    #     self.assertEquals(tmp, "Forty-two")
-    #     self.assertEquals(0, len(self.ht))
+        tmp = self.ht.pop(42)
+        self.assertEquals(tmp, "Forty-two")
+        self.assertEquals(0, len(self.ht))
 
-    # def testPopNonExisting(self):
-    #     self.assertEquals(0, len(self.ht))
-    #     self.ht.insert(42, "Forty-two")
-    #     self.assertEquals(1, len(self.ht))
+    def testPopNonExisting(self):
+        self.assertEquals(0, len(self.ht))
+        self.ht.insert(42, "Forty-two")
+        self.assertEquals(1, len(self.ht))
 
-    #     tmp = self.ht.pop(44, "Forty-four")
-    #     self.assertEquals(tmp, "Forty-four")
-    #     self.assertEquals(1, len(self.ht))
+        tmp = self.ht.pop(44, "Forty-four")
+        self.assertEquals(tmp, "Forty-four")
+        self.assertEquals(1, len(self.ht))
 
     # def testPopItemExisting(self):
     #     self.assertEquals(0, len(self.ht))
@@ -87,3 +89,135 @@ class TestHt(unittest.TestCase):
             self.assertEquals(str(i), j)
             count += 1
         self.assertEquals(count, 100)
+
+    def testFilters(self):
+        for kind in ('bloom', 'cuckoo', None):
+            h = ht.Ht(filter=kind)
+            for i in range(0, 1000):
+                h.insert(i, str(i))
+            for i in range(0, 2000):
+                self.assertEquals(i < 1000, i in h)
+            self.assertEquals("999", h.get(999))
+
+        self.ht.insert(1, "one")
+        self.ht.set_filter('cuckoo')
+        self.assertTrue(1 in self.ht)
+        self.assertFalse(2 in self.ht)
+        self.assertRaises(ValueError, self.ht.set_filter, 'quotient')
+
+        # ints 2**32 apart share a hash, more of them than a cuckoo
+        # filter can hold
+        for n in (12, 100):
+            h = ht.Ht(filter='cuckoo')
+            keys = [5 + i * 2 ** 32 for i in range(0, n)]
+            for k in keys:
+                h.insert(k, k)
+            for k in keys:
+                self.assertEquals(k, h.get(k))
+            self.assertFalse(6 in h)
+            self.assertFalse(5 + n * 2 ** 32 in h)
+            for k in keys[::2]:
+                del h[k]
+            for i, k in enumerate(keys):
+                self.assertEquals(i % 2 == 1, k in h)
+
+    def testKeyEquality(self):
+        # equal keys of the fast-path types need not be the same object
+        self.ht.insert("".join(["fo", "o"]), 1)
+        self.ht.insert(b"ba" + b"r", 2)
+        self.ht.insert(10 ** 20, 3)
+        self.assertEquals(1, self.ht.get("foo"))
+        self.assertEquals(2, self.ht.get(b"bar"))
+        self.assertEquals(3, self.ht.get(10 ** 20))
+        self.assertEquals(None, self.ht.get("fob"))
+
+        # mixed types compare as in Python
+        self.ht.insert(-1, "minus one")
+        self.assertEquals("minus one", self.ht.get(-1.0))
+        self.assertEquals(None, self.ht.get("-1"))
+        self.assertTrue((1, "a") not in self.ht)
+        self.ht.insert((1, "a"), 4)
+        self.assertEquals(4, self.ht.get((1, "a")))
+
+    def testBulkLoad(self):
+        d = dict((i, str(i)) for i in range(0, 1000))
+        for seq in (d, d.items(), tuple(d.items()), iter(d.items())):
+            h = ht.Ht(seq)
+            self.assertEquals(1000, len(h))
+            for i in range(0, 1000):
+                self.assertEquals(str(i), h[i])
+
+        self.ht.insert(1, "one")
+        self.ht.update({1: "uno", 2: "due"})
+        self.ht.update([(3, "tre")])
+        self.assertEquals(3, len(self.ht))
+        self.assertEquals("uno", self.ht[1])
+        self.assertRaises(ValueError, ht.Ht, 42)
+
+    def testViews(self):
+        for i in range(0, 100):
+            self.ht.insert(i, str(i))
+
+        self.assertEquals(sorted(self.ht.keys()), range(0, 100))
+        self.assertEquals(sorted(self.ht.values()), sorted(map(str, range(0, 100))))
+        self.assertEquals(sorted(self.ht.items()), [(i, str(i)) for i in range(0, 100)])
+        self.assertEquals(sorted(self.ht.iterkeys()), range(0, 100))
+        self.assertEquals(list(self.ht.itervalues()), self.ht.values())
+
+        keys = self.ht.viewkeys()
+        items = self.ht.viewitems()
+        self.assertEquals(100, len(keys))
+        self.assertTrue(42 in keys)
+        self.assertTrue((42, "42") in items)
+        self.assertFalse((42, "43") in items)
+        self.assertTrue("42" in self.ht.viewvalues())
+
+        # iterators do not survive changes
+        it = iter(keys)
+        next(it)
+        del self.ht[0]
+        self.assertRaises(RuntimeError, next, it)
+        it = iter(items)
+        next(it)
+        self.ht.insert(0, "0")
+        self.assertRaises(RuntimeError, next, it)
+        it = iter(keys)
+        self.ht.insert(0, "zero")
+        self.assertEquals(100, len(list(it)))
+
+        # views follow the table
+        self.ht.insert(100, "100")
+        self.assertEquals(101, len(keys))
+        self.assertEquals(sorted(keys), range(0, 101))
+
+    def testGcDuringListing(self):
+        # making the items may run the gc, and the callbacks of what it
+        # collects may change the table meanwhile
+        keys = range(0, 5000)
+        for k in keys:
+            self.ht[k] = str(k)
+
+        class Cycle(object):
+            pass
+
+        refs = []
+        def collected(ref):
+            refs.remove(ref)
+            if keys:
+                del self.ht[keys.pop()]
+                garbage()
+
+        def garbage():
+            c = Cycle()
+            c.cycle = c
+            refs.append(weakref.ref(c, collected))
+
+        threshold = gc.get_threshold()
+        garbage()
+        gc.set_threshold(1)
+        try:
+            self.assertRaises(RuntimeError, self.ht.items)
+        finally:
+            del keys[:]
+            gc.set_threshold(*threshold)
+        gc.collect()
@@ -0,0 +1,92 @@
+import unittest
+import random
+from hops import interval
+
+class TestIntervalTree(unittest.TestCase):
+    """A test class for the interval module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.tree = interval.IntervalTree()
+
+    def testInsert(self):
+        self.tree.insert(1, 5, "a")
+        self.tree.insert(3, 8, "b")
+        self.tree.insert(10, 12, "c")
+        self.assertEquals(3, len(self.tree))
+        self.assertEquals([(1.0, 5.0, "a"), (3.0, 8.0, "b"),
+                           (10.0, 12.0, "c")], list(self.tree))
+
+    def testBadBounds(self):
+        self.assertRaises(ValueError, self.tree.insert, 5, 1)
+        self.assertRaises(ValueError, self.tree.insert, float("nan"), 1)
+        self.assertEquals(0, len(self.tree))
+
+    def testStab(self):
+        self.tree.insert(1, 5, "a")
+        self.tree.insert(3, 8, "b")
+        self.tree.insert(10, 12, "c")
+        self.assertEquals(["a", "b"], [v for (l, h, v) in self.tree.stab(4)])
+        self.assertEquals(["b"], [v for (l, h, v) in self.tree.stab(8)])
+        self.assertEquals([], self.tree.stab(9))
+
+    def testOverlap(self):
+        data = []
+        for i in range(0, 1000):
+            lo = random.randint(0, 1000)
+            hi = lo + random.randint(0, 50)
+            data.append((float(lo), float(hi), i))
+            self.tree.insert(lo, hi, i)
+
+        for i in range(0, 100):
+            a = random.randint(0, 1100)
+            b = a + random.randint(0, 20)
+            expected = sorted([v for (l, h, v) in data if l <= b and h >= a])
+            res = self.tree.overlap(a, b)
+            self.assertEquals(expected, sorted([v for (l, h, v) in res]))
+            # in interval order; equal intervals in no particular one
+            self.assertEquals(sorted(res, key=lambda t: t[:2]), res)
+
+    def testRemove(self):
+        x, y = object(), object()
+        self.tree.insert(1, 2, x)
+        self.tree.insert(1, 2, y)
+        self.tree.remove(1, 2, y)
+        self.assertEquals([(1.0, 2.0, x)], list(self.tree))
+        self.assertRaises(KeyError, self.tree.remove, 1, 2, y)
+        self.tree.remove(1, 2)
+        self.assertEquals(0, len(self.tree))
+        self.assertRaises(KeyError, self.tree.remove, 1, 2)
+
+    def testRemoveOverlap(self):
+        # the subtree maxes follow removals and the rotations they cause
+        data = []
+        for i in range(0, 1000):
+            lo = random.randint(0, 1000)
+            hi = lo + random.randint(0, 50)
+            data.append((float(lo), float(hi), i))
+            self.tree.insert(lo, hi, i)
+
+        random.shuffle(data)
+        for (l, h, v) in data[:600]:
+            self.tree.remove(l, h, v)
+        data = data[600:]
+        self.assertEquals(400, len(self.tree))
+
+        for p in range(0, 1100, 7):
+            expected = sorted([v for (l, h, v) in data if l <= p <= h])
+            self.assertEquals(expected,
+                              sorted([v for (l, h, v) in self.tree.stab(p)]))
+
+    def testIterChange(self):
+        self.tree.insert(1, 2)
+        self.tree.insert(3, 4)
+        it = iter(self.tree)
+        next(it)
+        self.tree.insert(5, 6)
+        self.assertRaises(RuntimeError, next, it)
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,80 @@
+import collections
+import unittest
+from hops import linkedlist
+
+class TestLinkedList(unittest.TestCase):
+    """A test class for the linkedlist module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.list = linkedlist.LinkedList()
+
+    def testEnds(self):
+        ref = collections.deque()
+        for i in range(0, 3000):
+            self.list.append(i)
+            self.list.appendleft(-i)
+            ref.append(i)
+            ref.appendleft(-i)
+        self.assertEquals(list(ref), list(self.list))
+        self.assertEquals(list(reversed(ref)), list(reversed(self.list)))
+
+        for i in range(0, 2000):
+            self.assertEquals(ref.pop(), self.list.pop())
+            self.assertEquals(ref.popleft(), self.list.popleft())
+        self.assertEquals(list(ref), list(self.list))
+        self.assertEquals(2000, len(self.list))
+
+        self.list.clear()
+        self.assertFalse(self.list)
+        self.assertRaises(IndexError, self.list.pop)
+        self.assertRaises(IndexError, self.list.popleft)
+
+    def testHandles(self):
+        handles = [self.list.append(i) for i in range(0, 10)]
+        self.list.insert_before(handles[0], 'first')
+        self.list.insert_before(handles[5], 'five')
+        self.assertEquals(3, self.list.remove(handles[3]))
+        self.assertEquals(['first', 0, 1, 2, 4, 'five', 5, 6, 7, 8, 9],
+                          list(self.list))
+
+        # removed handles are stale, even once their node is reused
+        self.assertFalse(handles[3] in self.list)
+        self.list.append(10)
+        self.assertRaises(KeyError, self.list.remove, handles[3])
+        self.assertRaises(KeyError, self.list.get, handles[3])
+        self.assertEquals(4, self.list.get(handles[4]))
+        self.assertRaises(KeyError, linkedlist.LinkedList().remove, handles[4])
+
+    def testSplice(self):
+        other = linkedlist.LinkedList(range(0, 5))
+        handle = other.append(5)
+        self.list.extend(range(-5, 0))
+        self.list.extend(other)
+
+        self.assertEquals(range(-5, 6), list(self.list))
+        self.assertEquals(0, len(other))
+        self.assertTrue(handle in self.list)
+        self.assertFalse(handle in other)
+        self.assertEquals(5, self.list.remove(handle))
+
+        # both lists keep working on the nodes they share
+        other.append('x')
+        self.list.append('y')
+        self.assertEquals(['x'], list(other))
+        self.assertEquals(range(-5, 5) + ['y'], list(self.list))
+
+        # extending with itself doubles the list, as with lists
+        self.list.extend(self.list)
+        self.assertEquals(2 * (range(-5, 5) + ['y']), list(self.list))
+
+    def testChangeDuringIteration(self):
+        self.list.extend(range(0, 10))
+
+        def popping():
+            for x in self.list:
+                self.list.popleft()
+        self.assertRaises(RuntimeError, popping)
+        self.assertEquals(9, len(self.list))
@@ -0,0 +1,142 @@
+import random
+import unittest
+from hops import pq
+
+class TestPriorityQueue(unittest.TestCase):
+    """A test class for the pq module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.pq = pq.PriorityQueue()
+
+    def testPushPop(self):
+        keys = [random.random() for i in range(0, 1000)]
+        for k in keys:
+            self.pq.push(k, str(k))
+        self.assertEquals(1000, len(self.pq))
+        self.assertEquals(min(keys), self.pq.peek()[0])
+
+        for k in sorted(keys):
+            self.assertEquals((k, str(k)), self.pq.pop())
+        self.assertFalse(self.pq)
+        self.assertRaises(IndexError, self.pq.pop)
+        self.assertRaises(IndexError, self.pq.peek)
+
+    def testHandles(self):
+        handles = [self.pq.push(10 + i, i) for i in range(0, 10)]
+        self.pq.decrease_key(handles[7], 1)
+        self.assertEquals((1, 7), self.pq.peek())
+        self.assertRaises(ValueError, self.pq.decrease_key, handles[7], 50)
+
+        self.pq.update(handles[7], 50)
+        self.assertEquals(50, self.pq.priority(handles[7]))
+        self.assertEquals(3, self.pq.remove(handles[3]))
+        self.assertFalse(handles[3] in self.pq)
+        self.assertRaises(KeyError, self.pq.remove, handles[3])
+
+        items = [self.pq.pop()[1] for i in range(0, len(self.pq))]
+        self.assertEquals([0, 1, 2, 4, 5, 6, 8, 9, 7], items)
+
+    def testHeapify(self):
+        queue = pq.PriorityQueue([(5 - i, i) for i in range(0, 6)],
+                                 int_priorities=True)
+        queue.heapify([(-1, 'a')])
+        self.assertEquals((-1, 'a'), queue.pop())
+        self.assertEquals((0, 5), queue.pop())
+        self.assertEquals(5, len(queue))
+        queue.clear()
+        self.assertEquals(0, len(queue))
+
+
+class TestRadixHeap(unittest.TestCase):
+    """A test class for radix heaps.
+    """
+    def setUp(self):
+        self.heap = pq.RadixHeap()
+
+    def testPushPop(self):
+        keys = [random.randint(0, 2 ** 40) for i in range(0, 1000)]
+        for k in keys:
+            self.heap.push(k, str(k))
+        self.assertEquals(1000, len(self.heap))
+        self.assertEquals(min(keys), self.heap.peek()[0])
+
+        for k in sorted(keys):
+            self.assertEquals((k, str(k)), self.heap.pop())
+        self.assertFalse(self.heap)
+        self.assertRaises(IndexError, self.heap.pop)
+        self.assertRaises(IndexError, self.heap.peek)
+
+    def testMonotone(self):
+        self.heap.push(10, 'a')
+        self.heap.push(10, 'b')
+        self.heap.push(20, 'c')
+        self.assertEquals(10, self.heap.pop()[0])
+
+        # no key below the last one popped, equal ones are fine
+        self.assertRaises(ValueError, self.heap.push, 9, 'd')
+        self.heap.push(10, 'e')
+        self.heap.push(15, 'f')
+        self.assertEquals([10, 10, 15, 20],
+                          [self.heap.pop()[0] for i in range(0, 4)])
+
+        self.heap.push(30, 'g')
+        self.heap.clear()
+        self.assertEquals(0, len(self.heap))
+        self.heap.push(0, 'h')
+        self.assertEquals((0, 'h'), self.heap.pop())
+
+
+class TestPairingHeap(unittest.TestCase):
+    """A test class for pairing heaps.
+    """
+    def setUp(self):
+        self.heap = pq.PairingHeap()
+
+    def testPushPop(self):
+        keys = [random.random() for i in range(0, 1000)]
+        for k in keys:
+            self.heap.push(k, str(k))
+        self.assertEquals(1000, len(self.heap))
+        self.assertEquals(min(keys), self.heap.peek()[0])
+
+        for k in sorted(keys):
+            self.assertEquals((k, str(k)), self.heap.pop())
+        self.assertFalse(self.heap)
+        self.assertRaises(IndexError, self.heap.pop)
+        self.assertRaises(IndexError, self.heap.peek)
+
+    def testHandles(self):
+        handles = [self.heap.push(10 + i, i) for i in range(0, 10)]
+        self.heap.decrease_key(handles[7], 1)
+        self.assertEquals((1, 7), self.heap.peek())
+        self.assertEquals(1, self.heap.priority(handles[7]))
+        self.assertRaises(ValueError, self.heap.decrease_key, handles[7], 50)
+
+        self.assertEquals(3, self.heap.remove(handles[3]))
+        self.assertFalse(handles[3] in self.heap)
+        self.assertRaises(KeyError, self.heap.remove, handles[3])
+        self.assertRaises(KeyError, pq.PairingHeap().remove, handles[4])
+
+        items = [self.heap.pop()[1] for i in range(0, len(self.heap))]
+        self.assertEquals([7, 0, 1, 2, 4, 5, 6, 8, 9], items)
+        self.assertRaises(KeyError, self.heap.decrease_key, handles[0], 0)
+
+    def testAgainstPriorityQueue(self):
+        queue = pq.PriorityQueue()
+        qh, ph = {}, {}
+        for i in range(0, 2000):
+            k = random.random()
+            qh[i] = queue.push(k, i)
+            ph[i] = self.heap.push(k, i)
+        for i in range(0, 2000, 3):
+            k = random.random() / 10
+            if k < self.heap.priority(ph[i]):
+                queue.decrease_key(qh[i], k)
+                self.heap.decrease_key(ph[i], k)
+
+        while queue:
+            self.assertEquals(queue.pop(), self.heap.pop())
+        self.assertFalse(self.heap)
@@ -0,0 +1,52 @@
+import threading
+import unittest
+from Queue import Full, Empty
+from hops import ring
+
+class TestBoundedQueue(unittest.TestCase):
+    """A test class for the ring module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.queue = ring.BoundedQueue(100)
+
+    def testPutGet(self):
+        self.assertEquals(128, self.queue.maxsize)
+        for i in range(0, 128):
+            self.queue.put(i)
+        self.assertTrue(self.queue.full())
+        self.assertRaises(Full, self.queue.put_nowait, 128)
+        self.assertRaises(Full, self.queue.put, 128, True, 0.01)
+
+        self.assertEquals(range(0, 128),
+                          [self.queue.get() for i in range(0, 128)])
+        self.assertTrue(self.queue.empty())
+        self.assertRaises(Empty, self.queue.get_nowait)
+        self.assertRaises(Empty, self.queue.get, True, 0.01)
+
+    def testMany(self):
+        self.assertEquals(128, self.queue.put_many(range(0, 200)))
+        self.assertEquals(range(0, 10), self.queue.get_many(10))
+        self.assertEquals(10, self.queue.put_many(range(200, 300)))
+        self.assertEquals(range(10, 128) + range(200, 210),
+                          self.queue.get_many(1000))
+        self.assertEquals([], self.queue.get_many(10))
+
+    def testThreads(self):
+        queue = ring.BoundedQueue(16, 'mpsc')
+        def produce(base):
+            for i in range(base, base + 1000):
+                queue.put(i)
+
+        producers = [threading.Thread(target=produce, args=(n * 1000,))
+                     for n in range(0, 4)]
+        for t in producers:
+            t.start()
+        items = [queue.get(timeout=10) for i in range(0, 4000)]
+        for t in producers:
+            t.join()
+
+        self.assertEquals(range(0, 4000), sorted(items))
+        self.assertRaises(ValueError, ring.BoundedQueue, 16, 'spmc')
@@ -0,0 +1,79 @@
+import unittest
+from hops import ttl
+
+class TestTtlHt(unittest.TestCase):
+    """A test class for the ttl module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.ht = ttl.TtlHt(manual=True)
+
+    def testNoExpiry(self):
+        for i in range(0, 100):
+            self.ht[i] = str(i)
+        self.assertEquals(100, len(self.ht))
+        self.assertEquals(0, self.ht.advance(1e6))
+        self.assertEquals("42", self.ht[42])
+
+    def testExpiry(self):
+        for i in range(0, 100):
+            self.ht.insert(i, str(i), i + 1)
+        self.assertEquals(0, self.ht.advance(0.5))
+        self.assertEquals(10, self.ht.advance(10))
+        self.assertEquals(90, len(self.ht))
+        self.assertFalse(9 in self.ht)
+        self.assertTrue(10 in self.ht)
+        self.assertRaises(KeyError, lambda: self.ht[0])
+        self.assertEquals(None, self.ht.get(0))
+
+        self.assertEquals(90, self.ht.advance(1e5))
+        self.assertEquals(0, len(self.ht))
+
+    def testTouch(self):
+        self.ht.insert("session", 1, 10)
+        self.ht.advance(5)
+        self.ht.touch("session", 10)
+        self.ht.advance(12)
+        self.assertTrue("session" in self.ht)
+        self.ht.advance(16)
+        self.assertFalse("session" in self.ht)
+        self.assertRaises(KeyError, self.ht.touch, "session", 1)
+
+    def testReplace(self):
+        self.ht.insert(1, "one", 1)
+        self.ht.insert(1, "uno")
+        self.ht.advance(100)
+        self.assertEquals("uno", self.ht[1])
+
+    def testOverflow(self):
+        # a year is past the last wheel, entries wait on the overflow list
+        self.ht.insert(1, "one", 365 * 86400)
+        self.ht.insert(2, "two", 365 * 86400)
+        self.ht.touch(1, 10)
+        self.assertEquals(1, self.ht.advance(11))
+        del self.ht[2]
+        self.assertEquals(0, len(self.ht))
+        self.assertEquals(0, self.ht.advance(400 * 86400))
+
+    def testDefaultTtl(self):
+        h = ttl.TtlHt(60, manual=True)
+        h["k"] = "v"
+        h.advance(59)
+        self.assertTrue("k" in h)
+        h.advance(61)
+        self.assertFalse("k" in h)
+        self.assertRaises(ValueError, h.insert, "k", "v", 0)
+
+    def testDeletion(self):
+        self.ht.insert(1, 1, 5)
+        del self.ht[1]
+        self.assertEquals(0, self.ht.advance(10))
+        self.assertRaises(KeyError, self.ht.__delitem__, 1)
+
+    def testClock(self):
+        h = ttl.TtlHt()
+        h.insert(1, 1, 3600)
+        self.assertTrue(1 in h)
+        self.assertEquals(0, h.advance())
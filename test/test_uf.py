@@ -0,0 +1,82 @@
+import threading
+import unittest
+import numpy
+from hops import uf
+
+class TestUnionFind(unittest.TestCase):
+    """A test class for the uf module.
+    """
+    def setUp(self):
+        """set up data used in the tests. setUp is called before each
+        test function execution.
+        """
+        self.uf = uf.UnionFind(10)
+
+    def testUnion(self):
+        self.assertEquals(10, len(self.uf))
+        self.assertEquals(10, self.uf.sets)
+        self.assertTrue(self.uf.union(1, 2))
+        self.assertTrue(self.uf.union(2, 3))
+        self.assertFalse(self.uf.union(1, 3))
+        self.assertEquals(8, self.uf.sets)
+        self.assertTrue(self.uf.same(1, 3))
+        self.assertFalse(self.uf.same(1, 4))
+        self.assertEquals(self.uf.find(1), self.uf.find(3))
+        self.assertRaises(IndexError, self.uf.union, 1, 10)
+        self.assertRaises(IndexError, self.uf.find, -1)
+
+    def testBatch(self):
+        xs = numpy.array([0, 2, 4, 6, 0], dtype=numpy.uint32)
+        ys = numpy.array([1, 3, 5, 7, 7], dtype=numpy.uint32)
+        self.assertEquals(5, self.uf.union(xs, ys))
+        self.assertEquals(5, self.uf.sets)
+        roots = self.uf.find(numpy.arange(10))
+        self.assertEquals(1, len(set(roots[:2]) | set(roots[6:8])))
+        self.assertNotEquals(roots[0], roots[2])
+        self.assertRaises(IndexError, self.uf.union, [0], [10])
+        self.assertRaises(ValueError, self.uf.union, [0, 1], [2])
+        self.assertEquals(5, self.uf.sets)
+
+    def testLabels(self):
+        self.uf.union([3, 5, 8], [9, 3, 0])
+        k, labels = self.uf.labels()
+        self.assertEquals(7, k)
+        self.assertEquals([0, 1, 2, 3, 4, 3, 5, 6, 0, 3], list(labels))
+
+    def testResize(self):
+        self.uf.union(0, 9)
+        self.uf.resize(1000)
+        self.assertEquals(1000, len(self.uf))
+        self.assertEquals(999, self.uf.sets)
+        self.assertTrue(self.uf.same(0, 9))
+        self.assertTrue(self.uf.union(999, 0))
+
+    def testLarge(self):
+        n = 200000
+        u = uf.UnionFind(n)
+        # a chain 0 - 1 - ... - (n - 1), merged in random order
+        xs = numpy.random.permutation(n - 1).astype(numpy.uint32)
+        self.assertEquals(n - 1, u.union(xs, xs + 1))
+        self.assertEquals(1, u.sets)
+        self.assertEquals(1, len(set(u.find(numpy.arange(n)))))
+
+    def testLocked(self):
+        n = 100000
+        u = uf.UnionFind(n, locked=True)
+        # chains of 1000 ids, built by threads sharing the sets
+        def run(k):
+            xs = numpy.arange(k, n, 4, dtype=numpy.uint32)
+            xs = xs[xs % 1000 != 999]
+            u.union(xs, xs + 1)
+            u.find(numpy.arange(n))
+        threads = [threading.Thread(target=run, args=(k,)) for k in range(0, 4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEquals(n // 1000, u.sets)
+        self.assertTrue(u.same(1000, 1999))
+        self.assertFalse(u.same(999, 1000))
+
+if __name__ == '__main__':
+    unittest.main()